@@ -358,10 +358,6 @@ void on_GLES2_Render()
     // draw the sphere
     csrDrawMesh(g_pMesh, g_pShader, 0, 0);
 
-    // enable position and color slots
-    glEnableVertexAttribArray(g_pShader->m_VertexSlot);
-    glEnableVertexAttribArray(g_pShader->m_ColorSlot);
-
     // configure the polygon mesh
     csrSkinInit(&polygonMesh.m_Skin);
     polygonMesh.m_Time  = 0.0;
@@ -381,6 +377,8 @@ void on_GLES2_Render()
     polygonVB.m_Time                       = 0.0;
     polygonVB.m_pData                      = g_PolygonArray;
     polygonVB.m_Count                      = sizeof(g_PolygonArray) / sizeof(float);
+    polygonVB.m_pIndex                     = 0;
+    polygonVB.m_IndexCount                 = 0;
 
     // found collide polygons to draw?
     for (i = 0; i < polygonsToDrawCount; ++i)
@@ -400,6 +398,9 @@ void on_GLES2_Render()
         g_PolygonArray[15] = pPolygonsToDraw[i].m_Vertex[2].m_Y;
         g_PolygonArray[16] = pPolygonsToDraw[i].m_Vertex[2].m_Z;
 
+        // notify that the polygon changed
+        csrVertexBufferUpdateGeneration(&polygonVB);
+
         // draw the polygon
         csrDrawMesh(&polygonMesh, g_pShader, 0, 0);
     }
@@ -407,10 +408,6 @@ void on_GLES2_Render()
     if (polygonsToDrawCount)
         free(pPolygonsToDraw);
 
-    // disconnect slots from shader
-    glDisableVertexAttribArray(g_pShader->m_VertexSlot);
-    glDisableVertexAttribArray(g_pShader->m_ColorSlot);
-
     csrDrawEnd();
 }
 //------------------------------------------------------------------------------
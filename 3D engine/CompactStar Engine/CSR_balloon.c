@@ -390,10 +390,6 @@ void on_GLES2_Render()
     // draw the model
     csrDrawModel(g_pModel, 0, g_pShader, 0, 0);
 
-    // enable position and color slots
-    glEnableVertexAttribArray(g_pShader->m_VertexSlot);
-    glEnableVertexAttribArray(g_pShader->m_ColorSlot);
-
     // configure the polygon mesh
     csrSkinInit(&polygonMesh.m_Skin);
     polygonMesh.m_Time  = 0.0;
@@ -413,6 +409,8 @@ void on_GLES2_Render()
     polygonVB.m_Time                       = 0.0;
     polygonVB.m_pData                      = g_PolygonArray;
     polygonVB.m_Count                      = sizeof(g_PolygonArray) / sizeof(float);
+    polygonVB.m_pIndex                     = 0;
+    polygonVB.m_IndexCount                 = 0;
 
     // found collide polygons to draw?
     for (i = 0; i < polygonsToDrawCount; ++i)
@@ -432,6 +430,9 @@ void on_GLES2_Render()
         g_PolygonArray[15] = pPolygonsToDraw[i].m_Vertex[2].m_Y;
         g_PolygonArray[16] = pPolygonsToDraw[i].m_Vertex[2].m_Z;
 
+        // notify that the polygon changed
+        csrVertexBufferUpdateGeneration(&polygonVB);
+
         // draw the polygon
         csrDrawMesh(&polygonMesh, g_pShader, 0, 0);
     }
@@ -439,10 +440,6 @@ void on_GLES2_Render()
     if (polygonsToDrawCount)
         free(pPolygonsToDraw);
 
-    // disconnect slots from shader
-    glDisableVertexAttribArray(g_pShader->m_VertexSlot);
-    glDisableVertexAttribArray(g_pShader->m_ColorSlot);
-
     csrDrawEnd();
 }
 //------------------------------------------------------------------------------
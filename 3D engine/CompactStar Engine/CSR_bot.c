@@ -277,18 +277,22 @@ void* OnGetShader(const void* pModel, CSR_EModelType type)
     if (pModel == g_pScene->m_pSkybox)
         return g_pSkyboxShader;
 
-    csrShaderEnable(g_pShader);
-
+    return g_pShader;
+}
+//---------------------------------------------------------------------------
+void OnDrawItem(const CSR_Scene*        pScene,
+                const CSR_SceneContext* pContext,
+                const CSR_SceneItem*    pItem,
+                      void*             pShader)
+{
     // bot or fader?
-    if (pModel == g_Bot.m_pModel)
+    if (pItem->m_pModel == g_Bot.m_pModel)
         glUniform1f(g_AlphaSlot, g_BotAlpha);
     else
-    if (pModel == g_pFader)
+    if (pItem->m_pModel == g_pFader)
         glUniform1f(g_AlphaSlot, g_FaderAlpha);
     else
         glUniform1f(g_AlphaSlot, 1.0f);
-
-    return g_pShader;
 }
 //---------------------------------------------------------------------------
 void* OnGetID(const void* pKey)
@@ -967,6 +971,7 @@ void on_GLES2_Init(int view_w, int view_h)
     // configure the scene context
     csrSceneContextInit(&g_SceneContext);
     g_SceneContext.m_fOnGetShader     = OnGetShader;
+    g_SceneContext.m_fOnDrawItem      = OnDrawItem;
     g_SceneContext.m_fOnGetID         = OnGetID;
     g_SceneContext.m_fOnGetMDLIndex   = OnGetMDLIndex;
     g_SceneContext.m_fOnDeleteTexture = OnDeleteTexture;
@@ -52,6 +52,10 @@
 #define LANDSCAPE_DATA_FILE    "Resources/the_face.bmp"
 #define PLAYER_STEP_SOUND_FILE "Resources/human_walk_grass_step.wav"
 
+#define ATLAS_PAGE_SIZE 1024
+#define ATLAS_PADDING   2
+#define TEXTURE_COUNT   3
+
 //----------------------------------------------------------------------------
 const char g_VSTextured[] =
     "precision mediump float;"
@@ -84,6 +88,7 @@ CSR_OpenGLShader* g_pShader         = 0;
 CSR_Mesh*         g_pMesh           = 0;
 CSR_AABBNode*     g_pTree           = 0;
 CSR_MDL*          g_pModel          = 0;
+CSR_TextureAtlas* g_pAtlas          = 0;
 double            g_TextureLastTime = 0.0;
 double            g_ModelLastTime   = 0.0;
 double            g_MeshLastTime    = 0.0;
@@ -112,7 +117,7 @@ CSR_Color         g_Color;
 ALCdevice*        g_pOpenALDevice  = 0;
 ALCcontext*       g_pOpenALContext = 0;
 CSR_Sound*        g_pSound         = 0;
-CSR_OpenGLID      g_ID[2];
+CSR_OpenGLID      g_ID[TEXTURE_COUNT];
 //---------------------------------------------------------------------------
 void* OnGetShader(const void* pModel, CSR_EModelType type)
 {
@@ -124,20 +129,28 @@ void OnApplySkin(size_t index, const CSR_Skin* pSkin, int* pCanRelease)
     // should not be hardcoded, however there is only 1 model which will use this function in this demo,
     // so it is safe to do that
     g_ID[1].m_pKey     = (void*)(&pSkin->m_Texture);
-    g_ID[1].m_ID       = csrOpenGLTextureFromPixelBuffer(pSkin->m_Texture.m_pBuffer);
+    g_ID[1].m_ID       = M_CSR_Error_Code;
     g_ID[1].m_UseCount = 1;
 
-    // from now the source texture will no longer be used
+    // keep the source texture, it will be packed in the texture atlas once the model is opened
     if (pCanRelease)
-        *pCanRelease = 1;
+        *pCanRelease = 0;
 }
 //---------------------------------------------------------------------------
 void* OnGetID(const void* pKey)
 {
-    size_t i;
+    size_t             i;
+    const CSR_Texture* pPage;
+
+    // is the texture packed in the atlas? Its page is bound instead, thus the landscape and the
+    // model share the same texture
+    pPage = csrTextureAtlasGetPageTexture(g_pAtlas, (const CSR_Texture*)pKey);
+
+    if (pPage)
+        pKey = pPage;
 
     // iterate through resource ids
-    for (i = 0; i < 2; ++i)
+    for (i = 0; i < TEXTURE_COUNT; ++i)
         // found the texture to get?
         if (pKey == g_ID[i].m_pKey)
             return &g_ID[i];
@@ -150,7 +163,7 @@ void OnDeleteTexture(const CSR_Texture* pTexture)
     size_t i;
 
     // iterate through resource ids
-    for (i = 0; i < 2; ++i)
+    for (i = 0; i < TEXTURE_COUNT; ++i)
         // found the texture to delete?
         if (pTexture == g_ID[i].m_pKey)
         {
@@ -191,6 +204,8 @@ void ApplyMatrix(float w, float h)
 //------------------------------------------------------------------------------
 void on_GLES2_Init(int view_w, int view_h)
 {
+    size_t           i;
+    size_t           index;
     CSR_VertexFormat vertexFormat;
     CSR_Material     material;
     CSR_PixelBuffer* pPixelBuffer = 0;
@@ -259,14 +274,11 @@ void on_GLES2_Init(int view_w, int view_h)
     // create the AABB tree for the mountain model
     g_pTree = csrAABBTreeFromMesh(g_pMesh);
 
-    // load landscape texture
-    pPixelBuffer       = csrPixelBufferFromBitmapFile(LANDSCAPE_TEXTURE_FILE);
-    g_ID[0].m_pKey     = &g_pMesh->m_Skin.m_Texture;
-    g_ID[0].m_ID       = csrOpenGLTextureFromPixelBuffer(pPixelBuffer);
-    g_ID[0].m_UseCount = 1;
-
-    // landscape texture will no longer be used
-    csrPixelBufferRelease(pPixelBuffer);
+    // load landscape texture. NOTE the landscape keeps it, it will be packed in the texture atlas
+    g_pMesh->m_Skin.m_Texture.m_pBuffer = csrPixelBufferFromBitmapFile(LANDSCAPE_TEXTURE_FILE);
+    g_ID[0].m_pKey                      = &g_pMesh->m_Skin.m_Texture;
+    g_ID[0].m_ID                        = M_CSR_Error_Code;
+    g_ID[0].m_UseCount                  = 1;
 
     // configure the vertex format
     vertexFormat.m_HasNormal         = 0;
@@ -276,6 +288,33 @@ void on_GLES2_Init(int view_w, int view_h)
     // load the MDL model
     g_pModel = csrMDLOpen(MDL_FILE, 0, &vertexFormat, 0, 0, 0, OnApplySkin, OnDeleteTexture);
 
+    // pack the landscape texture and the model skin in the same atlas page, thus the texture
+    // isn't rebound between them
+    g_pAtlas = csrTextureAtlasCreate(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, ATLAS_PADDING);
+
+    if (g_pMesh && csrMeshCanUseAtlas(g_pMesh))
+    {
+        index = csrTextureAtlasAdd(g_pAtlas, &g_pMesh->m_Skin.m_Texture);
+
+        if (index != (size_t)M_CSR_Unknown_Index)
+            csrMeshRemapToAtlas(g_pMesh, &g_pAtlas->m_pItem[index]);
+    }
+
+    csrMDLPackSkins(g_pModel, g_pAtlas);
+
+    // upload the atlas page. NOTE the landscape texture and the model skin fit on the same page
+    if (g_pAtlas && g_pAtlas->m_PageCount)
+    {
+        g_ID[2].m_pKey     = &g_pAtlas->m_pPage[0].m_Texture;
+        g_ID[2].m_ID       = csrOpenGLTextureFromPixelBuffer(g_pAtlas->m_pPage[0].m_Texture.m_pBuffer);
+        g_ID[2].m_UseCount = 1;
+    }
+
+    // upload the textures which couldn't be packed
+    for (i = 0; i < 2; ++i)
+        if (g_ID[i].m_pKey && !csrTextureAtlasGetPageTexture(g_pAtlas, (const CSR_Texture*)g_ID[i].m_pKey))
+            g_ID[i].m_ID = csrOpenGLTextureFromPixelBuffer(((const CSR_Texture*)g_ID[i].m_pKey)->m_pBuffer);
+
     csrSoundInitializeOpenAL(&g_pOpenALDevice, &g_pOpenALContext);
 
     // load step sound file
@@ -288,6 +327,10 @@ void on_GLES2_Final()
     csrMeshRelease(g_pMesh, OnDeleteTexture);
     g_pMesh = 0;
 
+    // delete the texture atlas
+    csrTextureAtlasRelease(g_pAtlas, OnDeleteTexture);
+    g_pAtlas = 0;
+
     // delete shader
     csrOpenGLShaderRelease(g_pShader);
     g_pShader = 0;
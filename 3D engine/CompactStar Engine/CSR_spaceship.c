@@ -491,27 +491,33 @@ void* OnGetShader(const void* pModel, CSR_EModelType type)
 {
     // flame or laser?
     if (pModel == g_pFlame || pModel == g_pLaser)
-    {
-        csrShaderEnable(g_pFlameShader);
+        return g_pFlameShader;
 
+    return g_pShader;
+}
+//---------------------------------------------------------------------------
+void OnDrawItem(const CSR_Scene*        pScene,
+                const CSR_SceneContext* pContext,
+                const CSR_SceneItem*    pItem,
+                      void*             pShader)
+{
+    // flame or laser?
+    if (pItem->m_pModel == g_pFlame || pItem->m_pModel == g_pLaser)
+    {
         // set alpha transparency level
-        if (pModel == g_pFlame)
+        if (pItem->m_pModel == g_pFlame)
             glUniform1f(g_AlphaSlot, g_Alpha * g_ShipAlpha);
         else
             glUniform1f(g_AlphaSlot, g_Alpha + 0.5f);
 
-        return g_pFlameShader;
+        return;
     }
 
-    csrShaderEnable(g_pShader);
-
     // spaceship?
-    if (pModel == g_Spaceship.m_pKey)
+    if (pItem->m_pModel == g_Spaceship.m_pKey)
         glUniform1f(g_TexAlphaSlot, g_ShipAlpha);
     else
         glUniform1f(g_TexAlphaSlot, 1.0f);
-
-    return g_pShader;
 }
 //---------------------------------------------------------------------------
 void* OnGetID(const void* pKey)
@@ -608,6 +614,7 @@ void on_GLES2_Init(int view_w, int view_h)
     // configure the scene context
     csrSceneContextInit(&g_SceneContext);
     g_SceneContext.m_fOnGetShader     = OnGetShader;
+    g_SceneContext.m_fOnDrawItem      = OnDrawItem;
     g_SceneContext.m_fOnGetID         = OnGetID;
     g_SceneContext.m_fOnDeleteTexture = OnDeleteTexture;
 
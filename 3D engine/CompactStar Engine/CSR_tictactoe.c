@@ -25,6 +25,7 @@
 // std
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
 
@@ -76,6 +77,24 @@ const char g_VSTextured[] =
     "    gl_Position   = csr_uProjection * csr_uView * csr_uModel * vec4(csr_aVertices, 1.0);"
     "}";
 //----------------------------------------------------------------------------
+// same as above, but the model matrix is read per instance, thus all the pawns are drawn at once
+const char g_VSTexturedInstanced[] =
+    "precision mediump float;"
+    "attribute vec3 csr_aVertices;"
+    "attribute vec4 csr_aColor;"
+    "attribute vec2 csr_aTexCoord;"
+    "attribute mat4 csr_aModel;"
+    "uniform   mat4 csr_uProjection;"
+    "uniform   mat4 csr_uView;"
+    "varying   vec4 csr_vColor;"
+    "varying   vec2 csr_vTexCoord;"
+    "void main(void)"
+    "{"
+    "    csr_vColor    = csr_aColor;"
+    "    csr_vTexCoord = csr_aTexCoord;"
+    "    gl_Position   = csr_uProjection * csr_uView * csr_aModel * vec4(csr_aVertices, 1.0);"
+    "}";
+//----------------------------------------------------------------------------
 const char g_FSTextured[] =
     "precision mediump float;"
     "uniform sampler2D csr_sColorMap;"
@@ -116,6 +135,7 @@ typedef struct
 } CSR_Cell;
 //------------------------------------------------------------------------------
 CSR_OpenGLShader* g_pShader         = 0;
+CSR_OpenGLShader* g_pInstShader     = 0;
 CSR_Scene*        g_pScene          = 0;
 CSR_Mesh*         g_pPlayfield      = 0;
 CSR_Mesh*         g_pCross          = 0;
@@ -420,9 +440,31 @@ void OnSceneEnd(const CSR_Scene* pScene, const CSR_SceneContext* pContext)
 //---------------------------------------------------------------------------
 void* OnGetShader(const void* pModel, CSR_EModelType type)
 {
+    // the pawns are drawn 9 times each, use the instanced shader for them if available. NOTE it
+    // is only created if the hardware instancing is supported, otherwise the default shader,
+    // which contains the model matrix uniform, is used
+    if (g_pInstShader && (pModel == g_pCross || pModel == g_pRound))
+        return g_pInstShader;
+
     return g_pShader;
 }
 //---------------------------------------------------------------------------
+int CanDrawInstanced(void)
+{
+    const char* pVersion = (const char*)glGetString(GL_VERSION);
+
+    // no version?
+    if (!pVersion)
+        return 0;
+
+    // skip the OpenGL ES prefix, if any
+    if (!strncmp(pVersion, "OpenGL ES ", 10))
+        pVersion += 10;
+
+    // the hardware instancing is available since OpenGL ES 3.0 (and OpenGL 3.1)
+    return (atoi(pVersion) >= 3);
+}
+//---------------------------------------------------------------------------
 void* OnGetID(const void* pKey)
 {
     size_t i;
@@ -532,6 +574,25 @@ void on_GLES2_Init(int view_w, int view_h)
     g_pShader->m_TexCoordSlot = glGetAttribLocation(g_pShader->m_ProgramID, "csr_aTexCoord");
     g_pShader->m_TextureSlot  = glGetAttribLocation(g_pShader->m_ProgramID, "csr_sTexture");
 
+    // compile and link the instanced shader. NOTE its slots are resolved while linked, and it
+    // cannot be used without hardware instancing, as it contains no model matrix uniform
+    #ifndef CSR_OPENGL_2_ONLY
+        if (CanDrawInstanced())
+            g_pInstShader = csrOpenGLShaderLoadFromStr(&g_VSTexturedInstanced[0],
+                                                        sizeof(g_VSTexturedInstanced),
+                                                       &g_FSTextured[0],
+                                                        sizeof(g_FSTextured),
+                                                        0,
+                                                        0);
+
+        // the per-instance model matrix wasn't found? Draw the pawns with the default shader
+        if (g_pInstShader && g_pInstShader->m_InstanceSlot < 0)
+        {
+            csrOpenGLShaderRelease(g_pInstShader);
+            g_pInstShader = 0;
+        }
+    #endif
+
     CreateViewport(view_w, view_h);
 
     // configure OpenGL depth testing
@@ -636,9 +697,12 @@ void on_GLES2_Final()
     // release the scene
     csrSceneRelease(g_pScene, OnDeleteTexture);
 
-    // delete shader program
+    // delete shader programs
     csrOpenGLShaderRelease(g_pShader);
     g_pShader = 0;
+
+    csrOpenGLShaderRelease(g_pInstShader);
+    g_pInstShader = 0;
 }
 //------------------------------------------------------------------------------
 void on_GLES2_Size(int view_w, int view_h)
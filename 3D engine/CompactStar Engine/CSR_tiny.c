@@ -64,6 +64,35 @@ const char g_VSTextured[] =
     "    gl_Position   = csr_uProjection * csr_uView * csr_uModel * vec4(csr_aVertices, 1.0);"
     "}";
 //----------------------------------------------------------------------------
+// same as above, but the vertices are skinned by the GPU. The palette contains a matrix for each
+// bone of the tiny model, the indices and weights of the 4 bones influencing a vertex are sent
+// with it, and the source mesh is drawn as is
+const char g_VSSkinned[] =
+    "precision mediump float;"
+    "attribute vec3 csr_aVertices;"
+    "attribute vec4 csr_aColor;"
+    "attribute vec2 csr_aTexCoord;"
+    "attribute vec4 csr_aBoneIndices;"
+    "attribute vec4 csr_aBoneWeights;"
+    "uniform   mat4 csr_uProjection;"
+    "uniform   mat4 csr_uView;"
+    "uniform   mat4 csr_uModel;"
+    "uniform   mat4 csr_uBones[35];"
+    "varying   vec4 csr_vColor;"
+    "varying   vec2 csr_vTexCoord;"
+    "void main(void)"
+    "{"
+    "    vec4 vertex   = vec4(csr_aVertices, 1.0);"
+    "    vec4 skinned  = csr_aBoneWeights.x * (csr_uBones[int(csr_aBoneIndices.x)] * vertex) +"
+    "                    csr_aBoneWeights.y * (csr_uBones[int(csr_aBoneIndices.y)] * vertex) +"
+    "                    csr_aBoneWeights.z * (csr_uBones[int(csr_aBoneIndices.z)] * vertex) +"
+    "                    csr_aBoneWeights.w * (csr_uBones[int(csr_aBoneIndices.w)] * vertex);"
+    "    skinned.w     = 1.0;"
+    "    csr_vColor    = csr_aColor;"
+    "    csr_vTexCoord = csr_aTexCoord;"
+    "    gl_Position   = csr_uProjection * csr_uView * csr_uModel * skinned;"
+    "}";
+//----------------------------------------------------------------------------
 const char g_FSTextured[] =
     "precision mediump float;"
     "uniform sampler2D csr_sColorMap;"
@@ -75,6 +104,7 @@ const char g_FSTextured[] =
     "}";
 //------------------------------------------------------------------------------
 CSR_OpenGLShader* g_pShader         = 0;
+CSR_OpenGLShader* g_pSkinShader     = 0;
 CSR_Scene*        g_pScene          = 0;
 CSR_X*            g_pModel          = 0;
 float             g_ScreenWidth     = 0.0f;
@@ -118,6 +148,10 @@ void OnApplySkin(size_t index, const CSR_Skin* pSkin, int* pCanRelease)
 //---------------------------------------------------------------------------
 void* OnGetShader(const void* pModel, CSR_EModelType type)
 {
+    // skin the model on the GPU if the skinning shader could be linked
+    if (g_pSkinShader)
+        return g_pSkinShader;
+
     return g_pShader;
 }
 //---------------------------------------------------------------------------
@@ -224,6 +258,15 @@ void on_GLES2_Init(int view_w, int view_h)
     g_pShader->m_TexCoordSlot = glGetAttribLocation(g_pShader->m_ProgramID, "csr_aTexCoord");
     g_pShader->m_TextureSlot  = glGetAttribLocation(g_pShader->m_ProgramID, "csr_sTexture");
 
+    // compile and link the skinning shader. NOTE its slots are resolved while linked. If the GPU
+    // cannot contain the bone palette, the link fails and the model is skinned on the CPU instead
+    g_pSkinShader = csrOpenGLShaderLoadFromStr(&g_VSSkinned[0],
+                                                sizeof(g_VSSkinned),
+                                               &g_FSTextured[0],
+                                                sizeof(g_FSTextured),
+                                                0,
+                                                0);
+
     CreateViewport(view_w, view_h);
 
     // configure OpenGL depth testing
@@ -262,6 +305,9 @@ void on_GLES2_Final()
     // delete shader program
     csrOpenGLShaderRelease(g_pShader);
     g_pShader = 0;
+
+    csrOpenGLShaderRelease(g_pSkinShader);
+    g_pSkinShader = 0;
 }
 //------------------------------------------------------------------------------
 void on_GLES2_Size(int view_w, int view_h)
@@ -180,7 +180,7 @@ void on_GLES2_Init(int view_w, int view_h)
                                             sizeof(g_FSTextured),
                                             0,
                                             0);
-    glUseProgram(g_pShader->m_ProgramID);
+    csrShaderEnable(g_pShader);
 
     // configure the shader slots
     g_pShader->m_VertexSlot   = glGetAttribLocation(g_pShader->m_ProgramID, "csr_aVertices");
@@ -17,7 +17,460 @@
 
 // std
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
+//---------------------------------------------------------------------------
+// Global values
+//---------------------------------------------------------------------------
+CSR_fOnLockAABBTree g_fOnLockAABBTree = 0;
+//---------------------------------------------------------------------------
+// Aligned-Axis Bounding Box tree private functions
+//---------------------------------------------------------------------------
+int csrAABBTreeNodeIsPending(const CSR_AABBNode* pNode)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+        // acquire the flag, thus the children published with it are complete when it's cleared
+        return __atomic_load_n(&pNode->m_Pending, __ATOMIC_ACQUIRE);
+    #else
+        int pending;
+
+        // no atomic operation available, read the flag under the lock, which is a full barrier
+        if (!g_fOnLockAABBTree)
+            return pNode->m_Pending;
+
+        g_fOnLockAABBTree(1);
+        pending = pNode->m_Pending;
+        g_fOnLockAABBTree(0);
+
+        return pending;
+    #endif
+}
+//---------------------------------------------------------------------------
+void csrAABBTreeNodeSetExpanded(CSR_AABBNode* pNode)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+        // release the flag, thus the children are complete before a reader sees it cleared
+        __atomic_store_n(&pNode->m_Pending, 0, __ATOMIC_RELEASE);
+    #else
+        // the flag is written under the lock, and read under the lock as well
+        pNode->m_Pending = 0;
+    #endif
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeNodeBuildTriangles(CSR_AABBNode* pNode)
+{
+    size_t       i;
+    size_t       j;
+    size_t       count;
+    float*       pData;
+    float        d00;
+    float        d01;
+    float        d11;
+    float        denom;
+    CSR_Vector3  e1;
+    CSR_Vector3  e2;
+    CSR_Plane    plane;
+    CSR_Polygon3 polygon;
+
+    // nothing to build?
+    if (!pNode->m_pPolygonBuffer || !pNode->m_pPolygonBuffer->m_Count)
+        return 1;
+
+    count = pNode->m_pPolygonBuffer->m_Count;
+
+    // create the leaf triangles
+    pNode->m_pTriangles = (CSR_AABBTriangles*)malloc(sizeof(CSR_AABBTriangles));
+
+    // succeeded?
+    if (!pNode->m_pTriangles)
+        return 0;
+
+    pNode->m_pTriangles->m_Count = count;
+    pNode->m_pTriangles->m_pData = (float*)malloc(CSR_TC_Count * count * sizeof(float));
+
+    // succeeded?
+    if (!pNode->m_pTriangles->m_pData)
+    {
+        free(pNode->m_pTriangles);
+        pNode->m_pTriangles = 0;
+        return 0;
+    }
+
+    pData = pNode->m_pTriangles->m_pData;
+
+    // iterate through the leaf polygons
+    for (i = 0; i < count; ++i)
+    {
+        // get the polygon from his vertex buffer, this is done only once here
+        csrIndexedPolygonToPolygon(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i], &polygon);
+
+        // copy the first vertex, the others are only needed to get the polygon back, and are read
+        // from the indexed polygon in this case
+        pData[(CSR_TC_Vertex1       * count) + i] = polygon.m_Vertex[0].m_X;
+        pData[((CSR_TC_Vertex1 + 1) * count) + i] = polygon.m_Vertex[0].m_Y;
+        pData[((CSR_TC_Vertex1 + 2) * count) + i] = polygon.m_Vertex[0].m_Z;
+
+        // calculate the triangle edges
+        csrVec3Sub(&polygon.m_Vertex[1], &polygon.m_Vertex[0], &e1);
+        csrVec3Sub(&polygon.m_Vertex[2], &polygon.m_Vertex[0], &e2);
+        csrVec3Dot(&e1, &e1, &d00);
+        csrVec3Dot(&e1, &e2, &d01);
+        csrVec3Dot(&e2, &e2, &d11);
+
+        denom = (d00 * d11) - (d01 * d01);
+
+        // degenerated triangle? Store a null plane, thus it will never be hit
+        if (!denom)
+        {
+            for (j = CSR_TC_EdgeU; j < CSR_TC_Count; ++j)
+                pData[(j * count) + i] = 0.0f;
+
+            continue;
+        }
+
+        // calculate the edge duals, thus a barycentric coordinate is a simple dot product
+        pData[(CSR_TC_EdgeU       * count) + i] = ((d11 * e1.m_X) - (d01 * e2.m_X)) / denom;
+        pData[((CSR_TC_EdgeU + 1) * count) + i] = ((d11 * e1.m_Y) - (d01 * e2.m_Y)) / denom;
+        pData[((CSR_TC_EdgeU + 2) * count) + i] = ((d11 * e1.m_Z) - (d01 * e2.m_Z)) / denom;
+        pData[(CSR_TC_EdgeV       * count) + i] = ((d00 * e2.m_X) - (d01 * e1.m_X)) / denom;
+        pData[((CSR_TC_EdgeV + 1) * count) + i] = ((d00 * e2.m_Y) - (d01 * e1.m_Y)) / denom;
+        pData[((CSR_TC_EdgeV + 2) * count) + i] = ((d00 * e2.m_Z) - (d01 * e1.m_Z)) / denom;
+
+        // calculate the triangle plane
+        csrPlaneFromPoints(&polygon.m_Vertex[0], &polygon.m_Vertex[1], &polygon.m_Vertex[2], &plane);
+
+        pData[(CSR_TC_Plane       * count) + i] = plane.m_A;
+        pData[((CSR_TC_Plane + 1) * count) + i] = plane.m_B;
+        pData[((CSR_TC_Plane + 2) * count) + i] = plane.m_C;
+        pData[((CSR_TC_Plane + 3) * count) + i] = plane.m_D;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTrianglesIntersectRay(const CSR_AABBTriangles* pTriangles,
+                                       size_t             index,
+                                 const CSR_Ray3*          pRay,
+                                       CSR_Vector3*       pR)
+{
+    float        dot;
+    float        dist;
+    float        u;
+    float        v;
+    float        wX;
+    float        wY;
+    float        wZ;
+    CSR_Vector3  point;
+    const size_t count = pTriangles->m_Count;
+    const float* pData = pTriangles->m_pData;
+    const float  a     = pData[(CSR_TC_Plane       * count) + index];
+    const float  b     = pData[((CSR_TC_Plane + 1) * count) + index];
+    const float  c     = pData[((CSR_TC_Plane + 2) * count) + index];
+    const float  d     = pData[((CSR_TC_Plane + 3) * count) + index];
+
+    // calculate the angle between the ray and the plane normal
+    dot = (a * pRay->m_Dir.m_X) + (b * pRay->m_Dir.m_Y) + (c * pRay->m_Dir.m_Z);
+
+    // ray parallel to the plane, or degenerated triangle?
+    if (!dot)
+        return 0;
+
+    // calculate the point where the ray crosses the plane (same as the ray-plane intersection)
+    dist      = (d + (a * pRay->m_Pos.m_X) + (b * pRay->m_Pos.m_Y) + (c * pRay->m_Pos.m_Z)) / dot;
+    point.m_X = pRay->m_Pos.m_X - (dist * pRay->m_Dir.m_X);
+    point.m_Y = pRay->m_Pos.m_Y - (dist * pRay->m_Dir.m_Y);
+    point.m_Z = pRay->m_Pos.m_Z - (dist * pRay->m_Dir.m_Z);
+
+    // get the point relatively to the first vertex
+    wX = point.m_X - pData[(CSR_TC_Vertex1       * count) + index];
+    wY = point.m_Y - pData[((CSR_TC_Vertex1 + 1) * count) + index];
+    wZ = point.m_Z - pData[((CSR_TC_Vertex1 + 2) * count) + index];
+
+    // calculate the barycentric coordinates
+    u = (wX * pData[(CSR_TC_EdgeU * count) + index])       +
+        (wY * pData[((CSR_TC_EdgeU + 1) * count) + index]) +
+        (wZ * pData[((CSR_TC_EdgeU + 2) * count) + index]);
+    v = (wX * pData[(CSR_TC_EdgeV * count) + index])       +
+        (wY * pData[((CSR_TC_EdgeV + 1) * count) + index]) +
+        (wZ * pData[((CSR_TC_EdgeV + 2) * count) + index]);
+
+    // is point outside the triangle?
+    if (u < -M_CSR_Epsilon || v < -M_CSR_Epsilon || (u + v) > 1.0f + M_CSR_Epsilon)
+        return 0;
+
+    if (pR)
+        *pR = point;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTrianglesIntersectSphere(const CSR_AABBTriangles* pTriangles,
+                                          size_t             index,
+                                    const CSR_Sphere*        pSphere,
+                                          int*               pInside)
+{
+    float        dist;
+    float        u;
+    float        v;
+    float        wX;
+    float        wY;
+    float        wZ;
+    const size_t count = pTriangles->m_Count;
+    const float* pData = pTriangles->m_pData;
+    const float  a     = pData[(CSR_TC_Plane       * count) + index];
+    const float  b     = pData[((CSR_TC_Plane + 1) * count) + index];
+    const float  c     = pData[((CSR_TC_Plane + 2) * count) + index];
+    const float  d     = pData[((CSR_TC_Plane + 3) * count) + index];
+
+    *pInside = 0;
+
+    // degenerated triangle?
+    if (!a && !b && !c)
+        return 0;
+
+    // calculate the distance between the sphere center and the triangle plane
+    dist = (a * pSphere->m_Center.m_X) + (b * pSphere->m_Center.m_Y) + (c * pSphere->m_Center.m_Z) + d;
+
+    // is the sphere too far from the plane?
+    if (dist > pSphere->m_Radius || dist < -pSphere->m_Radius)
+        return 0;
+
+    // project the sphere center on the plane, relatively to the first vertex
+    wX = pSphere->m_Center.m_X - (dist * a) - pData[(CSR_TC_Vertex1       * count) + index];
+    wY = pSphere->m_Center.m_Y - (dist * b) - pData[((CSR_TC_Vertex1 + 1) * count) + index];
+    wZ = pSphere->m_Center.m_Z - (dist * c) - pData[((CSR_TC_Vertex1 + 2) * count) + index];
+
+    // calculate the barycentric coordinates
+    u = (wX * pData[(CSR_TC_EdgeU * count) + index])       +
+        (wY * pData[((CSR_TC_EdgeU + 1) * count) + index]) +
+        (wZ * pData[((CSR_TC_EdgeU + 2) * count) + index]);
+    v = (wX * pData[(CSR_TC_EdgeV * count) + index])       +
+        (wY * pData[((CSR_TC_EdgeV + 1) * count) + index]) +
+        (wZ * pData[((CSR_TC_EdgeV + 2) * count) + index]);
+
+    // is the projected center inside the triangle? Otherwise the sphere may still touch an edge
+    *pInside = (u >= -M_CSR_Epsilon && v >= -M_CSR_Epsilon && (u + v) <= 1.0f + M_CSR_Epsilon);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeGroundHit(const CSR_Ray3*      pRay,
+                         const CSR_AABBNode*  pNode,
+                               CSR_Polygon3*  pPolygon,
+                               CSR_Vector3*   pR)
+{
+    size_t       i;
+    CSR_Figure3  ray;
+    CSR_Figure3  box;
+    CSR_Figure3  polygon;
+
+    // is a lazy node visited for the first time? Expand it before going further
+    if (!csrAABBTreeNodeExpand((CSR_AABBNode*)pNode))
+        return 0;
+
+    // is leaf?
+    if (!pNode->m_pLeft && !pNode->m_pRight)
+    {
+        // do use the precomputed triangles?
+        if (pNode->m_pTriangles)
+        {
+            for (i = 0; i < pNode->m_pTriangles->m_Count; ++i)
+                if (csrAABBTrianglesIntersectRay(pNode->m_pTriangles, i, pRay, pR))
+                    return csrIndexedPolygonToPolygon(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i], pPolygon);
+
+            return 0;
+        }
+
+        ray.m_Type        =  CSR_F3_Ray;
+        ray.m_pFigure     =  pRay;
+        polygon.m_Type    =  CSR_F3_Polygon;
+        polygon.m_pFigure =  pPolygon;
+
+        // iterate through the leaf polygons
+        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+        {
+            // get the polygon from his vertex buffer
+            if (!csrIndexedPolygonToPolygon(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i], pPolygon))
+                return 0;
+
+            // check if the ground ray hits the polygon
+            if (csrIntersect3(&ray, &polygon, pR, 0, 0))
+                return 1;
+        }
+
+        return 0;
+    }
+
+    // convert ray to geometric figure
+    ray.m_Type    = CSR_F3_Ray;
+    ray.m_pFigure = pRay;
+    box.m_Type    = CSR_F3_Box;
+
+    // check the left child, then the right one
+    if (pNode->m_pLeft)
+    {
+        box.m_pFigure = pNode->m_pLeft->m_pBox;
+
+        if (csrIntersect3(&ray, &box, 0, 0, 0) && csrAABBTreeGroundHit(pRay, pNode->m_pLeft, pPolygon, pR))
+            return 1;
+    }
+
+    if (pNode->m_pRight)
+    {
+        box.m_pFigure = pNode->m_pRight->m_pBox;
+
+        if (csrIntersect3(&ray, &box, 0, 0, 0) && csrAABBTreeGroundHit(pRay, pNode->m_pRight, pPolygon, pR))
+            return 1;
+    }
+
+    return 0;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeNodeLazyPopulate(CSR_IndexedPolygonBuffer* pIPB, CSR_AABBNode* pNode)
+{
+    size_t       i;
+    CSR_Polygon3 polygon;
+    int          boxEmpty = 1;
+
+    // initialize node content
+    pNode->m_pParent        = 0;
+    pNode->m_pLeft          = 0;
+    pNode->m_pRight         = 0;
+    pNode->m_pBox           = (CSR_Box*)malloc(sizeof(CSR_Box));
+    pNode->m_pPolygonBuffer = pIPB;
+    pNode->m_pTriangles     = 0;
+    pNode->m_Pending        = 1;
+
+    // succeeded?
+    if (!pNode->m_pBox)
+        return 0;
+
+    // iterate through polygons the node will own, and extend the bounding box to include them.
+    // NOTE the box should be known before the node is expanded, because the parent tests it
+    for (i = 0; i < pIPB->m_Count; ++i)
+    {
+        csrIndexedPolygonToPolygon(&pIPB->m_pIndexedPolygon[i], &polygon);
+        csrBoxExtendToPolygon(&polygon, pNode->m_pBox, &boxEmpty);
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeNodeLazySplit(CSR_AABBNode* pNode)
+{
+    size_t                    i;
+    size_t                    j;
+    CSR_Box                   leftBox;
+    CSR_Box                   rightBox;
+    CSR_Polygon3              polygon;
+    CSR_IndexedPolygonBuffer* pLeftPolygons;
+    CSR_IndexedPolygonBuffer* pRightPolygons;
+    int                       insideLeft;
+    int                       insideRight;
+    int                       success;
+
+    // create the polygon buffers that will contain the divided polygons
+    pLeftPolygons  = csrIndexedPolygonBufferCreate();
+    pRightPolygons = csrIndexedPolygonBufferCreate();
+
+    // succeeded?
+    if (!pLeftPolygons || !pRightPolygons)
+    {
+        csrIndexedPolygonBufferRelease(pLeftPolygons);
+        csrIndexedPolygonBufferRelease(pRightPolygons);
+        return 0;
+    }
+
+    // divide the bounding box in 2 sub-boxes
+    csrBoxCut(pNode->m_pBox, &leftBox, &rightBox);
+
+    // iterate through polygons to divide
+    for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+    {
+        // get the concrete polygon (i.e. with physical coordinates, not indexes)
+        csrIndexedPolygonToPolygon(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i], &polygon);
+
+        insideLeft  = 0;
+        insideRight = 0;
+
+        // check which box contains the most vertices
+        for (j = 0; j < 3; ++j)
+            // is vertex inside left or right sub-box?
+            if (csrInsideBox(&polygon.m_Vertex[j], &leftBox))
+                ++insideLeft;
+            else
+                ++insideRight;
+
+        // add the polygon to the sub-box containing the most vertices
+        if (insideLeft >= insideRight)
+            success = csrIndexedPolygonBufferAdd(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i],
+                                                 pLeftPolygons);
+        else
+            success = csrIndexedPolygonBufferAdd(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i],
+                                                 pRightPolygons);
+
+        // succeeded?
+        if (!success)
+        {
+            csrIndexedPolygonBufferRelease(pLeftPolygons);
+            csrIndexedPolygonBufferRelease(pRightPolygons);
+            return 0;
+        }
+    }
+
+    // leaf reached? (i.e. all the polygons belong to the same side)
+    if (!pLeftPolygons->m_Count || !pRightPolygons->m_Count)
+    {
+        // the node keeps his polygons
+        csrIndexedPolygonBufferRelease(pLeftPolygons);
+        csrIndexedPolygonBufferRelease(pRightPolygons);
+
+        // precompute the leaf triangles
+        return csrAABBTreeNodeBuildTriangles(pNode);
+    }
+
+    // create the children
+    pNode->m_pLeft  = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+    pNode->m_pRight = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+
+    // succeeded?
+    if (!pNode->m_pLeft || !pNode->m_pRight)
+    {
+        free(pNode->m_pLeft);
+        free(pNode->m_pRight);
+        pNode->m_pLeft  = 0;
+        pNode->m_pRight = 0;
+
+        csrIndexedPolygonBufferRelease(pLeftPolygons);
+        csrIndexedPolygonBufferRelease(pRightPolygons);
+        return 0;
+    }
+
+    // populate them, their polygon buffers are owned by the children from now
+    success  = csrAABBTreeNodeLazyPopulate(pLeftPolygons,  pNode->m_pLeft);
+    success &= csrAABBTreeNodeLazyPopulate(pRightPolygons, pNode->m_pRight);
+
+    pNode->m_pLeft->m_pParent  = pNode;
+    pNode->m_pRight->m_pParent = pNode;
+
+    // succeeded?
+    if (!success)
+    {
+        csrAABBTreeNodeRelease(pNode->m_pLeft);
+        csrAABBTreeNodeRelease(pNode->m_pRight);
+        pNode->m_pLeft  = 0;
+        pNode->m_pRight = 0;
+        return 0;
+    }
+
+    // the polygons are now owned by the children, the node behaves as a normal parent node
+    free(pNode->m_pPolygonBuffer->m_pIndexedPolygon);
+    pNode->m_pPolygonBuffer->m_pIndexedPolygon = 0;
+    pNode->m_pPolygonBuffer->m_Count           = 0;
+
+    return 1;
+}
 //---------------------------------------------------------------------------
 // Aligned-Axis Bounding Box tree functions
 //---------------------------------------------------------------------------
@@ -53,6 +506,8 @@ int csrAABBTreeFromIndexedPolygonBuffer(const CSR_IndexedPolygonBuffer* pIPB,
     pNode->m_pRight         = 0;
     pNode->m_pBox           = (CSR_Box*)malloc(sizeof(CSR_Box));
     pNode->m_pPolygonBuffer = csrIndexedPolygonBufferCreate();
+    pNode->m_pTriangles     = 0;
+    pNode->m_Pending        = 0;
 
     // succeeded?
     if (!pNode->m_pBox || !pNode->m_pPolygonBuffer)
@@ -215,6 +670,13 @@ int csrAABBTreeFromIndexedPolygonBuffer(const CSR_IndexedPolygonBuffer* pIPB,
         csrIndexedPolygonBufferRelease(pLeftPolygons);
         csrIndexedPolygonBufferRelease(pRightPolygons);
 
+        // precompute the leaf triangles
+        if (!csrAABBTreeNodeBuildTriangles(pNode))
+        {
+            csrAABBTreeNodeContentRelease(pNode);
+            return 0;
+        }
+
         return 1;
     }
 
@@ -293,6 +755,89 @@ CSR_AABBNode* csrAABBTreeFromMesh(const CSR_Mesh* pMesh)
     return pRoot;
 }
 //---------------------------------------------------------------------------
+CSR_AABBNode* csrAABBTreeFromMeshLazy(const CSR_Mesh* pMesh)
+{
+    CSR_AABBNode* pRoot;
+
+    // get indexed polygon buffer from mesh
+    CSR_IndexedPolygonBuffer* pIPB = csrIndexedPolygonBufferFromMesh(pMesh);
+
+    // succeeded?
+    if (!pIPB)
+        return 0;
+
+    // create the root node
+    pRoot = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+
+    // succeeded?
+    if (!pRoot)
+    {
+        csrIndexedPolygonBufferRelease(pIPB);
+        return 0;
+    }
+
+    // populate the root node, which takes the ownership of the polygon buffer, then split it.
+    // The children will only be expanded when a query will descend into them
+    if (!csrAABBTreeNodeLazyPopulate(pIPB, pRoot) || !csrAABBTreeNodeExpand(pRoot))
+    {
+        csrAABBTreeNodeRelease(pRoot);
+        return 0;
+    }
+
+    return pRoot;
+}
+//---------------------------------------------------------------------------
+CSR_AABBNode* csrAABBTreeFromMeshMode(const CSR_Mesh* pMesh, CSR_EAABBTreeMode mode)
+{
+    switch (mode)
+    {
+        case CSR_AM_Full: return csrAABBTreeFromMesh(pMesh);
+        case CSR_AM_Lazy: return csrAABBTreeFromMeshLazy(pMesh);
+        default:          return 0;
+    }
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeNodeExpand(CSR_AABBNode* pNode)
+{
+    int success;
+
+    // no node?
+    if (!pNode)
+        return 0;
+
+    // already expanded? NOTE the flag may be cleared by another thread at any time, thus it's
+    // never read without synchronization
+    if (!csrAABBTreeNodeIsPending(pNode))
+        return 1;
+
+    // lock the tree
+    if (g_fOnLockAABBTree)
+        g_fOnLockAABBTree(1);
+
+    success = 1;
+
+    // check again, another thread may have expanded the node while the tree was locked
+    if (pNode->m_Pending)
+    {
+        success = csrAABBTreeNodeLazySplit(pNode);
+
+        // IMPORTANT the node should be marked as expanded only once his children are complete
+        if (success)
+            csrAABBTreeNodeSetExpanded(pNode);
+    }
+
+    // unlock the tree
+    if (g_fOnLockAABBTree)
+        g_fOnLockAABBTree(0);
+
+    return success;
+}
+//---------------------------------------------------------------------------
+void csrAABBTreeSetLockFunction(CSR_fOnLockAABBTree fOnLock)
+{
+    g_fOnLockAABBTree = fOnLock;
+}
+//---------------------------------------------------------------------------
 int csrAABBTreeResolve(const CSR_Ray3*           pRay,
                        const CSR_AABBNode*       pNode,
                              size_t              deep,
@@ -325,29 +870,39 @@ int csrAABBTreeResolve(const CSR_Ray3*           pRay,
         pPolygons->m_Count    = 0;
     }
 
+    // is a lazy node visited for the first time? Expand it before going further. NOTE the node
+    // content is completed here, his geometry remains unchanged
+    if (!csrAABBTreeNodeExpand((CSR_AABBNode*)pNode))
+        return 0;
+
     // is leaf?
     if (!pNode->m_pLeft && !pNode->m_pRight)
     {
-        // iterate through polygons contained in leaf
-        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
-        {
-            // allocate memory for a new polygon in the buffer
-            pPolygonBuffer = (CSR_Polygon3*)csrMemoryAlloc(pPolygons->m_pPolygon,
-                                                           sizeof(CSR_Polygon3),
-                                                           pPolygons->m_Count + 1);
+        // empty leaf?
+        if (!pNode->m_pPolygonBuffer->m_Count)
+            return 1;
 
-            // succeeded?
-            if (!pPolygonBuffer)
-                return 0;
+        // allocate memory for all the leaf polygons at once
+        pPolygonBuffer = (CSR_Polygon3*)csrMemoryAlloc(pPolygons->m_pPolygon,
+                                                       sizeof(CSR_Polygon3),
+                                                       pPolygons->m_Count + pNode->m_pPolygonBuffer->m_Count);
 
-            // update the polygon buffer
-            pPolygons->m_pPolygon = pPolygonBuffer;
-            ++pPolygons->m_Count;
+        // succeeded?
+        if (!pPolygonBuffer)
+            return 0;
 
+        // update the polygon buffer
+        pPolygons->m_pPolygon = pPolygonBuffer;
+
+        // iterate through polygons contained in leaf
+        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+        {
             // copy the polygon content
             if (!csrIndexedPolygonToPolygon(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i],
-                                            &pPolygons->m_pPolygon[pPolygons->m_Count - 1]))
+                                            &pPolygons->m_pPolygon[pPolygons->m_Count]))
                 return 0;
+
+            ++pPolygons->m_Count;
         }
 
         return 1;
@@ -386,6 +941,88 @@ int csrAABBTreeResolve(const CSR_Ray3*           pRay,
     return (leftResolved || rightResolved);
 }
 //---------------------------------------------------------------------------
+int csrAABBTreeSphereHit(const CSR_Sphere*   pSphere,
+                         const CSR_AABBNode* pNode,
+                               CSR_Polygon3* pPolygon,
+                               CSR_Plane*    pPlane)
+{
+    size_t      i;
+    int         inside;
+    CSR_Figure3 sphere;
+    CSR_Figure3 box;
+    CSR_Figure3 polygon;
+
+    // validate the inputs
+    if (!pSphere || !pNode || !pPolygon)
+        return 0;
+
+    // is a lazy node visited for the first time? Expand it before going further
+    if (!csrAABBTreeNodeExpand((CSR_AABBNode*)pNode))
+        return 0;
+
+    sphere.m_Type    = CSR_F3_Sphere;
+    sphere.m_pFigure = pSphere;
+
+    // is leaf?
+    if (!pNode->m_pLeft && !pNode->m_pRight)
+    {
+        polygon.m_Type    = CSR_F3_Polygon;
+        polygon.m_pFigure = pPolygon;
+
+        // iterate through the leaf polygons
+        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+        {
+            // do use the precomputed triangles? If yes, reject the polygons whose plane is out of
+            // the sphere without reading them
+            if (pNode->m_pTriangles && !csrAABBTrianglesIntersectSphere(pNode->m_pTriangles, i, pSphere, &inside))
+                continue;
+
+            // get the polygon from his vertex buffer
+            if (!csrIndexedPolygonToPolygon(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i], pPolygon))
+                return 0;
+
+            // is the sphere center above the triangle? In this case the plane is the sliding one
+            if (pNode->m_pTriangles && inside)
+            {
+                if (pPlane)
+                    csrPlaneFromPoints(&pPolygon->m_Vertex[0],
+                                       &pPolygon->m_Vertex[1],
+                                       &pPolygon->m_Vertex[2],
+                                        pPlane);
+
+                return 1;
+            }
+
+            // check if the sphere hits the polygon, or one of his edges
+            if (csrIntersect3(&sphere, &polygon, 0, 0, pPlane))
+                return 1;
+        }
+
+        return 0;
+    }
+
+    box.m_Type = CSR_F3_Box;
+
+    // check the left child, then the right one
+    if (pNode->m_pLeft)
+    {
+        box.m_pFigure = pNode->m_pLeft->m_pBox;
+
+        if (csrIntersect3(&sphere, &box, 0, 0, 0) && csrAABBTreeSphereHit(pSphere, pNode->m_pLeft, pPolygon, pPlane))
+            return 1;
+    }
+
+    if (pNode->m_pRight)
+    {
+        box.m_pFigure = pNode->m_pRight->m_pBox;
+
+        if (csrIntersect3(&sphere, &box, 0, 0, 0) && csrAABBTreeSphereHit(pSphere, pNode->m_pRight, pPolygon, pPlane))
+            return 1;
+    }
+
+    return 0;
+}
+//---------------------------------------------------------------------------
 void csrAABBTreeNodeContentRelease(CSR_AABBNode* pNode)
 {
     // release the bounding box
@@ -405,6 +1042,17 @@ void csrAABBTreeNodeContentRelease(CSR_AABBNode* pNode)
         free(pNode->m_pPolygonBuffer);
         pNode->m_pPolygonBuffer = 0;
     }
+
+    // release the precomputed triangles
+    if (pNode->m_pTriangles)
+    {
+        // release the triangles content
+        if (pNode->m_pTriangles->m_pData)
+            free(pNode->m_pTriangles->m_pData);
+
+        free(pNode->m_pTriangles);
+        pNode->m_pTriangles = 0;
+    }
 }
 //---------------------------------------------------------------------------
 void csrAABBTreeNodeRelease(CSR_AABBNode* pNode)
@@ -427,6 +1075,456 @@ void csrAABBTreeNodeRelease(CSR_AABBNode* pNode)
     free(pNode);
 }
 //---------------------------------------------------------------------------
+// Quantized Aligned-Axis Bounding Box tree private functions
+//---------------------------------------------------------------------------
+float csrQAABBTreeDecode(float min, float max, unsigned short value)
+{
+    const float t = (float)value / 65535.0f;
+
+    // NOTE written as an interpolation, thus 0 and 65535 return exactly the min and max values
+    return (min * (1.0f - t)) + (max * t);
+}
+//---------------------------------------------------------------------------
+void csrQAABBTreeQuantize(const CSR_Box*        pBox,
+                          const CSR_Box*        pFrame,
+                                unsigned short* pMin,
+                                unsigned short* pMax,
+                                CSR_Box*        pDecoded)
+{
+    size_t i;
+    float  value[6];
+    float  boxMin[3];
+    float  boxMax[3];
+    float  frameMin[3];
+    float  frameMax[3];
+    float  extent;
+    float  scale;
+    long   qMin;
+    long   qMax;
+
+    boxMin[0]   = pBox->m_Min.m_X;   boxMin[1]   = pBox->m_Min.m_Y;   boxMin[2]   = pBox->m_Min.m_Z;
+    boxMax[0]   = pBox->m_Max.m_X;   boxMax[1]   = pBox->m_Max.m_Y;   boxMax[2]   = pBox->m_Max.m_Z;
+    frameMin[0] = pFrame->m_Min.m_X; frameMin[1] = pFrame->m_Min.m_Y; frameMin[2] = pFrame->m_Min.m_Z;
+    frameMax[0] = pFrame->m_Max.m_X; frameMax[1] = pFrame->m_Max.m_Y; frameMax[2] = pFrame->m_Max.m_Z;
+
+    for (i = 0; i < 3; ++i)
+    {
+        extent = frameMax[i] - frameMin[i];
+        scale  = (extent > 0.0f) ? (65535.0f / extent) : 0.0f;
+
+        // quantize the box, rounding the min value down and the max value up
+        qMin = (long)floor((boxMin[i] - frameMin[i]) * scale);
+        qMax = (long)ceil ((boxMax[i] - frameMin[i]) * scale);
+
+        // clamp the values in the frame
+        qMin = qMin < 0 ? 0 : (qMin > 65535 ? 65535 : qMin);
+        qMax = qMax < 0 ? 0 : (qMax > 65535 ? 65535 : qMax);
+
+        // the quantization should be conservative, i.e. the decoded box should always contain
+        // the source box. Fix the rounding errors if required
+        while (qMin > 0 && csrQAABBTreeDecode(frameMin[i], frameMax[i], (unsigned short)qMin) > boxMin[i])
+            --qMin;
+
+        while (qMax < 65535 && csrQAABBTreeDecode(frameMin[i], frameMax[i], (unsigned short)qMax) < boxMax[i])
+            ++qMax;
+
+        pMin[i] = (unsigned short)qMin;
+        pMax[i] = (unsigned short)qMax;
+
+        value[i]     = csrQAABBTreeDecode(frameMin[i], frameMax[i], pMin[i]);
+        value[i + 3] = csrQAABBTreeDecode(frameMin[i], frameMax[i], pMax[i]);
+    }
+
+    // get the decoded box, which the children will be quantized in
+    pDecoded->m_Min.m_X = value[0];
+    pDecoded->m_Min.m_Y = value[1];
+    pDecoded->m_Min.m_Z = value[2];
+    pDecoded->m_Max.m_X = value[3];
+    pDecoded->m_Max.m_Y = value[4];
+    pDecoded->m_Max.m_Z = value[5];
+}
+//---------------------------------------------------------------------------
+void csrQAABBTreeDecodeBox(const CSR_QAABBNode* pNode,
+                                 size_t         index,
+                           const CSR_Box*       pFrame,
+                                 CSR_Box*       pBox)
+{
+    pBox->m_Min.m_X = csrQAABBTreeDecode(pFrame->m_Min.m_X, pFrame->m_Max.m_X, pNode->m_Min[index][0]);
+    pBox->m_Min.m_Y = csrQAABBTreeDecode(pFrame->m_Min.m_Y, pFrame->m_Max.m_Y, pNode->m_Min[index][1]);
+    pBox->m_Min.m_Z = csrQAABBTreeDecode(pFrame->m_Min.m_Z, pFrame->m_Max.m_Z, pNode->m_Min[index][2]);
+    pBox->m_Max.m_X = csrQAABBTreeDecode(pFrame->m_Min.m_X, pFrame->m_Max.m_X, pNode->m_Max[index][0]);
+    pBox->m_Max.m_Y = csrQAABBTreeDecode(pFrame->m_Min.m_Y, pFrame->m_Max.m_Y, pNode->m_Max[index][1]);
+    pBox->m_Max.m_Z = csrQAABBTreeDecode(pFrame->m_Min.m_Z, pFrame->m_Max.m_Z, pNode->m_Max[index][2]);
+}
+//---------------------------------------------------------------------------
+int csrQAABBTreeAddPolygons(const CSR_AABBNode*   pLeaf,
+                                  CSR_QAABBTree*  pTree,
+                                  unsigned*       pFirst,
+                                  unsigned short* pCount)
+{
+    size_t            i;
+    size_t            j;
+    size_t            vbIndex;
+    CSR_QAABBPolygon* pPolygons;
+    const size_t      count = pLeaf->m_pPolygonBuffer ? pLeaf->m_pPolygonBuffer->m_Count : 0;
+
+    // the leaf polygon count should fit in the node
+    if (count > 0xFFFF)
+        return 0;
+
+    *pFirst = (unsigned)pTree->m_PolygonCount;
+    *pCount = (unsigned short)count;
+
+    if (!count)
+        return 1;
+
+    // add the leaf polygons at the end of the polygon list
+    pPolygons = (CSR_QAABBPolygon*)csrMemoryAlloc(pTree->m_pPolygon,
+                                                  sizeof(CSR_QAABBPolygon),
+                                                  pTree->m_PolygonCount + count);
+
+    // succeeded?
+    if (!pPolygons)
+        return 0;
+
+    pTree->m_pPolygon = pPolygons;
+
+    for (i = 0; i < count; ++i)
+    {
+        const CSR_IndexedPolygon* pSrc = &pLeaf->m_pPolygonBuffer->m_pIndexedPolygon[i];
+
+        // the polygon should belong to the mesh
+        if (pSrc->m_pVB < pTree->m_pMesh->m_pVB)
+            return 0;
+
+        vbIndex = (size_t)(pSrc->m_pVB - pTree->m_pMesh->m_pVB);
+
+        if (vbIndex >= pTree->m_pMesh->m_Count)
+            return 0;
+
+        pPolygons[pTree->m_PolygonCount].m_VBIndex = (unsigned)vbIndex;
+
+        for (j = 0; j < 3; ++j)
+            pPolygons[pTree->m_PolygonCount].m_Index[j] = (unsigned)pSrc->m_pIndex[j];
+
+        ++pTree->m_PolygonCount;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrQAABBTreeAddNode(const CSR_AABBNode*  pNode,
+                        const CSR_Box*       pFrame,
+                              CSR_QAABBTree* pTree,
+                              unsigned*      pIndex)
+{
+    size_t              i;
+    size_t              slotCount = 0;
+    unsigned            index;
+    unsigned            childIndex;
+    CSR_Box             decoded;
+    CSR_QAABBNode*      pNodes;
+    const CSR_AABBNode* pSlot[4];
+    const CSR_AABBNode* pChild[2];
+
+    // collapse the binary node in a node containing up to 4 children. If the node is a leaf
+    // (may only happen for the root), it becomes the only child of the new node
+    if (!pNode->m_pLeft && !pNode->m_pRight)
+        pSlot[slotCount++] = pNode;
+    else
+    {
+        pChild[0] = pNode->m_pLeft;
+        pChild[1] = pNode->m_pRight;
+
+        for (i = 0; i < 2; ++i)
+        {
+            if (!pChild[i])
+                continue;
+
+            // expand the lazy children, if any
+            if (!csrAABBTreeNodeExpand((CSR_AABBNode*)pChild[i]))
+                return 0;
+
+            // child is a leaf? Keep it, otherwise take his own children instead
+            if (!pChild[i]->m_pLeft && !pChild[i]->m_pRight)
+                pSlot[slotCount++] = pChild[i];
+            else
+            {
+                if (pChild[i]->m_pLeft)
+                    pSlot[slotCount++] = pChild[i]->m_pLeft;
+
+                if (pChild[i]->m_pRight)
+                    pSlot[slotCount++] = pChild[i]->m_pRight;
+            }
+        }
+    }
+
+    // reserve the node. NOTE the nodes may move while the children are added, so only his
+    // index may be kept
+    pNodes = (CSR_QAABBNode*)csrMemoryAlloc(pTree->m_pNode,
+                                            sizeof(CSR_QAABBNode),
+                                            pTree->m_NodeCount + 1);
+
+    // succeeded?
+    if (!pNodes)
+        return 0;
+
+    pTree->m_pNode = pNodes;
+    index          = (unsigned)pTree->m_NodeCount;
+    ++pTree->m_NodeCount;
+
+    // initialize the node
+    memset(&pTree->m_pNode[index], 0, sizeof(CSR_QAABBNode));
+
+    for (i = 0; i < 4; ++i)
+        pTree->m_pNode[index].m_Child[i] = M_CSR_Error_Code;
+
+    // iterate through the node children
+    for (i = 0; i < slotCount; ++i)
+    {
+        // expand the lazy child, if any
+        if (!csrAABBTreeNodeExpand((CSR_AABBNode*)pSlot[i]))
+            return 0;
+
+        // quantize the child box in the node box
+        csrQAABBTreeQuantize(pSlot[i]->m_pBox,
+                             pFrame,
+                             pTree->m_pNode[index].m_Min[i],
+                             pTree->m_pNode[index].m_Max[i],
+                            &decoded);
+
+        // is leaf?
+        if (!pSlot[i]->m_pLeft && !pSlot[i]->m_pRight)
+        {
+            pTree->m_pNode[index].m_Leaf[i] = 1;
+
+            if (!csrQAABBTreeAddPolygons(pSlot[i],
+                                         pTree,
+                                        &pTree->m_pNode[index].m_Child[i],
+                                        &pTree->m_pNode[index].m_Count[i]))
+                return 0;
+
+            continue;
+        }
+
+        // add the child node, his own children are quantized in his decoded box
+        if (!csrQAABBTreeAddNode(pSlot[i], &decoded, pTree, &childIndex))
+            return 0;
+
+        pTree->m_pNode[index].m_Child[i] = childIndex;
+    }
+
+    *pIndex = index;
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrQAABBTreeResolveNode(const CSR_Figure3*        pRay,
+                            const CSR_QAABBTree*      pTree,
+                                  unsigned            index,
+                            const CSR_Box*            pFrame,
+                                  CSR_Polygon3Buffer* pPolygons)
+{
+    size_t               i;
+    size_t               j;
+    int                  result = 0;
+    CSR_Box              box;
+    CSR_Figure3          boxFigure;
+    CSR_IndexedPolygon   polygon;
+    CSR_Polygon3*        pPolygonBuffer;
+    const CSR_QAABBNode* pNode = &pTree->m_pNode[index];
+
+    boxFigure.m_Type    =  CSR_F3_Box;
+    boxFigure.m_pFigure = &box;
+
+    // iterate through the node children
+    for (i = 0; i < 4; ++i)
+    {
+        // unused child?
+        if (pNode->m_Child[i] == M_CSR_Error_Code)
+            continue;
+
+        // decode the child box
+        csrQAABBTreeDecodeBox(pNode, i, pFrame, &box);
+
+        // check if ray intersects the child box
+        if (!csrIntersect3(pRay, &boxFigure, 0, 0, 0))
+            continue;
+
+        // is a node?
+        if (!pNode->m_Leaf[i])
+        {
+            // resolve it, NOTE the box is copied because it will be reused for the next children
+            const CSR_Box frame = box;
+            result |= csrQAABBTreeResolveNode(pRay, pTree, pNode->m_Child[i], &frame, pPolygons);
+            continue;
+        }
+
+        // empty leaf?
+        if (!pNode->m_Count[i])
+            continue;
+
+        // allocate memory for the leaf polygons
+        pPolygonBuffer = (CSR_Polygon3*)csrMemoryAlloc(pPolygons->m_pPolygon,
+                                                       sizeof(CSR_Polygon3),
+                                                       pPolygons->m_Count + pNode->m_Count[i]);
+
+        // succeeded?
+        if (!pPolygonBuffer)
+            return 0;
+
+        pPolygons->m_pPolygon = pPolygonBuffer;
+
+        // iterate through the leaf polygons
+        for (j = 0; j < pNode->m_Count[i]; ++j)
+        {
+            const CSR_QAABBPolygon* pSrc = &pTree->m_pPolygon[pNode->m_Child[i] + j];
+
+            // get the polygon from his vertex buffer
+            polygon.m_pVB       = &pTree->m_pMesh->m_pVB[pSrc->m_VBIndex];
+            polygon.m_pIndex[0] =  pSrc->m_Index[0];
+            polygon.m_pIndex[1] =  pSrc->m_Index[1];
+            polygon.m_pIndex[2] =  pSrc->m_Index[2];
+
+            if (!csrIndexedPolygonToPolygon(&polygon, &pPolygons->m_pPolygon[pPolygons->m_Count]))
+                return 0;
+
+            ++pPolygons->m_Count;
+        }
+
+        result = 1;
+    }
+
+    return result;
+}
+//---------------------------------------------------------------------------
+// Quantized Aligned-Axis Bounding Box tree functions
+//---------------------------------------------------------------------------
+CSR_QAABBTree* csrQAABBTreeCreate(void)
+{
+    // create a new quantized tree
+    CSR_QAABBTree* pTree = (CSR_QAABBTree*)malloc(sizeof(CSR_QAABBTree));
+
+    // succeeded?
+    if (!pTree)
+        return 0;
+
+    // initialize the tree content
+    csrQAABBTreeInit(pTree);
+
+    return pTree;
+}
+//---------------------------------------------------------------------------
+void csrQAABBTreeRelease(CSR_QAABBTree* pTree)
+{
+    // no tree to release?
+    if (!pTree)
+        return;
+
+    // free the nodes
+    if (pTree->m_pNode)
+        free(pTree->m_pNode);
+
+    // free the polygons
+    if (pTree->m_pPolygon)
+        free(pTree->m_pPolygon);
+
+    // free the tree
+    free(pTree);
+}
+//---------------------------------------------------------------------------
+void csrQAABBTreeInit(CSR_QAABBTree* pTree)
+{
+    // no tree to initialize?
+    if (!pTree)
+        return;
+
+    // initialize the tree content
+    pTree->m_pMesh        = 0;
+    pTree->m_pNode        = 0;
+    pTree->m_NodeCount    = 0;
+    pTree->m_pPolygon     = 0;
+    pTree->m_PolygonCount = 0;
+    memset(&pTree->m_Box, 0, sizeof(CSR_Box));
+}
+//---------------------------------------------------------------------------
+CSR_QAABBTree* csrQAABBTreeFromAABBTree(const CSR_AABBNode* pRoot, const CSR_Mesh* pMesh)
+{
+    CSR_QAABBTree* pTree;
+    unsigned       index;
+
+    // validate the inputs
+    if (!pRoot || !pMesh)
+        return 0;
+
+    // a lazy root should be expanded before his box may be used
+    if (!csrAABBTreeNodeExpand((CSR_AABBNode*)pRoot) || !pRoot->m_pBox)
+        return 0;
+
+    // create the quantized tree
+    pTree = csrQAABBTreeCreate();
+
+    // succeeded?
+    if (!pTree)
+        return 0;
+
+    pTree->m_pMesh = pMesh;
+    pTree->m_Box   = *pRoot->m_pBox;
+
+    // add the nodes, the root children are quantized in the root box
+    if (!csrQAABBTreeAddNode(pRoot, &pTree->m_Box, pTree, &index))
+    {
+        csrQAABBTreeRelease(pTree);
+        return 0;
+    }
+
+    return pTree;
+}
+//---------------------------------------------------------------------------
+CSR_QAABBTree* csrQAABBTreeFromMesh(const CSR_Mesh* pMesh)
+{
+    CSR_QAABBTree* pTree;
+
+    // get the source tree
+    CSR_AABBNode* pRoot = csrAABBTreeFromMesh(pMesh);
+
+    // succeeded?
+    if (!pRoot)
+        return 0;
+
+    // compress it
+    pTree = csrQAABBTreeFromAABBTree(pRoot, pMesh);
+
+    // release the source tree, no longer used
+    csrAABBTreeNodeRelease(pRoot);
+
+    return pTree;
+}
+//---------------------------------------------------------------------------
+int csrQAABBTreeResolve(const CSR_Ray3*           pRay,
+                        const CSR_QAABBTree*      pTree,
+                              CSR_Polygon3Buffer* pPolygons)
+{
+    CSR_Figure3 ray;
+
+    // no polygon buffer to contain the result?
+    if (!pPolygons)
+        return 0;
+
+    // ensure the polygon buffer is initialized, otherwise this may cause hard-to-debug bugs
+    pPolygons->m_pPolygon = 0;
+    pPolygons->m_Count    = 0;
+
+    // validate the inputs
+    if (!pRay || !pTree || !pTree->m_NodeCount)
+        return 0;
+
+    // convert ray to geometric figure
+    ray.m_Type    = CSR_F3_Ray;
+    ray.m_pFigure = pRay;
+
+    return csrQAABBTreeResolveNode(&ray, pTree, 0, &pTree->m_Box, pPolygons);
+}
+//---------------------------------------------------------------------------
 // Sliding functions
 //---------------------------------------------------------------------------
 void csrSlidingPoint(const CSR_Plane*   pSlidingPlane,
@@ -551,43 +1649,38 @@ int csrGroundPosY(const CSR_Sphere*   pBoundingSphere,
                         CSR_Polygon3* pGroundPolygon,
                         float*        pR)
 {
-    size_t             i;
-    CSR_Ray3           groundRay;
-    CSR_Vector3        groundPos;
-    CSR_Polygon3Buffer polygonBuffer;
-    int                result;
+    CSR_Ray3     groundRay;
+    CSR_Vector3  groundPos;
+    CSR_Polygon3 groundPolygon;
+    int          result;
 
     // validate the inputs
     if (!pBoundingSphere || !pTree || !pGroundDir)
         return 0;
 
-    result = 0;
-
     // create the ground ray
     csrRay3FromPointDir(&pBoundingSphere->m_Center, pGroundDir, &groundRay);
 
-    // using the ground ray, resolve aligned-axis bounding box tree
-    csrAABBTreeResolve(&groundRay, pTree, 0, &polygonBuffer);
-
-    // initialize the ground position from the bounding sphere center
-    groundPos = pBoundingSphere->m_Center;
+    // using the ground ray, search for the first ground polygon in the aligned-axis bounding box
+    // tree. NOTE the polygons are tested while the tree is traversed, thus there is no need to
+    // collect them all before
+    result = csrAABBTreeGroundHit(&groundRay, pTree, &groundPolygon, &groundPos);
 
-    // iterate through polygons to check
-    for (i = 0; i < polygonBuffer.m_Count; ++i)
-        // check if a ground polygon was found, calculate the ground position if yes
-        if (csrGroundCollision(pBoundingSphere, &polygonBuffer.m_pPolygon[i], pGroundDir, &groundPos))
-        {
-            // copy the ground polygon, if required
-            if (pGroundPolygon)
-                *pGroundPolygon = polygonBuffer.m_pPolygon[i];
-
-            result = 1;
-            break;
-        }
-
-    // delete found polygons (no longer needed from now)
-    if (polygonBuffer.m_Count)
-        free(polygonBuffer.m_pPolygon);
+    // found a ground polygon?
+    if (result)
+    {
+        // consider the sphere radius in the result
+        groundPos.m_X += (pBoundingSphere->m_Radius * -pGroundDir->m_X);
+        groundPos.m_Y += (pBoundingSphere->m_Radius * -pGroundDir->m_Y);
+        groundPos.m_Z += (pBoundingSphere->m_Radius * -pGroundDir->m_Z);
+
+        // copy the ground polygon, if required
+        if (pGroundPolygon)
+            *pGroundPolygon = groundPolygon;
+    }
+    else
+        // initialize the ground position from the bounding sphere center
+        groundPos = pBoundingSphere->m_Center;
 
     // copy the resulting y value
     if (pR)
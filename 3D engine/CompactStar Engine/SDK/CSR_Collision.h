@@ -21,10 +21,48 @@
 #include "CSR_Geometry.h"
 #include "CSR_Vertex.h"
 
+//---------------------------------------------------------------------------
+// Enumerators
+//---------------------------------------------------------------------------
+
+/**
+* Aligned-axis bounding box tree build mode
+*/
+typedef enum
+{
+    CSR_AM_None = 0, // no tree is built
+    CSR_AM_Full = 1, // the whole tree is built at once
+    CSR_AM_Lazy = 2  // only the root is split, the children are built the first time they are visited
+} CSR_EAABBTreeMode;
+
+/**
+* Aligned-axis bounding box tree leaf triangle components, as stored in the leaf data block
+*/
+typedef enum
+{
+    CSR_TC_Vertex1 = 0,  // first vertex (x, y, z)
+    CSR_TC_EdgeU   = 3,  // dual of the first edge, the dot product with (p - v1) gives the 1st barycentric coordinate
+    CSR_TC_EdgeV   = 6,  // dual of the second edge, the dot product with (p - v1) gives the 2nd barycentric coordinate
+    CSR_TC_Plane   = 9,  // triangle plane (a, b, c, d), a null normal means a degenerated triangle
+    CSR_TC_Count   = 13
+} CSR_ETriangleComponent;
+
 //---------------------------------------------------------------------------
 // Structures
 //---------------------------------------------------------------------------
 
+/**
+* Aligned-axis bounding box tree leaf triangles. The data are stored by component, i.e. the value
+* of the component c for the triangle i is m_pData[(c * m_Count) + i]. Only the data read by the
+* hit tests are stored, the triangle i is the leaf indexed polygon i, from which the full polygon
+* is read
+*/
+typedef struct
+{
+    float* m_pData;  // triangle data, CSR_TC_Count floats per triangle
+    size_t m_Count;  // triangle count
+} CSR_AABBTriangles;
+
 /**
 * Aligned-axis bounding box tree node
 */
@@ -35,8 +73,61 @@ typedef struct CSR_tagAABBNode
     struct CSR_tagAABBNode*          m_pRight;
            CSR_Box*                  m_pBox;
            CSR_IndexedPolygonBuffer* m_pPolygonBuffer;
+           CSR_AABBTriangles*        m_pTriangles; // precomputed leaf triangles, 0 if the node isn't a leaf
+           int                       m_Pending; // if 1, the node still owns all his polygons and should be expanded before use
 } CSR_AABBNode;
 
+/**
+* Quantized aligned-axis bounding box tree node. Each node contains up to 4 children, whose
+* bounds are quantized on 16 bits relatively to the node bounds
+*/
+typedef struct
+{
+    unsigned short m_Min[4][3]; // children box min corner, quantized in the node box
+    unsigned short m_Max[4][3]; // children box max corner, quantized in the node box
+    unsigned       m_Child[4];  // child node index, first polygon index if leaf, M_CSR_Error_Code if unused
+    unsigned short m_Count[4];  // child polygon count if leaf, 0 if the child is a node
+    unsigned char  m_Leaf[4];   // 1 if the child is a leaf, which may also be empty, 0 if it's a node
+} CSR_QAABBNode;
+
+/**
+* Quantized aligned-axis bounding box tree polygon
+*/
+typedef struct
+{
+    unsigned m_VBIndex;  // index of the vertex buffer containing the polygon in the mesh
+    unsigned m_Index[3]; // polygon vertices offsets in the vertex buffer
+} CSR_QAABBPolygon;
+
+/**
+* Quantized aligned-axis bounding box tree, a compressed tree for low memory targets
+*/
+typedef struct
+{
+    const CSR_Mesh*         m_pMesh;        // mesh containing the polygons, not owned by the tree
+          CSR_Box           m_Box;          // root bounding box
+          CSR_QAABBNode*    m_pNode;        // tree nodes, the first one is the root
+          size_t            m_NodeCount;
+          CSR_QAABBPolygon* m_pPolygon;     // leaf polygons, each leaf owns a continuous range
+          size_t            m_PolygonCount;
+} CSR_QAABBTree;
+
+//---------------------------------------------------------------------------
+// Callbacks
+//---------------------------------------------------------------------------
+
+/**
+* Called when a lazy AABB tree node should be expanded
+*@param lock - if 1, the node is about to be expanded and the tree should be locked, if 0 the
+*              node was expanded and the tree may be unlocked
+*@note This callback is required only if the same lazy tree may be resolved by several threads
+*      at once. The lock and unlock operations should behave as a full memory barrier (e.g. a
+*      mutex), otherwise a concurrent reader may see an incomplete node
+*@note The pending flag of each visited node is read with an atomic acquire load on the
+*      compilers supporting it (gcc, clang), otherwise it's read under this lock
+*/
+typedef void (*CSR_fOnLockAABBTree)(int lock);
+
 #ifdef __cplusplus
     extern "C"
     {
@@ -62,6 +153,40 @@ typedef struct CSR_tagAABBNode
         */
         CSR_AABBNode* csrAABBTreeFromMesh(const CSR_Mesh* pMesh);
 
+        /**
+        * Gets a lazy AABB tree from a mesh
+        *@param pMesh - mesh
+        *@return aligned-axis bounding box tree root node, 0 on error
+        *@note Only the root node is split, the children are expanded the first time a query
+        *      descends into them, see csrAABBTreeNodeExpand()
+        *@note The AABB tree must be released when no longer used, see csrAABBTreeNodeRelease()
+        */
+        CSR_AABBNode* csrAABBTreeFromMeshLazy(const CSR_Mesh* pMesh);
+
+        /**
+        * Gets an AABB tree from a mesh, using the required build mode
+        *@param pMesh - mesh
+        *@param mode - tree build mode
+        *@return aligned-axis bounding box tree root node, 0 on error or if mode is CSR_AM_None
+        *@note The AABB tree must be released when no longer used, see csrAABBTreeNodeRelease()
+        */
+        CSR_AABBNode* csrAABBTreeFromMeshMode(const CSR_Mesh* pMesh, CSR_EAABBTreeMode mode);
+
+        /**
+        * Expands a lazy AABB tree node, i.e. splits his polygons between 2 new pending children
+        *@param[in, out] pNode - node to expand
+        *@return 1 on success, otherwise 0
+        *@note Nothing is done if the node was already expanded
+        *@note The expansion is serialized by the function set in csrAABBTreeSetLockFunction()
+        */
+        int csrAABBTreeNodeExpand(CSR_AABBNode* pNode);
+
+        /**
+        * Sets the function used to lock the lazy AABB trees while a node is expanded
+        *@param fOnLock - lock function, 0 if the trees are only used by one thread
+        */
+        void csrAABBTreeSetLockFunction(CSR_fOnLockAABBTree fOnLock);
+
         /**
         * Resolves AABB tree
         *@param pRay - ray against which tree items will be tested
@@ -69,12 +194,29 @@ typedef struct CSR_tagAABBNode
         *@param deep - tree deep level, used internally, should be set to 0
         *@param[out] pPolygons - polygons belonging to boxes hit by ray
         *@return 1 on success, otherwise 0
+        *@note The pending nodes of a lazy tree are expanded while the tree is resolved
         */
         int csrAABBTreeResolve(const CSR_Ray3*           pRay,
                                const CSR_AABBNode*       pNode,
                                      size_t              deep,
                                      CSR_Polygon3Buffer* pPolygons);
 
+        /**
+        * Checks if a sphere hits a polygon contained in an AABB tree
+        *@param pSphere - sphere to check
+        *@param pNode - root or parent node to check from
+        *@param[out] pPolygon - the first hit polygon
+        *@param[out] pPlane - the hit polygon plane, i.e. the sliding plane, ignored if 0
+        *@return 1 if the sphere hits a polygon, otherwise 0
+        *@note The precomputed leaf triangles are used to reject the polygons whose plane is too
+        *      far from the sphere, the remaining ones are read back only to be fully tested
+        *@note The pending nodes of a lazy tree are expanded while the tree is checked
+        */
+        int csrAABBTreeSphereHit(const CSR_Sphere*   pSphere,
+                                 const CSR_AABBNode* pNode,
+                                       CSR_Polygon3* pPolygon,
+                                       CSR_Plane*    pPlane);
+
         /**
         * Releases an AABB tree node content
         *@param[in, out] pNode - node for which content should be released
@@ -88,6 +230,62 @@ typedef struct CSR_tagAABBNode
         */
         void csrAABBTreeNodeRelease(CSR_AABBNode* pNode);
 
+        //-------------------------------------------------------------------
+        // Quantized Aligned-Axis Bounding Box tree functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a quantized AABB tree
+        *@return newly created quantized AABB tree, 0 on error
+        *@note The quantized AABB tree must be released when no longer used, see csrQAABBTreeRelease()
+        */
+        CSR_QAABBTree* csrQAABBTreeCreate(void);
+
+        /**
+        * Releases a quantized AABB tree
+        *@param[in, out] pTree - quantized AABB tree to release
+        */
+        void csrQAABBTreeRelease(CSR_QAABBTree* pTree);
+
+        /**
+        * Initializes a quantized AABB tree structure
+        *@param[in, out] pTree - quantized AABB tree to initialize
+        */
+        void csrQAABBTreeInit(CSR_QAABBTree* pTree);
+
+        /**
+        * Gets a quantized AABB tree from an AABB tree
+        *@param pRoot - AABB tree root node, pending lazy nodes are expanded while converted
+        *@param pMesh - mesh from which the AABB tree was built
+        *@return quantized AABB tree, 0 on error
+        *@note The mesh should remain valid while the quantized tree is used
+        *@note The quantized AABB tree must be released when no longer used, see csrQAABBTreeRelease()
+        */
+        CSR_QAABBTree* csrQAABBTreeFromAABBTree(const CSR_AABBNode* pRoot, const CSR_Mesh* pMesh);
+
+        /**
+        * Gets a quantized AABB tree from a mesh
+        *@param pMesh - mesh
+        *@return quantized AABB tree, 0 on error
+        *@note The mesh should remain valid while the quantized tree is used
+        *@note The quantized AABB tree must be released when no longer used, see csrQAABBTreeRelease()
+        */
+        CSR_QAABBTree* csrQAABBTreeFromMesh(const CSR_Mesh* pMesh);
+
+        /**
+        * Resolves a quantized AABB tree
+        *@param pRay - ray against which tree items will be tested
+        *@param pTree - quantized AABB tree to resolve
+        *@param[out] pPolygons - polygons belonging to boxes hit by ray
+        *@return 1 if at least one leaf was hit, otherwise 0
+        *@note The children boxes are decoded while the tree is traversed. As the quantization is
+        *      conservative, the found polygons are the same as, or a superset of, the polygons
+        *      found by csrAABBTreeResolve() on the source tree
+        */
+        int csrQAABBTreeResolve(const CSR_Ray3*           pRay,
+                                const CSR_QAABBTree*      pTree,
+                                      CSR_Polygon3Buffer* pPolygons);
+
         //-------------------------------------------------------------------
         // Sliding functions
         //-------------------------------------------------------------------
@@ -135,6 +333,7 @@ typedef struct CSR_tagAABBNode
         *@return 1 if a ground polygon was found, otherwise 0
         *@note The bounding sphere should be in the same coordinate system as the model. This means
         *      that any transformation should be applied to the sphere before calling this function
+        *@note The search stops on the first ground polygon found while the tree is traversed
         */
         int csrGroundPosY(const CSR_Sphere*   pBoundingSphere,
                           const CSR_AABBNode* pTree,
@@ -373,6 +373,221 @@ void csrArrayDeleteAt(size_t index, CSR_Array* pArray)
     --pArray->m_Count;
 }
 //---------------------------------------------------------------------------
+// Sort functions
+//---------------------------------------------------------------------------
+int csrRadixSort(CSR_SortItem* pItems, size_t count)
+{
+    size_t        i;
+    size_t        pass;
+    size_t        sum;
+    size_t        offset[256];
+    unsigned      shift;
+    CSR_SortItem* pTemp;
+    CSR_SortItem* pSrc;
+    CSR_SortItem* pDst;
+    CSR_SortItem* pSwap;
+
+    // validate the input
+    if (!pItems)
+        return 0;
+
+    // nothing to sort?
+    if (count < 2)
+        return 1;
+
+    // create the buffer in which the items will be distributed
+    pTemp = (CSR_SortItem*)malloc(sizeof(CSR_SortItem) * count);
+
+    // succeeded?
+    if (!pTemp)
+        return 0;
+
+    pSrc = pItems;
+    pDst = pTemp;
+
+    // sort the keys byte per byte, from the least to the most significant one
+    for (pass = 0; pass < sizeof(unsigned); ++pass)
+    {
+        shift = (unsigned)(pass * 8);
+
+        memset(offset, 0, sizeof(offset));
+
+        // count the items per byte value
+        for (i = 0; i < count; ++i)
+            ++offset[(pSrc[i].m_Key >> shift) & 0xFF];
+
+        // all the items share the same byte value? Nothing to do for this pass
+        if (offset[(pSrc[0].m_Key >> shift) & 0xFF] == count)
+            continue;
+
+        // convert the counts to offsets
+        sum = 0;
+
+        for (i = 0; i < 256; ++i)
+        {
+            const size_t value = offset[i];
+            offset[i]          = sum;
+            sum               += value;
+        }
+
+        // distribute the items
+        for (i = 0; i < count; ++i)
+            pDst[offset[(pSrc[i].m_Key >> shift) & 0xFF]++] = pSrc[i];
+
+        pSwap = pSrc;
+        pSrc  = pDst;
+        pDst  = pSwap;
+    }
+
+    // copy the result in the source buffer, if required
+    if (pSrc != pItems)
+        memcpy(pItems, pSrc, sizeof(CSR_SortItem) * count);
+
+    free(pTemp);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+// Handle functions
+//---------------------------------------------------------------------------
+void csrHandleTableInit(CSR_HandleTable* pTable)
+{
+    // no handle table to initialize?
+    if (!pTable)
+        return;
+
+    pTable->m_pSlot        = 0;
+    pTable->m_Count        = 0;
+    pTable->m_FreeSlot     = (size_t)M_CSR_Unknown_Index;
+    pTable->m_LastFreeSlot = (size_t)M_CSR_Unknown_Index;
+    pTable->m_FreeCount    = 0;
+}
+//---------------------------------------------------------------------------
+void csrHandleTableContentRelease(CSR_HandleTable* pTable)
+{
+    // no handle table to release?
+    if (!pTable)
+        return;
+
+    // free the slots
+    free(pTable->m_pSlot);
+
+    // reset the table
+    csrHandleTableInit(pTable);
+}
+//---------------------------------------------------------------------------
+CSR_Handle csrHandleTableAdd(CSR_HandleTable* pTable, size_t index, size_t tag)
+{
+    size_t          slotIndex;
+    CSR_HandleSlot* pSlot;
+
+    // no handle table?
+    if (!pTable)
+        return 0;
+
+    // reuse the oldest released slot, but only if enough slots are free, or if no more slot index
+    // is available. This spreads the generation changes over many slots
+    if (pTable->m_FreeSlot != (size_t)M_CSR_Unknown_Index &&
+       (pTable->m_FreeCount >= M_CSR_Handle_Min_Free   ||
+        pTable->m_Count     >= ((size_t)1 << M_CSR_Handle_Index_Bits)))
+    {
+        // remove it from the free slot list
+        slotIndex          = pTable->m_FreeSlot;
+        pTable->m_FreeSlot = pTable->m_pSlot[slotIndex].m_Index;
+        --pTable->m_FreeCount;
+
+        // was the last free slot?
+        if (pTable->m_FreeSlot == (size_t)M_CSR_Unknown_Index)
+            pTable->m_LastFreeSlot = (size_t)M_CSR_Unknown_Index;
+    }
+    else
+    {
+        // no more slot index available?
+        if (pTable->m_Count >= ((size_t)1 << M_CSR_Handle_Index_Bits))
+            return 0;
+
+        // add a new slot
+        pSlot = (CSR_HandleSlot*)csrMemoryAlloc(pTable->m_pSlot,
+                                                sizeof(CSR_HandleSlot),
+                                                pTable->m_Count + 1);
+
+        // succeeded?
+        if (!pSlot)
+            return 0;
+
+        slotIndex                     = pTable->m_Count;
+        pSlot[slotIndex].m_Generation = 1;
+        pTable->m_pSlot               = pSlot;
+        ++pTable->m_Count;
+    }
+
+    // link the slot to the object
+    pSlot          = &pTable->m_pSlot[slotIndex];
+    pSlot->m_Index = index;
+    pSlot->m_Tag   = tag;
+    pSlot->m_Used  = 1;
+
+    return (CSR_Handle)((pSlot->m_Generation << M_CSR_Handle_Index_Bits) | slotIndex);
+}
+//---------------------------------------------------------------------------
+CSR_HandleSlot* csrHandleTableGet(const CSR_HandleTable* pTable, CSR_Handle handle)
+{
+    size_t          slotIndex;
+    CSR_HandleSlot* pSlot;
+
+    // no handle table or invalid handle?
+    if (!pTable || !handle)
+        return 0;
+
+    slotIndex = handle & (((CSR_Handle)1 << M_CSR_Handle_Index_Bits) - 1);
+
+    // is slot index out of bounds?
+    if (slotIndex >= pTable->m_Count)
+        return 0;
+
+    pSlot = &pTable->m_pSlot[slotIndex];
+
+    // was the object deleted in the meantime?
+    if (!pSlot->m_Used || pSlot->m_Generation != (handle >> M_CSR_Handle_Index_Bits))
+        return 0;
+
+    return pSlot;
+}
+//---------------------------------------------------------------------------
+void csrHandleTableDelete(CSR_HandleTable* pTable, CSR_Handle handle)
+{
+    size_t          slotIndex;
+    CSR_HandleSlot* pSlot;
+
+    // get the slot matching with the handle
+    pSlot = csrHandleTableGet(pTable, handle);
+
+    // not found?
+    if (!pSlot)
+        return;
+
+    slotIndex = handle & (((CSR_Handle)1 << M_CSR_Handle_Index_Bits) - 1);
+
+    // invalidate all the existing handles pointing to this slot. NOTE the generation 0 is skipped
+    // to guarantee that 0 is never a valid handle
+    ++pSlot->m_Generation;
+
+    if (pSlot->m_Generation >= ((CSR_Handle)1 << (32 - M_CSR_Handle_Index_Bits)))
+        pSlot->m_Generation = 1;
+
+    pSlot->m_Used  = 0;
+    pSlot->m_Index = (size_t)M_CSR_Unknown_Index;
+
+    // add the slot at the end of the free slot list, so it will be reused last
+    if (pTable->m_LastFreeSlot == (size_t)M_CSR_Unknown_Index)
+        pTable->m_FreeSlot = slotIndex;
+    else
+        pTable->m_pSlot[pTable->m_LastFreeSlot].m_Index = slotIndex;
+
+    pTable->m_LastFreeSlot = slotIndex;
+    ++pTable->m_FreeCount;
+}
+//---------------------------------------------------------------------------
 // Buffer functions
 //---------------------------------------------------------------------------
 CSR_Buffer* csrBufferCreate(void)
@@ -602,7 +817,7 @@ int csrFileSave(const char* pFileName, const CSR_Buffer* pBuffer)
         return 0;
 
     // write the buffer content
-    bytesWritten = fwrite(pBuffer->m_pData, pBuffer->m_Length, 1, pFile);
+    bytesWritten = fwrite(pBuffer->m_pData, 1, pBuffer->m_Length, pFile);
 
     // close the file
     fclose(pFile);
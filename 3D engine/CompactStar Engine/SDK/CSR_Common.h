@@ -22,10 +22,22 @@
 //---------------------------------------------------------------------------
 // Global defines
 //---------------------------------------------------------------------------
-#define M_CSR_Version        1.05
-#define M_CSR_Error_Code     0xFFFFFFFF // yes this is a 32 bit error code, but enough for this engine
-#define M_CSR_Unknown_Index -1
-#define M_CSR_Epsilon        1.0E-3     // epsilon value used for tolerance
+#define M_CSR_Version            1.05
+#define M_CSR_Error_Code         0xFFFFFFFF // yes this is a 32 bit error code, but enough for this engine
+#define M_CSR_Unknown_Index     -1
+#define M_CSR_Epsilon            1.0E-3     // epsilon value used for tolerance
+#define M_CSR_Handle_Index_Bits  20         // handle bits containing the slot index, the others contain the generation
+#define M_CSR_Handle_Min_Free    1024       // free slots to keep before reusing one, delays the generation wrap
+
+// thread local storage, keeps a global value per thread
+#if defined(__GNUC__) || defined(__clang__)
+    #define M_CSR_Thread_Local __thread
+#elif defined(_MSC_VER)
+    #define M_CSR_Thread_Local __declspec(thread)
+#else
+    // no thread local storage available, the global value is shared by all the threads
+    #define M_CSR_Thread_Local
+#endif
 
 //---------------------------------------------------------------------------
 // Enumerators
@@ -74,6 +86,48 @@ typedef struct
     size_t         m_Count;
 } CSR_Array;
 
+/**
+* Sort item
+*/
+typedef struct
+{
+    unsigned m_Key;   // sort key
+    size_t   m_Index; // index of the sorted value in the caller data
+} CSR_SortItem;
+
+/**
+* Handle, identifies an object independently of its location in memory
+*@note A handle contains a slot index in its low bits, and the slot generation in its high bits.
+*      The generation changes each time the slot is released, thus a handle pointing to a deleted
+*      object is always detected. 0 is never a valid handle. The freed slots are reused in FIFO
+*      order, and only once M_CSR_Handle_Min_Free slots are free, thus a slot generation may only
+*      wrap after about 4096 * M_CSR_Handle_Min_Free deletions
+*/
+typedef unsigned CSR_Handle;
+
+/**
+* Handle slot
+*/
+typedef struct
+{
+    size_t   m_Index;      // object index in its owner list, next free slot if the slot is unused
+    size_t   m_Tag;        // user defined value linked to the object
+    unsigned m_Generation; // slot generation, changed each time the slot is released
+    int      m_Used;       // if 1, the slot is linked to an object
+} CSR_HandleSlot;
+
+/**
+* Handle table, i.e. a slot map linking the handles to the objects location
+*/
+typedef struct
+{
+    CSR_HandleSlot* m_pSlot;
+    size_t          m_Count;
+    size_t          m_FreeSlot;     // first free slot (next to reuse), M_CSR_Unknown_Index if no free slot
+    size_t          m_LastFreeSlot; // last free slot (last released), M_CSR_Unknown_Index if no free slot
+    size_t          m_FreeCount;    // free slot count
+} CSR_HandleTable;
+
 /**
 * Memory buffer
 */
@@ -290,6 +344,62 @@ typedef struct
         */
         void csrArrayDeleteAt(size_t index, CSR_Array* pArray);
 
+        //-------------------------------------------------------------------
+        // Sort functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Sorts items by ascending key, using a radix sort
+        *@param[in, out] pItems - items to sort, sorted items on function ends
+        *@param count - item count
+        *@return 1 on success, otherwise 0
+        *@note The sort is stable, i.e. the items sharing the same key keep their order
+        */
+        int csrRadixSort(CSR_SortItem* pItems, size_t count);
+
+        //-------------------------------------------------------------------
+        // Handle functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Initializes a handle table
+        *@param[in, out] pTable - handle table to initialize
+        */
+        void csrHandleTableInit(CSR_HandleTable* pTable);
+
+        /**
+        * Releases the handle table content
+        *@param[in, out] pTable - handle table for which the content should be released
+        *@note Only the content is released, the handle table itself is not released
+        */
+        void csrHandleTableContentRelease(CSR_HandleTable* pTable);
+
+        /**
+        * Adds a new handle in the table
+        *@param pTable - handle table
+        *@param index - object index in its owner list
+        *@param tag - user defined value to link to the object
+        *@return newly created handle, 0 on error
+        */
+        CSR_Handle csrHandleTableAdd(CSR_HandleTable* pTable, size_t index, size_t tag);
+
+        /**
+        * Gets the slot matching with a handle
+        *@param pTable - handle table
+        *@param handle - handle for which the slot should be get
+        *@return slot, 0 if the handle is invalid or if the object was deleted
+        *@note The slot index may be updated if the object moves in its owner list
+        */
+        CSR_HandleSlot* csrHandleTableGet(const CSR_HandleTable* pTable, CSR_Handle handle);
+
+        /**
+        * Deletes a handle from the table
+        *@param pTable - handle table
+        *@param handle - handle to delete
+        *@note All the copies of the handle become invalid
+        */
+        void csrHandleTableDelete(CSR_HandleTable* pTable, CSR_Handle handle);
+
         //-------------------------------------------------------------------
         // Buffer functions
         //-------------------------------------------------------------------
@@ -1369,6 +1369,126 @@ void csrBoxCut(const CSR_Box* pBox, CSR_Box* pLeftBox, CSR_Box* pRightBox)
     }
 }
 //---------------------------------------------------------------------------
+void csrBoxExtendToPoint(const CSR_Vector3* pPoint,
+                               CSR_Box*     pBox,
+                               int*         pEmpty)
+{
+    // is box empty?
+    if (*pEmpty)
+    {
+        // initialize bounding box with the point
+         pBox->m_Min = *pPoint;
+         pBox->m_Max = *pPoint;
+        *pEmpty      = 0;
+        return;
+    }
+
+    // search for box min edge
+    csrMathMin(pBox->m_Min.m_X, pPoint->m_X, &pBox->m_Min.m_X);
+    csrMathMin(pBox->m_Min.m_Y, pPoint->m_Y, &pBox->m_Min.m_Y);
+    csrMathMin(pBox->m_Min.m_Z, pPoint->m_Z, &pBox->m_Min.m_Z);
+
+    // search for box max edge
+    csrMathMax(pBox->m_Max.m_X, pPoint->m_X, &pBox->m_Max.m_X);
+    csrMathMax(pBox->m_Max.m_Y, pPoint->m_Y, &pBox->m_Max.m_Y);
+    csrMathMax(pBox->m_Max.m_Z, pPoint->m_Z, &pBox->m_Max.m_Z);
+}
+//---------------------------------------------------------------------------
+void csrBoxTransform(const CSR_Box* pBox, const CSR_Matrix4* pMatrix, CSR_Box* pR)
+{
+    CSR_Vector3 center;
+    CSR_Vector3 extent;
+    CSR_Vector3 newCenter;
+    CSR_Vector3 newExtent;
+
+    // get the box center and half size
+    center.m_X = (pBox->m_Min.m_X + pBox->m_Max.m_X) * 0.5f;
+    center.m_Y = (pBox->m_Min.m_Y + pBox->m_Max.m_Y) * 0.5f;
+    center.m_Z = (pBox->m_Min.m_Z + pBox->m_Max.m_Z) * 0.5f;
+    extent.m_X = (pBox->m_Max.m_X - pBox->m_Min.m_X) * 0.5f;
+    extent.m_Y = (pBox->m_Max.m_Y - pBox->m_Min.m_Y) * 0.5f;
+    extent.m_Z = (pBox->m_Max.m_Z - pBox->m_Min.m_Z) * 0.5f;
+
+    // transform the center
+    csrMat4ApplyToVector(pMatrix, &center, &newCenter);
+
+    // the new half size is the sum of the half size projections on each axis
+    newExtent.m_X = extent.m_X * (float)fabs(pMatrix->m_Table[0][0]) +
+                    extent.m_Y * (float)fabs(pMatrix->m_Table[1][0]) +
+                    extent.m_Z * (float)fabs(pMatrix->m_Table[2][0]);
+    newExtent.m_Y = extent.m_X * (float)fabs(pMatrix->m_Table[0][1]) +
+                    extent.m_Y * (float)fabs(pMatrix->m_Table[1][1]) +
+                    extent.m_Z * (float)fabs(pMatrix->m_Table[2][1]);
+    newExtent.m_Z = extent.m_X * (float)fabs(pMatrix->m_Table[0][2]) +
+                    extent.m_Y * (float)fabs(pMatrix->m_Table[1][2]) +
+                    extent.m_Z * (float)fabs(pMatrix->m_Table[2][2]);
+
+    csrVec3Sub(&newCenter, &newExtent, &pR->m_Min);
+    csrVec3Add(&newCenter, &newExtent, &pR->m_Max);
+}
+//---------------------------------------------------------------------------
+// Frustum functions
+//---------------------------------------------------------------------------
+void csrFrustumFromMatrix(const CSR_Matrix4* pMatrix, CSR_Frustum* pR)
+{
+    size_t i;
+    size_t axis;
+    float  sign;
+    float  length;
+
+    // each plane is the 4th column of the matrix added to or subtracted from one of the 3 first
+    // columns, in the following order: left, right, bottom, top, near, far
+    for (i = 0; i < 6; ++i)
+    {
+        axis = i / 2;
+        sign = (i % 2) ? -1.0f : 1.0f;
+
+        pR->m_Plane[i].m_A = pMatrix->m_Table[0][3] + (sign * pMatrix->m_Table[0][axis]);
+        pR->m_Plane[i].m_B = pMatrix->m_Table[1][3] + (sign * pMatrix->m_Table[1][axis]);
+        pR->m_Plane[i].m_C = pMatrix->m_Table[2][3] + (sign * pMatrix->m_Table[2][axis]);
+        pR->m_Plane[i].m_D = pMatrix->m_Table[3][3] + (sign * pMatrix->m_Table[3][axis]);
+
+        // normalize the plane
+        length = sqrt((pR->m_Plane[i].m_A * pR->m_Plane[i].m_A) +
+                      (pR->m_Plane[i].m_B * pR->m_Plane[i].m_B) +
+                      (pR->m_Plane[i].m_C * pR->m_Plane[i].m_C));
+
+        // should not happen, unless the matrix is wrong
+        if (!length)
+            continue;
+
+        pR->m_Plane[i].m_A /= length;
+        pR->m_Plane[i].m_B /= length;
+        pR->m_Plane[i].m_C /= length;
+        pR->m_Plane[i].m_D /= length;
+    }
+}
+//---------------------------------------------------------------------------
+int csrFrustumIntersectBox(const CSR_Frustum* pFrustum, const CSR_Box* pBox)
+{
+    size_t           i;
+    float            dist;
+    const CSR_Plane* pPlane;
+
+    // iterate through the frustum planes
+    for (i = 0; i < 6; ++i)
+    {
+        pPlane = &pFrustum->m_Plane[i];
+
+        // get the distance between the plane and the box corner which is the most inside the
+        // frustum. If even this corner is outside, the whole box is outside
+        dist = pPlane->m_A * (pPlane->m_A >= 0.0f ? pBox->m_Max.m_X : pBox->m_Min.m_X) +
+               pPlane->m_B * (pPlane->m_B >= 0.0f ? pBox->m_Max.m_Y : pBox->m_Min.m_Y) +
+               pPlane->m_C * (pPlane->m_C >= 0.0f ? pBox->m_Max.m_Z : pBox->m_Min.m_Z) +
+               pPlane->m_D;
+
+        if (dist < 0.0f)
+            return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
 // Inside checks
 //---------------------------------------------------------------------------
 int csrInsidePolygon2(const CSR_Vector2* pP, const CSR_Polygon2* pPo)
@@ -2147,6 +2267,7 @@ int csrIntersect3(const CSR_Figure3* pFigure1,
             CSR_Vector3 dir;
             CSR_Ray3    ray;
             CSR_Figure3 rayFigure;
+            CSR_Figure3 planeFigure;
 
             // get the segment to check
             const CSR_Segment3* pSegment = (CSR_Segment3*)pFirst;
@@ -2159,13 +2280,17 @@ int csrIntersect3(const CSR_Figure3* pFigure1,
             csrVec3Sub(&pSegment->m_End, &pSegment->m_Start, &dir);
             csrVec3Normalize(&dir, &ray.m_Dir);
 
-            // build a figure for the plane
+            // build a figure for the ray
             rayFigure.m_Type    = CSR_F3_Ray;
             rayFigure.m_pFigure = &ray;
 
+            // build a figure for the plane
+            planeFigure.m_Type    = CSR_F3_Plane;
+            planeFigure.m_pFigure = pSecond;
+
             // check the intersection. NOTE the segment will only intersect the plane if the
             // intersection point is inside the segment limits
-            if (csrIntersect3(&rayFigure, pSecond, &point, pR2, pR3))
+            if (csrIntersect3(&rayFigure, &planeFigure, &point, pR2, pR3))
                 if (csrVec3BetweenRange(&point, &pSegment->m_Start, &pSegment->m_End, M_CSR_Epsilon))
                 {
                     if (pR1)
@@ -2284,7 +2409,7 @@ int csrIntersect3(const CSR_Figure3* pFigure1,
 
                     // build a figure for the segment
                     segment.m_Type    = CSR_F3_Segment;
-                    segment.m_pFigure = &polygonPlane;
+                    segment.m_pFigure = &seg;
 
                     // build a figure for the plane
                     plane.m_Type    = CSR_F3_Plane;
@@ -201,6 +201,14 @@ typedef struct
     CSR_Vector3 m_Max;
 } CSR_Box;
 
+/**
+* View frustum, the planes normals point to the frustum inside
+*/
+typedef struct
+{
+    CSR_Plane m_Plane[6]; // left, right, bottom, top, near and far planes
+} CSR_Frustum;
+
 /**
 * 2D Polygon
 */
@@ -849,6 +857,46 @@ typedef struct
         */
         void csrBoxCut(const CSR_Box* pBox, CSR_Box* pLeftBox, CSR_Box* pRightBox);
 
+        /**
+        * Extends a box to encompass a point
+        *@param pPoint - point to encompass in the box
+        *@param[in, out] pBox - bounding box that will encompass the point
+        *@param[in, out] pEmpty - if 1, box is empty and still not contains any point
+        */
+        void csrBoxExtendToPoint(const CSR_Vector3* pPoint,
+                                       CSR_Box*     pBox,
+                                       int*         pEmpty);
+
+        /**
+        * Transforms a box and gets the aligned-axis box surrounding the result
+        *@param pBox - box to transform
+        *@param pMatrix - transformation matrix
+        *@param[out] pR - aligned-axis box surrounding the transformed box
+        */
+        void csrBoxTransform(const CSR_Box* pBox, const CSR_Matrix4* pMatrix, CSR_Box* pR);
+
+        //-------------------------------------------------------------------
+        // Frustum functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Extracts the frustum planes from a matrix
+        *@param pMatrix - matrix to extract from, e.g. the view matrix multiplied by the projection matrix
+        *@param[out] pR - frustum
+        *@note The frustum is expressed in the coordinate system the matrix is applied to, e.g. the
+        *      world coordinates for the view * projection matrix
+        */
+        void csrFrustumFromMatrix(const CSR_Matrix4* pMatrix, CSR_Frustum* pR);
+
+        /**
+        * Checks if a box is visible in a frustum
+        *@param pFrustum - frustum
+        *@param pBox - box to check
+        *@return 1 if the box is inside or crosses the frustum, otherwise 0
+        *@note This test is conservative, a box near a frustum corner may be reported as visible
+        */
+        int csrFrustumIntersectBox(const CSR_Frustum* pFrustum, const CSR_Box* pBox);
+
         //-------------------------------------------------------------------
         // Inside checks
         //-------------------------------------------------------------------
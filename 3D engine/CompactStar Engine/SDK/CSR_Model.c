@@ -397,6 +397,9 @@ CSR_Mesh* csrShapeCreateSurface(float                 width,
         csrVertexBufferAdd(&vertex, &normal, &uv, i, fOnGetVertexColor, pMesh->m_pVB);
     }
 
+    // index the vertices. NOTE on failure the shape is still drawn without index
+    csrMeshIndex(pMesh);
+
     return pMesh;
 }
 //---------------------------------------------------------------------------
@@ -611,6 +614,9 @@ CSR_Mesh* csrShapeCreateBox(float                 width,
     csrVertexBufferAdd(&vertices[6], &normals[2], &texCoords[22], 2, fOnGetVertexColor, &pMesh->m_pVB[5]);
     csrVertexBufferAdd(&vertices[4], &normals[2], &texCoords[23], 3, fOnGetVertexColor, &pMesh->m_pVB[5]);
 
+    // index the vertices. NOTE on failure the shape is still drawn without index
+    csrMeshIndex(pMesh);
+
     return pMesh;
 }
 //---------------------------------------------------------------------------
@@ -767,6 +773,9 @@ CSR_Mesh* csrShapeCreateSphere(float                 radius,
         }
     }
 
+    // index the vertices. NOTE on failure the shape is still drawn without index
+    csrMeshIndex(pMesh);
+
     return pMesh;
 }
 //---------------------------------------------------------------------------
@@ -904,6 +913,9 @@ CSR_Mesh* csrShapeCreateCylinder(float                 minRadius,
         csrVertexBufferAdd(&vertex, &normal, &uv, (i * 2) + 1, fOnGetVertexColor, pMesh->m_pVB);
     }
 
+    // index the vertices. NOTE on failure the shape is still drawn without index
+    csrMeshIndex(pMesh);
+
     return pMesh;
 }
 //---------------------------------------------------------------------------
@@ -1026,6 +1038,9 @@ CSR_Mesh* csrShapeCreateDisk(float                 centerX,
         csrVertexBufferAdd(&vertex, &normal, &uv, i, fOnGetVertexColor, pMesh->m_pVB);
     }
 
+    // index the vertices. NOTE on failure the shape is still drawn without index
+    csrMeshIndex(pMesh);
+
     return pMesh;
 }
 //---------------------------------------------------------------------------
@@ -1172,6 +1187,9 @@ CSR_Mesh* csrShapeCreateRing(float                 centerX,
         csrVertexBufferAdd(&vertex, &normal, &uv, (i * 2) + 1, fOnGetVertexColor, pMesh->m_pVB);
     }
 
+    // index the vertices. NOTE on failure the shape is still drawn without index
+    csrMeshIndex(pMesh);
+
     return pMesh;
 }
 //---------------------------------------------------------------------------
@@ -1363,6 +1381,9 @@ CSR_Mesh* csrShapeCreateSpiral(float                 centerX,
         z         += deltaZ;
     }
 
+    // index the vertices. NOTE on failure the shape is still drawn without index
+    csrMeshIndex(pMesh);
+
     return pMesh;
 }
 //---------------------------------------------------------------------------
@@ -2105,8 +2126,7 @@ void csrModelRelease(CSR_Model* pModel, const CSR_fOnDeleteTexture fOnDeleteText
             {
                 // free the mesh vertex buffer content
                 for (j = 0; j < pModel->m_pMesh[i].m_Count; ++j)
-                    if (pModel->m_pMesh[i].m_pVB[j].m_pData)
-                        free(pModel->m_pMesh[i].m_pVB[j].m_pData);
+                    csrVertexBufferContentRelease(&pModel->m_pMesh[i].m_pVB[j]);
 
                 // free the mesh vertex buffer
                 free(pModel->m_pMesh[i].m_pVB);
@@ -2573,8 +2593,7 @@ void csrMDLRelease(CSR_MDL* pMDL, const CSR_fOnDeleteTexture fOnDeleteTexture)
                     {
                         // free the mesh vertex buffer content
                         for (k = 0; k < pMDL->m_pModel[i].m_pMesh[j].m_Count; ++k)
-                            if (pMDL->m_pModel[i].m_pMesh[j].m_pVB[k].m_pData)
-                                free(pMDL->m_pModel[i].m_pMesh[j].m_pVB[k].m_pData);
+                            csrVertexBufferContentRelease(&pMDL->m_pModel[i].m_pMesh[j].m_pVB[k]);
 
                         // free the mesh vertex buffer
                         free(pMDL->m_pModel[i].m_pMesh[j].m_pVB);
@@ -2607,7 +2626,7 @@ void csrMDLInit(CSR_MDL* pMDL)
     pMDL->m_SkinCount      = 0;
 }
 //---------------------------------------------------------------------------
-void csrMDLUpdateIndex(const CSR_MDL* pMDL,
+void csrMDLSelectIndex(const CSR_MDL* pMDL,
                              size_t   fps,
                              size_t   animationIndex,
                              size_t*  pSkinIndex,
@@ -2759,6 +2778,33 @@ void csrMDLUpdateIndex(const CSR_MDL* pMDL,
     *pModelIndex = pMDL->m_pAnimation[animationIndex].m_Start + animIndex;
 }
 //---------------------------------------------------------------------------
+void csrMDLUpdateIndex(const CSR_MDL* pMDL,
+                             size_t   fps,
+                             size_t   animationIndex,
+                             size_t*  pSkinIndex,
+                             size_t*  pModelIndex,
+                             size_t*  pMeshIndex,
+                             double*  pTextureLastTime,
+                             double*  pModelLastTime,
+                             double*  pMeshLastTime,
+                             double   elapsedTime)
+{
+    csrProfilerBegin("MDL frame selection");
+
+    csrMDLSelectIndex(pMDL,
+                      fps,
+                      animationIndex,
+                      pSkinIndex,
+                      pModelIndex,
+                      pMeshIndex,
+                      pTextureLastTime,
+                      pModelLastTime,
+                      pMeshLastTime,
+                      elapsedTime);
+
+    csrProfilerEnd();
+}
+//---------------------------------------------------------------------------
 CSR_Mesh* csrMDLGetMesh(const CSR_MDL* pMDL, size_t modelIndex, size_t meshIndex)
 {
     // no MDL model?
@@ -2786,6 +2832,55 @@ CSR_Mesh* csrMDLGetMesh(const CSR_MDL* pMDL, size_t modelIndex, size_t meshIndex
     return &pMDL->m_pModel[modelIndex].m_pMesh[meshIndex];
 }
 //---------------------------------------------------------------------------
+int csrMDLPackSkins(CSR_MDL* pMDL, CSR_TextureAtlas* pAtlas)
+{
+    size_t              i;
+    size_t              j;
+    size_t              first;
+    const CSR_Texture** ppTexture;
+
+    // validate the inputs
+    if (!pMDL || !pAtlas)
+        return 0;
+
+    // no skin, or skins already packed?
+    if (!pMDL->m_SkinCount || csrTextureAtlasFind(pAtlas, &pMDL->m_pSkin[0].m_Texture))
+        return 1;
+
+    // all the meshes should be remappable, otherwise the skins remain separated
+    for (i = 0; i < pMDL->m_ModelCount; ++i)
+        for (j = 0; j < pMDL->m_pModel[i].m_MeshCount; ++j)
+            if (!csrMeshCanUseAtlas(&pMDL->m_pModel[i].m_pMesh[j]))
+                return 1;
+
+    // allocate memory for the skin textures to pack
+    ppTexture = (const CSR_Texture**)malloc(pMDL->m_SkinCount * sizeof(CSR_Texture*));
+
+    // succeeded?
+    if (!ppTexture)
+        return 0;
+
+    for (i = 0; i < pMDL->m_SkinCount; ++i)
+        ppTexture[i] = &pMDL->m_pSkin[i].m_Texture;
+
+    // pack the skins. NOTE they share the same texture coordinates, thus they are packed at the
+    // same position in consecutive layers
+    first = csrTextureAtlasAddLayered(pAtlas, ppTexture, pMDL->m_SkinCount);
+
+    free(ppTexture);
+
+    // the skins can't be packed, they remain separated
+    if (first == (size_t)M_CSR_Unknown_Index)
+        return 1;
+
+    // remap the meshes in the packed skins
+    for (i = 0; i < pMDL->m_ModelCount; ++i)
+        for (j = 0; j < pMDL->m_pModel[i].m_MeshCount; ++j)
+            csrMeshRemapToAtlas(&pMDL->m_pModel[i].m_pMesh[j], &pAtlas->m_pItem[first]);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
 int csrMDLReadHeader(const CSR_Buffer* pBuffer, size_t* pOffset, CSR_MDLHeader* pHeader)
 {
     int success = 1;
@@ -3286,6 +3381,10 @@ void csrMDLPopulateModel(const CSR_MDLHeader*        pHeader,
                                          pModel->m_pMesh[i].m_pVB))
                     return;
             }
+
+        // index the frame vertices, the polygons share most of them. NOTE on failure the frame is
+        // still drawn without index
+        csrVertexBufferIndex(pModel->m_pMesh[i].m_pVB, 0, 0);
     }
 }
 //---------------------------------------------------------------------------
@@ -3504,6 +3603,11 @@ CSR_Model* csrWaveFrontCreate(const CSR_Buffer*           pBuffer,
     free(pUV);
     free(pFace);
 
+    // index the model vertices, the faces share most of them. NOTE on failure the model is still
+    // drawn without index
+    for (i = 0; i < pModel->m_MeshCount; ++i)
+        csrMeshIndex(&pModel->m_pMesh[i]);
+
     return pModel;
 }
 //------------------------------------------------------------------------------
@@ -4395,6 +4499,10 @@ CSR_Mesh* csrLandscapeCreate(const CSR_PixelBuffer*      pPixelBuffer,
     if (vertices.m_Length)
         free(vertices.m_pData);
 
+    // index the vertices, the adjacent polygons sharing the same normal share their vertices.
+    // NOTE on failure the landscape is still drawn without index
+    csrMeshIndex(pMesh);
+
     return pMesh;
 }
 //---------------------------------------------------------------------------
@@ -5321,6 +5429,229 @@ int csrXBuildVertex(const CSR_Item_X*                 pItem,
     return 1;
 }
 //---------------------------------------------------------------------------
+int csrXBuildSkinVB(CSR_X* pX, size_t meshIndex)
+{
+    size_t                       i;
+    size_t                       j;
+    size_t                       k;
+    size_t                       l;
+    size_t                       vertexCount;
+    float*                       pTotal;
+    const CSR_VertexBuffer*      pVB          = pX->m_pMesh[meshIndex].m_pVB;
+    CSR_VertexBuffer*            pSkinVB      = &pX->m_pSkinVB[meshIndex];
+    const CSR_MeshSkinWeights_X* pMeshWeights = &pX->m_pMeshWeights[meshIndex];
+
+    // configure the skin vertex format
+    pSkinVB->m_Format.m_Type              = CSR_VT_Triangles;
+    pSkinVB->m_Format.m_HasNormal         = 0;
+    pSkinVB->m_Format.m_HasTexCoords      = 0;
+    pSkinVB->m_Format.m_HasPerVertexColor = 0;
+    pSkinVB->m_Format.m_Stride            = M_X_SKIN_STRIDE;
+
+    // mesh isn't skinned?
+    if (!pMeshWeights->m_Count || !pVB->m_Format.m_Stride)
+        return 1;
+
+    vertexCount = pVB->m_Count / pVB->m_Format.m_Stride;
+
+    // allocate memory for the skin vertices, each one is initially influenced by no bone
+    pSkinVB->m_pData = (float*)calloc(vertexCount * M_X_SKIN_STRIDE, sizeof(float));
+
+    // succeeded?
+    if (!pSkinVB->m_pData)
+        return 0;
+
+    pSkinVB->m_Count = vertexCount * M_X_SKIN_STRIDE;
+
+    // allocate memory for the total weight of each vertex
+    pTotal = (float*)calloc(vertexCount, sizeof(float));
+
+    // succeeded? If not, don't keep a skin without weights
+    if (!pTotal)
+    {
+        csrVertexBufferContentRelease(pSkinVB);
+        return 0;
+    }
+
+    // iterate through the mesh skin weights, each one is linked to a bone
+    for (i = 0; i < pMeshWeights->m_Count; ++i)
+    {
+        const CSR_Skin_Weights* pSkinWeights = &pMeshWeights->m_pSkinWeights[i];
+
+        // iterate through the vertices influenced by the bone
+        for (j = 0; j < pSkinWeights->m_IndexTableCount && j < pSkinWeights->m_WeightCount; ++j)
+            for (k = 0; k < pSkinWeights->m_pIndexTable[j].m_Count; ++k)
+            {
+                size_t       slot;
+                float*       pSkin;
+                const float  weight = pSkinWeights->m_pWeights[j];
+                const size_t vertex = pSkinWeights->m_pIndexTable[j].m_pData[k] / pVB->m_Format.m_Stride;
+
+                // no influence?
+                if (weight <= 0.0f)
+                    continue;
+
+                pTotal[vertex] += weight;
+
+                // get the weakest influence on the vertex
+                pSkin = &pSkinVB->m_pData[vertex * M_X_SKIN_STRIDE];
+                slot  = 0;
+
+                for (l = 1; l < M_X_SKIN_INFLUENCES; ++l)
+                    if (pSkin[M_X_SKIN_INFLUENCES + l] < pSkin[M_X_SKIN_INFLUENCES + slot])
+                        slot = l;
+
+                // replace it if the bone influence is stronger
+                if (weight > pSkin[M_X_SKIN_INFLUENCES + slot])
+                {
+                    pSkin[slot]                       = (float)i;
+                    pSkin[M_X_SKIN_INFLUENCES + slot] = weight;
+                }
+            }
+    }
+
+    // if a vertex was influenced by too many bones, scale the kept weights to the total weight
+    for (i = 0; i < vertexCount; ++i)
+    {
+        float* pSkin = &pSkinVB->m_pData[i * M_X_SKIN_STRIDE];
+        float  kept  = 0.0f;
+
+        for (l = 0; l < M_X_SKIN_INFLUENCES; ++l)
+            kept += pSkin[M_X_SKIN_INFLUENCES + l];
+
+        if (kept > 0.0f && kept < pTotal[i])
+            for (l = 0; l < M_X_SKIN_INFLUENCES; ++l)
+                pSkin[M_X_SKIN_INFLUENCES + l] *= pTotal[i] / kept;
+    }
+
+    free(pTotal);
+
+    // notify that the skin vertices changed
+    csrVertexBufferUpdateGeneration(pSkinVB);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrXAddVertexGroup(size_t group, size_t** pGroup, size_t* pCount)
+{
+    // allocate memory for the new vertex group
+    size_t* pNewGroup = (size_t*)csrMemoryAlloc(*pGroup, sizeof(size_t), *pCount + 1);
+
+    // succeeded?
+    if (!pNewGroup)
+        return 0;
+
+    // add the group
+    pNewGroup[*pCount] = group;
+    *pGroup            = pNewGroup;
+    ++(*pCount);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrXIndexMesh(CSR_X* pX, size_t meshIndex, const size_t* pGroup)
+{
+    size_t            i;
+    size_t            j;
+    size_t            k;
+    size_t            l;
+    size_t            count;
+    size_t*           pMap;
+    float*            pData;
+    unsigned*         pIndex;
+    CSR_VertexBuffer* pVB = pX->m_pMesh[meshIndex].m_pVB;
+    CSR_VertexBuffer* pPrint;
+
+    // empty mesh?
+    if (!pVB->m_Count || !pVB->m_Format.m_Stride)
+        return 1;
+
+    // allocate memory for the vertex map
+    pMap = (size_t*)malloc((pVB->m_Count / pVB->m_Format.m_Stride) * sizeof(size_t));
+
+    // succeeded?
+    if (!pMap)
+        return 0;
+
+    // index the mesh. NOTE on failure, or if all the vertices are unique, the mesh remains valid
+    // and is drawn without index
+    if (!csrVertexBufferIndex(pVB, pGroup, pMap) || !pVB->m_pIndex)
+    {
+        free(pMap);
+        return 1;
+    }
+
+    // do draw mesh only, nothing more is required
+    if (pX->m_MeshOnly)
+    {
+        free(pMap);
+        return 1;
+    }
+
+    // iterate through the mesh skin weights
+    for (i = 0; i < pX->m_pMeshWeights[meshIndex].m_Count; ++i)
+    {
+        CSR_Skin_Weights* pSkinWeights = &pX->m_pMeshWeights[meshIndex].m_pSkinWeights[i];
+
+        // iterate through the vertex index tables
+        for (j = 0; j < pSkinWeights->m_IndexTableCount; ++j)
+        {
+            CSR_Skin_Weight_Index_Table* pTable = &pSkinWeights->m_pIndexTable[j];
+
+            count = 0;
+
+            // move the indices to the merged vertices. NOTE several source vertices may be merged
+            // in the same one, which should be influenced only once
+            for (k = 0; k < pTable->m_Count; ++k)
+            {
+                const size_t offset = pMap[pTable->m_pData[k] / pVB->m_Format.m_Stride] *
+                                      pVB->m_Format.m_Stride;
+
+                for (l = 0; l < count; ++l)
+                    if (pTable->m_pData[l] == offset)
+                        break;
+
+                if (l == count)
+                    pTable->m_pData[count++] = offset;
+            }
+
+            pTable->m_Count = count;
+        }
+    }
+
+    free(pMap);
+
+    pPrint = &pX->m_pPrint[meshIndex];
+
+    // the print is a copy of the mesh, thus replace its content by the merged vertices
+    pData  = (float*)   malloc(pVB->m_Count      * sizeof(float));
+    pIndex = (unsigned*)malloc(pVB->m_IndexCount * sizeof(unsigned));
+
+    // succeeded?
+    if (!pData || !pIndex)
+    {
+        free(pData);
+        free(pIndex);
+        return 0;
+    }
+
+    memcpy(pData,  pVB->m_pData,  pVB->m_Count      * sizeof(float));
+    memcpy(pIndex, pVB->m_pIndex, pVB->m_IndexCount * sizeof(unsigned));
+
+    free(pPrint->m_pData);
+    free(pPrint->m_pIndex);
+
+    pPrint->m_pData      = pData;
+    pPrint->m_Count      = pVB->m_Count;
+    pPrint->m_pIndex     = pIndex;
+    pPrint->m_IndexCount = pVB->m_IndexCount;
+
+    // notify that the print data changed
+    csrVertexBufferUpdateGeneration(pPrint);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
 int csrXBuildMesh(const CSR_Item_X*           pItem,
                         CSR_X*                pX,
                         CSR_Bone*             pBone,
@@ -5338,6 +5669,8 @@ int csrXBuildMesh(const CSR_Item_X*           pItem,
     size_t                      index;
     size_t                      meshWeightsIndex;
     size_t                      materialIndex;
+    size_t                      groupCount;
+    size_t*                     pGroup;
     unsigned                    prevColor;
     int                         hasTexture;
     CSR_Mesh*                   pMesh;
@@ -5594,6 +5927,8 @@ int csrXBuildMesh(const CSR_Item_X*           pItem,
     // is model supporting animations?
     if (!pX->m_MeshOnly)
     {
+        CSR_VertexBuffer* pSkinVB;
+
         // if the animation is used, also create the associated mesh print
         CSR_VertexBuffer* pPrint = (CSR_VertexBuffer*)csrMemoryAlloc(pX->m_pPrint,
                                                                      sizeof(CSR_VertexBuffer),
@@ -5605,11 +5940,26 @@ int csrXBuildMesh(const CSR_Item_X*           pItem,
 
         // update the model mesh print data
         pX->m_pPrint = pPrint;
+
+        // also create the associated skin vertex buffer
+        pSkinVB = (CSR_VertexBuffer*)csrMemoryAlloc(pX->m_pSkinVB,
+                                                    sizeof(CSR_VertexBuffer),
+                                                    pX->m_PrintCount + 1);
+
+        // succeeded?
+        if (!pSkinVB)
+            return 0;
+
+        // update the model skin vertex buffers
+        pX->m_pSkinVB = pSkinVB;
         ++pX->m_PrintCount;
 
         // initialize the vertex buffer for the mesh print
         csrVertexBufferInit(&pX->m_pPrint[index]);
 
+        // initialize the skin vertex buffer, it will be filled once the mesh vertices are known
+        csrVertexBufferInit(&pX->m_pSkinVB[index]);
+
         // copy the vertex format, culling and material from the source mesh
         pX->m_pPrint[index].m_Format   = pX->m_pMesh[index].m_pVB->m_Format;
         pX->m_pPrint[index].m_Culling  = pX->m_pMesh[index].m_pVB->m_Culling;
@@ -5689,6 +6039,8 @@ int csrXBuildMesh(const CSR_Item_X*           pItem,
     // keep the previous color, it may change while the mesh is created
     prevColor     = pX->m_pMesh[index].m_pVB->m_Material.m_Color;
     materialIndex = 0;
+    groupCount    = 0;
+    pGroup        = 0;
 
     // iterate through indice table
     for (i = 0; i < pMeshDataset->m_IndiceCount; i += pMeshDataset->m_pIndices[i] + 1)
@@ -5724,14 +6076,37 @@ int csrXBuildMesh(const CSR_Item_X*           pItem,
                                      pMatListItem,
                                      pMatListDataset,
                                      fOnGetVertexColor))
+                {
+                    free(pGroup);
                     return 0;
+                }
 
+                // keep the source vertex of the newly added one
+                if (!csrXAddVertexGroup(pMeshDataset->m_pIndices[vertIndex], &pGroup, &groupCount))
+                {
+                    free(pGroup);
+                    return 0;
+                }
             }
         }
 
         ++materialIndex;
     }
 
+    // index the mesh. NOTE only the copies of the same source vertex are merged, thus the merged
+    // vertices are always influenced by the same bones
+    if (!csrXIndexMesh(pX, index, pGroup))
+    {
+        free(pGroup);
+        return 0;
+    }
+
+    free(pGroup);
+
+    // bake the bone indices and weights of each vertex, thus the mesh may be skinned on the GPU
+    if (!pX->m_MeshOnly && !csrXBuildSkinVB(pX, index))
+        return 0;
+
     return 1;
 }
 //---------------------------------------------------------------------------
@@ -5969,6 +6344,7 @@ CSR_X* csrXCreate(const CSR_Buffer*           pBuffer,
     pX->m_MeshCount           = 0;
     pX->m_pPrint              = 0;
     pX->m_PrintCount          = 0;
+    pX->m_pSkinVB             = 0;
     pX->m_pMeshWeights        = 0;
     pX->m_MeshWeightsCount    = 0;
     pX->m_pMeshToBoneDict     = 0;
@@ -6100,8 +6476,7 @@ void csrXRelease(CSR_X* pX, const CSR_fOnDeleteTexture fOnDeleteTexture)
             {
                 // free the mesh vertex buffer content
                 for (j = 0; j < pX->m_pMesh[i].m_Count; ++j)
-                    if (pX->m_pMesh[i].m_pVB[j].m_pData)
-                        free(pX->m_pMesh[i].m_pVB[j].m_pData);
+                    csrVertexBufferContentRelease(&pX->m_pMesh[i].m_pVB[j]);
 
                 // free the mesh vertex buffer
                 free(pX->m_pMesh[i].m_pVB);
@@ -6117,13 +6492,23 @@ void csrXRelease(CSR_X* pX, const CSR_fOnDeleteTexture fOnDeleteTexture)
     {
         // free the print content
         for (i = 0; i < pX->m_PrintCount; ++i)
-            if (pX->m_pPrint[i].m_pData)
-                free(pX->m_pPrint[i].m_pData);
+            csrVertexBufferContentRelease(&pX->m_pPrint[i]);
 
         // free the print
         free(pX->m_pPrint);
     }
 
+    // release the skin vertex buffers
+    if (pX->m_pSkinVB)
+    {
+        // free the skin vertex buffers content
+        for (i = 0; i < pX->m_PrintCount; ++i)
+            csrVertexBufferContentRelease(&pX->m_pSkinVB[i]);
+
+        // free the skin vertex buffers
+        free(pX->m_pSkinVB);
+    }
+
     // release the weights
     if (pX->m_pMeshWeights)
     {
@@ -6171,6 +6556,48 @@ void csrXInit(CSR_X* pX)
         return;
 }
 //---------------------------------------------------------------------------
+int csrXPackSkins(CSR_X* pX, CSR_TextureAtlas* pAtlas)
+{
+    size_t    i;
+    size_t    index;
+    CSR_Mesh* pMesh;
+
+    // validate the inputs
+    if (!pX || !pAtlas)
+        return 0;
+
+    // iterate through the meshes, each of them owns its own skin
+    for (i = 0; i < pX->m_MeshCount; ++i)
+    {
+        pMesh = &pX->m_pMesh[i];
+
+        // no texture, or texture already packed?
+        if (!pMesh->m_Skin.m_Texture.m_pBuffer || csrTextureAtlasFind(pAtlas, &pMesh->m_Skin.m_Texture))
+            continue;
+
+        // the mesh and its print, if any, should be remappable, otherwise the skin remains separated
+        if (!csrMeshCanUseAtlas(pMesh) ||
+           (!pX->m_MeshOnly && i < pX->m_PrintCount && !csrVertexBufferCanUseAtlas(&pX->m_pPrint[i])))
+            continue;
+
+        // pack the skin
+        index = csrTextureAtlasAdd(pAtlas, &pMesh->m_Skin.m_Texture);
+
+        // the skin can't be packed, it remains separated
+        if (index == (size_t)M_CSR_Unknown_Index)
+            continue;
+
+        // remap the mesh in the packed skin
+        csrMeshRemapToAtlas(pMesh, &pAtlas->m_pItem[index]);
+
+        // the print is a copy of the mesh, and keeps its own texture coordinates
+        if (!pX->m_MeshOnly && i < pX->m_PrintCount)
+            csrVertexBufferRemapToAtlas(&pX->m_pPrint[i], &pAtlas->m_pItem[index]);
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
 int csrXParse(const CSR_Buffer* pBuffer, size_t* pOffset, CSR_Item_X** pItem)
 {
     size_t wordOffset    = *pOffset;
@@ -21,6 +21,7 @@
 #include "CSR_Geometry.h"
 #include "CSR_Vertex.h"
 #include "CSR_Texture.h"
+#include "CSR_Profiler.h"
 
 //---------------------------------------------------------------------------
 // Global defines
@@ -35,6 +36,8 @@
 #define M_X_FORMAT_COMPRESSED    ((' ' << 24) + ('p' << 16) + ('m' << 8) + 'c')
 #define M_X_FORMAT_FLOAT_BITS_32 (('2' << 24) + ('3' << 16) + ('0' << 8) + '0')
 #define M_X_FORMAT_FLOAT_BITS_64 (('4' << 24) + ('6' << 16) + ('0' << 8) + '0')
+#define M_X_SKIN_INFLUENCES      4 // max bones influencing a vertex skinned on the GPU
+#define M_X_SKIN_STRIDE          8 // skin vertex size, i.e. the bone indices followed by their weights
 
 //---------------------------------------------------------------------------
 // Enumerators
@@ -405,6 +408,7 @@ typedef struct
     size_t                 m_MeshCount;           // mesh count
     CSR_VertexBuffer*      m_pPrint;              // printed meshes (i.e ready to be painted)
     size_t                 m_PrintCount;          // printed mesh count
+    CSR_VertexBuffer*      m_pSkinVB;             // bone indices and weights of each mesh vertex, one buffer per print, empty if the mesh isn't skinned
     CSR_MeshSkinWeights_X* m_pMeshWeights;        // skin weights belonging to a mesh
     size_t                 m_MeshWeightsCount;    // skin weights count
     CSR_MeshBoneItem_X*    m_pMeshToBoneDict;     // mesh to bone dictionary
@@ -1083,6 +1087,20 @@ typedef void (*CSR_fOnApplySkin)(size_t index, const CSR_Skin* pSkin, int* pCanR
         */
         CSR_Mesh* csrMDLGetMesh(const CSR_MDL* pMDL, size_t modelIndex, size_t meshIndex);
 
+        /**
+        * Packs the MDL model skins in a texture atlas, and remaps its meshes in the packed skins
+        *@param[in, out] pMDL - MDL model for which the skins should be packed
+        *@param[in, out] pAtlas - texture atlas in which the skins should be packed
+        *@return 1 on success, otherwise 0
+        *@note The skin pixel buffers should be kept while the model is opened, see fOnApplySkin
+        *@note The skins are packed at the same position in consecutive layers, thus they remain
+        *      switchable. Their layer may be read with csrTextureAtlasFind(), and the page texture
+        *      to bind instead of a skin with csrTextureAtlasGetPageTexture()
+        *@note If the skins can't be packed (e.g. too large, or the texture coordinates repeat the
+        *      texture) the model is kept unchanged
+        */
+        int csrMDLPackSkins(CSR_MDL* pMDL, CSR_TextureAtlas* pAtlas);
+
         /**
         * Reads MDL header
         *@param pBuffer - buffer containing the MDL data
@@ -1500,6 +1518,19 @@ typedef void (*CSR_fOnApplySkin)(size_t index, const CSR_Skin* pSkin, int* pCanR
         */
         void csrXInit(CSR_X* pX);
 
+        /**
+        * Packs the X model mesh skins in a texture atlas, and remaps the meshes in the packed skins
+        *@param[in, out] pX - X model for which the skins should be packed
+        *@param[in, out] pAtlas - texture atlas in which the skins should be packed
+        *@return 1 on success, otherwise 0
+        *@note The skin pixel buffers should be kept while the model is opened, see fOnApplySkin
+        *@note Each mesh skin is packed separately, the skins which can't be packed (e.g. too large,
+        *      or the texture coordinates repeat the texture) remain separated. The packed skin
+        *      layer may be read with csrTextureAtlasFind(), and the page texture to bind instead
+        *      of the skin with csrTextureAtlasGetPageTexture()
+        */
+        int csrXPackSkins(CSR_X* pX, CSR_TextureAtlas* pAtlas);
+
         /**
         * Parses the x file content
         *@param pBuffer - buffer containing the x file to parse
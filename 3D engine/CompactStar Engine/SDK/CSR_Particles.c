@@ -258,8 +258,12 @@ void csrParticlesAnimate(CSR_Particles* pParticles, float elapsedTime)
     if (!pParticles || !pParticles->m_fOnCalculateMotion)
         return;
 
+    csrProfilerBegin("Particles animation");
+
     // iterate through each particles and calculate his motion
     for (i = 0; i < pParticles->m_Count; ++i)
         pParticles->m_fOnCalculateMotion(pParticles, &pParticles->m_pParticle[i], elapsedTime);
+
+    csrProfilerEnd();
 }
 //---------------------------------------------------------------------------
@@ -22,6 +22,7 @@
 // compactStar engine
 #include "CSR_Geometry.h"
 #include "CSR_Physics.h"
+#include "CSR_Profiler.h"
 
 //---------------------------------------------------------------------------
 // Prototypes
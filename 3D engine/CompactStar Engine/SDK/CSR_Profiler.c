@@ -0,0 +1,318 @@
+/****************************************************************************
+ * ==> CSR_Profiler --------------------------------------------------------*
+ ****************************************************************************
+ * Description : This module provides a lightweight frame profiler          *
+ * Developer   : Jean-Milost Reymond                                        *
+ * Copyright   : 2017 - 2019, this file is part of the CompactStar Engine.  *
+ *               You are free to copy or redistribute this file, modify it, *
+ *               or use it for your own projects, commercial or not. This   *
+ *               file is provided "as is", WITHOUT ANY WARRANTY OF ANY      *
+ *               KIND. THE DEVELOPER IS NOT RESPONSIBLE FOR ANY DAMAGE OF   *
+ *               ANY KIND, ANY LOSS OF DATA, OR ANY LOSS OF PRODUCTIVITY    *
+ *               TIME THAT MAY RESULT FROM THE USAGE OF THIS SOURCE CODE,   *
+ *               DIRECTLY OR NOT.                                           *
+ ****************************************************************************/
+
+#include "CSR_Profiler.h"
+
+// std
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//---------------------------------------------------------------------------
+// Global values
+//---------------------------------------------------------------------------
+M_CSR_Thread_Local CSR_Profiler* g_pProfiler = 0; // current profiler, one per thread
+//---------------------------------------------------------------------------
+// Profiler private functions
+//---------------------------------------------------------------------------
+size_t csrProfilerAddZone(CSR_Profiler* pProfiler, const char* pName, size_t parent)
+{
+    CSR_ProfilerZone* pZone;
+
+    // add a new zone
+    pZone = (CSR_ProfilerZone*)csrMemoryAlloc(pProfiler->m_pZone,
+                                              sizeof(CSR_ProfilerZone),
+                                              pProfiler->m_Count + 1);
+
+    // succeeded?
+    if (!pZone)
+        return (size_t)M_CSR_Unknown_Index;
+
+    pProfiler->m_pZone = pZone;
+
+    // initialize the zone. NOTE the frames preceding its creation aren't part of its history
+    pZone                = &pProfiler->m_pZone[pProfiler->m_Count];
+    pZone->m_pName       = pName;
+    pZone->m_Parent      = parent;
+    pZone->m_FirstFrame  = pProfiler->m_FrameCount;
+    pZone->m_Start       = 0.0;
+    pZone->m_FrameTime   = 0.0;
+    pZone->m_FrameCalls  = 0;
+    memset(pZone->m_Time,  0, sizeof(pZone->m_Time));
+    memset(pZone->m_Calls, 0, sizeof(pZone->m_Calls));
+
+    return pProfiler->m_Count++;
+}
+//---------------------------------------------------------------------------
+int csrProfilerCompareTime(const void* pValue1, const void* pValue2)
+{
+    const double value1 = *(const double*)pValue1;
+    const double value2 = *(const double*)pValue2;
+
+    if (value1 < value2)
+        return -1;
+
+    if (value1 > value2)
+        return 1;
+
+    return 0;
+}
+//---------------------------------------------------------------------------
+// Profiler functions
+//---------------------------------------------------------------------------
+CSR_Profiler* csrProfilerCreate(const CSR_fOnGetTime fOnGetTime)
+{
+    // create a new profiler
+    CSR_Profiler* pProfiler = (CSR_Profiler*)malloc(sizeof(CSR_Profiler));
+
+    // succeeded?
+    if (!pProfiler)
+        return 0;
+
+    // initialize the profiler content
+    csrProfilerInit(fOnGetTime, pProfiler);
+
+    return pProfiler;
+}
+//---------------------------------------------------------------------------
+void csrProfilerRelease(CSR_Profiler* pProfiler)
+{
+    // no profiler to release?
+    if (!pProfiler)
+        return;
+
+    // release the profiler content
+    csrProfilerContentRelease(pProfiler);
+
+    // free the profiler
+    free(pProfiler);
+}
+//---------------------------------------------------------------------------
+void csrProfilerInit(const CSR_fOnGetTime fOnGetTime, CSR_Profiler* pProfiler)
+{
+    // no profiler to initialize?
+    if (!pProfiler)
+        return;
+
+    // initialize the profiler
+    pProfiler->m_pZone      = 0;
+    pProfiler->m_Count      = 0;
+    pProfiler->m_Depth      = 0;
+    pProfiler->m_FrameCount = 0;
+    pProfiler->m_fOnGetTime = fOnGetTime;
+}
+//---------------------------------------------------------------------------
+void csrProfilerContentRelease(CSR_Profiler* pProfiler)
+{
+    // no profiler to release?
+    if (!pProfiler)
+        return;
+
+    // stop the profiling if the profiler is the current one of the calling thread
+    if (g_pProfiler == pProfiler)
+        g_pProfiler = 0;
+
+    // free the zones
+    free(pProfiler->m_pZone);
+
+    pProfiler->m_pZone = 0;
+    pProfiler->m_Count = 0;
+    pProfiler->m_Depth = 0;
+}
+//---------------------------------------------------------------------------
+void csrProfilerSetCurrent(CSR_Profiler* pProfiler)
+{
+    g_pProfiler = pProfiler;
+}
+//---------------------------------------------------------------------------
+CSR_Profiler* csrProfilerGetCurrent(void)
+{
+    return g_pProfiler;
+}
+//---------------------------------------------------------------------------
+void csrProfilerBegin(const char* pName)
+{
+    size_t        parent;
+    size_t        index;
+    CSR_Profiler* pProfiler = g_pProfiler;
+
+    // nothing to profile?
+    if (!pProfiler)
+        return;
+
+    // too many nested zones? (NOTE the depth is still counted, thus the zones remain balanced)
+    if (pProfiler->m_Depth >= M_CSR_Profiler_Max_Depth)
+    {
+        ++pProfiler->m_Depth;
+        return;
+    }
+
+    // get the parent zone
+    if (pProfiler->m_Depth)
+        parent = pProfiler->m_Stack[pProfiler->m_Depth - 1];
+    else
+        parent = (size_t)M_CSR_Unknown_Index;
+
+    index = (size_t)M_CSR_Unknown_Index;
+
+    // search for the zone, and create it if entered for the first time. NOTE a zone nested in an
+    // unknown zone, or without name or time function, is counted but not measured
+    if (pName && pProfiler->m_fOnGetTime && (!pProfiler->m_Depth || parent != (size_t)M_CSR_Unknown_Index))
+    {
+        index = csrProfilerFindZone(pProfiler, pName, parent);
+
+        if (index == (size_t)M_CSR_Unknown_Index)
+            index = csrProfilerAddZone(pProfiler, pName, parent);
+    }
+
+    pProfiler->m_Stack[pProfiler->m_Depth] = index;
+    ++pProfiler->m_Depth;
+
+    // start the zone timer
+    if (index != (size_t)M_CSR_Unknown_Index)
+        pProfiler->m_pZone[index].m_Start = pProfiler->m_fOnGetTime();
+}
+//---------------------------------------------------------------------------
+void csrProfilerEnd(void)
+{
+    size_t            index;
+    CSR_ProfilerZone* pZone;
+    CSR_Profiler*     pProfiler = g_pProfiler;
+
+    // nothing to profile, or no running zone?
+    if (!pProfiler || !pProfiler->m_Depth)
+        return;
+
+    --pProfiler->m_Depth;
+
+    // was the zone too deep to be measured?
+    if (pProfiler->m_Depth >= M_CSR_Profiler_Max_Depth)
+        return;
+
+    index = pProfiler->m_Stack[pProfiler->m_Depth];
+
+    // is the zone measured?
+    if (index == (size_t)M_CSR_Unknown_Index)
+        return;
+
+    // add the time spent in the zone to the current frame
+    pZone               = &pProfiler->m_pZone[index];
+    pZone->m_FrameTime += pProfiler->m_fOnGetTime() - pZone->m_Start;
+    ++pZone->m_FrameCalls;
+}
+//---------------------------------------------------------------------------
+void csrProfilerEndFrame(CSR_Profiler* pProfiler)
+{
+    size_t i;
+    size_t slot;
+
+    // no profiler?
+    if (!pProfiler)
+        return;
+
+    // get the history slot to write
+    slot = pProfiler->m_FrameCount % M_CSR_Profiler_History;
+
+    // add the frame to the zone histories. NOTE a zone still running is added to the frame in
+    // which it ends
+    for (i = 0; i < pProfiler->m_Count; ++i)
+    {
+        CSR_ProfilerZone* pZone = &pProfiler->m_pZone[i];
+
+        pZone->m_Time[slot]  = pZone->m_FrameTime;
+        pZone->m_Calls[slot] = pZone->m_FrameCalls;
+        pZone->m_FrameTime   = 0.0;
+        pZone->m_FrameCalls  = 0;
+    }
+
+    ++pProfiler->m_FrameCount;
+}
+//---------------------------------------------------------------------------
+size_t csrProfilerFindZone(const CSR_Profiler* pProfiler, const char* pName, size_t parent)
+{
+    size_t i;
+
+    // validate the inputs
+    if (!pProfiler || !pName)
+        return (size_t)M_CSR_Unknown_Index;
+
+    // search for the zone. NOTE the name addresses are compared first, as the names are generally
+    // literals, and the contents only if they differ
+    for (i = 0; i < pProfiler->m_Count; ++i)
+        if (pProfiler->m_pZone[i].m_Parent == parent &&
+           (pProfiler->m_pZone[i].m_pName == pName || !strcmp(pProfiler->m_pZone[i].m_pName, pName)))
+            return i;
+
+    return (size_t)M_CSR_Unknown_Index;
+}
+//---------------------------------------------------------------------------
+int csrProfilerGetStats(const CSR_Profiler* pProfiler, size_t index, CSR_ProfilerStats* pStats)
+{
+    size_t                  i;
+    size_t                  count;
+    size_t                  calls;
+    double                  total;
+    double                  time[M_CSR_Profiler_History];
+    const CSR_ProfilerZone* pZone;
+
+    // validate the inputs
+    if (!pProfiler || index >= pProfiler->m_Count || !pStats)
+        return 0;
+
+    pZone = &pProfiler->m_pZone[index];
+
+    // get the frame count contained in the zone history
+    count = pProfiler->m_FrameCount - pZone->m_FirstFrame;
+
+    if (count > M_CSR_Profiler_History)
+        count = M_CSR_Profiler_History;
+
+    pStats->m_FrameCount = count;
+
+    // no frame ended since the zone was created?
+    if (!count)
+    {
+        pStats->m_Min     = 0.0;
+        pStats->m_Max     = 0.0;
+        pStats->m_Average = 0.0;
+        pStats->m_P99     = 0.0;
+        pStats->m_Calls   = 0.0;
+        return 1;
+    }
+
+    total = 0.0;
+    calls = 0;
+
+    // copy the last frame times, from the newest to the oldest
+    for (i = 0; i < count; ++i)
+    {
+        const size_t slot = (pProfiler->m_FrameCount - 1 - i) % M_CSR_Profiler_History;
+
+        time[i] = pZone->m_Time[slot];
+        total  += pZone->m_Time[slot];
+        calls  += pZone->m_Calls[slot];
+    }
+
+    // sort the times, to find the percentile
+    qsort(time, count, sizeof(double), csrProfilerCompareTime);
+
+    pStats->m_Min     = time[0];
+    pStats->m_Max     = time[count - 1];
+    pStats->m_Average = total / count;
+    pStats->m_P99     = time[(size_t)ceil(count * 0.99) - 1];
+    pStats->m_Calls   = (double)calls / count;
+
+    return 1;
+}
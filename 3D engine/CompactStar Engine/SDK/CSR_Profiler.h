@@ -0,0 +1,194 @@
+/****************************************************************************
+ * ==> CSR_Profiler --------------------------------------------------------*
+ ****************************************************************************
+ * Description : This module provides a lightweight frame profiler          *
+ * Developer   : Jean-Milost Reymond                                        *
+ * Copyright   : 2017 - 2019, this file is part of the CompactStar Engine.  *
+ *               You are free to copy or redistribute this file, modify it, *
+ *               or use it for your own projects, commercial or not. This   *
+ *               file is provided "as is", WITHOUT ANY WARRANTY OF ANY      *
+ *               KIND. THE DEVELOPER IS NOT RESPONSIBLE FOR ANY DAMAGE OF   *
+ *               ANY KIND, ANY LOSS OF DATA, OR ANY LOSS OF PRODUCTIVITY    *
+ *               TIME THAT MAY RESULT FROM THE USAGE OF THIS SOURCE CODE,   *
+ *               DIRECTLY OR NOT.                                           *
+ ****************************************************************************/
+
+#ifndef CSR_ProfilerH
+#define CSR_ProfilerH
+
+// std
+#include <stddef.h>
+
+// compactStar engine
+#include "CSR_Common.h"
+
+//---------------------------------------------------------------------------
+// Global defines
+//---------------------------------------------------------------------------
+#define M_CSR_Profiler_History   128 // frames kept in the history of each zone
+#define M_CSR_Profiler_Max_Depth 32  // maximum nested zones, the deeper zones are ignored
+
+//---------------------------------------------------------------------------
+// Callbacks
+//---------------------------------------------------------------------------
+
+/**
+* Called when the profiler needs the current time
+*@return current time, in milliseconds, from any fixed origin
+*@note The time should be monotonic and as precise as possible, e.g. QueryPerformanceCounter()
+*      on Windows, mach_absolute_time() on iOS or clock_gettime(CLOCK_MONOTONIC) on Android
+*/
+typedef double (*CSR_fOnGetTime)(void);
+
+//---------------------------------------------------------------------------
+// Structures
+//---------------------------------------------------------------------------
+
+/**
+* Profiler zone, i.e. a named code section measured in each frame
+*/
+typedef struct
+{
+    const char* m_pName;                           // zone name, should remain valid while the profiler is used
+    size_t      m_Parent;                          // parent zone index, M_CSR_Unknown_Index if the zone is a root
+    size_t      m_FirstFrame;                      // frame during which the zone was first entered
+    double      m_Start;                           // time at which the zone was last entered
+    double      m_FrameTime;                       // time spent in the zone during the current frame
+    size_t      m_FrameCalls;                      // zone entries during the current frame
+    double      m_Time[M_CSR_Profiler_History];    // time spent in the zone in the last frames, in a ring buffer
+    size_t      m_Calls[M_CSR_Profiler_History];   // zone entries in the last frames, in a ring buffer
+} CSR_ProfilerZone;
+
+/**
+* Profiler zone statistics, calculated on the zone history
+*/
+typedef struct
+{
+    double m_Min;        // shortest frame time, in milliseconds
+    double m_Max;        // longest frame time, in milliseconds
+    double m_Average;    // average frame time, in milliseconds
+    double m_P99;        // 99th percentile of the frame times, in milliseconds
+    double m_Calls;      // average zone entries per frame
+    size_t m_FrameCount; // frames on which the statistics were calculated
+} CSR_ProfilerStats;
+
+/**
+* Profiler
+*/
+typedef struct
+{
+    CSR_ProfilerZone* m_pZone;                           // measured zones
+    size_t            m_Count;                           // zone count
+    size_t            m_Stack[M_CSR_Profiler_Max_Depth]; // running zones, from the outermost to the innermost
+    size_t            m_Depth;                           // running zone count, may exceed the stack size
+    size_t            m_FrameCount;                      // ended frame count
+    CSR_fOnGetTime    m_fOnGetTime;                      // function returning the current time
+} CSR_Profiler;
+
+#ifdef __cplusplus
+    extern "C"
+    {
+#endif
+        //-------------------------------------------------------------------
+        // Profiler functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a profiler
+        *@param fOnGetTime - function returning the current time
+        *@return newly created profiler, 0 on error
+        *@note The profiler must be released when no longer used, see csrProfilerRelease()
+        */
+        CSR_Profiler* csrProfilerCreate(const CSR_fOnGetTime fOnGetTime);
+
+        /**
+        * Releases a profiler
+        *@param[in, out] pProfiler - profiler to release
+        *@note If the profiler is the current one of the calling thread, the profiling is stopped. The
+        *      other threads using it should stop the profiling before, see csrProfilerSetCurrent()
+        */
+        void csrProfilerRelease(CSR_Profiler* pProfiler);
+
+        /**
+        * Initializes a profiler
+        *@param fOnGetTime - function returning the current time
+        *@param[in, out] pProfiler - profiler to initialize
+        */
+        void csrProfilerInit(const CSR_fOnGetTime fOnGetTime, CSR_Profiler* pProfiler);
+
+        /**
+        * Releases the profiler content
+        *@param[in, out] pProfiler - profiler for which the content should be released
+        *@note Only the content is released, the profiler itself is not released
+        */
+        void csrProfilerContentRelease(CSR_Profiler* pProfiler);
+
+        /**
+        * Sets the profiler in which the engine zones entered by the calling thread are measured
+        *@param pProfiler - profiler to use, 0 to stop the profiling
+        *@note The current profiler is kept per thread, thus e.g. the render and the update threads
+        *      may each measure their zones in their own profiler, or only one of them may be profiled.
+        *      A profiler isn't thread safe, and should never be current in several threads at once
+        *@note On compilers without thread local storage (i.e. other than gcc, clang or Visual C++),
+        *      the current profiler is shared by all the threads, and the zones should be entered by
+        *      only one thread
+        *@note While no profiler is set, entering and leaving a zone costs only a test
+        */
+        void csrProfilerSetCurrent(CSR_Profiler* pProfiler);
+
+        /**
+        * Gets the profiler in which the engine zones entered by the calling thread are measured
+        *@return current profiler, 0 if none
+        */
+        CSR_Profiler* csrProfilerGetCurrent(void);
+
+        /**
+        * Enters a zone in the current profiler, nested in the running zone if any
+        *@param pName - zone name, should remain valid while the profiler is used (e.g. a literal)
+        *@note Each call should be followed by a csrProfilerEnd() call
+        */
+        void csrProfilerBegin(const char* pName);
+
+        /**
+        * Leaves the zone entered by the last csrProfilerBegin() call in the current profiler
+        */
+        void csrProfilerEnd(void);
+
+        /**
+        * Ends the current frame, i.e. adds the time spent in each zone to their history
+        *@param[in, out] pProfiler - profiler for which the frame should be ended
+        */
+        void csrProfilerEndFrame(CSR_Profiler* pProfiler);
+
+        /**
+        * Finds a zone in a profiler
+        *@param pProfiler - profiler in which the zone should be found
+        *@param pName - zone name
+        *@param parent - parent zone index, M_CSR_Unknown_Index to find a root zone
+        *@return zone index, M_CSR_Unknown_Index if not found
+        */
+        size_t csrProfilerFindZone(const CSR_Profiler* pProfiler, const char* pName, size_t parent);
+
+        /**
+        * Gets a zone statistics, calculated on the frames contained in its history
+        *@param pProfiler - profiler containing the zone
+        *@param index - zone index
+        *@param[out] pStats - zone statistics
+        *@return 1 on success, otherwise 0
+        */
+        int csrProfilerGetStats(const CSR_Profiler* pProfiler, size_t index, CSR_ProfilerStats* pStats);
+
+#ifdef __cplusplus
+    }
+#endif
+
+//---------------------------------------------------------------------------
+// Compiler
+//---------------------------------------------------------------------------
+
+// needed in mobile c compiler to link the .h file with the .c
+#if defined(_OS_IOS_) || defined(_OS_ANDROID_) || defined(_OS_WINDOWS_)
+    #include "CSR_Profiler.c"
+#endif
+
+#endif
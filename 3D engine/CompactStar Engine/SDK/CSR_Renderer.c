@@ -17,6 +17,7 @@
 
 // std
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef CSR_USE_OPENGL
     #include "CSR_Renderer_OpenGL.h"
@@ -24,11 +25,169 @@
     #include "CSR_Renderer_Metal.h"
 #endif
 
+//---------------------------------------------------------------------------
+// Global values
+//---------------------------------------------------------------------------
+M_CSR_Thread_Local CSR_RenderCommandBuffer* g_pRenderCommandBuffer = 0; // recording buffer, one per thread
+//---------------------------------------------------------------------------
+// Render command buffer private functions
+//---------------------------------------------------------------------------
+int csrRenderCommandBufferPush(      CSR_RenderCommandBuffer* pBuffer,
+                               const CSR_RenderCommand*       pCommand,
+                                     size_t                   size,
+                                     unsigned char**          ppData)
+{
+    size_t offset;
+
+    *ppData = 0;
+
+    // is the command array full?
+    if (pBuffer->m_Count >= pBuffer->m_Capacity)
+    {
+        const size_t       capacity  = pBuffer->m_Capacity ? pBuffer->m_Capacity * 2 : 64;
+        CSR_RenderCommand* pCommands = (CSR_RenderCommand*)csrMemoryAlloc(pBuffer->m_pCommand,
+                                                                          sizeof(CSR_RenderCommand),
+                                                                          capacity);
+
+        // succeeded?
+        if (!pCommands)
+        {
+            ++pBuffer->m_LostCount;
+            return 0;
+        }
+
+        pBuffer->m_pCommand = pCommands;
+        pBuffer->m_Capacity = capacity;
+    }
+
+    offset = (size_t)M_CSR_Unknown_Index;
+
+    // reserve the command data, if any. NOTE the data are aligned on 8 bytes, which is enough for
+    // the matrices, colors and lines they contain
+    if (size)
+    {
+        offset = (pBuffer->m_DataSize + 7) & ~(size_t)7;
+
+        // is the data array full?
+        if (offset + size > pBuffer->m_DataCapacity)
+        {
+            unsigned char* pNewData;
+            size_t         capacity = pBuffer->m_DataCapacity ? pBuffer->m_DataCapacity : 1024;
+
+            while (offset + size > capacity)
+                capacity *= 2;
+
+            pNewData = (unsigned char*)csrMemoryAlloc(pBuffer->m_pData, sizeof(unsigned char), capacity);
+
+            // succeeded?
+            if (!pNewData)
+            {
+                ++pBuffer->m_LostCount;
+                return 0;
+            }
+
+            pBuffer->m_pData        = pNewData;
+            pBuffer->m_DataCapacity = capacity;
+        }
+
+        *ppData             = pBuffer->m_pData + offset;
+        pBuffer->m_DataSize = offset + size;
+    }
+
+    // add the command
+    pBuffer->m_pCommand[pBuffer->m_Count]        = *pCommand;
+    pBuffer->m_pCommand[pBuffer->m_Count].m_Data =  offset;
+    ++pBuffer->m_Count;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrRenderCommandBufferRecord(      CSR_ERenderCommandType type,
+                                  const void*                  pShader,
+                                  const void*                  pModel,
+                                  const CSR_Array*             pMatrixArray,
+                                  const CSR_fOnGetID           fOnGetID,
+                                        size_t                 index0,
+                                        size_t                 index1,
+                                        size_t                 index2,
+                                  const void*                  pData,
+                                        size_t                 size)
+{
+    size_t            i;
+    unsigned char*    pMatrices;
+    CSR_RenderCommand command;
+
+    // build the command
+    command.m_Type        = type;
+    command.m_pShader     = pShader;
+    command.m_pModel      = pModel;
+    command.m_MatrixCount = 0;
+    command.m_fOnGetID    = fOnGetID;
+    command.m_Index[0]    = index0;
+    command.m_Index[1]    = index1;
+    command.m_Index[2]    = index2;
+    command.m_Data        = (size_t)M_CSR_Unknown_Index;
+
+    // no matrix to draw with? Just add the command to the current buffer, with its value if any
+    if (!pMatrixArray || !pMatrixArray->m_Count)
+    {
+        csrRenderCommandBufferAdd(g_pRenderCommandBuffer, &command, pData, size);
+        return;
+    }
+
+    command.m_MatrixCount = pMatrixArray->m_Count;
+
+    // add the command with room for its matrices. NOTE the matrices are copied, because the array
+    // may be modified or released before the buffer is replayed (e.g. the visible matrices of a
+    // scene draw list)
+    if (!csrRenderCommandBufferPush(g_pRenderCommandBuffer,
+                                    &command,
+                                     pMatrixArray->m_Count * sizeof(CSR_Matrix4),
+                                    &pMatrices))
+        return;
+
+    // copy the matrices
+    for (i = 0; i < pMatrixArray->m_Count; ++i)
+        memcpy(pMatrices + i * sizeof(CSR_Matrix4), pMatrixArray->m_pItem[i].m_pData, sizeof(CSR_Matrix4));
+}
+//---------------------------------------------------------------------------
+void csrRenderCommandBufferCountMesh(const CSR_Mesh*               pMesh,
+                                           size_t                  matrixCount,
+                                           CSR_RenderCommandStats* pStats)
+{
+    size_t i;
+    size_t instanceCount;
+
+    // no mesh?
+    if (!pMesh)
+        return;
+
+    // without matrix, the mesh is drawn once with the connected model matrix
+    if (matrixCount)
+        instanceCount = matrixCount;
+    else
+        instanceCount = 1;
+
+    // count the vertex buffers to draw
+    for (i = 0; i < pMesh->m_Count; ++i)
+    {
+        ++pStats->m_DrawCount;
+        pStats->m_InstanceCount += instanceCount;
+        pStats->m_VertexCount   += csrVertexBufferGetElementCount(&pMesh->m_pVB[i]) * instanceCount;
+    }
+}
 //---------------------------------------------------------------------------
 // Shader functions
 //---------------------------------------------------------------------------
 void csrShaderEnable(const void* pShader)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_ShaderEnable, pShader, 0, 0, 0, 0, 0, 0, 0, 0);
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLShaderEnable((CSR_OpenGLShader*)pShader);
     #elif defined(CSR_USE_METAL)
@@ -40,6 +199,22 @@ void csrShaderEnable(const void* pShader)
 //---------------------------------------------------------------------------
 void csrShaderConnectProjectionMatrix(const void* pShader, const CSR_Matrix4* pMatrix)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_ShaderConnectProjectionMatrix,
+                                     pShader,
+                                     0,
+                                     0,
+                                     0,
+                                     0,
+                                     0,
+                                     0,
+                                     pMatrix,
+                                     sizeof(CSR_Matrix4));
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLShaderConnectProjectionMatrix((CSR_OpenGLShader*)pShader, pMatrix);
     #elif defined(CSR_USE_METAL)
@@ -51,6 +226,22 @@ void csrShaderConnectProjectionMatrix(const void* pShader, const CSR_Matrix4* pM
 //---------------------------------------------------------------------------
 void csrShaderConnectViewMatrix(const void* pShader, const CSR_Matrix4* pMatrix)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_ShaderConnectViewMatrix,
+                                     pShader,
+                                     0,
+                                     0,
+                                     0,
+                                     0,
+                                     0,
+                                     0,
+                                     pMatrix,
+                                     sizeof(CSR_Matrix4));
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLShaderConnectViewMatrix((CSR_OpenGLShader*)pShader, pMatrix);
     #elif defined(CSR_USE_METAL)
@@ -64,6 +255,13 @@ void csrShaderConnectViewMatrix(const void* pShader, const CSR_Matrix4* pMatrix)
 //---------------------------------------------------------------------------
 void csrDrawBegin(const CSR_Color* pColor)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_DrawBegin, 0, 0, 0, 0, 0, 0, 0, pColor, sizeof(CSR_Color));
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLDrawBegin(pColor);
     #elif defined(CSR_USE_METAL)
@@ -75,6 +273,13 @@ void csrDrawBegin(const CSR_Color* pColor)
 //---------------------------------------------------------------------------
 void csrDrawEnd(void)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_DrawEnd, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLDrawEnd();
     #elif defined(CSR_USE_METAL)
@@ -86,6 +291,13 @@ void csrDrawEnd(void)
 //---------------------------------------------------------------------------
 void csrDrawLine(const CSR_Line* pLine, const void* pShader)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_DrawLine, pShader, 0, 0, 0, 0, 0, 0, pLine, sizeof(CSR_Line));
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLDrawLine(pLine, (CSR_OpenGLShader*)pShader);
     #elif defined(CSR_USE_METAL)
@@ -99,6 +311,13 @@ void csrDrawVertexBuffer(const CSR_VertexBuffer* pVB,
                          const void*             pShader,
                          const CSR_Array*        pMatrixArray)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_DrawVertexBuffer, pShader, pVB, pMatrixArray, 0, 0, 0, 0, 0, 0);
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLDrawVertexBuffer(pVB, (CSR_OpenGLShader*)pShader, pMatrixArray);
     #elif defined(CSR_USE_METAL)
@@ -113,6 +332,13 @@ void csrDrawMesh(const CSR_Mesh*    pMesh,
                  const CSR_Array*   pMatrixArray,
                  const CSR_fOnGetID fOnGetID)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_DrawMesh, pShader, pMesh, pMatrixArray, fOnGetID, 0, 0, 0, 0, 0);
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLDrawMesh(pMesh, (CSR_OpenGLShader*)pShader, pMatrixArray, fOnGetID);
     #elif defined(CSR_USE_METAL)
@@ -128,6 +354,22 @@ void csrDrawModel(const CSR_Model*   pModel,
                   const CSR_Array*   pMatrixArray,
                   const CSR_fOnGetID fOnGetID)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_DrawModel,
+                                     pShader,
+                                     pModel,
+                                     pMatrixArray,
+                                     fOnGetID,
+                                     index,
+                                     0,
+                                     0,
+                                     0,
+                                     0);
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLDrawModel(pModel, index, (CSR_OpenGLShader*)pShader, pMatrixArray, fOnGetID);
     #elif defined(CSR_USE_METAL)
@@ -145,6 +387,22 @@ void csrDrawMDL(const CSR_MDL*     pMDL,
                       size_t       meshIndex,
                 const CSR_fOnGetID fOnGetID)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_DrawMDL,
+                                     pShader,
+                                     pMDL,
+                                     pMatrixArray,
+                                     fOnGetID,
+                                     skinIndex,
+                                     modelIndex,
+                                     meshIndex,
+                                     0,
+                                     0);
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLDrawMDL(pMDL,
                         (CSR_OpenGLShader*)pShader,
@@ -173,6 +431,22 @@ void csrDrawX(const CSR_X*       pX,
                     size_t       frameIndex,
               const CSR_fOnGetID fOnGetID)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_DrawX,
+                                     pShader,
+                                     pX,
+                                     pMatrixArray,
+                                     fOnGetID,
+                                     animSetIndex,
+                                     frameIndex,
+                                     0,
+                                     0,
+                                     0);
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLDrawX(pX,
                       (CSR_OpenGLShader*)pShader,
@@ -196,6 +470,13 @@ void csrDrawX(const CSR_X*       pX,
 //---------------------------------------------------------------------------
 void csrStateEnableDepthMask(int value)
 {
+    // recording the commands?
+    if (g_pRenderCommandBuffer)
+    {
+        csrRenderCommandBufferRecord(CSR_RC_StateEnableDepthMask, 0, 0, 0, 0, value, 0, 0, 0, 0);
+        return;
+    }
+
     #ifdef CSR_USE_OPENGL
         csrOpenGLStateEnableDepthMask(value);
     #elif defined(CSR_USE_METAL)
@@ -205,3 +486,460 @@ void csrStateEnableDepthMask(int value)
     #endif
 }
 //---------------------------------------------------------------------------
+// Render command buffer functions
+//---------------------------------------------------------------------------
+CSR_RenderCommandBuffer* csrRenderCommandBufferCreate(void)
+{
+    // create a new render command buffer
+    CSR_RenderCommandBuffer* pBuffer = (CSR_RenderCommandBuffer*)malloc(sizeof(CSR_RenderCommandBuffer));
+
+    // succeeded?
+    if (!pBuffer)
+        return 0;
+
+    // initialize the render command buffer content
+    csrRenderCommandBufferInit(pBuffer);
+
+    return pBuffer;
+}
+//---------------------------------------------------------------------------
+void csrRenderCommandBufferRelease(CSR_RenderCommandBuffer* pBuffer)
+{
+    // no render command buffer to release?
+    if (!pBuffer)
+        return;
+
+    // release the render command buffer content
+    csrRenderCommandBufferContentRelease(pBuffer);
+
+    // free the render command buffer
+    free(pBuffer);
+}
+//---------------------------------------------------------------------------
+void csrRenderCommandBufferInit(CSR_RenderCommandBuffer* pBuffer)
+{
+    // no render command buffer to initialize?
+    if (!pBuffer)
+        return;
+
+    // initialize the render command buffer
+    pBuffer->m_pCommand     = 0;
+    pBuffer->m_Count        = 0;
+    pBuffer->m_Capacity     = 0;
+    pBuffer->m_pData        = 0;
+    pBuffer->m_DataSize     = 0;
+    pBuffer->m_DataCapacity = 0;
+    pBuffer->m_LostCount    = 0;
+}
+//---------------------------------------------------------------------------
+void csrRenderCommandBufferContentRelease(CSR_RenderCommandBuffer* pBuffer)
+{
+    // no render command buffer to release?
+    if (!pBuffer)
+        return;
+
+    // stop the recording if the buffer is the current one of the calling thread
+    if (g_pRenderCommandBuffer == pBuffer)
+        g_pRenderCommandBuffer = 0;
+
+    // free the commands and their data
+    free(pBuffer->m_pCommand);
+    free(pBuffer->m_pData);
+
+    csrRenderCommandBufferInit(pBuffer);
+}
+//---------------------------------------------------------------------------
+void csrRenderCommandBufferClear(CSR_RenderCommandBuffer* pBuffer)
+{
+    // no render command buffer to clear?
+    if (!pBuffer)
+        return;
+
+    pBuffer->m_Count     = 0;
+    pBuffer->m_DataSize  = 0;
+    pBuffer->m_LostCount = 0;
+}
+//---------------------------------------------------------------------------
+int csrRenderCommandBufferAdd(      CSR_RenderCommandBuffer* pBuffer,
+                              const CSR_RenderCommand*       pCommand,
+                              const void*                    pData,
+                                    size_t                   size)
+{
+    unsigned char* pCopy;
+
+    // validate the inputs
+    if (!pBuffer || !pCommand)
+        return 0;
+
+    // add the command with room for its value, if any
+    if (!csrRenderCommandBufferPush(pBuffer, pCommand, pData ? size : 0, &pCopy))
+        return 0;
+
+    // copy the value
+    if (pCopy)
+        memcpy(pCopy, pData, size);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrRenderCommandBufferAppend(CSR_RenderCommandBuffer* pBuffer, const CSR_RenderCommandBuffer* pOther)
+{
+    size_t i;
+
+    // validate the inputs
+    if (!pBuffer || !pOther || pBuffer == pOther)
+        return 0;
+
+    // the lost commands are lost in the whole buffer
+    pBuffer->m_LostCount += pOther->m_LostCount;
+
+    // copy the commands with their values. NOTE the value sizes aren't stored, but are known from
+    // the command types and the matrix counts
+    for (i = 0; i < pOther->m_Count; ++i)
+    {
+        const CSR_RenderCommand* pCommand = &pOther->m_pCommand[i];
+        const void*              pData    = csrRenderCommandBufferGetData(pOther, pCommand);
+        size_t                   size;
+
+        switch (pCommand->m_Type)
+        {
+            case CSR_RC_ShaderConnectProjectionMatrix:
+            case CSR_RC_ShaderConnectViewMatrix: size = sizeof(CSR_Matrix4); break;
+            case CSR_RC_DrawBegin:               size = sizeof(CSR_Color);   break;
+            case CSR_RC_DrawLine:                size = sizeof(CSR_Line);    break;
+            default:                             size = 0;                   break;
+        }
+
+        // the draw commands may contain their matrices
+        if (pCommand->m_MatrixCount)
+            size = pCommand->m_MatrixCount * sizeof(CSR_Matrix4);
+
+        if (!csrRenderCommandBufferAdd(pBuffer, pCommand, pData, size))
+            return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+const void* csrRenderCommandBufferGetData(const CSR_RenderCommandBuffer* pBuffer,
+                                          const CSR_RenderCommand*       pCommand)
+{
+    // validate the inputs
+    if (!pBuffer || !pCommand || pCommand->m_Data == (size_t)M_CSR_Unknown_Index)
+        return 0;
+
+    return pBuffer->m_pData + pCommand->m_Data;
+}
+//---------------------------------------------------------------------------
+void csrRenderCommandBufferReplay(const CSR_RenderCommandBuffer* pBuffer)
+{
+    size_t                   i;
+    size_t                   j;
+    size_t                   itemCount;
+    CSR_Array                matrixArray;
+    CSR_RenderCommandBuffer* pRecording;
+
+    // no render command buffer to replay?
+    if (!pBuffer)
+        return;
+
+    // suspend the recording of the calling thread, if any, the commands should be executed
+    pRecording             = g_pRenderCommandBuffer;
+    g_pRenderCommandBuffer = 0;
+
+    csrArrayInit(&matrixArray);
+    itemCount = 0;
+
+    // execute the commands
+    for (i = 0; i < pBuffer->m_Count; ++i)
+    {
+        const CSR_RenderCommand* pCommand     = &pBuffer->m_pCommand[i];
+        const void*              pData        = csrRenderCommandBufferGetData(pBuffer, pCommand);
+        const CSR_Array*         pMatrixArray = 0;
+
+        // does the command draw with copied matrices?
+        if (pCommand->m_MatrixCount && pData)
+        {
+            // grow the matrix array items, if required. NOTE they're kept for the next commands
+            if (pCommand->m_MatrixCount > itemCount)
+            {
+                CSR_ArrayItem* pItem = (CSR_ArrayItem*)csrMemoryAlloc(matrixArray.m_pItem,
+                                                                      sizeof(CSR_ArrayItem),
+                                                                      pCommand->m_MatrixCount);
+
+                // succeeded? If not, the command cannot be drawn
+                if (!pItem)
+                    continue;
+
+                matrixArray.m_pItem = pItem;
+                itemCount           = pCommand->m_MatrixCount;
+            }
+
+            // link the matrix copies
+            for (j = 0; j < pCommand->m_MatrixCount; ++j)
+            {
+                matrixArray.m_pItem[j].m_pData    = (CSR_Matrix4*)pData + j;
+                matrixArray.m_pItem[j].m_AutoFree = 0;
+            }
+
+            matrixArray.m_Count = pCommand->m_MatrixCount;
+            pMatrixArray        = &matrixArray;
+        }
+
+        switch (pCommand->m_Type)
+        {
+            case CSR_RC_ShaderEnable:
+                csrShaderEnable(pCommand->m_pShader);
+                break;
+
+            case CSR_RC_ShaderConnectProjectionMatrix:
+                csrShaderConnectProjectionMatrix(pCommand->m_pShader, (const CSR_Matrix4*)pData);
+                break;
+
+            case CSR_RC_ShaderConnectViewMatrix:
+                csrShaderConnectViewMatrix(pCommand->m_pShader, (const CSR_Matrix4*)pData);
+                break;
+
+            case CSR_RC_DrawBegin:
+                csrDrawBegin((const CSR_Color*)pData);
+                break;
+
+            case CSR_RC_DrawEnd:
+                csrDrawEnd();
+                break;
+
+            case CSR_RC_DrawLine:
+                csrDrawLine((const CSR_Line*)pData, pCommand->m_pShader);
+                break;
+
+            case CSR_RC_DrawVertexBuffer:
+                csrDrawVertexBuffer((const CSR_VertexBuffer*)pCommand->m_pModel,
+                                    pCommand->m_pShader,
+                                    pMatrixArray);
+                break;
+
+            case CSR_RC_DrawMesh:
+                csrDrawMesh((const CSR_Mesh*)pCommand->m_pModel,
+                            pCommand->m_pShader,
+                            pMatrixArray,
+                            pCommand->m_fOnGetID);
+                break;
+
+            case CSR_RC_DrawModel:
+                csrDrawModel((const CSR_Model*)pCommand->m_pModel,
+                             pCommand->m_Index[0],
+                             pCommand->m_pShader,
+                             pMatrixArray,
+                             pCommand->m_fOnGetID);
+                break;
+
+            case CSR_RC_DrawMDL:
+                csrDrawMDL((const CSR_MDL*)pCommand->m_pModel,
+                           pCommand->m_pShader,
+                           pMatrixArray,
+                           pCommand->m_Index[0],
+                           pCommand->m_Index[1],
+                           pCommand->m_Index[2],
+                           pCommand->m_fOnGetID);
+                break;
+
+            case CSR_RC_DrawX:
+                csrDrawX((const CSR_X*)pCommand->m_pModel,
+                         pCommand->m_pShader,
+                         pMatrixArray,
+                         pCommand->m_Index[0],
+                         pCommand->m_Index[1],
+                         pCommand->m_fOnGetID);
+                break;
+
+            case CSR_RC_StateEnableDepthMask:
+                csrStateEnableDepthMask((int)pCommand->m_Index[0]);
+                break;
+        }
+    }
+
+    free(matrixArray.m_pItem);
+
+    // resume the recording
+    g_pRenderCommandBuffer = pRecording;
+}
+//---------------------------------------------------------------------------
+int csrRenderCommandBufferValidate(const CSR_RenderCommandBuffer* pBuffer,
+                                         CSR_RenderCommandStats*  pStats)
+{
+    size_t                 i;
+    int                    drawing;
+    int                    shaderKnown;
+    const void*            pEnabledShader;
+    CSR_RenderCommandStats stats;
+
+    // no render command buffer to validate?
+    if (!pBuffer)
+        return 0;
+
+    memset(&stats, 0, sizeof(CSR_RenderCommandStats));
+    stats.m_FirstError = (size_t)M_CSR_Unknown_Index;
+
+    // the lost commands make the buffer invalid
+    stats.m_ErrorCount = pBuffer->m_LostCount;
+
+    // the buffer may be a frame part, thus the drawing state and the enabled shader are unknown
+    // until a command sets them
+    drawing        = -1;
+    shaderKnown    =  0;
+    pEnabledShader =  0;
+
+    // iterate through the commands to check
+    for (i = 0; i < pBuffer->m_Count; ++i)
+    {
+        const CSR_RenderCommand* pCommand = &pBuffer->m_pCommand[i];
+        const void*              pData    = csrRenderCommandBufferGetData(pBuffer, pCommand);
+        int                      valid    = 1;
+
+        // unknown command?
+        if ((size_t)pCommand->m_Type >= M_CSR_Render_Command_Types)
+            valid = 0;
+        else
+            ++stats.m_Count[pCommand->m_Type];
+
+        switch (pCommand->m_Type)
+        {
+            case CSR_RC_ShaderEnable:
+                shaderKnown    = 1;
+                pEnabledShader = pCommand->m_pShader;
+                break;
+
+            case CSR_RC_ShaderConnectProjectionMatrix:
+            case CSR_RC_ShaderConnectViewMatrix:
+                valid = pCommand->m_pShader && pData;
+                break;
+
+            case CSR_RC_DrawBegin:
+                valid   = pData && drawing != 1;
+                drawing = 1;
+                break;
+
+            case CSR_RC_DrawEnd:
+                valid   = drawing != 0;
+                drawing = 0;
+                break;
+
+            case CSR_RC_DrawLine:
+                valid = pCommand->m_pShader && pData;
+
+                if (valid)
+                {
+                    ++stats.m_DrawCount;
+                    ++stats.m_InstanceCount;
+                    stats.m_VertexCount += 2;
+                }
+
+                break;
+
+            case CSR_RC_DrawVertexBuffer:
+                valid = pCommand->m_pShader && pCommand->m_pModel;
+
+                if (valid)
+                {
+                    CSR_Mesh mesh;
+
+                    // count the vertex buffer as a single buffer mesh
+                    mesh.m_pVB   = (CSR_VertexBuffer*)pCommand->m_pModel;
+                    mesh.m_Count = 1;
+                    csrRenderCommandBufferCountMesh(&mesh, pCommand->m_MatrixCount, &stats);
+                }
+
+                break;
+
+            case CSR_RC_DrawMesh:
+                valid = pCommand->m_pShader && pCommand->m_pModel;
+
+                if (valid)
+                    csrRenderCommandBufferCountMesh((const CSR_Mesh*)pCommand->m_pModel,
+                                                     pCommand->m_MatrixCount,
+                                                    &stats);
+
+                break;
+
+            case CSR_RC_DrawModel:
+            {
+                const CSR_Model* pModel = (const CSR_Model*)pCommand->m_pModel;
+
+                valid = pCommand->m_pShader && pModel && pModel->m_MeshCount;
+
+                // NOTE the model mesh index loops, like in the renderers
+                if (valid)
+                    csrRenderCommandBufferCountMesh(&pModel->m_pMesh[pCommand->m_Index[0] % pModel->m_MeshCount],
+                                                     pCommand->m_MatrixCount,
+                                                    &stats);
+
+                break;
+            }
+
+            case CSR_RC_DrawMDL:
+            {
+                const CSR_Mesh* pMesh = 0;
+
+                valid = pCommand->m_pShader && pCommand->m_pModel;
+
+                if (valid)
+                    pMesh = csrMDLGetMesh((const CSR_MDL*)pCommand->m_pModel,
+                                          pCommand->m_Index[1],
+                                          pCommand->m_Index[2]);
+
+                // NOTE the renderers only draw the MDL meshes containing one vertex buffer
+                if (pMesh && pMesh->m_Count == 1)
+                    csrRenderCommandBufferCountMesh(pMesh, pCommand->m_MatrixCount, &stats);
+
+                break;
+            }
+
+            case CSR_RC_DrawX:
+            {
+                size_t       j;
+                const CSR_X* pX = (const CSR_X*)pCommand->m_pModel;
+
+                valid = pCommand->m_pShader && pX;
+
+                if (valid)
+                    for (j = 0; j < pX->m_MeshCount; ++j)
+                        csrRenderCommandBufferCountMesh(&pX->m_pMesh[j], pCommand->m_MatrixCount, &stats);
+
+                break;
+            }
+
+            case CSR_RC_StateEnableDepthMask:
+                break;
+        }
+
+        // are the shader connections and the draws using the enabled shader?
+        if (pCommand->m_Type != CSR_RC_ShaderEnable && pCommand->m_pShader &&
+            shaderKnown && pCommand->m_pShader != pEnabledShader)
+            valid = 0;
+
+        // count the invalid command
+        if (!valid)
+        {
+            if (stats.m_FirstError == (size_t)M_CSR_Unknown_Index)
+                stats.m_FirstError = i;
+
+            ++stats.m_ErrorCount;
+        }
+    }
+
+    if (pStats)
+        *pStats = stats;
+
+    return !stats.m_ErrorCount;
+}
+//---------------------------------------------------------------------------
+void csrRenderCommandBufferSetCurrent(CSR_RenderCommandBuffer* pBuffer)
+{
+    g_pRenderCommandBuffer = pBuffer;
+}
+//---------------------------------------------------------------------------
+CSR_RenderCommandBuffer* csrRenderCommandBufferGetCurrent(void)
+{
+    return g_pRenderCommandBuffer;
+}
+//---------------------------------------------------------------------------
@@ -40,6 +40,34 @@
     #error "The graphics library to use in unknown for this system."
 #endif
 
+//---------------------------------------------------------------------------
+// Global defines
+//---------------------------------------------------------------------------
+#define M_CSR_Render_Command_Types 12 // render command type count, see CSR_ERenderCommandType
+
+//---------------------------------------------------------------------------
+// Enumerations
+//---------------------------------------------------------------------------
+
+/**
+* Render command type, i.e. the renderer function the command calls when replayed
+*/
+typedef enum
+{
+    CSR_RC_ShaderEnable,
+    CSR_RC_ShaderConnectProjectionMatrix,
+    CSR_RC_ShaderConnectViewMatrix,
+    CSR_RC_DrawBegin,
+    CSR_RC_DrawEnd,
+    CSR_RC_DrawLine,
+    CSR_RC_DrawVertexBuffer,
+    CSR_RC_DrawMesh,
+    CSR_RC_DrawModel,
+    CSR_RC_DrawMDL,
+    CSR_RC_DrawX,
+    CSR_RC_StateEnableDepthMask
+} CSR_ERenderCommandType;
+
 //---------------------------------------------------------------------------
 // Callbacks
 //---------------------------------------------------------------------------
@@ -51,6 +79,55 @@
 */
 typedef void* (*CSR_fOnGetID)(const void* pKey);
 
+//---------------------------------------------------------------------------
+// Structures
+//---------------------------------------------------------------------------
+
+/**
+* Render command, i.e. a recorded renderer function call
+*@note The models and shaders are only linked, whereas the matrices, colors and lines passed by
+*      value and the matrices contained in the matrix arrays are copied in the command buffer data
+*/
+typedef struct
+{
+    CSR_ERenderCommandType m_Type;
+    const void*            m_pShader;      // shader to enable, to connect or to draw with
+    const void*            m_pModel;       // vertex buffer, mesh, model, MDL or X model to draw
+    size_t                 m_MatrixCount;  // copied matrix count to draw with, 0 to use the connected model matrix
+    CSR_fOnGetID           m_fOnGetID;     // callback function to get the resource identifiers
+    size_t                 m_Index[3];     // model mesh index, MDL skin, model and mesh indices, X animation set and frame indices, or depth mask value
+    size_t                 m_Data;         // offset of the matrix, color, line or matrix array copy in the command buffer data
+} CSR_RenderCommand;
+
+/**
+* Render command buffer, i.e. a recorded frame or frame part which may be replayed later
+*@note The command and data arrays are grown by doubling their capacity, and kept when the buffer
+*      is cleared, thus recording a frame similar to the previous one allocates nothing
+*/
+typedef struct
+{
+    CSR_RenderCommand* m_pCommand;     // recorded commands
+    size_t             m_Count;        // recorded command count
+    size_t             m_Capacity;     // command count the command array may contain
+    unsigned char*     m_pData;        // copies of the values passed to the commands
+    size_t             m_DataSize;     // used data size, in bytes
+    size_t             m_DataCapacity; // data array size, in bytes
+    size_t             m_LostCount;    // commands which could not be recorded, e.g. on memory failure
+} CSR_RenderCommandBuffer;
+
+/**
+* Render command statistics, calculated by the null backend, i.e. without any graphics library
+*/
+typedef struct
+{
+    size_t m_Count[M_CSR_Render_Command_Types]; // command count per type
+    size_t m_DrawCount;                         // vertex buffer draws, the instances excluded
+    size_t m_InstanceCount;                     // vertex buffer draws, the instances included
+    size_t m_VertexCount;                       // submitted vertices, the instances included
+    size_t m_ErrorCount;                        // invalid command count
+    size_t m_FirstError;                        // first invalid command index, M_CSR_Unknown_Index if none
+} CSR_RenderCommandStats;
+
 #ifdef __cplusplus
     extern "C"
     {
@@ -187,6 +264,120 @@ typedef void* (*CSR_fOnGetID)(const void* pKey);
         */
         void csrStateEnableDepthMask(int value);
 
+        //-------------------------------------------------------------------
+        // Render command buffer functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a render command buffer
+        *@return newly created render command buffer, 0 on error
+        *@note The render command buffer must be released when no longer used, see
+        *      csrRenderCommandBufferRelease()
+        */
+        CSR_RenderCommandBuffer* csrRenderCommandBufferCreate(void);
+
+        /**
+        * Releases a render command buffer
+        *@param[in, out] pBuffer - render command buffer to release
+        */
+        void csrRenderCommandBufferRelease(CSR_RenderCommandBuffer* pBuffer);
+
+        /**
+        * Initializes a render command buffer
+        *@param[in, out] pBuffer - render command buffer to initialize
+        */
+        void csrRenderCommandBufferInit(CSR_RenderCommandBuffer* pBuffer);
+
+        /**
+        * Releases the render command buffer content
+        *@param[in, out] pBuffer - render command buffer for which the content should be released
+        *@note Only the content is released, the buffer itself is not released
+        */
+        void csrRenderCommandBufferContentRelease(CSR_RenderCommandBuffer* pBuffer);
+
+        /**
+        * Clears a render command buffer, i.e. removes its commands but keeps its memory
+        *@param[in, out] pBuffer - render command buffer to clear
+        */
+        void csrRenderCommandBufferClear(CSR_RenderCommandBuffer* pBuffer);
+
+        /**
+        * Adds a command to a render command buffer
+        *@param[in, out] pBuffer - render command buffer to add to
+        *@param pCommand - command to add, its m_Data value is ignored
+        *@param pData - value to copy with the command, e.g. a matrix, a color, a line or the
+        *               m_MatrixCount matrices of a draw command, may be 0
+        *@param size - value size, in bytes
+        *@return 1 on success, otherwise 0
+        *@note Several threads may record their own buffers at the same time, which may then be
+        *      appended together and replayed on the rendering thread
+        */
+        int csrRenderCommandBufferAdd(      CSR_RenderCommandBuffer* pBuffer,
+                                      const CSR_RenderCommand*       pCommand,
+                                      const void*                    pData,
+                                            size_t                   size);
+
+        /**
+        * Appends the commands of a render command buffer to another
+        *@param[in, out] pBuffer - render command buffer to append to
+        *@param pOther - render command buffer to append
+        *@return 1 on success, otherwise 0
+        */
+        int csrRenderCommandBufferAppend(CSR_RenderCommandBuffer* pBuffer, const CSR_RenderCommandBuffer* pOther);
+
+        /**
+        * Gets the value copied with a command
+        *@param pBuffer - render command buffer containing the command
+        *@param pCommand - command for which the value should be get
+        *@return value, 0 if the command contains no value
+        */
+        const void* csrRenderCommandBufferGetData(const CSR_RenderCommandBuffer* pBuffer,
+                                                  const CSR_RenderCommand*       pCommand);
+
+        /**
+        * Replays a render command buffer, i.e. calls the renderer functions it contains
+        *@param pBuffer - render command buffer to replay
+        *@note The commands are executed by the graphics library (OpenGL or Metal), even if a render
+        *      command buffer is currently recording on the calling thread, see
+        *      csrRenderCommandBufferSetCurrent()
+        */
+        void csrRenderCommandBufferReplay(const CSR_RenderCommandBuffer* pBuffer);
+
+        /**
+        * Validates a render command buffer and calculates its statistics, without any graphics library
+        *@param pBuffer - render command buffer to validate
+        *@param[out] pStats - render command statistics, ignored if 0
+        *@return 1 if all the commands are valid, otherwise 0
+        *@note A command is invalid if its shader, its model or its value is missing, if its shader
+        *      isn't the enabled one, or if the draw begin and end are nested or unbalanced. A buffer
+        *      without begin or end remains valid, because it may be a frame part
+        */
+        int csrRenderCommandBufferValidate(const CSR_RenderCommandBuffer* pBuffer,
+                                                 CSR_RenderCommandStats*  pStats);
+
+        /**
+        * Sets the render command buffer in which the shader, draw and state functions called by the
+        * calling thread are recorded
+        *@param pBuffer - render command buffer to record in, 0 to call the graphics library again
+        *@note While a buffer is set, the shader, draw and state functions called by the same thread
+        *      are recorded instead of being executed. A command which cannot be recorded is counted
+        *      in m_LostCount, and makes the buffer invalid
+        *@note The current buffer is kept per thread, thus several threads may record their own
+        *      buffer at once, e.g. one per scene part, and the render thread append or replay them
+        *      once complete. A buffer isn't thread safe, and should never be current in several
+        *      threads at once
+        *@note On compilers without thread local storage (i.e. other than gcc, clang or Visual C++),
+        *      the current buffer is shared by all the threads, and only one thread may record
+        */
+        void csrRenderCommandBufferSetCurrent(CSR_RenderCommandBuffer* pBuffer);
+
+        /**
+        * Gets the render command buffer in which the shader, draw and state functions called by the
+        * calling thread are recorded
+        *@return current render command buffer of the calling thread, 0 if none
+        */
+        CSR_RenderCommandBuffer* csrRenderCommandBufferGetCurrent(void);
+
 #ifdef __cplusplus
     }
 #endif
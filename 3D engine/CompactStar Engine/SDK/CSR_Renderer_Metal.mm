@@ -171,6 +171,7 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
 @interface CSR_MetalBasicRenderer()
 {
     IVerticesDict            m_VerticesDict;
+    IVerticesDict            m_IndicesDict;
     ITexturesDict            m_TexturesDict;
     IUniformDict             m_UniformsDict;
     IUniformBuffers          m_SkyboxUniform;
@@ -183,7 +184,7 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
 * Draws a vertex array
 *@param pRenderEncoder - render encoder to use to draw the vertex array
 *@param pVB - vertex buffer containing the vertex array to draw
-*@param vertexCount - vertex count
+*@param vertexCount - vertex count, or index count if the vertex buffer is indexed
 *@param pUniformKey - uniform key
 */
 - (void) csrMetalDrawArray :(id<MTLRenderCommandEncoder>)pRenderEncoder
@@ -305,8 +306,8 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
     
     [m_pRenderEncoder setDepthStencilState:m_pDepthState];
 
-    // calculate the vertex count
-    const size_t vertexCount = pVB->m_Count / pVB->m_Format.m_Stride;
+    // calculate the vertex count, which is the index count if the vertex buffer is indexed
+    const size_t vertexCount = csrVertexBufferGetElementCount(pVB);
     
     // do draw the vertex buffer several times?
     if (pMatrixArray && pMatrixArray->m_Count)
@@ -499,6 +500,8 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
         // mesh contains skin weights?
         if (pX->m_pMeshWeights[i].m_pSkinWeights)
         {
+            csrProfilerBegin("X skinning");
+
             // clear the previous print vertices (needs to be cleared to properly apply the weights)
             for (j = 0; j < pMesh->m_pVB->m_Count; j += pMesh->m_pVB->m_Format.m_Stride)
             {
@@ -557,6 +560,8 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
                         pX->m_pPrint[i].m_pData[iZ] += (outputVertex.m_Z * pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pWeights[k]);
                     }
             }
+
+            csrProfilerEnd();
         }
 
         // get vertices to update
@@ -694,6 +699,18 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
 
     // keep the newly created vertex buffer reference in the vertices dictionary
     m_VerticesDict[pVB] = pVertexBuffer;
+
+    // no vertex indices?
+    if (!pVB->m_pIndex)
+        return;
+
+    // create a metal index buffer from the compactStar engine vertex indices
+    id<MTLBuffer> pIndexBuffer = [m_pDevice newBufferWithBytes:pVB->m_pIndex
+                                                        length:pVB->m_IndexCount * sizeof(unsigned)
+                                                       options:vbOptions];
+
+    // keep the newly created index buffer reference in the indices dictionary
+    m_IndicesDict[pVB] = pIndexBuffer;
 }
 //---------------------------------------------------------------------------
 - (bool) CreateTexture :(void* _Nullable)pKey :(nonnull NSURL*)pUrl
@@ -958,6 +975,41 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
     else
         return;
 
+    // is the vertex buffer indexed?
+    if (pVB->m_pIndex)
+    {
+        IVerticesDict::const_iterator itIndex = m_IndicesDict.find(pVB);
+
+        if (itIndex == m_IndicesDict.end())
+            return;
+
+        // search for array type to draw
+        switch (pVB->m_Format.m_Type)
+        {
+            case CSR_VT_Triangles:
+                [pRenderEncoder drawIndexedPrimitives:MTLPrimitiveTypeTriangle
+                                           indexCount:vertexCount
+                                            indexType:MTLIndexTypeUInt32
+                                          indexBuffer:itIndex->second
+                                    indexBufferOffset:0];
+                return;
+
+            case CSR_VT_TriangleStrip:
+                [pRenderEncoder drawIndexedPrimitives:MTLPrimitiveTypeTriangleStrip
+                                           indexCount:vertexCount
+                                            indexType:MTLIndexTypeUInt32
+                                          indexBuffer:itIndex->second
+                                    indexBufferOffset:0];
+                return;
+
+            case CSR_VT_TriangleFan:
+                @throw @"Unsupported format type - CSR_VT_TriangleFan";
+
+            default:
+                return;
+        }
+    }
+
     // search for array type to draw
     switch (pVB->m_Format.m_Type)
     {
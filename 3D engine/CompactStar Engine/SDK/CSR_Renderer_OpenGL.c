@@ -17,43 +17,408 @@
 
 // std
 #include <stdlib.h>
+#include <string.h>
 #include <memory.h>
 
 //---------------------------------------------------------------------------
-// Texture functions
+// Global values
 //---------------------------------------------------------------------------
-GLuint csrOpenGLTextureFromPixelBuffer(const CSR_PixelBuffer* pPixelBuffer)
+CSR_OpenGLVBCache g_OpenGLVBCache = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1};
+CSR_OpenGLState   g_OpenGLState   = {-1,
+                                     -1,
+                                     {-1, -1, -1, -1, -1, -1, -1, -1},
+                                     {-1, -1, -1, -1, -1, -1, -1, -1},
+                                     -1,
+                                     -1,
+                                     -1,
+                                     -1,
+                                     -1,
+                                     -1,
+                                     -1,
+                                     -1,
+                                     -1,
+                                     -1,
+                                     -1,
+                                     0,
+                                     0};
+CSR_OpenGLProgramCache g_OpenGLProgramCache = {0, 0, 0};
+//---------------------------------------------------------------------------
+// State private functions
+//---------------------------------------------------------------------------
+void csrOpenGLStateSetProgram(GLuint programID)
 {
-    unsigned char* pPixels;
-    unsigned       x;
-    unsigned       y;
-    unsigned char  c;
-    GLint          pixelType;
-    GLuint         index;
+    // already in use?
+    if (g_OpenGLState.m_Program == (GLint)programID)
+        return;
 
-    // validate the input
-    if (!pPixelBuffer || !pPixelBuffer->m_Width || !pPixelBuffer->m_Height)
-        return M_CSR_Error_Code;
+    glUseProgram(programID);
+    g_OpenGLState.m_Program = (GLint)programID;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStateSetActiveTexture(GLint unit)
+{
+    // already active?
+    if (g_OpenGLState.m_ActiveTexture == unit)
+        return;
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    g_OpenGLState.m_ActiveTexture = unit;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStateBindTexture(GLenum target, GLuint textureID)
+{
+    GLint* pBound;
+
+    // get the texture bound to the active unit, if known
+    if (g_OpenGLState.m_ActiveTexture < 0 ||
+        g_OpenGLState.m_ActiveTexture >= M_CSR_OpenGL_State_Texture_Units)
+        pBound = 0;
+    else
+    if (target == GL_TEXTURE_2D)
+        pBound = &g_OpenGLState.m_Texture[g_OpenGLState.m_ActiveTexture];
+    else
+    if (target == GL_TEXTURE_CUBE_MAP)
+        pBound = &g_OpenGLState.m_Cubemap[g_OpenGLState.m_ActiveTexture];
+    else
+        pBound = 0;
+
+    // not tracked?
+    if (!pBound)
+    {
+        glBindTexture(target, textureID);
+        return;
+    }
+
+    // already bound?
+    if (*pBound == (GLint)textureID)
+        return;
+
+    glBindTexture(target, textureID);
+    *pBound = (GLint)textureID;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStateForgetTexture(GLuint textureID)
+{
+    size_t i;
+
+    // the texture identifier may be reused after the texture is deleted, thus the units on which
+    // it was bound become unknown
+    for (i = 0; i < M_CSR_OpenGL_State_Texture_Units; ++i)
+    {
+        if (g_OpenGLState.m_Texture[i] == (GLint)textureID)
+            g_OpenGLState.m_Texture[i] = -1;
+
+        if (g_OpenGLState.m_Cubemap[i] == (GLint)textureID)
+            g_OpenGLState.m_Cubemap[i] = -1;
+    }
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStateSetCapability(GLenum capability, GLint* pCurrent, GLint value)
+{
+    // already set?
+    if (*pCurrent == value)
+        return;
+
+    if (value)
+        glEnable(capability);
+    else
+        glDisable(capability);
+
+    *pCurrent = value;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStateSetCullFace(GLenum face)
+{
+    // already set?
+    if (g_OpenGLState.m_CullFace == (GLint)face)
+        return;
+
+    glCullFace(face);
+    g_OpenGLState.m_CullFace = (GLint)face;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStateSetFrontFace(GLenum face)
+{
+    // already set?
+    if (g_OpenGLState.m_FrontFace == (GLint)face)
+        return;
+
+    glFrontFace(face);
+    g_OpenGLState.m_FrontFace = (GLint)face;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStateSetBlendFunc(GLenum equation, GLenum srcFactor, GLenum dstFactor)
+{
+    // set the blend equation, if changed
+    if (g_OpenGLState.m_BlendEquation != (GLint)equation)
+    {
+        glBlendEquation(equation);
+        g_OpenGLState.m_BlendEquation = (GLint)equation;
+    }
+
+    // already set?
+    if (g_OpenGLState.m_BlendSrc == (GLint)srcFactor && g_OpenGLState.m_BlendDst == (GLint)dstFactor)
+        return;
+
+    glBlendFunc(srcFactor, dstFactor);
+    g_OpenGLState.m_BlendSrc = (GLint)srcFactor;
+    g_OpenGLState.m_BlendDst = (GLint)dstFactor;
+}
+//---------------------------------------------------------------------------
+#ifndef CSR_OPENGL_2_ONLY
+    void csrOpenGLStateSetPolygonMode(GLenum mode)
+    {
+        // already set?
+        if (g_OpenGLState.m_PolygonMode == (GLint)mode)
+            return;
+
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+        g_OpenGLState.m_PolygonMode = (GLint)mode;
+    }
+#endif
+//---------------------------------------------------------------------------
+void csrOpenGLStateSetDepthMask(GLint value)
+{
+    // already set?
+    if (g_OpenGLState.m_DepthMask == value)
+        return;
+
+    glDepthMask(value ? GL_TRUE : GL_FALSE);
+    g_OpenGLState.m_DepthMask = value;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStateSetAttribArrays(unsigned mask)
+{
+    GLint    i;
+    unsigned changed;
+
+    // enabled arrays unknown?
+    if (!g_OpenGLState.m_AttribArraysKnown)
+    {
+        // query the available slot count, only once
+        if (g_OpenGLState.m_AttribCount < 0)
+        {
+            glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &g_OpenGLState.m_AttribCount);
+
+            if (g_OpenGLState.m_AttribCount > M_CSR_OpenGL_State_Max_Attribs)
+                g_OpenGLState.m_AttribCount = M_CSR_OpenGL_State_Max_Attribs;
+        }
+
+        // set all the arrays
+        for (i = 0; i < g_OpenGLState.m_AttribCount; ++i)
+            if (mask & (1u << i))
+                glEnableVertexAttribArray((GLuint)i);
+            else
+                glDisableVertexAttribArray((GLuint)i);
+
+        g_OpenGLState.m_AttribArrays      = mask;
+        g_OpenGLState.m_AttribArraysKnown = 1;
+        return;
+    }
+
+    // get the arrays to change
+    changed = mask ^ g_OpenGLState.m_AttribArrays;
+
+    // set them
+    for (i = 0; changed; ++i, changed >>= 1)
+        if (changed & 1u)
+        {
+            if (mask & (1u << i))
+                glEnableVertexAttribArray((GLuint)i);
+            else
+                glDisableVertexAttribArray((GLuint)i);
+        }
+
+    g_OpenGLState.m_AttribArrays = mask;
+}
+//---------------------------------------------------------------------------
+unsigned csrOpenGLStateAttribMask(GLint slot)
+{
+    // no slot, or slot out of the tracked range?
+    if (slot < 0 || slot >= M_CSR_OpenGL_State_Max_Attribs)
+        return 0;
 
+    return 1u << slot;
+}
+//---------------------------------------------------------------------------
+// Texture private functions
+//---------------------------------------------------------------------------
+GLint csrOpenGLTextureGetFormat(const CSR_PixelBuffer* pPixelBuffer)
+{
     // select the correct pixel type to use
     switch (pPixelBuffer->m_BytePerPixel)
     {
         case 3:
-            pixelType = GL_RGB;
-            break;
+            return GL_RGB;
 
         case 4:
-            // actually the bitmaps are limited to 24 bit RGB (due to below calculation). For that
+            // actually the bitmaps are limited to 24 bit RGB (due to the pixel reordering). For that
             // reason trying to create a texture from a RGBA bitmap is prohibited
             if (pPixelBuffer->m_ImageType == CSR_IT_Bitmap)
-                return M_CSR_Error_Code;
+                return 0;
 
-            pixelType = GL_RGBA;
-            break;
+            return GL_RGBA;
 
         default:
-            return M_CSR_Error_Code;
+            return 0;
+    }
+}
+//---------------------------------------------------------------------------
+void csrOpenGLTextureReorderBitmap(const CSR_PixelBuffer* pPixelBuffer, unsigned char* pPixels)
+{
+    unsigned      x;
+    unsigned      y;
+    unsigned char c;
+
+    // get bitmap data into right format
+    for (y = 0; y < pPixelBuffer->m_Height; ++y)
+        for (x = 0; x < pPixelBuffer->m_Width; ++x)
+            for (c = 0; c < 3; ++c)
+                pPixels[3 * (pPixelBuffer->m_Width * y + x) + c] =
+                        ((unsigned char*)pPixelBuffer->m_pData)
+                                [pPixelBuffer->m_Stride * y + 3 * (pPixelBuffer->m_Width - x - 1) + (2 - c)];
+}
+//---------------------------------------------------------------------------
+// Texture queue private functions
+//---------------------------------------------------------------------------
+int csrOpenGLTextureQueueReserve(CSR_OpenGLTextureQueue* pQueue, size_t count)
+{
+    // grow the pending upload array
+    CSR_OpenGLTextureUpload** pUploads =
+            (CSR_OpenGLTextureUpload**)csrMemoryAlloc(pQueue->m_pUpload,
+                                                      sizeof(CSR_OpenGLTextureUpload*),
+                                                      pQueue->m_Count + count);
+
+    // succeeded?
+    if (!pUploads)
+        return 0;
+
+    pQueue->m_pUpload = pUploads;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLTextureQueueAllocate(CSR_OpenGLTextureUpload* pUpload, GLenum target, GLuint textureID)
+{
+    pUpload->m_Target    = target;
+    pUpload->m_TextureID = textureID;
+    pUpload->m_Row       = 0;
+
+    // allocate the texture image, without content. NOTE no pixel buffer object is bound here, as
+    // the queue processing always unbinds it
+    glTexImage2D(target,
+                 0,
+                 pUpload->m_Format,
+                 (GLsizei)pUpload->m_Width,
+                 (GLsizei)pUpload->m_Height,
+                 0,
+                 pUpload->m_Format,
+                 GL_UNSIGNED_BYTE,
+                 0);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLTextureQueueUploadRows(CSR_OpenGLTextureUpload* pUpload, size_t rows, const GLvoid* pPixels)
+{
+    // bind the texture receiving the rows
+    if (pUpload->m_Target == GL_TEXTURE_2D)
+        csrOpenGLStateBindTexture(GL_TEXTURE_2D, pUpload->m_TextureID);
+    else
+        csrOpenGLStateBindTexture(GL_TEXTURE_CUBE_MAP, pUpload->m_TextureID);
+
+    // upload them, either from the client memory or from the bound pixel buffer object
+    glTexSubImage2D(pUpload->m_Target,
+                    0,
+                    0,
+                    (GLint)pUpload->m_Row,
+                    (GLsizei)pUpload->m_Width,
+                    (GLsizei)rows,
+                    pUpload->m_Format,
+                    GL_UNSIGNED_BYTE,
+                    pPixels);
+
+    pUpload->m_Row += rows;
+}
+//---------------------------------------------------------------------------
+#ifndef CSR_OPENGL_2_ONLY
+    int csrOpenGLTextureQueueUploadFromPBO(CSR_OpenGLTextureQueue*  pQueue,
+                                           CSR_OpenGLTextureUpload* pUpload,
+                                           size_t                   rows)
+    {
+        const size_t               index   = pQueue->m_PBOIndex;
+        const size_t               size    = rows * pUpload->m_RowSize;
+        const unsigned char* const pSource = pUpload->m_pPixels + pUpload->m_Row * pUpload->m_RowSize;
+        void*                      pData;
+
+        // is the pixel buffer object still used by a previous upload?
+        if (pQueue->m_Fence[index])
+        {
+            // don't wait for the GPU, the ring is full for this frame
+            if (glClientWaitSync(pQueue->m_Fence[index], 0, 0) == GL_TIMEOUT_EXPIRED)
+                return 0;
+
+            glDeleteSync(pQueue->m_Fence[index]);
+            pQueue->m_Fence[index] = 0;
+        }
+
+        // create the pixel buffer object on its first use
+        if (!pQueue->m_PBO[index])
+        {
+            glGenBuffers(1, &pQueue->m_PBO[index]);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pQueue->m_PBO[index]);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)pQueue->m_PBOSize, 0, GL_STREAM_DRAW);
+        }
+        else
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pQueue->m_PBO[index]);
+
+        // copy the rows in the pixel buffer object. NOTE the previous content is no longer needed,
+        // and its fence was signaled, thus no synchronization is required
+        pData = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                                 0,
+                                 (GLsizeiptr)size,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+        if (pData)
+        {
+            memcpy(pData, pSource, size);
+
+            // upload the rows from the pixel buffer object, if its content remained valid
+            if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+            {
+                csrOpenGLTextureQueueUploadRows(pUpload, rows, 0);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+                // the pixel buffer object may be refilled once the GPU copied its content
+                pQueue->m_Fence[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                pQueue->m_PBOIndex     = (index + 1) % M_CSR_OpenGL_Texture_Queue_PBOs;
+                return 1;
+            }
+        }
+
+        // failed, upload the rows from the client memory instead
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        csrOpenGLTextureQueueUploadRows(pUpload, rows, pSource);
+        return 1;
     }
+#endif
+//---------------------------------------------------------------------------
+// Texture functions
+//---------------------------------------------------------------------------
+GLuint csrOpenGLTextureFromPixelBuffer(const CSR_PixelBuffer* pPixelBuffer)
+{
+    unsigned char* pPixels;
+    GLint          pixelType;
+    GLuint         index;
+
+    // validate the input
+    if (!pPixelBuffer || !pPixelBuffer->m_Width || !pPixelBuffer->m_Height)
+        return M_CSR_Error_Code;
+
+    // select the correct pixel type to use
+    pixelType = csrOpenGLTextureGetFormat(pPixelBuffer);
+
+    // unsupported?
+    if (!pixelType)
+        return M_CSR_Error_Code;
 
     // reorder the pixels if image is a bitmap
     if (pPixelBuffer->m_ImageType == CSR_IT_Bitmap)
@@ -63,20 +428,19 @@ GLuint csrOpenGLTextureFromPixelBuffer(const CSR_PixelBuffer* pPixelBuffer)
                                          pPixelBuffer->m_Height *
                                          3);
 
-        // get bitmap data into right format
-        for (y = 0; y < pPixelBuffer->m_Height; ++y)
-            for (x = 0; x < pPixelBuffer->m_Width; ++x)
-                for (c = 0; c < 3; ++c)
-                    pPixels[3 * (pPixelBuffer->m_Width * y + x) + c] =
-                            ((unsigned char*)pPixelBuffer->m_pData)
-                                    [pPixelBuffer->m_Stride * y + 3 * (pPixelBuffer->m_Width - x - 1) + (2 - c)];
+        // succeeded?
+        if (!pPixels)
+            return M_CSR_Error_Code;
+
+        csrOpenGLTextureReorderBitmap(pPixelBuffer, pPixels);
     }
     else
         pPixels = (unsigned char*)pPixelBuffer->m_pData;
 
     // create new OpenGL texture
     glGenTextures(1, &index);
-    glBindTexture(GL_TEXTURE_2D, index);
+    csrOpenGLStateForgetTexture(index);
+    csrOpenGLStateBindTexture(GL_TEXTURE_2D, index);
 
     // set texture filtering
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -104,103 +468,433 @@ GLuint csrOpenGLTextureFromPixelBuffer(const CSR_PixelBuffer* pPixelBuffer)
     return index;
 }
 //---------------------------------------------------------------------------
-// Cubemap functions
-//------------------------------------------------------------------------------
-GLuint csrOpenGLCubemapLoad(const char** pFileNames)
+// Texture upload functions
+//---------------------------------------------------------------------------
+CSR_OpenGLTextureUpload* csrOpenGLTextureUploadCreate(const CSR_PixelBuffer* pPixelBuffer)
 {
-    size_t i;
-
-    // create a cubemap texture
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    // iterate through cubemap faces to load
-    for (i = 0; i < 6; ++i)
-    {
-        unsigned char* pPixels;
-        int            doReleasePixels = 0;
+    GLint                    format;
+    CSR_OpenGLTextureUpload* pUpload;
 
-        // load the texture content from file
-        CSR_PixelBuffer* pPixelBuffer = csrPixelBufferFromBitmapFile(pFileNames[i]);
+    // validate the input
+    if (!pPixelBuffer || !pPixelBuffer->m_Width || !pPixelBuffer->m_Height || !pPixelBuffer->m_pData)
+        return 0;
 
-        // failed?
-        if (!pPixelBuffer)
-            continue;
+    // select the correct pixel type to use
+    format = csrOpenGLTextureGetFormat(pPixelBuffer);
 
-        // reorder the pixels if image is a bitmap
-        if (pPixelBuffer->m_ImageType == CSR_IT_Bitmap)
-        {
-            size_t x;
-            size_t y;
-            size_t c;
+    // unsupported?
+    if (!format)
+        return 0;
 
-            doReleasePixels = 1;
+    // create a new texture upload
+    pUpload = (CSR_OpenGLTextureUpload*)malloc(sizeof(CSR_OpenGLTextureUpload));
 
-            pPixels = (unsigned char*)malloc(sizeof(unsigned char)  *
-                                             pPixelBuffer->m_Width  *
-                                             pPixelBuffer->m_Height *
-                                             3);
+    // succeeded?
+    if (!pUpload)
+        return 0;
 
-            // get bitmap data into right format
-            for (y = 0; y < pPixelBuffer->m_Height; ++y)
-                for (x = 0; x < pPixelBuffer->m_Width; ++x)
-                    for (c = 0; c < 3; ++c)
-                        pPixels[3 * (pPixelBuffer->m_Width * y + x) + c] =
-                                ((unsigned char*)pPixelBuffer->m_pData)
-                                        [pPixelBuffer->m_Stride * y + 3 * (pPixelBuffer->m_Width - x - 1) + (2 - c)];
-        }
-        else
-            pPixels = (unsigned char*)pPixelBuffer->m_pData;
+    pUpload->m_Width     = pPixelBuffer->m_Width;
+    pUpload->m_Height    = pPixelBuffer->m_Height;
+    pUpload->m_RowSize   = pPixelBuffer->m_Width * pPixelBuffer->m_BytePerPixel;
+    pUpload->m_Format    = format;
+    pUpload->m_Target    = GL_TEXTURE_2D;
+    pUpload->m_TextureID = 0;
+    pUpload->m_Row       = 0;
+    pUpload->m_pPixels   = (unsigned char*)malloc(pUpload->m_RowSize * pUpload->m_Height);
 
-        // load the texture on the GPU
-        glTexImage2D((GLenum)(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i),
-                     0,
-                     GL_RGB,
-                     pPixelBuffer->m_Width,
-                     pPixelBuffer->m_Height,
-                     0,
-                     GL_RGB,
-                     GL_UNSIGNED_BYTE,
-                     pPixels);
+    // succeeded?
+    if (!pUpload->m_pPixels)
+    {
+        free(pUpload);
+        return 0;
+    }
 
-        if (doReleasePixels)
-            free(pPixels);
+    // copy the pixels, reordered if the image is a bitmap
+    if (pPixelBuffer->m_ImageType == CSR_IT_Bitmap)
+        csrOpenGLTextureReorderBitmap(pPixelBuffer, pUpload->m_pPixels);
+    else
+        memcpy(pUpload->m_pPixels, pPixelBuffer->m_pData, pUpload->m_RowSize * pUpload->m_Height);
 
-        // release the previously loaded bitmap
-        csrPixelBufferRelease(pPixelBuffer);
-    }
+    return pUpload;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLTextureUploadRelease(CSR_OpenGLTextureUpload* pUpload)
+{
+    // no texture upload to release?
+    if (!pUpload)
+        return;
 
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S,     GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T,     GL_CLAMP_TO_EDGE);
+    // free the pixels
+    free(pUpload->m_pPixels);
 
-    return textureID;
+    // free the texture upload
+    free(pUpload);
 }
 //---------------------------------------------------------------------------
-// Identifier functions
+// Texture queue functions
 //---------------------------------------------------------------------------
-CSR_OpenGLID* csrOpenGLIDCreate(void)
+CSR_OpenGLTextureQueue* csrOpenGLTextureQueueCreate(size_t pboSize, size_t frameBudget)
 {
-    // create a new identifier
-    CSR_OpenGLID* pID = (CSR_OpenGLID*)malloc(sizeof(CSR_OpenGLID));
+    size_t                  i;
+    CSR_OpenGLTextureQueue* pQueue;
+
+    // validate the inputs
+    if (!pboSize || !frameBudget)
+        return 0;
+
+    // create a new texture upload queue
+    pQueue = (CSR_OpenGLTextureQueue*)malloc(sizeof(CSR_OpenGLTextureQueue));
 
     // succeeded?
-    if (!pID)
+    if (!pQueue)
         return 0;
 
-    // initialize the shader content
-    csrOpenGLIDInit(pID);
+    pQueue->m_pUpload     = 0;
+    pQueue->m_Count       = 0;
+    pQueue->m_FrameBudget = frameBudget;
+    pQueue->m_PBOSize     = pboSize;
+    pQueue->m_PBOIndex    = 0;
 
-    return pID;
+    // the pixel buffer objects are created on their first use
+    for (i = 0; i < M_CSR_OpenGL_Texture_Queue_PBOs; ++i)
+    {
+        pQueue->m_PBO[i] = 0;
+
+        #ifndef CSR_OPENGL_2_ONLY
+            pQueue->m_Fence[i] = 0;
+        #endif
+    }
+
+    return pQueue;
 }
 //---------------------------------------------------------------------------
-void csrOpenGLIDRelease(CSR_OpenGLID* pID)
+void csrOpenGLTextureQueueRelease(CSR_OpenGLTextureQueue* pQueue)
 {
-    // no identifier to release?
-    if (!pID)
-        return;
+    size_t i;
+
+    // no texture upload queue to release?
+    if (!pQueue)
+        return;
+
+    // release the pending uploads
+    for (i = 0; i < pQueue->m_Count; ++i)
+        csrOpenGLTextureUploadRelease(pQueue->m_pUpload[i]);
+
+    free(pQueue->m_pUpload);
+
+    // delete the fences and the pixel buffer objects
+    for (i = 0; i < M_CSR_OpenGL_Texture_Queue_PBOs; ++i)
+    {
+        #ifndef CSR_OPENGL_2_ONLY
+            if (pQueue->m_Fence[i])
+                glDeleteSync(pQueue->m_Fence[i]);
+        #endif
+
+        if (pQueue->m_PBO[i])
+            glDeleteBuffers(1, &pQueue->m_PBO[i]);
+    }
+
+    // free the texture upload queue
+    free(pQueue);
+}
+//---------------------------------------------------------------------------
+GLuint csrOpenGLTextureQueueAdd(CSR_OpenGLTextureQueue* pQueue, CSR_OpenGLTextureUpload* pUpload)
+{
+    GLuint index;
+
+    // validate the inputs
+    if (!pQueue || !pUpload)
+        return M_CSR_Error_Code;
+
+    // reserve the room for the upload
+    if (!csrOpenGLTextureQueueReserve(pQueue, 1))
+        return M_CSR_Error_Code;
+
+    // create new OpenGL texture
+    glGenTextures(1, &index);
+    csrOpenGLStateForgetTexture(index);
+    csrOpenGLStateBindTexture(GL_TEXTURE_2D, index);
+
+    // set texture filtering
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // set texture wrapping mode
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // allocate the texture image, which will be filled while the queue is processed
+    csrOpenGLTextureQueueAllocate(pUpload, GL_TEXTURE_2D, index);
+
+    pQueue->m_pUpload[pQueue->m_Count] = pUpload;
+    ++pQueue->m_Count;
+
+    return index;
+}
+//---------------------------------------------------------------------------
+GLuint csrOpenGLTextureQueueAddCubemap(CSR_OpenGLTextureQueue* pQueue, CSR_OpenGLTextureUpload** pUploads)
+{
+    size_t i;
+    GLuint textureID;
+
+    // validate the inputs
+    if (!pQueue || !pUploads)
+        return M_CSR_Error_Code;
+
+    // reserve the room for all the faces
+    if (!csrOpenGLTextureQueueReserve(pQueue, 6))
+        return M_CSR_Error_Code;
+
+    // create a cubemap texture
+    glGenTextures(1, &textureID);
+    csrOpenGLStateForgetTexture(textureID);
+    csrOpenGLStateBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+
+    // iterate through cubemap faces to allocate
+    for (i = 0; i < 6; ++i)
+    {
+        // missing face?
+        if (!pUploads[i])
+            continue;
+
+        // allocate the face image, which will be filled while the queue is processed
+        csrOpenGLTextureQueueAllocate(pUploads[i], (GLenum)(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i), textureID);
+
+        pQueue->m_pUpload[pQueue->m_Count] = pUploads[i];
+        ++pQueue->m_Count;
+    }
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S,     GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T,     GL_CLAMP_TO_EDGE);
+
+    return textureID;
+}
+//---------------------------------------------------------------------------
+size_t csrOpenGLTextureQueueProcess(CSR_OpenGLTextureQueue* pQueue)
+{
+    size_t budget;
+    size_t completed;
+
+    // nothing to upload?
+    if (!pQueue || !pQueue->m_Count)
+        return 0;
+
+    budget    = pQueue->m_FrameBudget;
+    completed = 0;
+
+    // the upload rows are tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // iterate through the pending uploads, from the oldest
+    while (pQueue->m_Count)
+    {
+        CSR_OpenGLTextureUpload* pUpload = pQueue->m_pUpload[0];
+        size_t                   rows    = pUpload->m_Height - pUpload->m_Row;
+
+        // limit the rows to the remaining budget. NOTE at least one row is uploaded per frame,
+        // even if it exceeds the budget, otherwise a too large image would never be uploaded
+        if (rows * pUpload->m_RowSize > budget)
+            rows = budget / pUpload->m_RowSize;
+
+        if (!rows)
+        {
+            // budget exhausted?
+            if (budget < pQueue->m_FrameBudget)
+                break;
+
+            rows = 1;
+        }
+
+        #ifndef CSR_OPENGL_2_ONLY
+            // do the rows fit in a pixel buffer object?
+            if (pUpload->m_RowSize <= pQueue->m_PBOSize)
+            {
+                if (rows * pUpload->m_RowSize > pQueue->m_PBOSize)
+                    rows = pQueue->m_PBOSize / pUpload->m_RowSize;
+
+                // stop if all the pixel buffer objects are still used by the GPU
+                if (!csrOpenGLTextureQueueUploadFromPBO(pQueue, pUpload, rows))
+                    break;
+            }
+            else
+                csrOpenGLTextureQueueUploadRows(pUpload,
+                                                rows,
+                                                pUpload->m_pPixels + pUpload->m_Row * pUpload->m_RowSize);
+        #else
+            csrOpenGLTextureQueueUploadRows(pUpload,
+                                            rows,
+                                            pUpload->m_pPixels + pUpload->m_Row * pUpload->m_RowSize);
+        #endif
+
+        // update the remaining budget
+        if (rows * pUpload->m_RowSize < budget)
+            budget -= rows * pUpload->m_RowSize;
+        else
+            budget = 0;
+
+        // is the upload incomplete?
+        if (pUpload->m_Row < pUpload->m_Height)
+            continue;
+
+        // remove the completed upload from the queue
+        csrOpenGLTextureUploadRelease(pUpload);
+
+        --pQueue->m_Count;
+        memmove(pQueue->m_pUpload, pQueue->m_pUpload + 1, pQueue->m_Count * sizeof(CSR_OpenGLTextureUpload*));
+
+        ++completed;
+    }
+
+    // restore the default alignment
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    return completed;
+}
+//---------------------------------------------------------------------------
+int csrOpenGLTextureQueueIsPending(const CSR_OpenGLTextureQueue* pQueue, GLuint textureID)
+{
+    size_t i;
+
+    // no texture upload queue?
+    if (!pQueue)
+        return 0;
+
+    // search for an upload filling the texture
+    for (i = 0; i < pQueue->m_Count; ++i)
+        if (pQueue->m_pUpload[i]->m_TextureID == textureID)
+            return 1;
+
+    return 0;
+}
+//---------------------------------------------------------------------------
+size_t csrOpenGLTextureQueueCancel(CSR_OpenGLTextureQueue* pQueue, GLuint textureID)
+{
+    size_t i;
+    size_t count;
+    size_t cancelled;
+
+    // no texture upload queue?
+    if (!pQueue)
+        return 0;
+
+    count     = 0;
+    cancelled = 0;
+
+    // iterate through the pending uploads, and keep those filling another texture in their order
+    for (i = 0; i < pQueue->m_Count; ++i)
+        if (pQueue->m_pUpload[i]->m_TextureID == textureID)
+        {
+            csrOpenGLTextureUploadRelease(pQueue->m_pUpload[i]);
+            ++cancelled;
+        }
+        else
+        {
+            pQueue->m_pUpload[count] = pQueue->m_pUpload[i];
+            ++count;
+        }
+
+    pQueue->m_Count = count;
+
+    return cancelled;
+}
+//---------------------------------------------------------------------------
+// Cubemap functions
+//------------------------------------------------------------------------------
+GLuint csrOpenGLCubemapLoad(const char** pFileNames)
+{
+    size_t i;
+
+    // create a cubemap texture
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    csrOpenGLStateForgetTexture(textureID);
+    csrOpenGLStateBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+
+    // iterate through cubemap faces to load
+    for (i = 0; i < 6; ++i)
+    {
+        unsigned char* pPixels;
+        int            doReleasePixels = 0;
+
+        // load the texture content from file
+        CSR_PixelBuffer* pPixelBuffer = csrPixelBufferFromBitmapFile(pFileNames[i]);
+
+        // failed?
+        if (!pPixelBuffer)
+            continue;
+
+        // reorder the pixels if image is a bitmap
+        if (pPixelBuffer->m_ImageType == CSR_IT_Bitmap)
+        {
+            doReleasePixels = 1;
+
+            pPixels = (unsigned char*)malloc(sizeof(unsigned char)  *
+                                             pPixelBuffer->m_Width  *
+                                             pPixelBuffer->m_Height *
+                                             3);
+
+            // succeeded?
+            if (!pPixels)
+            {
+                csrPixelBufferRelease(pPixelBuffer);
+                continue;
+            }
+
+            csrOpenGLTextureReorderBitmap(pPixelBuffer, pPixels);
+        }
+        else
+            pPixels = (unsigned char*)pPixelBuffer->m_pData;
+
+        // load the texture on the GPU
+        glTexImage2D((GLenum)(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i),
+                     0,
+                     GL_RGB,
+                     pPixelBuffer->m_Width,
+                     pPixelBuffer->m_Height,
+                     0,
+                     GL_RGB,
+                     GL_UNSIGNED_BYTE,
+                     pPixels);
+
+        if (doReleasePixels)
+            free(pPixels);
+
+        // release the previously loaded bitmap
+        csrPixelBufferRelease(pPixelBuffer);
+    }
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S,     GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T,     GL_CLAMP_TO_EDGE);
+
+    return textureID;
+}
+//---------------------------------------------------------------------------
+// Identifier functions
+//---------------------------------------------------------------------------
+CSR_OpenGLID* csrOpenGLIDCreate(void)
+{
+    // create a new identifier
+    CSR_OpenGLID* pID = (CSR_OpenGLID*)malloc(sizeof(CSR_OpenGLID));
+
+    // succeeded?
+    if (!pID)
+        return 0;
+
+    // initialize the shader content
+    csrOpenGLIDInit(pID);
+
+    return pID;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLIDRelease(CSR_OpenGLID* pID)
+{
+    // no identifier to release?
+    if (!pID)
+        return;
 
     // free the identifier
     free(pID);
@@ -218,382 +912,1210 @@ void csrOpenGLIDInit(CSR_OpenGLID* pID)
     pID->m_ID       = M_CSR_Error_Code;
 }
 //---------------------------------------------------------------------------
-// Shader functions
+// Shader private functions
+//---------------------------------------------------------------------------
+void csrOpenGLShaderClearUniforms(CSR_OpenGLShader* pShader)
+{
+    size_t i;
+
+    // free the user uniforms
+    for (i = 0; i < pShader->m_UniformCount; ++i)
+        free(pShader->m_pUniform[i].m_pName);
+
+    free(pShader->m_pUniform);
+
+    pShader->m_pUniform     = 0;
+    pShader->m_UniformCount = 0;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLShaderResolveSlots(CSR_OpenGLShader* pShader)
+{
+    GLint i;
+    GLint count;
+
+    // get the attribute slots
+    pShader->m_VertexSlot      = glGetAttribLocation(pShader->m_ProgramID,  "csr_aVertices");
+    pShader->m_NormalSlot      = glGetAttribLocation(pShader->m_ProgramID,  "csr_aNormal");
+    pShader->m_TexCoordSlot    = glGetAttribLocation(pShader->m_ProgramID,  "csr_aTexCoord");
+    pShader->m_ColorSlot       = glGetAttribLocation(pShader->m_ProgramID,  "csr_aColor");
+    pShader->m_InstanceSlot    = glGetAttribLocation(pShader->m_ProgramID,  "csr_aModel");
+    pShader->m_BoneIndicesSlot = glGetAttribLocation(pShader->m_ProgramID,  "csr_aBoneIndices");
+    pShader->m_BoneWeightsSlot = glGetAttribLocation(pShader->m_ProgramID,  "csr_aBoneWeights");
+
+    // get the uniform slots
+    pShader->m_ProjectionSlot  = glGetUniformLocation(pShader->m_ProgramID, "csr_uProjection");
+    pShader->m_ViewSlot        = glGetUniformLocation(pShader->m_ProgramID, "csr_uView");
+    pShader->m_ModelSlot       = glGetUniformLocation(pShader->m_ProgramID, "csr_uModel");
+    pShader->m_BonesSlot       = glGetUniformLocation(pShader->m_ProgramID, "csr_uBones");
+    pShader->m_TextureSlot     = glGetUniformLocation(pShader->m_ProgramID, "csr_sTexture");
+    pShader->m_BumpMapSlot     = glGetUniformLocation(pShader->m_ProgramID, "csr_sBumpMap");
+    pShader->m_CubemapSlot     = glGetUniformLocation(pShader->m_ProgramID, "csr_sCubemap");
+    pShader->m_BoneCount       = 0;
+
+    // the texture sampler may also be named color map
+    if (pShader->m_TextureSlot < 0)
+        pShader->m_TextureSlot = glGetUniformLocation(pShader->m_ProgramID, "csr_sColorMap");
+
+    // no bone palette?
+    if (pShader->m_BonesSlot < 0)
+        return;
+
+    glGetProgramiv(pShader->m_ProgramID, GL_ACTIVE_UNIFORMS, &count);
+
+    // search for the bone palette size. NOTE the array name may be followed by its first index
+    for (i = 0; i < count; ++i)
+    {
+        char    name[32];
+        GLint   size;
+        GLenum  type;
+        GLsizei length;
+
+        glGetActiveUniform(pShader->m_ProgramID, (GLuint)i, sizeof(name), &length, &size, &type, name);
+
+        if (!strncmp(name, "csr_uBones", 10) && (name[10] == '\0' || name[10] == '['))
+        {
+            pShader->m_BoneCount = size;
+            return;
+        }
+    }
+}
+//---------------------------------------------------------------------------
+// Program cache private functions
+//---------------------------------------------------------------------------
+#ifndef CSR_OPENGL_2_ONLY
+    unsigned csrOpenGLProgramCacheHash(unsigned hash, const void* pData, size_t length)
+    {
+        size_t i;
+
+        // hash the data (FNV-1a)
+        for (i = 0; i < length; ++i)
+        {
+            hash ^= ((const unsigned char*)pData)[i];
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+#endif
+//---------------------------------------------------------------------------
+#ifndef CSR_OPENGL_2_ONLY
+    int csrOpenGLProgramCacheGetKey(const CSR_Buffer* pVertex, const CSR_Buffer* pFragment, unsigned* pKey)
+    {
+        size_t      i;
+        size_t      j;
+        size_t      length;
+        GLint       formatCount;
+        const char* pStrings[3];
+
+        // is the cache disabled?
+        if (!g_OpenGLProgramCache.m_pDir)
+            return 0;
+
+        formatCount = 0;
+
+        // does the driver support any program binary format?
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+        if (formatCount <= 0)
+            return 0;
+
+        // get the driver strings, a binary is only valid for the driver which created it
+        pStrings[0] = (const char*)glGetString(GL_VENDOR);
+        pStrings[1] = (const char*)glGetString(GL_RENDERER);
+        pStrings[2] = (const char*)glGetString(GL_VERSION);
+
+        // hash the sources and the driver strings twice, from 2 different bases, to get a 64 bit
+        // key. NOTE the lengths are also hashed, thus the concatenated strings remain distinct
+        for (i = 0; i < 2; ++i)
+        {
+            unsigned hash = i ? 0x9E3779B9u : 2166136261u;
+
+            hash = csrOpenGLProgramCacheHash(hash, &pVertex->m_Length,   sizeof(size_t));
+            hash = csrOpenGLProgramCacheHash(hash,  pVertex->m_pData,    pVertex->m_Length);
+            hash = csrOpenGLProgramCacheHash(hash, &pFragment->m_Length, sizeof(size_t));
+            hash = csrOpenGLProgramCacheHash(hash,  pFragment->m_pData,  pFragment->m_Length);
+
+            for (j = 0; j < 3; ++j)
+            {
+                length = pStrings[j] ? strlen(pStrings[j]) : 0;
+
+                hash = csrOpenGLProgramCacheHash(hash, &length, sizeof(size_t));
+
+                if (length)
+                    hash = csrOpenGLProgramCacheHash(hash, pStrings[j], length);
+            }
+
+            pKey[i] = hash;
+        }
+
+        return 1;
+    }
+#endif
+//---------------------------------------------------------------------------
+#ifndef CSR_OPENGL_2_ONLY
+    char* csrOpenGLProgramCacheGetFileName(const unsigned* pKey)
+    {
+        size_t     i;
+        size_t     length;
+        char*      pFileName;
+        const char digits[] = "0123456789abcdef";
+
+        length = strlen(g_OpenGLProgramCache.m_pDir);
+
+        // create the file name, i.e. the directory followed by csr_program_<key>.bin
+        pFileName = (char*)malloc(length + 33);
+
+        // succeeded?
+        if (!pFileName)
+            return 0;
+
+        memcpy(pFileName,          g_OpenGLProgramCache.m_pDir, length);
+        memcpy(pFileName + length, "csr_program_",              12);
+        length += 12;
+
+        // write the key in hexadecimal
+        for (i = 0; i < 16; ++i)
+            pFileName[length + i] = digits[(pKey[i / 8] >> (28 - 4 * (i % 8))) & 0xF];
+
+        memcpy(pFileName + length + 16, ".bin", 5);
+
+        return pFileName;
+    }
+#endif
+//---------------------------------------------------------------------------
+#ifndef CSR_OPENGL_2_ONLY
+    int csrOpenGLProgramCacheLoad(const unsigned* pKey, CSR_OpenGLShader* pShader)
+    {
+        unsigned    header[4];
+        char*       pFileName;
+        CSR_Buffer* pBuffer;
+        GLint       success;
+
+        pFileName = csrOpenGLProgramCacheGetFileName(pKey);
+
+        // succeeded?
+        if (!pFileName)
+            return 0;
+
+        // open the program binary, if any
+        pBuffer = csrFileOpen(pFileName);
+        free(pFileName);
+
+        // found it?
+        if (!pBuffer)
+            return 0;
+
+        // is the binary valid and matching with the key? The header contains the file identifier,
+        // the key and the binary format
+        if (pBuffer->m_Length <= sizeof(header))
+        {
+            csrBufferRelease(pBuffer);
+            return 0;
+        }
+
+        memcpy(header, pBuffer->m_pData, sizeof(header));
+
+        if (header[0] != M_CSR_OpenGL_Program_Cache_ID || header[1] != pKey[0] || header[2] != pKey[1])
+        {
+            csrBufferRelease(pBuffer);
+            return 0;
+        }
+
+        // load the program from its binary
+        glProgramBinary(pShader->m_ProgramID,
+                        (GLenum)header[3],
+                        (const unsigned char*)pBuffer->m_pData + sizeof(header),
+                        (GLsizei)(pBuffer->m_Length - sizeof(header)));
+
+        csrBufferRelease(pBuffer);
+
+        // did the driver accept it?
+        glGetProgramiv(pShader->m_ProgramID, GL_LINK_STATUS, &success);
+
+        if (success == GL_FALSE)
+            return 0;
+
+        // resolve the well-known slots, as for a linked program
+        csrOpenGLShaderClearUniforms(pShader);
+        csrOpenGLShaderResolveSlots(pShader);
+
+        return 1;
+    }
+#endif
+//---------------------------------------------------------------------------
+#ifndef CSR_OPENGL_2_ONLY
+    void csrOpenGLProgramCacheSave(const unsigned* pKey, const CSR_OpenGLShader* pShader)
+    {
+        unsigned   header[4];
+        char*      pFileName;
+        GLint      length;
+        GLsizei    written;
+        GLenum     format;
+        CSR_Buffer buffer;
+
+        length = 0;
+
+        // get the program binary length
+        glGetProgramiv(pShader->m_ProgramID, GL_PROGRAM_BINARY_LENGTH, &length);
+
+        if (length <= 0)
+            return;
+
+        buffer.m_pData = malloc(sizeof(header) + (size_t)length);
+
+        // succeeded?
+        if (!buffer.m_pData)
+            return;
+
+        written = 0;
+
+        // get the program binary, after the header
+        glGetProgramBinary(pShader->m_ProgramID,
+                           length,
+                           &written,
+                           &format,
+                           (unsigned char*)buffer.m_pData + sizeof(header));
+
+        pFileName = csrOpenGLProgramCacheGetFileName(pKey);
+
+        // save the binary, with its header. NOTE a failure is ignored, the program will simply be
+        // compiled again on the next launch
+        if (written > 0 && pFileName)
+        {
+            header[0] = M_CSR_OpenGL_Program_Cache_ID;
+            header[1] = pKey[0];
+            header[2] = pKey[1];
+            header[3] = (unsigned)format;
+
+            memcpy(buffer.m_pData, header, sizeof(header));
+            buffer.m_Length = sizeof(header) + (size_t)written;
+
+            csrFileSave(pFileName, &buffer);
+        }
+
+        free(pFileName);
+        free(buffer.m_pData);
+    }
+#endif
+//---------------------------------------------------------------------------
+// Shader functions
+//---------------------------------------------------------------------------
+CSR_OpenGLShader* csrOpenGLShaderCreate(void)
+{
+    // create a new shader
+    CSR_OpenGLShader* pShader = (CSR_OpenGLShader*)malloc(sizeof(CSR_OpenGLShader));
+
+    // succeeded?
+    if (!pShader)
+        return 0;
+
+    // initialize the shader content
+    csrOpenGLShaderInit(pShader);
+
+    return pShader;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLShaderRelease(CSR_OpenGLShader* pShader)
+{
+    // no shader to release?
+    if (!pShader)
+        return;
+
+    // delete the fragment shader
+    if (pShader->m_FragmentID)
+        glDeleteShader(pShader->m_FragmentID);
+
+    // delete the vertex shader
+    if (pShader->m_VertexID)
+        glDeleteShader(pShader->m_VertexID);
+
+    // delete the shader program
+    if (pShader->m_ProgramID)
+    {
+        // the program identifier may be reused, thus the current program becomes unknown
+        if (g_OpenGLState.m_Program == (GLint)pShader->m_ProgramID)
+            g_OpenGLState.m_Program = -1;
+
+        glDeleteProgram(pShader->m_ProgramID);
+    }
+
+    // free the user uniforms
+    csrOpenGLShaderClearUniforms(pShader);
+
+    // free the shader
+    free(pShader);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLShaderInit(CSR_OpenGLShader* pShader)
+{
+    // no shader to initialize?
+    if (!pShader)
+        return;
+
+    // initialize the shader content
+    pShader->m_ProgramID       =  0;
+    pShader->m_VertexID        =  0;
+    pShader->m_FragmentID      =  0;
+    pShader->m_VertexSlot      = -1;
+    pShader->m_NormalSlot      = -1;
+    pShader->m_TexCoordSlot    = -1;
+    pShader->m_TextureSlot     = -1;
+    pShader->m_BumpMapSlot     = -1;
+    pShader->m_CubemapSlot     = -1;
+    pShader->m_ColorSlot       = -1;
+    pShader->m_ModelSlot       = -1;
+    pShader->m_InstanceSlot    = -1;
+    pShader->m_BoneIndicesSlot = -1;
+    pShader->m_BoneWeightsSlot = -1;
+    pShader->m_ProjectionSlot  = -1;
+    pShader->m_ViewSlot        = -1;
+    pShader->m_BonesSlot       = -1;
+    pShader->m_BoneCount       =  0;
+    pShader->m_pUniform        =  0;
+    pShader->m_UniformCount    =  0;
+}
+//---------------------------------------------------------------------------
+CSR_OpenGLShader* csrOpenGLShaderLoadFromFile(const char*               pVertex,
+                                              const char*               pFragment,
+                                              const CSR_fOnLinkStaticVB fOnLinkStaticVB,
+                                              const void*               pCustomData)
+{
+    CSR_Buffer*       pVertexProgram;
+    CSR_Buffer*       pFragmentProgram;
+    CSR_OpenGLShader* pShader;
+
+    // open the vertex file to load
+    pVertexProgram = csrFileOpen(pVertex);
+
+    // succeeded?
+    if (!pVertexProgram)
+        return 0;
+
+    // open the fragment file to load
+    pFragmentProgram = csrFileOpen(pFragment);
+
+    // succeeded?
+    if (!pFragmentProgram)
+    {
+        csrBufferRelease(pVertexProgram);
+        return 0;
+    }
+
+    // load the shader from opened vertex and fragment programs
+    pShader = csrOpenGLShaderLoadFromBuffer(pVertexProgram,
+                                            pFragmentProgram,
+                                            fOnLinkStaticVB,
+                                            pCustomData);
+
+    // release the program buffers
+    csrBufferRelease(pVertexProgram);
+    csrBufferRelease(pFragmentProgram);
+
+    return pShader;
+}
+//------------------------------------------------------------------------------
+CSR_OpenGLShader* csrOpenGLShaderLoadFromStr(const char*               pVertex,
+                                                   size_t              vertexLength,
+                                             const char*               pFragment,
+                                                   size_t              fragmentLength,
+                                             const CSR_fOnLinkStaticVB fOnLinkStaticVB,
+                                             const void*               pCustomData)
+{
+    CSR_Buffer*       pVS;
+    CSR_Buffer*       pFS;
+    CSR_OpenGLShader* pShader;
+
+    // validate the inputs
+    if (!pVertex || !vertexLength || !pFragment || !fragmentLength)
+        return 0;
+
+    // create buffers to contain vertex and fragment programs
+    pVS = csrBufferCreate();
+    pFS = csrBufferCreate();
+
+    // copy the vertex program to read
+    pVS->m_Length = vertexLength;
+    pVS->m_pData  = (unsigned char*)malloc(pVS->m_Length + 1);
+    memcpy(pVS->m_pData, pVertex, pVS->m_Length);
+    ((unsigned char*)pVS->m_pData)[pVS->m_Length] = 0x0;
+
+    // copy the fragment program to read
+    pFS->m_Length = fragmentLength;
+    pFS->m_pData  = (unsigned char*)malloc(pFS->m_Length + 1);
+    memcpy(pFS->m_pData, pFragment, pFS->m_Length);
+    ((unsigned char*)pFS->m_pData)[pFS->m_Length] = 0x0;
+
+    // compile and build the shader
+    pShader = csrOpenGLShaderLoadFromBuffer(pVS, pFS, fOnLinkStaticVB, pCustomData);
+
+    // release the buffers
+    csrBufferRelease(pVS);
+    csrBufferRelease(pFS);
+
+    return pShader;
+}
+//---------------------------------------------------------------------------
+CSR_OpenGLShader* csrOpenGLShaderLoadFromBuffer(const CSR_Buffer*         pVertex,
+                                                const CSR_Buffer*         pFragment,
+                                                const CSR_fOnLinkStaticVB fOnLinkStaticVB,
+                                                const void*               pCustomData)
+{
+    CSR_OpenGLShader* pShader;
+    #ifndef CSR_OPENGL_2_ONLY
+        int           cached;
+        unsigned      key[2];
+    #endif
+
+    // source vertex or fragment program is missing?
+    if (!pVertex || !pFragment)
+        return 0;
+
+    // create a new shader
+    pShader = csrOpenGLShaderCreate();
+
+    // succeeded?
+    if (!pShader)
+        return 0;
+
+    // create a new shader program
+    pShader->m_ProgramID = glCreateProgram();
+
+    // succeeded?
+    if (!pShader->m_ProgramID)
+    {
+        csrOpenGLShaderRelease(pShader);
+        return 0;
+    }
+
+    #ifndef CSR_OPENGL_2_ONLY
+        // may the program be cached? NOTE a static VB callback may change the link result
+        cached = !fOnLinkStaticVB && csrOpenGLProgramCacheGetKey(pVertex, pFragment, key);
+
+        if (cached)
+        {
+            // load the program from its binary, if available
+            if (csrOpenGLProgramCacheLoad(key, pShader))
+            {
+                ++g_OpenGLProgramCache.m_Hits;
+                return pShader;
+            }
+
+            ++g_OpenGLProgramCache.m_Misses;
+
+            // a rejected binary may leave the program in an unknown state, start from a new one
+            glDeleteProgram(pShader->m_ProgramID);
+            pShader->m_ProgramID = glCreateProgram();
+
+            // succeeded?
+            if (!pShader->m_ProgramID)
+            {
+                csrOpenGLShaderRelease(pShader);
+                return 0;
+            }
+
+            // let the driver keep the binary of the linked program
+            glProgramParameteri(pShader->m_ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+    #endif
+
+    // create and compile the vertex shader
+    if (!csrOpenGLShaderCompile(pVertex, GL_VERTEX_SHADER, pShader))
+    {
+        csrOpenGLShaderRelease(pShader);
+        return 0;
+    }
+
+    // create and compile the fragment shader
+    if (!csrOpenGLShaderCompile(pFragment, GL_FRAGMENT_SHADER, pShader))
+    {
+        csrOpenGLShaderRelease(pShader);
+        return 0;
+    }
+
+    // attach compiled programs with shader
+    glAttachShader(pShader->m_ProgramID, pShader->m_VertexID);
+    glAttachShader(pShader->m_ProgramID, pShader->m_FragmentID);
+
+    // let the user attach static vertex buffers if he wants
+    if (fOnLinkStaticVB)
+        fOnLinkStaticVB(pShader, pCustomData);
+
+    // link shader
+    if (!csrOpenGLShaderLink(pShader))
+    {
+        csrOpenGLShaderRelease(pShader);
+        return 0;
+    }
+
+    #ifndef CSR_OPENGL_2_ONLY
+        // keep the program binary for the next launches
+        if (cached)
+            csrOpenGLProgramCacheSave(key, pShader);
+    #endif
+
+    return pShader;
+}
+//---------------------------------------------------------------------------
+int csrOpenGLShaderCompile(const CSR_Buffer* pSource, GLenum shaderType, CSR_OpenGLShader* pShader)
+{
+    GLuint shaderID;
+    GLint  success;
+
+    // no source data to compile?
+    if (!pSource || !pSource->m_Length || !pSource->m_pData)
+        return 0;
+
+    // no shader to add result to?
+    if (!pShader)
+        return 0;
+
+    // create a new shader program
+    shaderID = glCreateShader(shaderType);
+
+    // succeeded?
+    if (!shaderID)
+        return 0;
+
+    // compile the shader program
+    #ifdef __APPLE__
+        glShaderSource(shaderID, 1, (const GLchar* const*)&pSource->m_pData, 0);
+    #else
+        glShaderSource(shaderID, 1, (GLchar**)&pSource->m_pData, 0);
+    #endif
+    glCompileShader(shaderID);
+
+    // get compiler result
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
+
+    // succeeded?
+    if (success == GL_FALSE)
+    {
+        // delete the shader
+        glDeleteShader(shaderID);
+        return 0;
+    }
+
+    // assign the compiled shader to the correct identifier
+    switch (shaderType)
+    {
+        case GL_VERTEX_SHADER:   pShader->m_VertexID   = shaderID; break;
+        case GL_FRAGMENT_SHADER: pShader->m_FragmentID = shaderID; break;
+        default:                 glDeleteShader(shaderID);         return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrOpenGLShaderLink(CSR_OpenGLShader* pShader)
+{
+    GLint success;
+
+    // no shader to link?
+    if (!pShader || !pShader->m_ProgramID)
+        return 0;
+
+    // link the shader
+    glLinkProgram(pShader->m_ProgramID);
+
+    // get linker result
+    glGetProgramiv(pShader->m_ProgramID, GL_LINK_STATUS, &success);
+
+    // the previous user uniform slots are no longer valid
+    csrOpenGLShaderClearUniforms(pShader);
+
+    // succeeded?
+    if (success == GL_FALSE)
+        return 0;
+
+    // resolve the well-known slots, thus they are never searched while drawing
+    csrOpenGLShaderResolveSlots(pShader);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLShaderEnable(const CSR_OpenGLShader* pShader)
+{
+    // no shader to enable?
+    if (!pShader)
+    {
+        // disable all
+        csrOpenGLStateSetProgram(0);
+        return;
+    }
+
+    // enable the shader
+    csrOpenGLStateSetProgram(pShader->m_ProgramID);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLShaderConnectProjectionMatrix(const CSR_OpenGLShader* pShader,
+                                            const CSR_Matrix4*      pMatrix)
+{
+    // connect the projection matrix to the shader
+    if (pShader->m_ProjectionSlot >= 0)
+        glUniformMatrix4fv(pShader->m_ProjectionSlot, 1, 0, &pMatrix->m_Table[0][0]);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLShaderConnectViewMatrix(const CSR_OpenGLShader* pShader,
+                                      const CSR_Matrix4*      pMatrix)
+{
+    // connect the view matrix to the shader
+    if (pShader->m_ViewSlot >= 0)
+        glUniformMatrix4fv(pShader->m_ViewSlot, 1, 0, &pMatrix->m_Table[0][0]);
+}
+//---------------------------------------------------------------------------
+GLint csrOpenGLShaderGetUniform(CSR_OpenGLShader* pShader, const char* pName)
+{
+    size_t             i;
+    size_t             length;
+    CSR_OpenGLUniform* pUniform;
+
+    // validate the inputs
+    if (!pShader || !pShader->m_ProgramID || !pName)
+        return -1;
+
+    // search for an already resolved uniform
+    for (i = 0; i < pShader->m_UniformCount; ++i)
+        if (!strcmp(pShader->m_pUniform[i].m_pName, pName))
+            return pShader->m_pUniform[i].m_Slot;
+
+    // add a new uniform
+    pUniform = (CSR_OpenGLUniform*)csrMemoryAlloc(pShader->m_pUniform,
+                                                  sizeof(CSR_OpenGLUniform),
+                                                  pShader->m_UniformCount + 1);
+
+    // succeeded?
+    if (!pUniform)
+        return -1;
+
+    pShader->m_pUniform = pUniform;
+    pUniform            = &pShader->m_pUniform[pShader->m_UniformCount];
+
+    // copy the uniform name
+    length            = strlen(pName);
+    pUniform->m_pName = (char*)malloc(length + 1);
+
+    // succeeded?
+    if (!pUniform->m_pName)
+        return -1;
+
+    memcpy(pUniform->m_pName, pName, length + 1);
+
+    // search for the uniform in the shader program. NOTE a missing uniform is also kept, thus it's
+    // no longer searched
+    pUniform->m_Slot = glGetUniformLocation(pShader->m_ProgramID, pName);
+
+    ++pShader->m_UniformCount;
+
+    return pUniform->m_Slot;
+}
+//---------------------------------------------------------------------------
+// Program cache functions
+//---------------------------------------------------------------------------
+int csrOpenGLProgramCacheEnable(const char* pDir)
+{
+    size_t length;
+    char*  pCopy;
+
+    // forget the previous directory
+    free(g_OpenGLProgramCache.m_pDir);
+    g_OpenGLProgramCache.m_pDir = 0;
+
+    // disable the cache?
+    if (!pDir)
+        return 1;
+
+    // copy the new directory
+    length = strlen(pDir);
+    pCopy  = (char*)malloc(length + 1);
+
+    // succeeded?
+    if (!pCopy)
+        return 0;
+
+    memcpy(pCopy, pDir, length + 1);
+    g_OpenGLProgramCache.m_pDir = pCopy;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+const CSR_OpenGLProgramCache* csrOpenGLProgramCacheGet(void)
+{
+    return &g_OpenGLProgramCache;
+}
+//---------------------------------------------------------------------------
+// Static buffer functions
 //---------------------------------------------------------------------------
-CSR_OpenGLShader* csrOpenGLShaderCreate(void)
+CSR_OpenGLStaticBuffer* csrOpenGLStaticBufferCreate(const CSR_OpenGLShader* pShader,
+                                                    const CSR_Buffer*       pBuffer)
 {
-    // create a new shader
-    CSR_OpenGLShader* pShader = (CSR_OpenGLShader*)malloc(sizeof(CSR_OpenGLShader));
+    CSR_OpenGLStaticBuffer* pSB;
 
-    // succeeded?
+    // no shader?
     if (!pShader)
         return 0;
 
-    // initialize the shader content
-    csrOpenGLShaderInit(pShader);
+    // validate the inputs
+    if (!pBuffer || !pBuffer->m_Length)
+        return 0;
 
-    return pShader;
+    // create a static buffer
+    pSB = (CSR_OpenGLStaticBuffer*)malloc(sizeof(CSR_OpenGLStaticBuffer));
+
+    // succeeded?
+    if (!pSB)
+        return 0;
+
+    // initialize the static buffer
+    csrOpenGLStaticBufferInit(pSB);
+
+    // create a Vertex Buffer Object (VBO) on the GPU size
+    glGenBuffers(1, &pSB->m_BufferID);
+
+    // bind the newly created VBO
+    glBindBuffer(GL_ARRAY_BUFFER, pSB->m_BufferID);
+
+    // copy the buffer data content in the VBO
+    glBufferData(GL_ARRAY_BUFFER,
+                 pBuffer->m_Length * sizeof(float),
+                 ((float*)pBuffer->m_pData),
+                 GL_STATIC_DRAW);
+
+    // unbind the VBO
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return pSB;
 }
 //---------------------------------------------------------------------------
-void csrOpenGLShaderRelease(CSR_OpenGLShader* pShader)
+void csrOpenGLStaticBufferRelease(CSR_OpenGLStaticBuffer* pSB)
 {
-    // no shader to release?
-    if (!pShader)
+    // no static buffer to release?
+    if (!pSB)
         return;
 
-    // delete the fragment shader
-    if (pShader->m_FragmentID)
-        glDeleteShader(pShader->m_FragmentID);
-
-    // delete the vertex shader
-    if (pShader->m_VertexID)
-        glDeleteShader(pShader->m_VertexID);
-
-    // delete the shader program
-    if (pShader->m_ProgramID)
-        glDeleteProgram(pShader->m_ProgramID);
+    // free the static buffer content
+    if (pSB->m_BufferID != M_CSR_Error_Code)
+        glDeleteBuffers(1, &pSB->m_BufferID);
 
-    // free the shader
-    free(pShader);
+    // free the static buffer
+    free(pSB);
 }
 //---------------------------------------------------------------------------
-void csrOpenGLShaderInit(CSR_OpenGLShader* pShader)
+void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
 {
-    // no shader to initialize?
-    if (!pShader)
+    // no static buffer to initialize?
+    if (!pSB)
         return;
 
-    // initialize the shader content
-    pShader->m_ProgramID    =  0;
-    pShader->m_VertexID     =  0;
-    pShader->m_FragmentID   =  0;
-    pShader->m_VertexSlot   = -1;
-    pShader->m_NormalSlot   = -1;
-    pShader->m_TexCoordSlot = -1;
-    pShader->m_TextureSlot  = -1;
-    pShader->m_BumpMapSlot  = -1;
-    pShader->m_CubemapSlot  = -1;
-    pShader->m_ColorSlot    = -1;
-    pShader->m_ModelSlot    = -1;
+    // initialize the static buffer content
+    pSB->m_BufferID = M_CSR_Error_Code;
+    pSB->m_Stride   = 0;
 }
 //---------------------------------------------------------------------------
-CSR_OpenGLShader* csrOpenGLShaderLoadFromFile(const char*               pVertex,
-                                              const char*               pFragment,
-                                              const CSR_fOnLinkStaticVB fOnLinkStaticVB,
-                                              const void*               pCustomData)
+// Vertex buffer cache private functions
+//---------------------------------------------------------------------------
+int csrOpenGLVBCacheFind(const CSR_VertexBuffer* pVB, size_t* pIndex)
 {
-    CSR_Buffer*       pVertexProgram;
-    CSR_Buffer*       pFragmentProgram;
-    CSR_OpenGLShader* pShader;
-
-    // open the vertex file to load
-    pVertexProgram = csrFileOpen(pVertex);
+    size_t first = 0;
+    size_t last  = g_OpenGLVBCache.m_Count;
 
-    // succeeded?
-    if (!pVertexProgram)
-        return 0;
-
-    // open the fragment file to load
-    pFragmentProgram = csrFileOpen(pFragment);
-
-    // succeeded?
-    if (!pFragmentProgram)
+    // search for the vertex buffer using a dichotomic search, the items are sorted by key
+    while (first < last)
     {
-        csrBufferRelease(pVertexProgram);
-        return 0;
-    }
+        const size_t middle = first + ((last - first) >> 1);
+        const size_t key    = (size_t)g_OpenGLVBCache.m_pItem[middle].m_pKey;
 
-    // load the shader from opened vertex and fragment programs
-    pShader = csrOpenGLShaderLoadFromBuffer(pVertexProgram,
-                                            pFragmentProgram,
-                                            fOnLinkStaticVB,
-                                            pCustomData);
+        if (key == (size_t)pVB)
+        {
+            *pIndex = middle;
+            return 1;
+        }
 
-    // release the program buffers
-    csrBufferRelease(pVertexProgram);
-    csrBufferRelease(pFragmentProgram);
+        if (key < (size_t)pVB)
+            first = middle + 1;
+        else
+            last  = middle;
+    }
 
-    return pShader;
+    // not found, get the index where it should be inserted
+    *pIndex = first;
+    return 0;
 }
-//------------------------------------------------------------------------------
-CSR_OpenGLShader* csrOpenGLShaderLoadFromStr(const char*               pVertex,
-                                                   size_t              vertexLength,
-                                             const char*               pFragment,
-                                                   size_t              fragmentLength,
-                                             const CSR_fOnLinkStaticVB fOnLinkStaticVB,
-                                             const void*               pCustomData)
+//---------------------------------------------------------------------------
+void csrOpenGLVBCacheDeleteItem(CSR_OpenGLVBCacheItem* pItem)
 {
-    CSR_Buffer*       pVS;
-    CSR_Buffer*       pFS;
-    CSR_OpenGLShader* pShader;
+    // delete the vertex and index copies. NOTE an index buffer identifier of 0 is ignored
+    glDeleteBuffers(1, &pItem->m_BufferID);
+    glDeleteBuffers(1, &pItem->m_IndexBufferID);
+}
+//---------------------------------------------------------------------------
+int csrOpenGLVBCacheCanUseUIntIndices(void)
+{
+    #ifdef CSR_OPENGL_2_ONLY
+        const char* pExtensions;
 
-    // validate the inputs
-    if (!pVertex || !vertexLength || !pFragment || !fragmentLength)
-        return 0;
+        // already queried?
+        if (g_OpenGLVBCache.m_UIntIndices >= 0)
+            return g_OpenGLVBCache.m_UIntIndices;
 
-    // create buffers to contain vertex and fragment programs
-    pVS = csrBufferCreate();
-    pFS = csrBufferCreate();
+        // OpenGL ES 2.0 supports the 32 bit indices only with the OES_element_index_uint extension
+        pExtensions = (const char*)glGetString(GL_EXTENSIONS);
 
-    // copy the vertex program to read
-    pVS->m_Length = vertexLength;
-    pVS->m_pData  = (unsigned char*)malloc(pVS->m_Length + 1);
-    memcpy(pVS->m_pData, pVertex, pVS->m_Length);
-    ((unsigned char*)pVS->m_pData)[pVS->m_Length] = 0x0;
+        g_OpenGLVBCache.m_UIntIndices = (pExtensions && strstr(pExtensions, "GL_OES_element_index_uint")) ? 1 : 0;
 
-    // copy the fragment program to read
-    pFS->m_Length = fragmentLength;
-    pFS->m_pData  = (unsigned char*)malloc(pFS->m_Length + 1);
-    memcpy(pFS->m_pData, pFragment, pFS->m_Length);
-    ((unsigned char*)pFS->m_pData)[pFS->m_Length] = 0x0;
+        return g_OpenGLVBCache.m_UIntIndices;
+    #else
+        return 1;
+    #endif
+}
+//---------------------------------------------------------------------------
+GLenum csrOpenGLVBCacheGetIndexType(const CSR_VertexBuffer* pVB)
+{
+    // not indexed?
+    if (!pVB->m_pIndex || !pVB->m_Format.m_Stride)
+        return GL_NONE;
 
-    // compile and build the shader
-    pShader = csrOpenGLShaderLoadFromBuffer(pVS, pFS, fOnLinkStaticVB, pCustomData);
+    // do the indices fit in 16 bit? NOTE the 0xFFFF index is never used, as it may be the
+    // primitive restart index
+    if (pVB->m_Count / pVB->m_Format.m_Stride <= M_CSR_OpenGL_Max_Short_Vertices)
+        return GL_UNSIGNED_SHORT;
 
-    // release the buffers
-    csrBufferRelease(pVS);
-    csrBufferRelease(pFS);
+    // can the indices be drawn as 32 bit?
+    if (csrOpenGLVBCacheCanUseUIntIndices())
+        return GL_UNSIGNED_INT;
 
-    return pShader;
+    return GL_NONE;
 }
 //---------------------------------------------------------------------------
-CSR_OpenGLShader* csrOpenGLShaderLoadFromBuffer(const CSR_Buffer*         pVertex,
-                                                const CSR_Buffer*         pFragment,
-                                                const CSR_fOnLinkStaticVB fOnLinkStaticVB,
-                                                const void*               pCustomData)
+const GLvoid* csrOpenGLVBCacheGetIndices(const CSR_VertexBuffer* pVB, GLenum type, size_t* pSize)
 {
-    CSR_OpenGLShader* pShader;
-
-    // source vertex or fragment program is missing?
-    if (!pVertex || !pFragment)
-        return 0;
+    size_t i;
 
-    // create a new shader
-    pShader = csrOpenGLShaderCreate();
+    // are the indices drawn as 32 bit? Use them as is
+    if (type != GL_UNSIGNED_SHORT)
+    {
+        *pSize = pVB->m_IndexCount * sizeof(unsigned);
+        return pVB->m_pIndex;
+    }
 
-    // succeeded?
-    if (!pShader)
-        return 0;
+    // grow the 16 bit indices, if required. NOTE they're kept between the drawings, thus nothing
+    // is allocated once the largest index count was converted
+    if (pVB->m_IndexCount > g_OpenGLVBCache.m_ShortIndexSize)
+    {
+        GLushort* pIndex = (GLushort*)csrMemoryAlloc(g_OpenGLVBCache.m_pShortIndex,
+                                                     sizeof(GLushort),
+                                                     pVB->m_IndexCount);
 
-    // create a new shader program
-    pShader->m_ProgramID = glCreateProgram();
+        // succeeded?
+        if (!pIndex)
+            return 0;
 
-    // succeeded?
-    if (!pShader->m_ProgramID)
-    {
-        csrOpenGLShaderRelease(pShader);
-        return 0;
+        g_OpenGLVBCache.m_pShortIndex    = pIndex;
+        g_OpenGLVBCache.m_ShortIndexSize = pVB->m_IndexCount;
     }
 
-    // create and compile the vertex shader
-    if (!csrOpenGLShaderCompile(pVertex, GL_VERTEX_SHADER, pShader))
+    // convert the indices
+    for (i = 0; i < pVB->m_IndexCount; ++i)
+        g_OpenGLVBCache.m_pShortIndex[i] = (GLushort)pVB->m_pIndex[i];
+
+    *pSize = pVB->m_IndexCount * sizeof(GLushort);
+    return g_OpenGLVBCache.m_pShortIndex;
+}
+//---------------------------------------------------------------------------
+float* csrOpenGLVBCacheGetVertices(const CSR_VertexBuffer* pVB)
+{
+    size_t       i;
+    const size_t stride = pVB->m_Format.m_Stride;
+
+    // grow the vertex data, if required
+    if (pVB->m_IndexCount * stride > g_OpenGLVBCache.m_VertexDataSize)
     {
-        csrOpenGLShaderRelease(pShader);
-        return 0;
+        float* pData = (float*)csrMemoryAlloc(g_OpenGLVBCache.m_pVertexData,
+                                              sizeof(float),
+                                              pVB->m_IndexCount * stride);
+
+        // succeeded?
+        if (!pData)
+            return 0;
+
+        g_OpenGLVBCache.m_pVertexData    = pData;
+        g_OpenGLVBCache.m_VertexDataSize = pVB->m_IndexCount * stride;
     }
 
-    // create and compile the fragment shader
-    if (!csrOpenGLShaderCompile(pFragment, GL_FRAGMENT_SHADER, pShader))
+    // read the vertices in the index order, thus they can be drawn without their indices
+    for (i = 0; i < pVB->m_IndexCount; ++i)
+        memcpy(&g_OpenGLVBCache.m_pVertexData[i * stride],
+               &pVB->m_pData[pVB->m_pIndex[i] * stride],
+               stride * sizeof(float));
+
+    return g_OpenGLVBCache.m_pVertexData;
+}
+//---------------------------------------------------------------------------
+int csrOpenGLVBCacheUpdateIndices(const CSR_VertexBuffer* pVB, CSR_OpenGLVBCacheItem* pItem)
+{
+    size_t        size;
+    const GLvoid* pIndices;
+
+    // vertex buffer no longer indexed? Delete the index copy, if any
+    if (!pVB->m_pIndex)
     {
-        csrOpenGLShaderRelease(pShader);
-        return 0;
+        glDeleteBuffers(1, &pItem->m_IndexBufferID);
+        pItem->m_IndexBufferID = 0;
+        return 1;
     }
 
-    // attach compiled programs with shader
-    glAttachShader(pShader->m_ProgramID, pShader->m_VertexID);
-    glAttachShader(pShader->m_ProgramID, pShader->m_FragmentID);
+    // get the indices to copy
+    pIndices = csrOpenGLVBCacheGetIndices(pVB, csrOpenGLVBCacheGetIndexType(pVB), &size);
 
-    // let the user attach static vertex buffers if he wants
-    if (fOnLinkStaticVB)
-        fOnLinkStaticVB(pShader, pCustomData);
+    // succeeded?
+    if (!pIndices)
+        return 0;
 
-    // link shader
-    if (!csrOpenGLShaderLink(pShader))
+    // create the index copy, if still not exists
+    if (!pItem->m_IndexBufferID)
     {
-        csrOpenGLShaderRelease(pShader);
-        return 0;
+        glGenBuffers(1, &pItem->m_IndexBufferID);
+
+        // succeeded?
+        if (!pItem->m_IndexBufferID)
+            return 0;
     }
 
-    return pShader;
+    // copy the vertex indices, as dynamic as they are likely to change again
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pItem->m_IndexBufferID);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, pIndices, GL_DYNAMIC_DRAW);
+
+    return 1;
 }
 //---------------------------------------------------------------------------
-int csrOpenGLShaderCompile(const CSR_Buffer* pSource, GLenum shaderType, CSR_OpenGLShader* pShader)
+int csrOpenGLVBCacheAdd(const CSR_VertexBuffer* pVB, size_t index)
 {
-    GLuint shaderID;
-    GLint  success;
+    GLuint                 bufferID      = 0;
+    GLuint                 indexBufferID = 0;
+    size_t                 size          = 0;
+    const GLvoid*          pIndices      = 0;
+    CSR_OpenGLVBCacheItem* pItem;
+
+    // get the indices to copy, if the vertex buffer is indexed
+    if (pVB->m_pIndex)
+    {
+        pIndices = csrOpenGLVBCacheGetIndices(pVB, csrOpenGLVBCacheGetIndexType(pVB), &size);
 
-    // no source data to compile?
-    if (!pSource || !pSource->m_Length || !pSource->m_pData)
-        return 0;
+        // succeeded?
+        if (!pIndices)
+            return 0;
+    }
 
-    // no shader to add result to?
-    if (!pShader)
-        return 0;
+    // create a Vertex Buffer Object (VBO) on the GPU side
+    glGenBuffers(1, &bufferID);
 
-    // create a new shader program
-    shaderID = glCreateShader(shaderType);
+    // create an index buffer on the GPU side, if the vertex buffer is indexed
+    if (pVB->m_pIndex)
+        glGenBuffers(1, &indexBufferID);
 
     // succeeded?
-    if (!shaderID)
+    if (!bufferID || (pVB->m_pIndex && !indexBufferID))
+    {
+        glDeleteBuffers(1, &bufferID);
+        glDeleteBuffers(1, &indexBufferID);
         return 0;
+    }
 
-    // compile the shader program
-    #ifdef __APPLE__
-        glShaderSource(shaderID, 1, (const GLchar* const*)&pSource->m_pData, 0);
-    #else
-        glShaderSource(shaderID, 1, (GLchar**)&pSource->m_pData, 0);
-    #endif
-    glCompileShader(shaderID);
-
-    // get compiler result
-    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
+    // add a new item to the cache
+    pItem = (CSR_OpenGLVBCacheItem*)csrMemoryAlloc(g_OpenGLVBCache.m_pItem,
+                                                   sizeof(CSR_OpenGLVBCacheItem),
+                                                   g_OpenGLVBCache.m_Count + 1);
 
     // succeeded?
-    if (success == GL_FALSE)
+    if (!pItem)
     {
-        // delete the shader
-        glDeleteShader(shaderID);
+        glDeleteBuffers(1, &bufferID);
+        glDeleteBuffers(1, &indexBufferID);
         return 0;
     }
 
-    // assign the compiled shader to the correct identifier
-    switch (shaderType)
+    g_OpenGLVBCache.m_pItem = pItem;
+
+    // move the next items to keep the cache sorted
+    if (index < g_OpenGLVBCache.m_Count)
+        memmove(&g_OpenGLVBCache.m_pItem[index + 1],
+                &g_OpenGLVBCache.m_pItem[index],
+                (g_OpenGLVBCache.m_Count - index) * sizeof(CSR_OpenGLVBCacheItem));
+
+    ++g_OpenGLVBCache.m_Count;
+
+    // delete the copy along with the vertex buffer content, instead of waiting it gets too old
+    csrVertexBufferSetOnDelete(csrOpenGLVBCacheDelete);
+
+    // copy the vertex buffer content in the VBO
+    glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+    glBufferData(GL_ARRAY_BUFFER, pVB->m_Count * sizeof(float), pVB->m_pData, GL_STATIC_DRAW);
+
+    // copy the vertex indices in the index buffer
+    if (indexBufferID)
     {
-        case GL_VERTEX_SHADER:   pShader->m_VertexID   = shaderID; break;
-        case GL_FRAGMENT_SHADER: pShader->m_FragmentID = shaderID; break;
-        default:                 glDeleteShader(shaderID);         return 0;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, pIndices, GL_STATIC_DRAW);
     }
 
+    // initialize the item
+    pItem                  = &g_OpenGLVBCache.m_pItem[index];
+    pItem->m_pKey          = pVB;
+    pItem->m_Generation    = pVB->m_Generation;
+    pItem->m_Length        = pVB->m_Count;
+    pItem->m_LastDraw      = g_OpenGLVBCache.m_DrawCount;
+    pItem->m_Dynamic       = 0;
+    pItem->m_BufferID      = bufferID;
+    pItem->m_IndexBufferID = indexBufferID;
+
     return 1;
 }
 //---------------------------------------------------------------------------
-int csrOpenGLShaderLink(CSR_OpenGLShader* pShader)
+int csrOpenGLVBCacheBind(const CSR_VertexBuffer* pVB)
 {
-    GLint success;
+    size_t                 index;
+    CSR_OpenGLVBCacheItem* pItem;
 
-    // no shader to link?
-    if (!pShader || !pShader->m_ProgramID)
+    // is the cache disabled, or was the vertex buffer never initialized?
+    if (g_OpenGLVBCache.m_Disabled || !pVB->m_Generation)
         return 0;
 
-    // link the shader
-    glLinkProgram(pShader->m_ProgramID);
+    // search for the vertex buffer copy, and create it if drawn for the first time. NOTE the
+    // newly created copy remains bound, as well as its index copy if the vertex buffer is indexed
+    if (!csrOpenGLVBCacheFind(pVB, &index))
+        return csrOpenGLVBCacheAdd(pVB, index);
 
-    // get linker result
-    glGetProgramiv(pShader->m_ProgramID, GL_LINK_STATUS, &success);
+    pItem = &g_OpenGLVBCache.m_pItem[index];
 
-    // succeeded?
-    if (success == GL_FALSE)
-        return 0;
+    // bind the copy
+    glBindBuffer(GL_ARRAY_BUFFER, pItem->m_BufferID);
 
-    return 1;
-}
-//---------------------------------------------------------------------------
-void csrOpenGLShaderEnable(const CSR_OpenGLShader* pShader)
-{
-    // no shader to enable?
-    if (!pShader)
+    // was the vertex buffer modified since cached? NOTE this is also the case if a released
+    // vertex buffer memory was reused by a new one, as the generations are unique
+    if (pItem->m_Generation != pVB->m_Generation)
     {
-        // disable all
-        glUseProgram(0);
-        return;
+        // update the index copy. NOTE on failure the vertex buffer is drawn from the client
+        // memory, and the copy will be updated again on the next drawing
+        if (!csrOpenGLVBCacheUpdateIndices(pVB, pItem))
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            return 0;
+        }
+
+        // is the copy already dynamic and large enough? If yes, just overwrite its content,
+        // otherwise reallocate it as dynamic, as the vertex buffer is likely to change again
+        if (pItem->m_Dynamic && pItem->m_Length == pVB->m_Count)
+            glBufferSubData(GL_ARRAY_BUFFER, 0, pVB->m_Count * sizeof(float), pVB->m_pData);
+        else
+            glBufferData(GL_ARRAY_BUFFER,
+                         pVB->m_Count * sizeof(float),
+                         pVB->m_pData,
+                         GL_DYNAMIC_DRAW);
+
+        pItem->m_Generation = pVB->m_Generation;
+        pItem->m_Length     = pVB->m_Count;
+        pItem->m_Dynamic    = 1;
     }
+    else
+    if (pItem->m_IndexBufferID)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pItem->m_IndexBufferID);
 
-    // enable the shader
-    glUseProgram(pShader->m_ProgramID);
+    pItem->m_LastDraw = g_OpenGLVBCache.m_DrawCount;
+
+    return 1;
 }
 //---------------------------------------------------------------------------
-void csrOpenGLShaderConnectProjectionMatrix(const CSR_OpenGLShader* pShader,
-                                            const CSR_Matrix4*      pMatrix)
+void csrOpenGLVBCachePurge(void)
 {
-    GLint slot;
+    size_t i;
+    size_t count = 0;
 
-    // get the projection matrix slot from shader
-    slot = glGetUniformLocation(pShader->m_ProgramID, "csr_uProjection");
+    ++g_OpenGLVBCache.m_DrawCount;
 
-    // connect the projection matrix to the shader
-    if (slot >= 0)
-        glUniformMatrix4fv(slot, 1, 0, &pMatrix->m_Table[0][0]);
+    // delete the copies which remained unused for too long, e.g. because their vertex buffer was
+    // released, and compact the remaining ones (thus they remain sorted)
+    for (i = 0; i < g_OpenGLVBCache.m_Count; ++i)
+        if (g_OpenGLVBCache.m_DrawCount - g_OpenGLVBCache.m_pItem[i].m_LastDraw > M_CSR_OpenGL_VB_Cache_Max_Age)
+            csrOpenGLVBCacheDeleteItem(&g_OpenGLVBCache.m_pItem[i]);
+        else
+        {
+            if (count != i)
+                g_OpenGLVBCache.m_pItem[count] = g_OpenGLVBCache.m_pItem[i];
+
+            ++count;
+        }
+
+    g_OpenGLVBCache.m_Count = count;
 }
 //---------------------------------------------------------------------------
-void csrOpenGLShaderConnectViewMatrix(const CSR_OpenGLShader* pShader,
-                                      const CSR_Matrix4*      pMatrix)
+// Vertex buffer cache functions
+//---------------------------------------------------------------------------
+void csrOpenGLVBCacheEnable(int value)
 {
-    GLint slot;
-
-    // get the view matrix slot from shader
-    slot = glGetUniformLocation(pShader->m_ProgramID, "csr_uView");
+    // delete the cached buffers, they would no longer be updated
+    if (!value)
+        csrOpenGLVBCacheClear();
 
-    // connect the view matrix to the shader
-    if (slot >= 0)
-        glUniformMatrix4fv(slot, 1, 0, &pMatrix->m_Table[0][0]);
+    g_OpenGLVBCache.m_Disabled = !value;
 }
 //---------------------------------------------------------------------------
-// Static buffer functions
-//---------------------------------------------------------------------------
-CSR_OpenGLStaticBuffer* csrOpenGLStaticBufferCreate(const CSR_OpenGLShader* pShader,
-                                                    const CSR_Buffer*       pBuffer)
+void csrOpenGLVBCacheDelete(const CSR_VertexBuffer* pVB)
 {
-    CSR_OpenGLStaticBuffer* pSB;
+    size_t index;
 
-    // no shader?
-    if (!pShader)
-        return 0;
+    // no vertex buffer, or not cached?
+    if (!pVB || !csrOpenGLVBCacheFind(pVB, &index))
+        return;
 
-    // validate the inputs
-    if (!pBuffer || !pBuffer->m_Length)
-        return 0;
+    // delete the copy
+    csrOpenGLVBCacheDeleteItem(&g_OpenGLVBCache.m_pItem[index]);
 
-    // create a static buffer
-    pSB = (CSR_OpenGLStaticBuffer*)malloc(sizeof(CSR_OpenGLStaticBuffer));
+    // remove the item from the cache
+    if (index + 1 < g_OpenGLVBCache.m_Count)
+        memmove(&g_OpenGLVBCache.m_pItem[index],
+                &g_OpenGLVBCache.m_pItem[index + 1],
+                (g_OpenGLVBCache.m_Count - index - 1) * sizeof(CSR_OpenGLVBCacheItem));
 
-    // succeeded?
-    if (!pSB)
-        return 0;
+    --g_OpenGLVBCache.m_Count;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLVBCacheClear(void)
+{
+    size_t i;
 
-    // initialize the static buffer
-    csrOpenGLStaticBufferInit(pSB);
+    // delete the copies
+    for (i = 0; i < g_OpenGLVBCache.m_Count; ++i)
+        csrOpenGLVBCacheDeleteItem(&g_OpenGLVBCache.m_pItem[i]);
 
-    // create a Vertex Buffer Object (VBO) on the GPU size
-    glGenBuffers(1, &pSB->m_BufferID);
+    // free the cache content
+    free(g_OpenGLVBCache.m_pItem);
 
-    // bind the newly created VBO
-    glBindBuffer(GL_ARRAY_BUFFER, pSB->m_BufferID);
+    g_OpenGLVBCache.m_pItem = 0;
+    g_OpenGLVBCache.m_Count = 0;
 
-    // copy the buffer data content in the VBO
-    glBufferData(GL_ARRAY_BUFFER,
-                 pBuffer->m_Length * sizeof(float),
-                 ((float*)pBuffer->m_pData),
-                 GL_STATIC_DRAW);
+    // delete the instance buffer
+    if (g_OpenGLVBCache.m_InstanceBufferID)
+    {
+        glDeleteBuffers(1, &g_OpenGLVBCache.m_InstanceBufferID);
+        g_OpenGLVBCache.m_InstanceBufferID = 0;
+    }
 
-    // unbind the VBO
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // free the instance data
+    free(g_OpenGLVBCache.m_pInstanceData);
 
-    return pSB;
-}
-//---------------------------------------------------------------------------
-void csrOpenGLStaticBufferRelease(CSR_OpenGLStaticBuffer* pSB)
-{
-    // no static buffer to release?
-    if (!pSB)
-        return;
+    g_OpenGLVBCache.m_pInstanceData = 0;
+    g_OpenGLVBCache.m_InstanceSize  = 0;
 
-    // free the static buffer content
-    if (pSB->m_BufferID != M_CSR_Error_Code)
-        glDeleteBuffers(1, &pSB->m_BufferID);
+    // free the converted indices and vertices
+    free(g_OpenGLVBCache.m_pShortIndex);
+    free(g_OpenGLVBCache.m_pVertexData);
 
-    // free the static buffer
-    free(pSB);
-}
-//---------------------------------------------------------------------------
-void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
-{
-    // no static buffer to initialize?
-    if (!pSB)
-        return;
+    g_OpenGLVBCache.m_pShortIndex    = 0;
+    g_OpenGLVBCache.m_ShortIndexSize = 0;
+    g_OpenGLVBCache.m_pVertexData    = 0;
+    g_OpenGLVBCache.m_VertexDataSize = 0;
 
-    // initialize the static buffer content
-    pSB->m_BufferID = M_CSR_Error_Code;
-    pSB->m_Stride   = 0;
+    // the next context may support other index types
+    g_OpenGLVBCache.m_UIntIndices = -1;
 }
 //---------------------------------------------------------------------------
 // Multisample antialiasing shader
@@ -708,13 +2230,14 @@ void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
 
         // create multisampled output texture
         glGenTextures(1, &pMSAA->m_TextureID);
-        glBindTexture(GL_TEXTURE_2D, pMSAA->m_TextureID);
+        csrOpenGLStateForgetTexture(pMSAA->m_TextureID);
+        csrOpenGLStateBindTexture(GL_TEXTURE_2D, pMSAA->m_TextureID);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, (GLint)width, (GLint)height, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
 
         // configure texture filters to use and bind texture
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        csrOpenGLStateBindTexture(GL_TEXTURE_2D, 0);
 
         // create and bind a multisampled texture buffer
         glGenFramebuffers(1, &pMSAA->m_TextureBufferID);
@@ -777,7 +2300,10 @@ void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
 
         // delete the multisampled texture
         if (pMSAA->m_TextureID)
+        {
+            csrOpenGLStateForgetTexture(pMSAA->m_TextureID);
             glDeleteTextures(1, &pMSAA->m_TextureID);
+        }
 
         // delete the multisampled texture buffer
         if (pMSAA->m_TextureBufferID)
@@ -873,6 +2399,7 @@ void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
         // delete the multisampled texture
         if (pMSAA->m_TextureID)
         {
+            csrOpenGLStateForgetTexture(pMSAA->m_TextureID);
             glDeleteTextures(1, &pMSAA->m_TextureID);
             pMSAA->m_TextureID = M_CSR_Error_Code;
         }
@@ -934,15 +2461,15 @@ void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
         if (pMSAA && pMSAA->m_pShader && pMSAA->m_pStaticBuffer)
         {
             // configure the culling
-            glEnable(GL_CULL_FACE);
-            glCullFace(GL_FRONT);
-            glFrontFace(GL_CW);
+            csrOpenGLStateSetCapability(GL_CULL_FACE, &g_OpenGLState.m_Culling, 1);
+            csrOpenGLStateSetCullFace(GL_FRONT);
+            csrOpenGLStateSetFrontFace(GL_CW);
 
             // disable the alpha blending
-            glDisable(GL_BLEND);
+            csrOpenGLStateSetCapability(GL_BLEND, &g_OpenGLState.m_Blending, 0);
 
             // set polygon mode to fill
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            csrOpenGLStateSetPolygonMode(GL_FILL);
 
             // enable the MSAA shader
             csrOpenGLShaderEnable(pMSAA->m_pShader);
@@ -967,20 +2494,23 @@ void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
             // configure the depth testing
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
-            glDisable(GL_DEPTH_TEST);
+            csrOpenGLStateSetCapability(GL_DEPTH_TEST, &g_OpenGLState.m_DepthTest, 0);
 
             // select the texture sampler to use (GL_TEXTURE0 for normal textures)
-            glActiveTexture(GL_TEXTURE0);
-            glUniform1i(pMSAA->m_pShader->m_TextureSlot, GL_TEXTURE0);
+            csrOpenGLStateSetActiveTexture(0);
+            glUniform1i(pMSAA->m_pShader->m_TextureSlot, 0);
 
             // bind the texure to use
-            glBindTexture(GL_TEXTURE_2D, pMSAA->m_TextureID);
+            csrOpenGLStateBindTexture(GL_TEXTURE_2D, pMSAA->m_TextureID);
 
             // bind the VBO containing the shape to draw
             glBindBuffer(GL_ARRAY_BUFFER, pMSAA->m_pStaticBuffer->m_BufferID);
 
-            // enable the vertices
-            glEnableVertexAttribArray(pMSAA->m_pShader->m_VertexSlot);
+            // enable the vertices and texture coordinates
+            csrOpenGLStateSetAttribArrays(csrOpenGLStateAttribMask(pMSAA->m_pShader->m_VertexSlot) |
+                                          csrOpenGLStateAttribMask(pMSAA->m_pShader->m_TexCoordSlot));
+
+            // link the vertices
             glVertexAttribPointer(pMSAA->m_pShader->m_VertexSlot,
                                   2,
                                   GL_FLOAT,
@@ -988,8 +2518,7 @@ void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
                                   (float)pMSAA->m_pStaticBuffer->m_Stride * sizeof(float),
                                   0);
 
-            // enable the texture coordinates
-            glEnableVertexAttribArray(pMSAA->m_pShader->m_TexCoordSlot);
+            // link the texture coordinates
             glVertexAttribPointer(pMSAA->m_pShader->m_TexCoordSlot,
                                   2,
                                   GL_FLOAT,
@@ -1001,8 +2530,7 @@ void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
             glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
             // disable the vertex attribute arrays
-            glDisableVertexAttribArray(pMSAA->m_pShader->m_TexCoordSlot);
-            glDisableVertexAttribArray(pMSAA->m_pShader->m_VertexSlot);
+            csrOpenGLStateSetAttribArrays(0);
 
             // unbind the VBO
             glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -1012,18 +2540,133 @@ void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
 //---------------------------------------------------------------------------
 // Draw private functions
 //---------------------------------------------------------------------------
-void csrOpenGLDrawArray(const CSR_VertexBuffer* pVB, size_t vertexCount)
+void csrOpenGLDrawArray(const CSR_VertexBuffer* pVB,
+                              size_t            vertexCount,
+                              GLenum            indexType,
+                        const GLvoid*           pIndices)
 {
+    GLenum mode;
+
     // search for array type to draw
     switch (pVB->m_Format.m_Type)
     {
-        case CSR_VT_Triangles:     glDrawArrays(GL_TRIANGLES,      0, (GLsizei)vertexCount); return;
-        case CSR_VT_TriangleStrip: glDrawArrays(GL_TRIANGLE_STRIP, 0, (GLsizei)vertexCount); return;
-        case CSR_VT_TriangleFan:   glDrawArrays(GL_TRIANGLE_FAN,   0, (GLsizei)vertexCount); return;
-        default:                                                                             return;
+        case CSR_VT_Triangles:     mode = GL_TRIANGLES;      break;
+        case CSR_VT_TriangleStrip: mode = GL_TRIANGLE_STRIP; break;
+        case CSR_VT_TriangleFan:   mode = GL_TRIANGLE_FAN;   break;
+        default:                   return;
     }
+
+    // draw the vertices by index, if the vertex buffer is indexed and its indices can be drawn
+    if (indexType != GL_NONE)
+        glDrawElements(mode, (GLsizei)vertexCount, indexType, pIndices);
+    else
+        glDrawArrays(mode, 0, (GLsizei)vertexCount);
 }
 //---------------------------------------------------------------------------
+#ifndef CSR_OPENGL_2_ONLY
+    int csrOpenGLDrawArrayInstanced(const CSR_VertexBuffer* pVB,
+                                    const CSR_OpenGLShader* pShader,
+                                    const CSR_Array*        pMatrixArray,
+                                          size_t            vertexCount,
+                                          GLenum            indexType,
+                                    const GLvoid*           pIndices)
+    {
+        size_t i;
+        size_t size;
+        GLenum mode;
+        float* pMatrices;
+
+        // does the shader support the instancing?
+        if (pShader->m_InstanceSlot < 0)
+            return 0;
+
+        // search for array type to draw
+        switch (pVB->m_Format.m_Type)
+        {
+            case CSR_VT_Triangles:     mode = GL_TRIANGLES;      break;
+            case CSR_VT_TriangleStrip: mode = GL_TRIANGLE_STRIP; break;
+            case CSR_VT_TriangleFan:   mode = GL_TRIANGLE_FAN;   break;
+            default:                   return 1;
+        }
+
+        // create the instance buffer, if still not exists
+        if (!g_OpenGLVBCache.m_InstanceBufferID)
+        {
+            glGenBuffers(1, &g_OpenGLVBCache.m_InstanceBufferID);
+
+            // succeeded?
+            if (!g_OpenGLVBCache.m_InstanceBufferID)
+                return 0;
+        }
+
+        // grow the instance data, if required. NOTE it's kept between the drawings, thus nothing
+        // is allocated once the largest instance count was drawn
+        if (pMatrixArray->m_Count > g_OpenGLVBCache.m_InstanceSize)
+        {
+            size = g_OpenGLVBCache.m_InstanceSize ? g_OpenGLVBCache.m_InstanceSize * 2 : 64;
+
+            if (size < pMatrixArray->m_Count)
+                size = pMatrixArray->m_Count;
+
+            pMatrices = (float*)csrMemoryAlloc(g_OpenGLVBCache.m_pInstanceData, sizeof(CSR_Matrix4), size);
+
+            // succeeded?
+            if (!pMatrices)
+                return 0;
+
+            g_OpenGLVBCache.m_pInstanceData = pMatrices;
+            g_OpenGLVBCache.m_InstanceSize  = size;
+        }
+
+        pMatrices = g_OpenGLVBCache.m_pInstanceData;
+
+        // gather the matrices, which aren't contiguous in the array
+        for (i = 0; i < pMatrixArray->m_Count; ++i)
+            memcpy(&pMatrices[i * 16], pMatrixArray->m_pItem[i].m_pData, sizeof(CSR_Matrix4));
+
+        // copy the matrices in the instance buffer. NOTE the previous content is orphaned, thus
+        // the drawings still using it aren't waited
+        glBindBuffer(GL_ARRAY_BUFFER, g_OpenGLVBCache.m_InstanceBufferID);
+        glBufferData(GL_ARRAY_BUFFER,
+                     pMatrixArray->m_Count * sizeof(CSR_Matrix4),
+                     pMatrices,
+                     GL_STREAM_DRAW);
+
+        // send the matrix columns to the shader, one matrix per instance
+        for (i = 0; i < 4; ++i)
+        {
+            const GLuint slot = (GLuint)pShader->m_InstanceSlot + (GLuint)i;
+
+            csrOpenGLStateSetAttribArrays(g_OpenGLState.m_AttribArrays | csrOpenGLStateAttribMask(slot));
+            glVertexAttribPointer(slot,
+                                  4,
+                                  GL_FLOAT,
+                                  GL_FALSE,
+                                  sizeof(CSR_Matrix4),
+                                  (GLvoid*)(i * 4 * sizeof(float)));
+            glVertexAttribDivisor(slot, 1);
+        }
+
+        // draw all the instances at once
+        if (indexType != GL_NONE)
+            glDrawElementsInstanced(mode,
+                                    (GLsizei)vertexCount,
+                                    indexType,
+                                    pIndices,
+                                    (GLsizei)pMatrixArray->m_Count);
+        else
+            glDrawArraysInstanced(mode, 0, (GLsizei)vertexCount, (GLsizei)pMatrixArray->m_Count);
+
+        // restore the matrix slots, the next drawings may use them as per-vertex attributes
+        for (i = 0; i < 4; ++i)
+            glVertexAttribDivisor((GLuint)pShader->m_InstanceSlot + (GLuint)i, 0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        return 1;
+    }
+#endif
+//---------------------------------------------------------------------------
 // Draw functions
 //---------------------------------------------------------------------------
 void csrOpenGLDrawBegin(const CSR_Color* pColor)
@@ -1038,18 +2681,23 @@ void csrOpenGLDrawBegin(const CSR_Color* pColor)
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // configure the OpenGL depth testing
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
+    csrOpenGLStateSetCapability(GL_DEPTH_TEST, &g_OpenGLState.m_DepthTest, 1);
+    csrOpenGLStateSetDepthMask(1);
     glDepthFunc(GL_LEQUAL);
     glDepthRangef(0.0f, 1.0f);
 }
 //---------------------------------------------------------------------------
 void csrOpenGLDrawEnd(void)
-{}
+{
+    // disable the vertex attribute arrays, which remain enabled between the drawings
+    csrOpenGLStateSetAttribArrays(0);
+
+    // delete the cached vertex buffers which are no longer used
+    csrOpenGLVBCachePurge();
+}
 //---------------------------------------------------------------------------
 void csrOpenGLDrawLine(const CSR_Line* pLine, const CSR_OpenGLShader* pShader)
 {
-    GLint  slot;
     size_t stride;
     float  lineVertex[14];
 
@@ -1073,17 +2721,14 @@ void csrOpenGLDrawLine(const CSR_Line* pLine, const CSR_OpenGLShader* pShader)
     // bind shader program
     csrOpenGLShaderEnable(pShader);
 
-    // get the model matrix slot from shader
-    slot = glGetUniformLocation(pShader->m_ProgramID, "csr_uModel");
-
-    // found it?
-    if (slot >= 0)
+    // does the shader contain a model matrix?
+    if (pShader->m_ModelSlot >= 0)
     {
         CSR_Matrix4 matrix;
         csrMat4Identity(&matrix);
 
         // connect default model matrix to shader
-        glUniformMatrix4fv(slot, 1, GL_FALSE, &matrix.m_Table[0][0]);
+        glUniformMatrix4fv(pShader->m_ModelSlot, 1, GL_FALSE, &matrix.m_Table[0][0]);
     }
 
     // generate the line vertex buffer
@@ -1113,8 +2758,8 @@ void csrOpenGLDrawLine(const CSR_Line* pLine, const CSR_OpenGLShader* pShader)
         return;
 
     // enable shader slots
-    glEnableVertexAttribArray(pShader->m_VertexSlot);
-    glEnableVertexAttribArray(pShader->m_ColorSlot);
+    csrOpenGLStateSetAttribArrays(csrOpenGLStateAttribMask(pShader->m_VertexSlot) |
+                                  csrOpenGLStateAttribMask(pShader->m_ColorSlot));
 
     // link the line buffer to the shader
     glVertexAttribPointer(pShader->m_VertexSlot,
@@ -1133,25 +2778,33 @@ void csrOpenGLDrawLine(const CSR_Line* pLine, const CSR_OpenGLShader* pShader)
     // draw the line
     glDrawArrays(GL_LINES, 0, 2);
 
-    // disable shader slots
-    glDisableVertexAttribArray(pShader->m_VertexSlot);
-    glDisableVertexAttribArray(pShader->m_ColorSlot);
+    // disable shader slots, the line buffer is no longer valid after the function returns
+    csrOpenGLStateSetAttribArrays(0);
 
     // unbind shader program
     csrOpenGLShaderEnable(0);
 }
 //---------------------------------------------------------------------------
-void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
-                               const CSR_OpenGLShader* pShader,
-                               const CSR_Array*        pMatrixArray)
+void csrOpenGLDrawSkinnedVertexBuffer(const CSR_VertexBuffer* pVB,
+                                      const CSR_VertexBuffer* pSkinVB,
+                                      const CSR_OpenGLShader* pShader,
+                                      const CSR_Array*        pMatrixArray)
 {
     GLvoid* pCoords;
     GLvoid* pNormals;
     GLvoid* pTexCoords;
     GLvoid* pColors;
+    GLvoid* pIndices;
+    float*  pData;
     size_t  i;
     size_t  offset;
     size_t  vertexCount;
+    size_t  data;
+    size_t  size;
+    GLenum  indexType;
+    int     cached;
+    int     skinCached;
+    int     instanced;
 
     // no vertex buffer to draw?
     if (!pVB)
@@ -1165,60 +2818,119 @@ void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
     if (!pVB->m_Count || !pVB->m_Format.m_Stride)
         return;
 
-    // configure the culling
+    // get the index type to draw
+    indexType = csrOpenGLVBCacheGetIndexType(pVB);
+
+    // is the vertex buffer indexed, but its indices cannot be drawn? (i.e. 32 bit indices on OpenGL
+    // ES 2.0 without the OES_element_index_uint extension). If yes, draw its vertices in the index
+    // order from the client memory
+    if (pVB->m_pIndex && indexType == GL_NONE)
+    {
+        pData = csrOpenGLVBCacheGetVertices(pVB);
+
+        // succeeded?
+        if (!pData)
+            return;
+    }
+    else
+        pData = pVB->m_pData;
+
+    // configure the culling. NOTE GL_NONE isn't a valid culled face, the culling is only disabled
     switch (pVB->m_Culling.m_Type)
     {
-        case CSR_CT_None:  glDisable(GL_CULL_FACE); glCullFace(GL_NONE);           break;
-        case CSR_CT_Front: glEnable(GL_CULL_FACE);  glCullFace(GL_FRONT);          break;
-        case CSR_CT_Back:  glEnable(GL_CULL_FACE);  glCullFace(GL_BACK);           break;
-        case CSR_CT_Both:  glEnable(GL_CULL_FACE);  glCullFace(GL_FRONT_AND_BACK); break;
-        default:           glDisable(GL_CULL_FACE); glCullFace(GL_NONE);           break;
+        case CSR_CT_Front: csrOpenGLStateSetCullFace(GL_FRONT);          break;
+        case CSR_CT_Back:  csrOpenGLStateSetCullFace(GL_BACK);           break;
+        case CSR_CT_Both:  csrOpenGLStateSetCullFace(GL_FRONT_AND_BACK); break;
+        default:                                                         break;
     }
 
+    csrOpenGLStateSetCapability(GL_CULL_FACE,
+                               &g_OpenGLState.m_Culling,
+                                pVB->m_Culling.m_Type == CSR_CT_Front ||
+                                pVB->m_Culling.m_Type == CSR_CT_Back  ||
+                                pVB->m_Culling.m_Type == CSR_CT_Both);
+
     // configure the culling face
     switch (pVB->m_Culling.m_Face)
     {
-        case CSR_CF_CW:  glFrontFace(GL_CW);  break;
-        case CSR_CF_CCW: glFrontFace(GL_CCW); break;
+        case CSR_CF_CW:  csrOpenGLStateSetFrontFace(GL_CW);  break;
+        case CSR_CF_CCW: csrOpenGLStateSetFrontFace(GL_CCW); break;
     }
 
     // configure the alpha blending
     if (pVB->m_Material.m_Transparent)
     {
-        glEnable(GL_BLEND);
-        glBlendEquation(GL_FUNC_ADD);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        csrOpenGLStateSetCapability(GL_BLEND, &g_OpenGLState.m_Blending, 1);
+        csrOpenGLStateSetBlendFunc(GL_FUNC_ADD, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
     else
-        glDisable(GL_BLEND);
+        csrOpenGLStateSetCapability(GL_BLEND, &g_OpenGLState.m_Blending, 0);
 
     // configure the wireframe mode
     #ifndef CSR_OPENGL_2_ONLY
         if (pVB->m_Material.m_Wireframe)
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+            csrOpenGLStateSetPolygonMode(GL_LINE);
         else
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            csrOpenGLStateSetPolygonMode(GL_FILL);
     #endif
 
-    // enable vertex slot
-    glEnableVertexAttribArray(pShader->m_VertexSlot);
+    // enable the vertex, normal, texture and color slots, and disable the others
+    csrOpenGLStateSetAttribArrays(csrOpenGLStateAttribMask(pShader->m_VertexSlot) |
+                                 (pVB->m_Format.m_HasNormal         ? csrOpenGLStateAttribMask(pShader->m_NormalSlot)   : 0) |
+                                 (pVB->m_Format.m_HasTexCoords      ? csrOpenGLStateAttribMask(pShader->m_TexCoordSlot) : 0) |
+                                 (pVB->m_Format.m_HasPerVertexColor ? csrOpenGLStateAttribMask(pShader->m_ColorSlot)    : 0) |
+                                 (pSkinVB ? csrOpenGLStateAttribMask(pShader->m_BoneIndicesSlot) |
+                                            csrOpenGLStateAttribMask(pShader->m_BoneWeightsSlot) : 0));
 
-    // enable normal slot
-    if (pVB->m_Format.m_HasNormal)
-        glEnableVertexAttribArray(pShader->m_NormalSlot);
+    skinCached = 0;
 
-    // enable texture slot
-    if (pVB->m_Format.m_HasTexCoords)
-        glEnableVertexAttribArray(pShader->m_TexCoordSlot);
+    // are the vertices skinned on the GPU?
+    if (pSkinVB)
+    {
+        // get the skin vertex buffer copy on the GPU side, or draw it from the client memory
+        skinCached = csrOpenGLVBCacheBind(pSkinVB);
 
-    // enable color slot
-    if (pVB->m_Format.m_HasPerVertexColor)
-        glEnableVertexAttribArray(pShader->m_ColorSlot);
+        if (skinCached)
+            data = 0;
+        else
+            data = (size_t)pSkinVB->m_pData;
+
+        // send the bone indices and weights to shader
+        glVertexAttribPointer(pShader->m_BoneIndicesSlot,
+                              M_X_SKIN_INFLUENCES,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              M_X_SKIN_STRIDE * sizeof(float),
+                              (GLvoid*)data);
+        glVertexAttribPointer(pShader->m_BoneWeightsSlot,
+                              M_X_SKIN_INFLUENCES,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              M_X_SKIN_STRIDE * sizeof(float),
+                              (GLvoid*)(data + M_X_SKIN_INFLUENCES * sizeof(float)));
+    }
+
+    // get the vertex buffer copy on the GPU side. If not available, the vertex buffer is drawn from
+    // the client memory
+    if (pData == pVB->m_pData)
+        cached = csrOpenGLVBCacheBind(pVB);
+    else
+        cached = 0;
+
+    // unbind the skin vertex buffer copy, if the vertex buffer is drawn from the client memory
+    if (!cached && skinCached)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // get the data start, which is an offset in the bound VBO if the vertex buffer is cached
+    if (cached)
+        data = 0;
+    else
+        data = (size_t)pData;
 
     offset = 0;
 
     // send vertices to shader
-    pCoords = &pVB->m_pData[offset];
+    pCoords = (GLvoid*)(data + offset * sizeof(float));
     glVertexAttribPointer(pShader->m_VertexSlot,
                           3,
                           GL_FLOAT,
@@ -1232,8 +2944,8 @@ void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
     if (pVB->m_Format.m_HasNormal)
     {
         // send normals to shader
-        pNormals = &pVB->m_pData[offset];
-        glVertexAttribPointer(pShader->m_TexCoordSlot,
+        pNormals = (GLvoid*)(data + offset * sizeof(float));
+        glVertexAttribPointer(pShader->m_NormalSlot,
                               3,
                               GL_FLOAT,
                               GL_FALSE,
@@ -1247,7 +2959,7 @@ void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
     if (pVB->m_Format.m_HasTexCoords)
     {
         // send textures to shader
-        pTexCoords = &pVB->m_pData[offset];
+        pTexCoords = (GLvoid*)(data + offset * sizeof(float));
         glVertexAttribPointer(pShader->m_TexCoordSlot,
                               2,
                               GL_FLOAT,
@@ -1262,7 +2974,7 @@ void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
     if (pVB->m_Format.m_HasPerVertexColor)
     {
         // send colors to shader
-        pColors = &pVB->m_pData[offset];
+        pColors = (GLvoid*)(data + offset * sizeof(float));
         glVertexAttribPointer(pShader->m_ColorSlot,
                               4,
                               GL_FLOAT,
@@ -1283,54 +2995,77 @@ void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
         glVertexAttrib4f(pShader->m_ColorSlot, r, g, b, a);
     }
 
-    // calculate the vertex count
-    vertexCount = pVB->m_Count / pVB->m_Format.m_Stride;
+    // calculate the vertex count, which is the index count if the vertex buffer is indexed
+    vertexCount = csrVertexBufferGetElementCount(pVB);
+
+    // get the indices start, which is an offset in the bound index copy if the vertex buffer is
+    // cached. NOTE the indices are drawn as 16 bit if they fit, otherwise as 32 bit, which OpenGL
+    // ES 2.0 supports only with the OES_element_index_uint extension
+    if (cached || indexType == GL_NONE)
+        pIndices = 0;
+    else
+    {
+        pIndices = (GLvoid*)csrOpenGLVBCacheGetIndices(pVB, indexType, &size);
+
+        // succeeded? If not, nothing is drawn
+        if (!pIndices)
+            vertexCount = 0;
+    }
 
     // do draw the vertex buffer several times?
     if (pMatrixArray && pMatrixArray->m_Count)
     {
-        // get the model matrix slot from shader
-        const GLint slot = glGetUniformLocation(pShader->m_ProgramID, "csr_uModel");
+        // draw all the instances at once, if supported
+        #ifndef CSR_OPENGL_2_ONLY
+            instanced = csrOpenGLDrawArrayInstanced(pVB,
+                                                    pShader,
+                                                    pMatrixArray,
+                                                    vertexCount,
+                                                    indexType,
+                                                    pIndices);
+        #else
+            instanced = 0;
+        #endif
+
+        // not supported? Draw the instances one by one
+        if (!instanced)
+        {
+            const GLint slot = pShader->m_ModelSlot;
 
-        // found it?
-        if (slot >= 0)
-            // yes, iterate through each matrix to use to draw the vertex buffer
-            for (i = 0; i < pMatrixArray->m_Count; ++i)
-            {
-                // connect the model matrix to the shader
-                glUniformMatrix4fv(slot,
-                                   1,
-                                   0,
-                                   &((CSR_Matrix4*)pMatrixArray->m_pItem[i].m_pData)->m_Table[0][0]);
-
-                // draw the next buffer
-                csrOpenGLDrawArray(pVB, vertexCount);
-            }
+            // does the shader contain a model matrix?
+            if (slot >= 0)
+                // yes, iterate through each matrix to use to draw the vertex buffer
+                for (i = 0; i < pMatrixArray->m_Count; ++i)
+                {
+                    // connect the model matrix to the shader
+                    glUniformMatrix4fv(slot,
+                                       1,
+                                       0,
+                                       &((CSR_Matrix4*)pMatrixArray->m_pItem[i].m_pData)->m_Table[0][0]);
+
+                    // draw the next buffer
+                    csrOpenGLDrawArray(pVB, vertexCount, indexType, pIndices);
+                }
+        }
     }
     else
         // no, simply draw the buffer without worrying about the model matrix
-        csrOpenGLDrawArray(pVB, vertexCount);
-
-    // disable vertices slots from shader
-    glDisableVertexAttribArray(pShader->m_VertexSlot);
+        csrOpenGLDrawArray(pVB, vertexCount, indexType, pIndices);
 
-    // disable normal slot
-    if (pVB->m_Format.m_HasNormal)
-        glDisableVertexAttribArray(pShader->m_NormalSlot);
-
-    // disable texture slot
-    if (pVB->m_Format.m_HasTexCoords)
-        glDisableVertexAttribArray(pShader->m_TexCoordSlot);
+    // unbind the vertex buffer copy, the next client memory drawings may not use it
+    if (cached || skinCached)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    // disable color slot
-    if (pVB->m_Format.m_HasPerVertexColor)
-        glDisableVertexAttribArray(pShader->m_ColorSlot);
+    // unbind the index copy as well
+    if (cached && pVB->m_pIndex)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 //---------------------------------------------------------------------------
-void csrOpenGLDrawMesh(const CSR_Mesh*         pMesh,
-                       const CSR_OpenGLShader* pShader,
-                       const CSR_Array*        pMatrixArray,
-                       const CSR_fOnGetID      fOnGetID)
+void csrOpenGLDrawSkinnedMesh(const CSR_Mesh*         pMesh,
+                              const CSR_VertexBuffer* pSkinVB,
+                              const CSR_OpenGLShader* pShader,
+                              const CSR_Array*        pMatrixArray,
+                              const CSR_fOnGetID      fOnGetID)
 {
     size_t i;
 
@@ -1366,22 +3101,22 @@ void csrOpenGLDrawMesh(const CSR_Mesh*         pMesh,
                 if (pTextureID && (GLuint)pTextureID->m_ID != M_CSR_Error_Code)
                 {
                     // select the texture sampler to use (GL_TEXTURE0 for normal textures)
-                    glActiveTexture(GL_TEXTURE0);
-                    glUniform1i(pShader->m_TextureSlot, GL_TEXTURE0);
+                    csrOpenGLStateSetActiveTexture(0);
+                    glUniform1i(pShader->m_TextureSlot, 0);
 
                     // bind the texure to use
-                    glBindTexture(GL_TEXTURE_2D, pTextureID->m_ID);
+                    csrOpenGLStateBindTexture(GL_TEXTURE_2D, pTextureID->m_ID);
                 }
 
                 // a bump map is defined for this mesh?
                 if (pBumpmapID && (GLuint)pBumpmapID->m_ID != M_CSR_Error_Code)
                 {
                     // select the texture sampler to use (GL_TEXTURE1 for bump map textures)
-                    glActiveTexture(GL_TEXTURE1);
-                    glUniform1i(pShader->m_BumpMapSlot, GL_TEXTURE1);
+                    csrOpenGLStateSetActiveTexture(1);
+                    glUniform1i(pShader->m_BumpMapSlot, 1);
 
                     // bind the texure to use
-                    glBindTexture(GL_TEXTURE_2D, pBumpmapID->m_ID);
+                    csrOpenGLStateBindTexture(GL_TEXTURE_2D, pBumpmapID->m_ID);
                 }
             }
 
@@ -1396,13 +3131,92 @@ void csrOpenGLDrawMesh(const CSR_Mesh*         pMesh,
                 //glUniform1i(pShader->m_CubemapSlot, GL_TEXTURE0);
 
                 // bind the cubemap texure to use
-                glBindTexture(GL_TEXTURE_CUBE_MAP, pCubemapID->m_ID);
+                csrOpenGLStateBindTexture(GL_TEXTURE_CUBE_MAP, pCubemapID->m_ID);
             }
         }
 
         // draw the next mesh vertex buffer
-        csrOpenGLDrawVertexBuffer(&pMesh->m_pVB[i], pShader, pMatrixArray);
+        csrOpenGLDrawSkinnedVertexBuffer(&pMesh->m_pVB[i],
+                                          pSkinVB ? &pSkinVB[i] : 0,
+                                          pShader,
+                                          pMatrixArray);
+    }
+}
+//---------------------------------------------------------------------------
+int csrOpenGLSkinXOnGPU(const CSR_X*            pX,
+                              size_t            meshIndex,
+                        const CSR_OpenGLShader* pShader,
+                              size_t            animSetIndex,
+                              size_t            frameIndex)
+{
+    size_t                       i;
+    CSR_Matrix4                  palette[M_CSR_OpenGL_Max_Bones];
+    const CSR_MeshSkinWeights_X* pMeshWeights = &pX->m_pMeshWeights[meshIndex];
+
+    // can the shader skin the mesh, and were its bone indices and weights baked?
+    if (!pShader                                              ||
+         pShader->m_BonesSlot       < 0                       ||
+         pShader->m_BoneIndicesSlot < 0                       ||
+         pShader->m_BoneWeightsSlot < 0                       ||
+         pMeshWeights->m_Count > (size_t)pShader->m_BoneCount ||
+         pMeshWeights->m_Count > M_CSR_OpenGL_Max_Bones       ||
+        !pX->m_pSkinVB                                        ||
+        !pX->m_pSkinVB[meshIndex].m_pData)
+        return 0;
+
+    // can the mesh indices be drawn? If not, the vertices are read in the index order while drawn,
+    // and the bone indices and weights no longer match them
+    for (i = 0; i < pX->m_pMesh[meshIndex].m_Count; ++i)
+        if (pX->m_pMesh[meshIndex].m_pVB[i].m_pIndex &&
+            csrOpenGLVBCacheGetIndexType(&pX->m_pMesh[meshIndex].m_pVB[i]) == GL_NONE)
+            return 0;
+
+    csrProfilerBegin("X bone palette");
+
+    // calculate the final matrix of each bone influencing the mesh
+    for (i = 0; i < pMeshWeights->m_Count; ++i)
+    {
+        CSR_Matrix4 boneMatrix;
+
+        // get the bone matrix
+        if (pX->m_PoseOnly)
+            csrBoneGetMatrix(pMeshWeights->m_pSkinWeights[i].m_pBone, 0, &boneMatrix);
+        else
+            csrBoneGetAnimMatrix(pMeshWeights->m_pSkinWeights[i].m_pBone,
+                                &pX->m_pAnimationSet[animSetIndex],
+                                 frameIndex,
+                                 0,
+                                &boneMatrix);
+
+        // get the final matrix after bones transform
+        csrMat4Multiply(&pMeshWeights->m_pSkinWeights[i].m_Matrix, &boneMatrix, &palette[i]);
     }
+
+    // send the bone palette to the shader, the vertices will be skinned while drawn
+    csrOpenGLShaderEnable(pShader);
+    glUniformMatrix4fv(pShader->m_BonesSlot,
+                       (GLsizei)pMeshWeights->m_Count,
+                       GL_FALSE,
+                       &palette[0].m_Table[0][0]);
+
+    csrProfilerEnd();
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
+                               const CSR_OpenGLShader* pShader,
+                               const CSR_Array*        pMatrixArray)
+{
+    csrOpenGLDrawSkinnedVertexBuffer(pVB, 0, pShader, pMatrixArray);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLDrawMesh(const CSR_Mesh*         pMesh,
+                       const CSR_OpenGLShader* pShader,
+                       const CSR_Array*        pMatrixArray,
+                       const CSR_fOnGetID      fOnGetID)
+{
+    csrOpenGLDrawSkinnedMesh(pMesh, 0, pShader, pMatrixArray, fOnGetID);
 }
 //---------------------------------------------------------------------------
 void csrOpenGLDrawModel(const CSR_Model*        pModel,
@@ -1453,11 +3267,11 @@ void csrOpenGLDrawMDL(const CSR_MDL*          pMDL,
         if (pTextureID && (GLuint)pTextureID->m_ID != M_CSR_Error_Code)
         {
             // select the texture sampler to use (GL_TEXTURE0 for normal textures)
-            glActiveTexture(GL_TEXTURE0);
-            glUniform1i(pShader->m_TextureSlot, GL_TEXTURE0);
+            csrOpenGLStateSetActiveTexture(0);
+            glUniform1i(pShader->m_TextureSlot, 0);
 
             // bind the texure to use
-            glBindTexture(GL_TEXTURE_2D, pTextureID->m_ID);
+            csrOpenGLStateBindTexture(GL_TEXTURE_2D, pTextureID->m_ID);
         }
     }
 
@@ -1496,6 +3310,7 @@ void csrOpenGLDrawX(const CSR_X*            pX,
     for (i = 0; i < pX->m_MeshCount; ++i)
     {
         int               useLocalMatrixArray;
+        int               gpuSkinning;
         CSR_Mesh*         pMesh;
         CSR_VertexBuffer* pSrcBuffer;
         CSR_Array*        pLocalMatrixArray;
@@ -1521,9 +3336,15 @@ void csrOpenGLDrawX(const CSR_X*            pX,
             // exists, a custom version of this function should also be written for it)
             continue;
 
-        // mesh contains skin weights?
-        if (pX->m_pMeshWeights[i].m_pSkinWeights)
+        // mesh contains skin weights? If yes, skin it on the GPU if the shader supports it
+        gpuSkinning = pX->m_pMeshWeights[i].m_pSkinWeights &&
+                      csrOpenGLSkinXOnGPU(pX, i, pShader, animSetIndex, frameIndex);
+
+        // otherwise skin it on the CPU
+        if (pX->m_pMeshWeights[i].m_pSkinWeights && !gpuSkinning)
         {
+            csrProfilerBegin("X skinning");
+
             // clear the previous print vertices (needs to be cleared to properly apply the weights)
             for (j = 0; j < pMesh->m_pVB->m_Count; j += pMesh->m_pVB->m_Format.m_Stride)
             {
@@ -1582,11 +3403,18 @@ void csrOpenGLDrawX(const CSR_X*            pX,
                         pX->m_pPrint[i].m_pData[iZ] += (outputVertex.m_Z * pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pWeights[k]);
                     }
             }
+
+            // notify that the print changed, thus its GPU copy is updated
+            csrVertexBufferUpdateGeneration(&pX->m_pPrint[i]);
+
+            csrProfilerEnd();
         }
 
-        // use the model print as final vertex buffer
-        pSrcBuffer   = pMesh->m_pVB;
-        pMesh->m_pVB = &pX->m_pPrint[i];
+        // use the model print as final vertex buffer, unless the GPU skins the source mesh
+        pSrcBuffer = pMesh->m_pVB;
+
+        if (!gpuSkinning)
+            pMesh->m_pVB = &pX->m_pPrint[i];
 
         useLocalMatrixArray = 0;
 
@@ -1627,7 +3455,11 @@ void csrOpenGLDrawX(const CSR_X*            pX,
             pLocalMatrixArray = (CSR_Array*)pMatrixArray;
 
         // draw the model mesh
-        csrOpenGLDrawMesh(pMesh, pShader, pLocalMatrixArray, fOnGetID);
+        csrOpenGLDrawSkinnedMesh(pMesh,
+                                 gpuSkinning ? &pX->m_pSkinVB[i] : 0,
+                                 pShader,
+                                 pLocalMatrixArray,
+                                 fOnGetID);
 
         // restore the correct mesh vertex buffer
         pMesh->m_pVB = pSrcBuffer;
@@ -1642,15 +3474,33 @@ void csrOpenGLDrawX(const CSR_X*            pX,
 //---------------------------------------------------------------------------
 void csrOpenGLStateEnableDepthMask(int value)
 {
-    // do disable the depth buffer writing?
-    if (!value)
+    // enable or disable the depth buffer writing
+    csrOpenGLStateSetDepthMask(value ? 1 : 0);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStateInvalidate(void)
+{
+    size_t i;
+
+    g_OpenGLState.m_Program       = -1;
+    g_OpenGLState.m_ActiveTexture = -1;
+
+    for (i = 0; i < M_CSR_OpenGL_State_Texture_Units; ++i)
     {
-        // disable the depth buffer writing
-        glDepthMask(GL_FALSE);
-        return;
+        g_OpenGLState.m_Texture[i] = -1;
+        g_OpenGLState.m_Cubemap[i] = -1;
     }
 
-    // enable the depth buffer writing again
-    glDepthMask(GL_TRUE);
+    g_OpenGLState.m_Culling           = -1;
+    g_OpenGLState.m_CullFace          = -1;
+    g_OpenGLState.m_FrontFace         = -1;
+    g_OpenGLState.m_Blending          = -1;
+    g_OpenGLState.m_BlendEquation     = -1;
+    g_OpenGLState.m_BlendSrc          = -1;
+    g_OpenGLState.m_BlendDst          = -1;
+    g_OpenGLState.m_PolygonMode       = -1;
+    g_OpenGLState.m_DepthTest         = -1;
+    g_OpenGLState.m_DepthMask         = -1;
+    g_OpenGLState.m_AttribArraysKnown = 0;
 }
 //---------------------------------------------------------------------------
@@ -44,6 +44,17 @@
     #error "The OpenGL renderer isn't implemented for this platform"
 #endif
 
+//---------------------------------------------------------------------------
+// Global defines
+//---------------------------------------------------------------------------
+#define M_CSR_OpenGL_VB_Cache_Max_Age    600 // drawing count after which an unused cached buffer is deleted
+#define M_CSR_OpenGL_State_Texture_Units 8   // texture units for which the bound textures are tracked
+#define M_CSR_OpenGL_State_Max_Attribs   32  // vertex attribute slots for which the arrays are tracked
+#define M_CSR_OpenGL_Max_Bones           64  // max bone matrices in a palette sent to the GPU skinning shaders
+#define M_CSR_OpenGL_Max_Short_Vertices  65535 // max vertex count for which the indices are drawn as 16 bit
+#define M_CSR_OpenGL_Texture_Queue_PBOs  4   // pixel buffer objects in the texture upload ring
+#define M_CSR_OpenGL_Program_Cache_ID    (('B' << 24) + ('P' << 16) + ('S' << 8) + 'C') // program binary file identifier
+
 //---------------------------------------------------------------------------
 // Structures
 //---------------------------------------------------------------------------
@@ -58,24 +69,53 @@ typedef struct
     GLint  m_ID;
 } CSR_OpenGLID;
 
+/**
+* Shader uniform, searched in the shader program only on its first use
+*/
+typedef struct
+{
+    char* m_pName;
+    GLint m_Slot;
+} CSR_OpenGLUniform;
+
 /**
 * Shader
 */
 typedef struct
 {
-    GLuint m_ProgramID;
-    GLuint m_VertexID;
-    GLuint m_FragmentID;
-    GLint  m_VertexSlot;
-    GLint  m_NormalSlot;
-    GLint  m_TexCoordSlot;
-    GLint  m_TextureSlot;
-    GLint  m_BumpMapSlot;
-    GLint  m_CubemapSlot;
-    GLint  m_ColorSlot;
-    GLint  m_ModelSlot;
+    GLuint             m_ProgramID;
+    GLuint             m_VertexID;
+    GLuint             m_FragmentID;
+    GLint              m_VertexSlot;
+    GLint              m_NormalSlot;
+    GLint              m_TexCoordSlot;
+    GLint              m_TextureSlot;
+    GLint              m_BumpMapSlot;
+    GLint              m_CubemapSlot;
+    GLint              m_ColorSlot;
+    GLint              m_ModelSlot;
+    GLint              m_InstanceSlot;   // per-instance model matrix attribute (mat4, i.e. 4 consecutive slots)
+    GLint              m_BoneIndicesSlot;
+    GLint              m_BoneWeightsSlot;
+    GLint              m_ProjectionSlot;
+    GLint              m_ViewSlot;
+    GLint              m_BonesSlot;      // bone matrix palette used by the GPU skinning
+    GLint              m_BoneCount;      // bone matrix palette size
+    CSR_OpenGLUniform* m_pUniform;       // user uniforms, see csrOpenGLShaderGetUniform()
+    size_t             m_UniformCount;
 } CSR_OpenGLShader;
 
+/**
+* Program binary cache, keeps the linked shader programs on the disk to skip their compilation on
+* the next launches
+*/
+typedef struct
+{
+    char*  m_pDir;   // directory containing the program binaries, 0 if the cache is disabled
+    size_t m_Hits;   // programs loaded from their binary
+    size_t m_Misses; // programs compiled from their sources while the cache was enabled
+} CSR_OpenGLProgramCache;
+
 /**
 * Static buffer, it's a buffer which the content was moved to a shader, i.e. on the GPU side
 */
@@ -85,6 +125,96 @@ typedef struct
     size_t m_Stride;
 } CSR_OpenGLStaticBuffer;
 
+/**
+* Vertex buffer cache item, it's a copy of a vertex buffer kept on the GPU side
+*/
+typedef struct
+{
+    const CSR_VertexBuffer* m_pKey;       // cached vertex buffer
+    size_t                  m_Generation; // vertex buffer data generation contained in the copy
+    size_t                  m_Length;     // copy length, in floats
+    size_t                  m_LastDraw;   // drawing during which the copy was last used
+    int                     m_Dynamic;    // if 1, the vertex buffer data was modified since cached
+    GLuint                  m_BufferID;
+    GLuint                  m_IndexBufferID; // vertex indices copy, 0 if the vertex buffer isn't indexed
+} CSR_OpenGLVBCacheItem;
+
+/**
+* Vertex buffer cache, contains the vertex buffers already copied on the GPU side
+*/
+typedef struct
+{
+    CSR_OpenGLVBCacheItem* m_pItem;     // cached vertex buffers, sorted by key
+    size_t                 m_Count;     // cached vertex buffer count
+    size_t                 m_DrawCount; // ended drawing count
+    int                    m_Disabled;  // if 1, the vertex buffers are drawn from the client memory
+    GLuint                 m_InstanceBufferID; // instance model matrices, refilled on each instanced drawing
+    float*                 m_pInstanceData;    // instance model matrices gathered before being copied, only grown
+    size_t                 m_InstanceSize;     // matrix count the instance data may contain
+    GLushort*              m_pShortIndex;      // indices converted to 16 bit before being drawn or copied, only grown
+    size_t                 m_ShortIndexSize;   // index count the 16 bit indices may contain
+    float*                 m_pVertexData;      // vertices read in the index order, if the indices cannot be drawn, only grown
+    size_t                 m_VertexDataSize;   // float count the vertex data may contain
+    int                    m_UIntIndices;      // 1 if the 32 bit indices are supported, 0 if not, -1 if still not queried
+} CSR_OpenGLVBCache;
+
+/**
+* OpenGL state, it's a copy of the current OpenGL state, used to skip the redundant changes. Each
+* value is -1 while unknown
+*/
+typedef struct
+{
+    GLint    m_Program;                                     // current shader program
+    GLint    m_ActiveTexture;                               // current texture unit, from 0
+    GLint    m_Texture[M_CSR_OpenGL_State_Texture_Units];   // 2D texture bound to each unit
+    GLint    m_Cubemap[M_CSR_OpenGL_State_Texture_Units];   // cubemap texture bound to each unit
+    GLint    m_Culling;                                     // 1 if the face culling is enabled
+    GLint    m_CullFace;
+    GLint    m_FrontFace;
+    GLint    m_Blending;                                    // 1 if the alpha blending is enabled
+    GLint    m_BlendEquation;
+    GLint    m_BlendSrc;
+    GLint    m_BlendDst;
+    GLint    m_PolygonMode;
+    GLint    m_DepthTest;                                   // 1 if the depth testing is enabled
+    GLint    m_DepthMask;                                   // 1 if the depth buffer writing is enabled
+    GLint    m_AttribCount;                                 // available vertex attribute slots, -1 if not queried
+    unsigned m_AttribArrays;                                // enabled vertex attribute arrays, one bit per slot
+    int      m_AttribArraysKnown;                           // if 0, the enabled vertex attribute arrays are unknown
+} CSR_OpenGLState;
+
+/**
+* Texture upload, i.e. a texture image ready to be copied on the GPU
+*/
+typedef struct
+{
+    unsigned char* m_pPixels;   // pixels in the OpenGL layout, i.e. tightly packed rows
+    size_t         m_Width;
+    size_t         m_Height;
+    size_t         m_RowSize;   // row size, in bytes
+    GLint          m_Format;    // GL_RGB or GL_RGBA
+    GLenum         m_Target;    // GL_TEXTURE_2D or a cubemap face, known once queued
+    GLuint         m_TextureID; // texture receiving the image, known once queued
+    size_t         m_Row;       // next row to upload
+} CSR_OpenGLTextureUpload;
+
+/**
+* Texture upload queue, copies the queued images on the GPU a few rows at a time, through a ring
+* of pixel buffer objects
+*/
+typedef struct
+{
+    CSR_OpenGLTextureUpload** m_pUpload;                                // pending uploads, in the order they were queued
+    size_t                    m_Count;                                  // pending upload count
+    size_t                    m_FrameBudget;                            // max bytes uploaded per frame
+    size_t                    m_PBOSize;                                // pixel buffer object size, in bytes
+    size_t                    m_PBOIndex;                               // next pixel buffer object to fill
+    GLuint                    m_PBO[M_CSR_OpenGL_Texture_Queue_PBOs];   // pixel buffer objects, 0 until first used
+    #ifndef CSR_OPENGL_2_ONLY
+        GLsync                m_Fence[M_CSR_OpenGL_Texture_Queue_PBOs]; // last upload from each pixel buffer object, 0 if none
+    #endif
+} CSR_OpenGLTextureQueue;
+
 /**
 * Multisampling antialiasing
 */
@@ -129,6 +259,104 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         */
         GLuint csrOpenGLTextureFromPixelBuffer(const CSR_PixelBuffer* pPixelBuffer);
 
+        //-------------------------------------------------------------------
+        // Texture upload functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a texture upload from a pixel buffer
+        *@param pPixelBuffer - pixel buffer containing the texture image
+        *@return newly created texture upload, 0 on error
+        *@note This function doesn't use OpenGL, thus the images may be decoded and prepared on a
+        *      worker thread, e.g. with csrPixelBufferFromBitmapFile() and this function, and then
+        *      queued on the rendering thread
+        *@note The texture upload must be released when no longer used, unless it was queued, see
+        *      csrOpenGLTextureUploadRelease()
+        */
+        CSR_OpenGLTextureUpload* csrOpenGLTextureUploadCreate(const CSR_PixelBuffer* pPixelBuffer);
+
+        /**
+        * Releases a texture upload
+        *@param[in, out] pUpload - texture upload to release
+        *@note The texture receiving the image, if any, isn't deleted
+        */
+        void csrOpenGLTextureUploadRelease(CSR_OpenGLTextureUpload* pUpload);
+
+        //-------------------------------------------------------------------
+        // Texture queue functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a texture upload queue
+        *@param pboSize - pixel buffer object size, in bytes, e.g. 1 MB
+        *@param frameBudget - max bytes uploaded each time the queue is processed, e.g. 2 MB
+        *@return newly created texture upload queue, 0 on error
+        *@note The texture upload queue must be released when no longer used, see
+        *      csrOpenGLTextureQueueRelease()
+        */
+        CSR_OpenGLTextureQueue* csrOpenGLTextureQueueCreate(size_t pboSize, size_t frameBudget);
+
+        /**
+        * Releases a texture upload queue
+        *@param[in, out] pQueue - texture upload queue to release
+        *@note The pending uploads are released, but their textures are kept, and remain incomplete
+        */
+        void csrOpenGLTextureQueueRelease(CSR_OpenGLTextureQueue* pQueue);
+
+        /**
+        * Queues a texture upload
+        *@param[in, out] pQueue - texture upload queue to add to
+        *@param pUpload - texture upload to queue, owned by the queue on success
+        *@return texture receiving the image, M_CSR_Error_Code on error
+        *@note The texture is created immediately, thus it may be linked to a model, but its content
+        *      is undefined until the upload is completed, see csrOpenGLTextureQueueIsPending()
+        *@note The upload should be cancelled before the texture is deleted, otherwise the queue
+        *      would continue to fill it, see csrOpenGLTextureQueueCancel()
+        */
+        GLuint csrOpenGLTextureQueueAdd(CSR_OpenGLTextureQueue* pQueue, CSR_OpenGLTextureUpload* pUpload);
+
+        /**
+        * Queues the uploads of the 6 cubemap faces
+        *@param[in, out] pQueue - texture upload queue to add to
+        *@param pUploads - texture uploads of each face, owned by the queue on success. A missing
+        *                  face may be 0
+        *@return cubemap texture receiving the faces, M_CSR_Error_Code on error
+        *@note The uploads should be cancelled before the cubemap is deleted, see
+        *      csrOpenGLTextureQueueCancel()
+        */
+        GLuint csrOpenGLTextureQueueAddCubemap(CSR_OpenGLTextureQueue* pQueue, CSR_OpenGLTextureUpload** pUploads);
+
+        /**
+        * Processes a texture upload queue, i.e. uploads the next pending images rows
+        *@param[in, out] pQueue - texture upload queue to process
+        *@return completed upload count
+        *@note This function should be called once per frame, on the rendering thread. It uploads at
+        *      most the queue frame budget, and never waits for the GPU: a pixel buffer object still
+        *      used by a previous upload isn't refilled before its fence is signaled
+        *@note With OpenGL 2 only, the rows are uploaded from the client memory, still limited by
+        *      the frame budget
+        */
+        size_t csrOpenGLTextureQueueProcess(CSR_OpenGLTextureQueue* pQueue);
+
+        /**
+        * Checks if a texture is still being uploaded
+        *@param pQueue - texture upload queue
+        *@param textureID - texture to check
+        *@return 1 if the texture content is still incomplete, otherwise 0
+        */
+        int csrOpenGLTextureQueueIsPending(const CSR_OpenGLTextureQueue* pQueue, GLuint textureID);
+
+        /**
+        * Cancels the pending uploads of a texture
+        *@param[in, out] pQueue - texture upload queue
+        *@param textureID - texture for which the uploads should be cancelled
+        *@return cancelled upload count
+        *@note This function must be called before a still pending texture is deleted, otherwise
+        *      the queue would upload the remaining rows in a deleted, or worse, a reused texture
+        *      identifier. The texture itself is kept, and remains incomplete
+        */
+        size_t csrOpenGLTextureQueueCancel(CSR_OpenGLTextureQueue* pQueue, GLuint textureID);
+
         //-------------------------------------------------------------------
         // Cubemap functions
         //-------------------------------------------------------------------
@@ -226,6 +454,8 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         *@param pCustomData - custom data to send to fOnLinkStaticVB, 0 if not used
         *@return newly created shader, 0 on error
         *@note The shader must be released when no longer used, see csrShaderRelease()
+        *@note If the program binary cache is enabled, the program is loaded from its binary if
+        *      possible, and compiled from the sources otherwise, see csrOpenGLProgramCacheEnable()
         */
         CSR_OpenGLShader* csrOpenGLShaderLoadFromBuffer(const CSR_Buffer*         pVertex,
                                                         const CSR_Buffer*         pFragment,
@@ -249,6 +479,12 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         * Links the shader
         *@param[in, out] pShader - shader to link, linked shader if function ends with success
         *@return 1 on success, otherwise 0
+        *@note The well-known slots are resolved once linked, thus they are never searched while
+        *      drawing. These are the csr_aVertices, csr_aNormal, csr_aTexCoord, csr_aColor,
+        *      csr_aModel, csr_aBoneIndices and csr_aBoneWeights attributes, and the csr_uProjection,
+        *      csr_uView, csr_uModel, csr_uBones, csr_sTexture (or csr_sColorMap), csr_sBumpMap and
+        *      csr_sCubemap uniforms. Each slot remains -1 if not used by the shader, and may still
+        *      be overwritten by the caller
         */
         int csrOpenGLShaderLink(CSR_OpenGLShader* pShader);
 
@@ -274,6 +510,41 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         void csrOpenGLShaderConnectViewMatrix(const CSR_OpenGLShader* pShader,
                                               const CSR_Matrix4*      pMatrix);
 
+        /**
+        * Gets a user uniform slot
+        *@param[in, out] pShader - shader containing the uniform
+        *@param pName - uniform name
+        *@return uniform slot, -1 if not found or on error
+        *@note The uniform is searched in the shader program only the first time, the slot is then
+        *      kept in the shader until it's linked again
+        */
+        GLint csrOpenGLShaderGetUniform(CSR_OpenGLShader* pShader, const char* pName);
+
+        //-------------------------------------------------------------------
+        // Program cache functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Enables the program binary cache
+        *@param pDir - directory in which the program binaries are stored, including the trailing
+        *              path separator, 0 to disable the cache
+        *@return 1 on success, otherwise 0
+        *@note The binaries are keyed by a hash of the shader sources and of the OpenGL vendor,
+        *      renderer and version strings, thus a driver update invalidates them. A binary the
+        *      driver rejects is replaced by the program compiled from the sources
+        *@note The programs linked with a fOnLinkStaticVB callback are always compiled, because the
+        *      callback may change the link result
+        *@note Requires OpenGL 4.1 or OpenGL ES 3.0, does nothing with OpenGL 2 only or if the driver
+        *      supports no binary format
+        */
+        int csrOpenGLProgramCacheEnable(const char* pDir);
+
+        /**
+        * Gets the program binary cache
+        *@return program binary cache
+        */
+        const CSR_OpenGLProgramCache* csrOpenGLProgramCacheGet(void);
+
         //-------------------------------------------------------------------
         // Static buffer functions
         //-------------------------------------------------------------------
@@ -302,6 +573,35 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         */
         void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB);
 
+        //-------------------------------------------------------------------
+        // Vertex buffer cache functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Enables or disables the vertex buffer cache
+        *@param value - if 1, the vertex buffers are copied on the GPU side the first time they are
+        *               drawn, otherwise they are drawn from the client memory
+        *@note The cache is enabled by default. Disabling it deletes all the cached buffers
+        */
+        void csrOpenGLVBCacheEnable(int value);
+
+        /**
+        * Deletes the GPU copy of a vertex buffer
+        *@param pVB - vertex buffer for which the copy should be deleted
+        *@note This function is set as the vertex buffer delete callback (see
+        *      csrVertexBufferSetOnDelete()) once a copy exists, thus the copy is deleted when its
+        *      vertex buffer content is released. The copies of the vertex buffers freed by other
+        *      means are deleted once they remained unused during M_CSR_OpenGL_VB_Cache_Max_Age
+        *      drawings
+        */
+        void csrOpenGLVBCacheDelete(const CSR_VertexBuffer* pVB);
+
+        /**
+        * Deletes all the cached vertex buffers, and the instance buffer
+        *@note This function should be called before the OpenGL context is destroyed
+        */
+        void csrOpenGLVBCacheClear(void);
+
         //-------------------------------------------------------------------
         // Multisampling antialiasing functions
         //-------------------------------------------------------------------
@@ -378,6 +678,7 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
 
         /**
         * Ends to draw
+        *@note The cached vertex buffers which remained unused for too long are deleted here
         */
         void csrOpenGLDrawEnd(void);
 
@@ -395,6 +696,13 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         *@param pMatrixArray - matrices to use, one for each vertex buffer drawing. If 0, the model
         *                      matrix currently connected in the shader will be used
         *@note The shader must be first enabled with the csrShaderEnable() function
+        *@note The vertex buffer is copied on the GPU side the first time it's drawn, and the copy
+        *      is updated only when its generation changes, see csrVertexBufferUpdateGeneration()
+        *@note If the shader declares a per-instance model matrix attribute (e.g. attribute mat4
+        *      csr_aModel, which slot is set in m_InstanceSlot), all the matrices are drawn at once
+        *      using the hardware instancing. Such shader should always be drawn with a matrix array.
+        *      Otherwise, or on OpenGL ES 2, the vertex buffer is drawn once per matrix, which is
+        *      connected to the csr_uModel uniform
         */
         void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
                                        const CSR_OpenGLShader* pShader,
@@ -456,6 +764,13 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         *@param animSetIndex - animation set index, ignored if model isn't animated
         *@param frameIndex - frame index, ignored if model isn't animated
         *@param fOnGetID - callback function to get the OpenGL identifier matching with a key
+        *@note The skinned meshes are skinned on the GPU if the shader declares the csr_uBones
+        *      uniform (a mat4 array, large enough to contain all the bones influencing a mesh, and
+        *      up to M_CSR_OpenGL_Max_Bones) and the csr_aBoneIndices and csr_aBoneWeights
+        *      attributes (vec4, containing the indices in csr_uBones of the bones influencing the
+        *      vertex and their weights). In this case the vertex position should be calculated by
+        *      the shader as the sum of each bone matrix multiplied by the vertex, then by the bone
+        *      weight. Otherwise the meshes are skinned on the CPU
         */
         void csrOpenGLDrawX(const CSR_X*            pX,
                             const CSR_OpenGLShader* pShader,
@@ -474,6 +789,17 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         */
         void csrOpenGLStateEnableDepthMask(int value);
 
+        /**
+        * Invalidates the OpenGL state copy, thus the next state changes are applied unconditionally
+        *@note The renderer keeps a copy of the OpenGL state, and skips the changes which would not
+        *      modify it. This function should be called after any state was changed by a code not
+        *      belonging to the renderer, e.g. a glUseProgram(), glBindTexture(), glEnable() or
+        *      glEnableVertexAttribArray() call, or a glDeleteTextures() call on a bound texture
+        *@note The vertex attribute arrays remain enabled between the drawings, and are disabled
+        *      by csrOpenGLDrawEnd()
+        */
+        void csrOpenGLStateInvalidate(void);
+
 #ifdef __cplusplus
     }
 #endif
@@ -199,783 +199,5034 @@ void csrSceneContextInit(CSR_SceneContext* pContext)
     pContext->m_fOnGetMDLIndex            = 0;
     pContext->m_fOnGetXIndex              = 0;
     pContext->m_fOnGetShader              = 0;
+    pContext->m_fOnDrawItem               = 0;
+    pContext->m_fOnVisibleSet             = 0;
     pContext->m_fOnGetID                  = 0;
     pContext->m_fOnDeleteTexture          = 0;
+    pContext->m_pDrawList                 = 0;
+    pContext->m_pTransparentList          = 0;
+    pContext->m_pOcclusionBuffer          = 0;
+    pContext->m_fOnRunJobs                = 0;
+    pContext->m_JobCount                  = 0;
 }
 //---------------------------------------------------------------------------
 // Scene item private functions
 //---------------------------------------------------------------------------
-CSR_SceneItem* csrSceneItemDeleteModelFrom(CSR_SceneItem*       pItem,
-                                           size_t               index,
-                                           size_t               count,
-                                     const CSR_fOnDeleteTexture fOnDeleteTexture)
+void csrSceneModelRelease(void* pModel, CSR_EModelType type, const CSR_fOnDeleteTexture fOnDeleteTexture)
 {
-    CSR_SceneItem* pNewItem;
+    // no model to release?
+    if (!pModel)
+        return;
 
-    // no item list to delete from?
-    if (!pItem)
-        return 0;
+    switch (type)
+    {
+        case CSR_MT_Line:  free((CSR_Line*)pModel);                   break;
+        case CSR_MT_Mesh:  csrMeshRelease(pModel,  fOnDeleteTexture); break;
+        case CSR_MT_Model: csrModelRelease(pModel, fOnDeleteTexture); break;
+        case CSR_MT_MDL:   csrMDLRelease(pModel,   fOnDeleteTexture); break;
+        case CSR_MT_X:     csrXRelease(pModel,     fOnDeleteTexture); break;
+    }
+}
+//---------------------------------------------------------------------------
+void csrSceneDeleteInstanceAt(CSR_Scene* pScene, CSR_SceneItem* pItem, size_t index)
+{
+    size_t          last;
+    CSR_HandleSlot* pSlot;
 
-    // was the last model in the scene?
-    if (count == 1)
-        // don't create a new scene item list
-        return 0;
+    // validate the inputs
+    if (!pScene || !pItem || !pItem->m_pMatrixArray || index >= pItem->m_pMatrixArray->m_Count)
+        return;
 
-    // create a scene item list one item smaller than the existing one
-    pNewItem = (CSR_SceneItem*)csrMemoryAlloc(0, sizeof(CSR_SceneItem), count - 1);
+    last = pItem->m_pMatrixArray->m_Count - 1;
 
-    // succeeded?
-    if (!pNewItem)
-        return 0;
+    // free the matrix, if required
+    if (pItem->m_pMatrixArray->m_pItem[index].m_AutoFree && pItem->m_pMatrixArray->m_pItem[index].m_pData)
+        free(pItem->m_pMatrixArray->m_pItem[index].m_pData);
 
-    // copy all the remaining items in the new list
-    if (!index)
-        memcpy(pNewItem, pItem + 1, (count - 1) * sizeof(CSR_SceneItem));
-    else
-    if (index == (count - 1))
-        memcpy(pNewItem, pItem, (count - 1) * sizeof(CSR_SceneItem));
+    // release the instance handle
+    if (index < pItem->m_InstanceHandleCount)
+        csrHandleTableDelete(&pScene->m_InstanceHandles, pItem->m_pInstanceHandle[index]);
+
+    // move the last instance in the free location, thus the other instances don't move
+    if (index != last)
+    {
+        pItem->m_pMatrixArray->m_pItem[index] = pItem->m_pMatrixArray->m_pItem[last];
+
+        // move the level of detail state with the instance
+        if (pItem->m_pLOD && last < pItem->m_pLOD->m_StateCount)
+            pItem->m_pLOD->m_pState[index] = pItem->m_pLOD->m_pState[last];
+
+        // update the moved instance handle
+        if (last < pItem->m_InstanceHandleCount)
+        {
+            pItem->m_pInstanceHandle[index] = pItem->m_pInstanceHandle[last];
+
+            pSlot = csrHandleTableGet(&pScene->m_InstanceHandles, pItem->m_pInstanceHandle[index]);
+
+            if (pSlot)
+                pSlot->m_Index = index;
+        }
+    }
+
+    --pItem->m_pMatrixArray->m_Count;
+
+    if (pItem->m_pLOD && pItem->m_pLOD->m_StateCount > pItem->m_pMatrixArray->m_Count)
+        pItem->m_pLOD->m_StateCount = pItem->m_pMatrixArray->m_Count;
+
+    if (pItem->m_InstanceHandleCount > pItem->m_pMatrixArray->m_Count)
+        pItem->m_InstanceHandleCount = pItem->m_pMatrixArray->m_Count;
+
+    // was the last instance?
+    if (!pItem->m_pMatrixArray->m_Count)
+    {
+        free(pItem->m_pMatrixArray->m_pItem);
+        pItem->m_pMatrixArray->m_pItem = 0;
+
+        free(pItem->m_pInstanceHandle);
+        pItem->m_pInstanceHandle     = 0;
+        pItem->m_InstanceHandleCount = 0;
+    }
+}
+//---------------------------------------------------------------------------
+void csrSceneDeleteItemAt(      CSR_Scene*           pScene,
+                                int                  transparent,
+                                size_t               index,
+                          const CSR_fOnDeleteTexture fOnDeleteTexture)
+{
+    size_t          i;
+    size_t          last;
+    CSR_SceneItem*  pItems;
+    CSR_SceneItem*  pNewItems;
+    CSR_HandleSlot* pSlot;
+
+    // get the list containing the item
+    if (transparent)
+    {
+        pItems = pScene->m_pTransparentItem;
+        last   = pScene->m_TransparentItemCount - 1;
+    }
     else
     {
-        memcpy(pNewItem,         pItem,             sizeof(CSR_SceneItem) *          index);
-        memcpy(pNewItem + index, pItem + index + 1, sizeof(CSR_SceneItem) * (count - index - 1));
+        pItems = pScene->m_pItem;
+        last   = pScene->m_ItemCount - 1;
     }
 
+    // release the instance handles
+    for (i = 0; i < pItems[index].m_InstanceHandleCount; ++i)
+        csrHandleTableDelete(&pScene->m_InstanceHandles, pItems[index].m_pInstanceHandle[i]);
+
+    // release the item handle
+    csrHandleTableDelete(&pScene->m_ItemHandles, pItems[index].m_Handle);
+
     // release the item content
-    csrSceneItemContentRelease(&pItem[index], fOnDeleteTexture);
+    csrSceneItemContentRelease(&pItems[index], fOnDeleteTexture);
+
+    // move the last item in the free location, thus the other items don't move
+    if (index != last)
+    {
+        pItems[index] = pItems[last];
+
+        // update the moved item handle
+        pSlot = csrHandleTableGet(&pScene->m_ItemHandles, pItems[index].m_Handle);
+
+        if (pSlot)
+            pSlot->m_Index = index;
+    }
+
+    // was the last item?
+    if (!last)
+    {
+        free(pItems);
+        pNewItems = 0;
+    }
+    else
+    {
+        // shrink the list. NOTE if it fails, the previous list is still valid and can be kept
+        pNewItems = (CSR_SceneItem*)csrMemoryAlloc(pItems, sizeof(CSR_SceneItem), last);
+
+        if (!pNewItems)
+            pNewItems = pItems;
+    }
 
-    return pNewItem;
+    // update the scene content
+    if (transparent)
+    {
+        pScene->m_pTransparentItem     = pNewItems;
+        pScene->m_TransparentItemCount = last;
+    }
+    else
+    {
+        pScene->m_pItem     = pNewItems;
+        pScene->m_ItemCount = last;
+    }
 }
 //---------------------------------------------------------------------------
-// Scene item functions
+void csrSceneItemGetCenter(const CSR_SceneItem* pItem, const CSR_Matrix4* pMatrix, CSR_Vector3* pR)
+{
+    CSR_Vector3 position;
+
+    // the item is located on its bounding box center, or on its origin if it has no box
+    if (pItem->m_HasBox)
+    {
+        position.m_X = (pItem->m_Box.m_Min.m_X + pItem->m_Box.m_Max.m_X) * 0.5f;
+        position.m_Y = (pItem->m_Box.m_Min.m_Y + pItem->m_Box.m_Max.m_Y) * 0.5f;
+        position.m_Z = (pItem->m_Box.m_Min.m_Z + pItem->m_Box.m_Max.m_Z) * 0.5f;
+    }
+    else
+    {
+        position.m_X = 0.0f;
+        position.m_Y = 0.0f;
+        position.m_Z = 0.0f;
+    }
+
+    // put the position in the world coordinates system
+    if (pMatrix)
+        csrMat4ApplyToVector(pMatrix, &position, pR);
+    else
+        *pR = position;
+}
 //---------------------------------------------------------------------------
-CSR_SceneItem* csrSceneItemCreate(void)
+void csrSceneGetViewPosition(const CSR_Scene* pScene, CSR_Vector3* pR)
 {
-    // create a new scene item
-    CSR_SceneItem* pSceneItem = (CSR_SceneItem*)malloc(sizeof(CSR_SceneItem));
+    float       determinant;
+    CSR_Matrix4 invViewMatrix;
 
-    // succeeded?
-    if (!pSceneItem)
-        return 0;
+    // the camera is located on the view coordinates system origin
+    csrMat4Inverse(&pScene->m_ViewMatrix, &invViewMatrix, &determinant);
 
-    // initialize the scene item content
-    csrSceneItemInit(pSceneItem);
+    pR->m_X = invViewMatrix.m_Table[3][0];
+    pR->m_Y = invViewMatrix.m_Table[3][1];
+    pR->m_Z = invViewMatrix.m_Table[3][2];
+}
+//---------------------------------------------------------------------------
+size_t csrSceneLODGetLevel(const CSR_SceneLODGroup* pLOD, float distance)
+{
+    size_t level = 0;
 
-    return pSceneItem;
+    // the levels are sorted by ascending distance
+    while (level < pLOD->m_Count && distance >= pLOD->m_pLevel[level].m_Distance)
+        ++level;
+
+    return level;
 }
 //---------------------------------------------------------------------------
-void csrSceneItemContentRelease(CSR_SceneItem*       pSceneItem,
-                          const CSR_fOnDeleteTexture fOnDeleteTexture)
+size_t csrSceneItemSelectLOD(const CSR_SceneItem* pItem,
+                                   size_t         index,
+                             const CSR_Matrix4*   pMatrix,
+                             const CSR_Vector3*   pViewPos)
 {
-    // no scene item to release?
-    if (!pSceneItem)
-        return;
+    size_t             farLevel;
+    size_t             nearLevel;
+    size_t             level;
+    float              distance;
+    float              hysteresis;
+    CSR_Vector3        center;
+    CSR_Vector3        delta;
+    CSR_SceneLODGroup* pLOD = pItem->m_pLOD;
+
+    // calculate the instance distance from the camera
+    csrSceneItemGetCenter(pItem, pMatrix, &center);
+    csrVec3Sub(&center, pViewPos, &delta);
+    csrVec3Length(&delta, &distance);
+
+    // limit the hysteresis to a meaningful range
+    hysteresis = pLOD->m_Hysteresis;
+
+    if (hysteresis < 0.0f)
+        hysteresis = 0.0f;
+    else
+    if (hysteresis > 0.9f)
+        hysteresis = 0.9f;
 
-    // release the model
-    if (pSceneItem->m_pModel)
-        switch (pSceneItem->m_Type)
-        {
-            case CSR_MT_Line:  free((CSR_Line*)pSceneItem->m_pModel);                   break;
-            case CSR_MT_Mesh:  csrMeshRelease(pSceneItem->m_pModel,  fOnDeleteTexture); break;
-            case CSR_MT_Model: csrModelRelease(pSceneItem->m_pModel, fOnDeleteTexture); break;
-            case CSR_MT_MDL:   csrMDLRelease(pSceneItem->m_pModel,   fOnDeleteTexture); break;
-            case CSR_MT_X:     csrXRelease(pSceneItem->m_pModel,     fOnDeleteTexture); break;
-        }
+    // get the levels allowed around the current distance. NOTE the current level is kept as long
+    // as it remains between them, which avoids to pop between two levels around a threshold
+    farLevel  = csrSceneLODGetLevel(pLOD, distance / (1.0f + hysteresis));
+    nearLevel = csrSceneLODGetLevel(pLOD, distance / (1.0f - hysteresis));
 
-    // release the aligned-axis bounding box tree
-    if (pSceneItem->m_pAABBTree)
+    // is the instance level known? (if not, select the coarsest allowed level)
+    if (index < pLOD->m_StateCount && pLOD->m_pState[index] != 0xFF)
     {
-        size_t i;
+        level = pLOD->m_pState[index];
 
-        // release all the tree content
-        for (i = 0; i < pSceneItem->m_AABBTreeCount; ++i)
-        {
-            // get the AABB tree root node
-            CSR_AABBNode* pNode = &pSceneItem->m_pAABBTree[i];
+        if (level < farLevel)
+            level = farLevel;
+        else
+        if (level > nearLevel)
+            level = nearLevel;
+    }
+    else
+        level = nearLevel;
 
-            // release all children on left side
-            if (pNode->m_pLeft)
-                csrAABBTreeNodeRelease(pNode->m_pLeft);
+    // keep the level for the next frame
+    if (index < pLOD->m_StateCount)
+        pLOD->m_pState[index] = (unsigned char)level;
 
-            // release all children on right side
-            if (pNode->m_pRight)
-                csrAABBTreeNodeRelease(pNode->m_pRight);
+    return level;
+}
+//---------------------------------------------------------------------------
+void csrSceneItemUpdateLODState(const CSR_SceneItem* pItem)
+{
+    unsigned char*     pState;
+    CSR_SceneLODGroup* pLOD = pItem->m_pLOD;
 
-            // delete node content
-            csrAABBTreeNodeContentRelease(pNode);
-        }
+    // nothing to do if the level states match with the instances
+    if (!pItem->m_pMatrixArray || pLOD->m_StateCount == pItem->m_pMatrixArray->m_Count)
+        return;
 
-        // free the tree container
-        free(pSceneItem->m_pAABBTree);
-    }
+    // reallocate the states, one per instance
+    pState = (unsigned char*)csrMemoryAlloc(pLOD->m_pState,
+                                            sizeof(unsigned char),
+                                            pItem->m_pMatrixArray->m_Count);
 
-    // release the matrix array
-    csrArrayRelease(pSceneItem->m_pMatrixArray);
+    // succeeded? (if not, the levels are selected without hysteresis)
+    if (!pState)
+        return;
 
-    // NOTE don't release the shader, as it's just linked with the item, not owned
+    // the instances changed, thus their previous levels are unknown
+    memset(pState, 0xFF, pItem->m_pMatrixArray->m_Count);
+
+    pLOD->m_pState     = pState;
+    pLOD->m_StateCount = pItem->m_pMatrixArray->m_Count;
 }
 //---------------------------------------------------------------------------
-void csrSceneItemInit(CSR_SceneItem* pSceneItem)
+void* csrSceneItemGetLODModel(const CSR_SceneItem* pItem, size_t level)
 {
-    // no scene item to initialize?
-    if (!pSceneItem)
-        return;
+    if (!level)
+        return pItem->m_pModel;
 
-    // initialize the scene item
-    pSceneItem->m_pModel        = 0;
-    pSceneItem->m_Type          = CSR_MT_Model;
-    pSceneItem->m_CollisionType = CSR_CO_None;
-    pSceneItem->m_pMatrixArray  = 0;
-    pSceneItem->m_pAABBTree     = 0;
-    pSceneItem->m_AABBTreeCount = 0;
-    pSceneItem->m_AABBTreeIndex = 0;
+    return pItem->m_pLOD->m_pLevel[level - 1].m_pModel;
 }
 //---------------------------------------------------------------------------
-void csrSceneItemDraw(const CSR_Scene*        pScene,
-                      const CSR_SceneContext* pContext,
-                      const CSR_SceneItem*    pItem)
+int csrSceneBatchIsVisible(const CSR_SceneContext* pContext,
+                           const CSR_SceneBatch*   pBatch,
+                           const CSR_Frustum*      pFrustum)
+{
+    size_t i;
+
+    // the batch box contains all the merged instances, but it may be visible while none of them
+    // is, e.g. if they are spread around the view. NOTE the ranges are in the world coordinates
+    // system, as the batch is drawn with an identity matrix
+    for (i = 0; i < pBatch->m_Count; ++i)
+    {
+        // the ranges an instance brought in several vertex buffers share the same box
+        if (i && !memcmp(&pBatch->m_pRange[i].m_Box, &pBatch->m_pRange[i - 1].m_Box, sizeof(CSR_Box)))
+            continue;
+
+        if (csrFrustumIntersectBox(pFrustum, &pBatch->m_pRange[i].m_Box) &&
+            csrSceneOcclusionBufferIsVisible(pContext->m_pOcclusionBuffer, &pBatch->m_pRange[i].m_Box))
+            return 1;
+    }
+
+    return 0;
+}
+//---------------------------------------------------------------------------
+size_t csrSceneItemGetMaxDrawCommands(const CSR_SceneItem* pItem)
+{
+    // each level of detail may require its own command
+    if (pItem->m_pLOD)
+        return pItem->m_pLOD->m_Count + 1;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrSceneDrawCommandInit(const CSR_SceneItem*        pItem,
+                                   void*                 pModel,
+                                   void*                 pShader,
+                                   CSR_SceneDrawCommand* pCommand)
+{
+    pCommand->m_pItem        = pItem;
+    pCommand->m_pModel       = pModel;
+    pCommand->m_pShader      = pShader;
+    pCommand->m_VisibleIndex = 0;
+    pCommand->m_Culled       = 0;
+    pCommand->m_Key          = 0;
+    csrArrayInit(&pCommand->m_VisibleArray);
+    memset(&pCommand->m_Index, 0, sizeof(CSR_SceneItemIndex));
+}
+//---------------------------------------------------------------------------
+size_t csrSceneItemPrepareDraw(const CSR_Scene*            pScene,
+                               const CSR_SceneContext*     pContext,
+                               const CSR_SceneItem*        pItem,
+                               const CSR_Frustum*          pFrustum,
+                               const CSR_Vector3*          pViewPos,
+                                     CSR_SceneDrawList*    pList)
 {
-    void* pShader;
+    size_t                i;
+    size_t                level;
+    size_t                levelCount;
+    size_t                visibleCount;
+    size_t                commandCount;
+    size_t                levelInstances[0xFF];
+    unsigned char*        pLevel;
+    void*                 pShader;
+    void*                 pModel;
+    int                   cull;
+    CSR_Box               box;
+    CSR_Array             visibleArray;
+    const CSR_Array*      pMatrixArray;
+    CSR_SceneLODGroup*    pLOD;
+    CSR_SceneDrawCommand* pCommands;
 
     // validate the inputs
-    if (!pScene || !pContext || !pItem)
-        return;
+    if (!pScene || !pContext || !pItem || !pList)
+        return 0;
 
     pShader = 0;
 
-    // get the shader to use with the model
+    // get the shader to use with the model. NOTE all the levels of detail share the same shader
     if (pContext->m_fOnGetShader)
         pShader = pContext->m_fOnGetShader(pItem->m_pModel, pItem->m_Type);
 
-    // found one?
-    if (!pShader)
+    // the caller reserved enough commands, matrices and levels for the item
+    pCommands    = &pList->m_pCommand[pList->m_Count];
+    pLevel       =  pList->m_pLevel;
+    pMatrixArray =  pItem->m_pMatrixArray;
+    pLOD         =  pItem->m_pLOD;
+    levelCount   = (pLOD && pViewPos) ? pLOD->m_Count + 1 : 1;
+    cull         = (pFrustum && pItem->m_HasBox);
+
+    // an item without matrix is drawn once, with the model matrix the caller set, thus it can
+    // neither be culled nor use a level of detail. Also nothing to select if all the instances
+    // are drawn with the item model
+    if (!pMatrixArray || !pMatrixArray->m_Count || (!cull && levelCount == 1))
+    {
+        // notify the caller about the visible instances
+        if (pContext->m_fOnVisibleSet)
+            pContext->m_fOnVisibleSet(pScene, pContext, pItem, pMatrixArray);
+
+        // no shader to draw the item?
+        if (!pShader)
+            return 0;
+
+        csrSceneDrawCommandInit(pItem, pItem->m_pModel, pShader, &pCommands[0]);
+        return 1;
+    }
+
+    // keep one level state per instance, to apply the hysteresis
+    if (levelCount > 1)
+        csrSceneItemUpdateLODState(pItem);
+
+    memset(levelInstances, 0, levelCount * sizeof(size_t));
+
+    visibleCount = 0;
+
+    // iterate through the item instances
+    for (i = 0; i < pMatrixArray->m_Count; ++i)
+    {
+        const CSR_Matrix4* pMatrix = (const CSR_Matrix4*)pMatrixArray->m_pItem[i].m_pData;
+
+        // is the instance out of the view frustum, or hidden behind an occluder?
+        if (cull)
+        {
+            // put the model box in the world coordinates system
+            csrBoxTransform(&pItem->m_Box, pMatrix, &box);
+
+            if (!csrFrustumIntersectBox(pFrustum, &box) ||
+                !csrSceneOcclusionBufferIsVisible(pContext->m_pOcclusionBuffer, &box) ||
+                (pItem->m_pBatch && pItem->m_pBatch->m_Count > 1 && !csrSceneBatchIsVisible(pContext, pItem->m_pBatch, pFrustum)))
+            {
+                pLevel[i] = 0xFF;
+                continue;
+            }
+        }
+
+        // select the instance level of detail
+        if (levelCount > 1)
+        {
+            level = csrSceneItemSelectLOD(pItem, i, pMatrix, pViewPos);
+
+            // the instances using a level without model are no longer drawn, thus they aren't
+            // visible either
+            if (!csrSceneItemGetLODModel(pItem, level))
+            {
+                pLevel[i] = 0xFF;
+                continue;
+            }
+        }
+        else
+            level = 0;
+
+        pLevel[i] = (unsigned char)level;
+        ++levelInstances[level];
+        ++visibleCount;
+    }
+
+    // notify the caller about the visible instances
+    if (pContext->m_fOnVisibleSet)
+    {
+        // all the instances are visible?
+        if (visibleCount == pMatrixArray->m_Count)
+            pContext->m_fOnVisibleSet(pScene, pContext, pItem, pMatrixArray);
+        else
+        {
+            // list the visible instances in the free matrices, which are overwritten by the
+            // commands below. NOTE the matrices are only linked, not owned
+            visibleArray.m_pItem = &pList->m_pMatrix[pList->m_MatrixCount];
+            visibleArray.m_Count = 0;
+
+            for (i = 0; i < pMatrixArray->m_Count; ++i)
+                if (pLevel[i] != 0xFF)
+                {
+                    visibleArray.m_pItem[visibleArray.m_Count]            = pMatrixArray->m_pItem[i];
+                    visibleArray.m_pItem[visibleArray.m_Count].m_AutoFree = 0;
+                    ++visibleArray.m_Count;
+                }
+
+            pContext->m_fOnVisibleSet(pScene, pContext, pItem, &visibleArray);
+        }
+    }
+
+    commandCount = 0;
+
+    // build one command per level of detail containing visible instances
+    if (pShader)
+        for (level = 0; level < levelCount; ++level)
+        {
+            // no instance to draw with this level?
+            if (!levelInstances[level])
+                continue;
+
+            pModel = csrSceneItemGetLODModel(pItem, level);
+
+            // the instances using a level without model are no longer drawn
+            if (!pModel)
+                continue;
+
+            csrSceneDrawCommandInit(pItem, pModel, pShader, &pCommands[commandCount]);
+
+            // all the instances are drawn with this level? (no need to list them)
+            if (levelInstances[level] == pMatrixArray->m_Count)
+            {
+                ++commandCount;
+                break;
+            }
+
+            // the instances to draw are listed in the draw list matrices, and linked once the
+            // whole list is prepared
+            pCommands[commandCount].m_VisibleIndex = pList->m_MatrixCount;
+            pCommands[commandCount].m_Culled       = 1;
+
+            // list the instances to draw with this level
+            for (i = 0; i < pMatrixArray->m_Count; ++i)
+                if (pLevel[i] == level)
+                {
+                    pList->m_pMatrix[pList->m_MatrixCount]            = pMatrixArray->m_pItem[i];
+                    pList->m_pMatrix[pList->m_MatrixCount].m_AutoFree = 0;
+                    ++pList->m_MatrixCount;
+                }
+
+            pCommands[commandCount].m_VisibleArray.m_Count = levelInstances[level];
+            ++commandCount;
+        }
+
+    return commandCount;
+}
+//---------------------------------------------------------------------------
+void csrSceneItemGetIndex(const CSR_SceneContext*   pContext,
+                          const CSR_SceneItem*      pItem,
+                                CSR_SceneItemIndex* pIndex)
+{
+    // are the indexes frozen, e.g. by a scene snapshot?
+    if (pItem->m_pIndex)
+    {
+        memcpy(pIndex, pItem->m_pIndex, sizeof(CSR_SceneItemIndex));
         return;
+    }
+
+    memset(pIndex, 0, sizeof(CSR_SceneItemIndex));
+
+    // let the caller select the indexes to draw the item with. NOTE the item model is notified,
+    // and the indexes are used for all its levels of detail
+    switch (pItem->m_Type)
+    {
+        case CSR_MT_Model:
+            if (pContext->m_fOnGetModelIndex)
+                pContext->m_fOnGetModelIndex((const CSR_Model*)pItem->m_pModel, &pIndex->m_ModelIndex);
+
+            return;
+
+        case CSR_MT_MDL:
+            if (pContext->m_fOnGetMDLIndex)
+                pContext->m_fOnGetMDLIndex((const CSR_MDL*)pItem->m_pModel,
+                                                          &pIndex->m_SkinIndex,
+                                                          &pIndex->m_ModelIndex,
+                                                          &pIndex->m_MeshIndex);
+
+            return;
+
+        case CSR_MT_X:
+            if (pContext->m_fOnGetXIndex)
+                pContext->m_fOnGetXIndex((const CSR_X*)pItem->m_pModel,
+                                                      &pIndex->m_AnimSetIndex,
+                                                      &pIndex->m_FrameIndex);
 
-    // enable the item shader
-    csrShaderEnable(pShader);
+            return;
 
-    // connect the projection matrix to shader
-    csrShaderConnectProjectionMatrix(pShader, &pScene->m_ProjectionMatrix);
+        default:
+            return;
+    }
+}
+//---------------------------------------------------------------------------
+void csrSceneItemSubmitDraw(const CSR_Scene*            pScene,
+                            const CSR_SceneContext*     pContext,
+                            const CSR_SceneDrawCommand* pCommand)
+{
+    const CSR_SceneItem* pItem        = pCommand->m_pItem;
+          void*          pModel       = pCommand->m_pModel;
+          void*          pShader      = pCommand->m_pShader;
+    const CSR_Array*     pMatrixArray = pCommand->m_Culled ? &pCommand->m_VisibleArray : pItem->m_pMatrixArray;
 
-    // connect the view matrix to shader
-    csrShaderConnectViewMatrix(pShader, &pScene->m_ViewMatrix);
+    // let the caller set the shader uniforms specific to the item
+    if (pContext->m_fOnDrawItem)
+        pContext->m_fOnDrawItem(pScene, pContext, pItem, pShader);
 
     // draw the model
     switch (pItem->m_Type)
     {
         case CSR_MT_Line:
             // draw the line
-            csrDrawLine((const CSR_Line*)pItem->m_pModel, pShader);
+            csrDrawLine((const CSR_Line*)pModel, pShader);
             break;
 
         case CSR_MT_Mesh:
             // draw the mesh
-            csrDrawMesh((const CSR_Mesh*)pItem->m_pModel,
+            csrDrawMesh((const CSR_Mesh*)pModel,
                                          pShader,
-                                         pItem->m_pMatrixArray,
+                                         pMatrixArray,
                                          pContext->m_fOnGetID);
 
             break;
 
         case CSR_MT_Model:
-        {
-            size_t index = 0;
-
-            // notify the caller that the model is about to be drawn
-            if (pContext->m_fOnGetModelIndex)
-                pContext->m_fOnGetModelIndex((const CSR_Model*)pItem->m_pModel, &index);
-
             // draw the model
-            csrDrawModel((const CSR_Model*)pItem->m_pModel,
-                                           index,
+            csrDrawModel((const CSR_Model*)pModel,
+                                           pCommand->m_Index.m_ModelIndex,
                                            pShader,
-                                           pItem->m_pMatrixArray,
+                                           pMatrixArray,
                                            pContext->m_fOnGetID);
 
             break;
-        }
 
         case CSR_MT_MDL:
-        {
-            size_t skinIndex  = 0;
-            size_t modelIndex = 0;
-            size_t meshIndex  = 0;
-
-            // notify the caller that the MDL model is about to be drawn
-            if (pContext->m_fOnGetMDLIndex)
-                pContext->m_fOnGetMDLIndex((const CSR_MDL*)pItem->m_pModel,
-                                                          &skinIndex,
-                                                          &modelIndex,
-                                                          &meshIndex);
-
             // draw the MDL model
-            csrDrawMDL((const CSR_MDL*)pItem->m_pModel,
+            csrDrawMDL((const CSR_MDL*)pModel,
                                        pShader,
-                                       pItem->m_pMatrixArray,
-                                       skinIndex,
-                                       modelIndex,
-                                       meshIndex,
+                                       pMatrixArray,
+                                       pCommand->m_Index.m_SkinIndex,
+                                       pCommand->m_Index.m_ModelIndex,
+                                       pCommand->m_Index.m_MeshIndex,
                                        pContext->m_fOnGetID);
 
             break;
-        }
 
         case CSR_MT_X:
-        {
-            size_t animSetIndex = 0;
-            size_t frameIndex   = 0;
-
-            // notify the caller that the MDL model is about to be drawn
-            if (pContext->m_fOnGetXIndex)
-                pContext->m_fOnGetXIndex((const CSR_X*)pItem->m_pModel, &animSetIndex, &frameIndex);
-
             // draw the X model
-            csrDrawX((const CSR_X*)pItem->m_pModel,
+            csrDrawX((const CSR_X*)pModel,
                                    pShader,
-                                   pItem->m_pMatrixArray,
-                                   animSetIndex,
-                                   frameIndex,
+                                   pMatrixArray,
+                                   pCommand->m_Index.m_AnimSetIndex,
+                                   pCommand->m_Index.m_FrameIndex,
                                    pContext->m_fOnGetID);
 
             break;
-        }
     }
-
-    // disable the item shader
-    csrShaderEnable(0);
 }
 //---------------------------------------------------------------------------
-void csrSceneItemDetectCollision(const CSR_Scene*                   pScene,
-                                 const CSR_SceneItem*               pSceneItem,
-                                 const CSR_CollisionInput*          pCollisionInput,
-                                       CSR_CollisionOutput*         pCollisionOutput,
-                                       CSR_fOnCustomDetectCollision fOnCustomDetectCollision)
+const CSR_Mesh* csrSceneDrawCommandGetFirstMesh(const CSR_SceneDrawCommand* pCommand)
 {
-    size_t      i;
-    CSR_Vector3 rayPos;
-    CSR_Vector3 rayDir;
-    CSR_Vector3 rayDirN;
-    CSR_Sphere  sphere;
-
-    // validate the inputs
-    if (!pScene || !pSceneItem || !pCollisionInput || !pCollisionOutput)
-        return;
-
-    // can detect collision on this model?
-    if (!(pSceneItem->m_CollisionType & CSR_CO_Custom) &&
-         (pSceneItem->m_CollisionType == CSR_CO_None   ||
-         !pSceneItem->m_pMatrixArray                   ||
-         !pSceneItem->m_pMatrixArray->m_Count          ||
-         !pSceneItem->m_AABBTreeCount                  ||
-          pSceneItem->m_AABBTreeIndex >= pSceneItem->m_AABBTreeCount))
-        return;
-
-    // copy the sphere radius
-    sphere.m_Radius = pCollisionInput->m_BoundingSphere.m_Radius;
-
-    // iterate through each model position
-    for (i = 0; i < pSceneItem->m_pMatrixArray->m_Count; ++i)
+    switch (pCommand->m_pItem->m_Type)
     {
-        CSR_Matrix4 invertMatrix;
-        float       determinant;
-
-        // inverse the model matrix
-        csrMat4Inverse(&((CSR_Matrix4*)pSceneItem->m_pMatrixArray->m_pItem->m_pData)[i],
-                       &invertMatrix,
-                       &determinant);
+        case CSR_MT_Mesh:
+            return (const CSR_Mesh*)pCommand->m_pModel;
 
-        // let the caller process custom collisions if required
-        if (fOnCustomDetectCollision && pSceneItem->m_CollisionType & CSR_CO_Custom)
+        case CSR_MT_Model:
         {
-            if (fOnCustomDetectCollision(pScene,
-                                         pSceneItem,
-                                         i,
-                                        &invertMatrix,
-                                         pCollisionInput,
-                                         pCollisionOutput))
-                continue;
+            const CSR_Model* pModel = (const CSR_Model*)pCommand->m_pModel;
 
-            // because not checked above, to prevent that stupid things happen...
-            if (!pSceneItem->m_AABBTreeCount || pSceneItem->m_AABBTreeIndex >= pSceneItem->m_AABBTreeCount)
-                continue;
-        }
+            if (pModel && pModel->m_MeshCount)
+                return &pModel->m_pMesh[0];
 
-        // put the bounding sphere into the model coordinate system (at the location where the
-        // collision should be checked)
-        csrMat4Transform(&invertMatrix, &pCollisionInput->m_CheckPos, &sphere.m_Center);
+            return 0;
+        }
 
-        // do detect the ground collision on this model?
-        if (pSceneItem->m_CollisionType & CSR_CO_Ground)
+        case CSR_MT_MDL:
         {
-            CSR_Polygon3 groundPolygon;
-            float        posY;
-
-            // calculate the y position where to place the point of view
-            if (csrGroundPosY(&sphere,
-                              &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
-                              &pScene->m_GroundDir,
-                              &groundPolygon,
-                              &posY))
-            {
-                CSR_Plane   polygonPlane;
-                CSR_Matrix4 transposedMatrix;
-
-                // notify that a ground collision happened
-                pCollisionOutput->m_Collision |= CSR_CO_Ground;
+            const CSR_MDL* pMDL = (const CSR_MDL*)pCommand->m_pModel;
 
-                // set the new ground position
-                pCollisionOutput->m_GroundPos = posY;
+            if (pMDL && pMDL->m_ModelCount && pMDL->m_pModel[0].m_MeshCount)
+                return &pMDL->m_pModel[0].m_pMesh[0];
 
-                // calculate and set the new ground plane
-                csrPlaneFromPoints(&groundPolygon.m_Vertex[0],
-                                   &groundPolygon.m_Vertex[1],
-                                   &groundPolygon.m_Vertex[2],
-                                   &polygonPlane);
-                csrMat4Transpose(&invertMatrix, &transposedMatrix);
-                csrPlaneTransform(&polygonPlane, &transposedMatrix, &pCollisionOutput->m_GroundPlane);
-            }
+            return 0;
         }
 
-        // do detect the edge collision on this model?
-        if (pSceneItem->m_CollisionType & CSR_CO_Edge)
+        case CSR_MT_X:
         {
-            CSR_Vector3 motionDir;
-            CSR_Vector3 motionDirN;
-            CSR_Ray3    motionRay;
+            const CSR_X* pX = (const CSR_X*)pCommand->m_pModel;
 
-            // calculate the motion ray and put it into the model coordinate system
-            csrVec3Sub(&pCollisionInput->m_CheckPos, &pCollisionInput->m_BoundingSphere.m_Center, &motionDir);
-            csrVec3Normalize(&motionDir, &motionDirN);
-            csrMat4ApplyToVector(&invertMatrix, &pCollisionInput->m_BoundingSphere.m_Center, &rayPos);
-            csrMat4ApplyToNormal(&invertMatrix, &motionDir, &rayDir);
-            csrVec3Normalize(&rayDir, &rayDirN);
-            csrRay3FromPointDir(&rayPos, &rayDirN, &motionRay);
+            if (pX && pX->m_MeshCount)
+                return &pX->m_pMesh[0];
 
-            // 1. detect if the motion ray intersects one of the polygon. If yes the detection is terminated
-            // 2. detect if the sphere intersects one of the polygon
+            return 0;
+        }
 
-            /*
-            CSR_Polygon3Buffer polygonBuffer;
+        default:
+            return 0;
+    }
+}
+//---------------------------------------------------------------------------
+const void* csrSceneDrawCommandGetTextureKey(const CSR_SceneContext*     pContext,
+                                             const CSR_SceneDrawCommand* pCommand)
+{
+    const void*     pKey = 0;
+    const CSR_Mesh* pMesh;
 
-            // check for collision
-            if (csrAABBTreeResolve(&transformedRay,
-                                   &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
-                                    0,
-                                   &polygonBuffer))
-            {
-                // found at least 1 collision
-                pCollisionInfo->m_Collision = 1;
+    // the MDL models read their texture from the skin list, and not from their meshes
+    if (pCommand->m_pItem->m_Type == CSR_MT_MDL)
+    {
+        const CSR_MDL* pMDL = (const CSR_MDL*)pCommand->m_pModel;
 
-                // FIXME calculate the resulting sliding plane
-            }
+        if (pMDL && pMDL->m_SkinCount)
+            pKey = &pMDL->m_pSkin[0].m_Texture;
+    }
+    else
+    {
+        pMesh = csrSceneDrawCommandGetFirstMesh(pCommand);
 
-            // delete found polygons (no longer needed from now)
-            if (polygonBuffer.m_Count)
-                free(polygonBuffer.m_pPolygon);
-            */
-        }
+        if (pMesh)
+            pKey = &pMesh->m_Skin.m_Texture;
+    }
 
-        // do detect the mouse collision on this model?
-        if (pSceneItem->m_CollisionType & CSR_CO_Mouse)
-        {
-            CSR_Ray3      mouseRay;
-            CSR_HitModel* pHitModel;
+    if (!pKey)
+        return 0;
 
-            // put the mouse ray into the model coordinate system
-            csrMat4ApplyToVector(&invertMatrix, &pCollisionInput->m_MouseRay.m_Pos, &rayPos);
-            csrMat4ApplyToNormal(&invertMatrix, &pCollisionInput->m_MouseRay.m_Dir, &rayDir);
-            csrVec3Normalize(&rayDir, &rayDirN);
-            csrRay3FromPointDir(&rayPos, &rayDirN, &mouseRay);
+    // several models may share the same texture, in this case the renderer identifier is the same
+    if (pContext->m_fOnGetID)
+        return pContext->m_fOnGetID(pKey);
 
-            // create a new hit model container, if required
-            if (!pCollisionOutput->m_pHitModel)
-                pCollisionOutput->m_pHitModel = csrArrayCreate();
+    return pKey;
+}
+//---------------------------------------------------------------------------
+unsigned csrSceneDrawCommandGetStateKey(const CSR_SceneDrawCommand* pCommand)
+{
+    const CSR_Mesh* pMesh = csrSceneDrawCommandGetFirstMesh(pCommand);
 
-            // create a new hit model
-            pHitModel = csrHitModelCreate();
+    if (!pMesh || !pMesh->m_Count)
+        return 0;
 
-            // succeeded?
-            if (!pHitModel)
-                continue;
+    // the states are read from the first vertex buffer, which is representative of the whole model
+    // in the most cases
+    return ((unsigned)pMesh->m_pVB[0].m_Culling.m_Type     & 0x3)        |
+           (((unsigned)pMesh->m_pVB[0].m_Culling.m_Face    & 0x1)  << 2) |
+           ((pMesh->m_pVB[0].m_Material.m_Wireframe ? 1u : 0u) << 3);
+}
+//---------------------------------------------------------------------------
+int csrSceneRankTableReset(CSR_SceneRankTable* pTable, size_t count)
+{
+    size_t size = 16;
 
-            // using the mouse ray, resolve aligned-axis bounding box tree
-            csrAABBTreeResolve(&mouseRay,
-                               &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
-                                0,
-                               &pHitModel->m_Polygons);
+    // keep the table at most half full, thus a free slot is always found quickly
+    while (size < count * 2)
+        size <<= 1;
 
-            // found a collision with the mouse ray?
-            if (pHitModel->m_Polygons.m_Count)
-            {
-                // notify that a mouse collision happened
-                pCollisionOutput->m_Collision |= CSR_CO_Mouse;
+    // grow the table if required
+    if (size > pTable->m_Size)
+    {
+        free((void*)pTable->m_pKey);
+        free(pTable->m_pRank);
 
-                // populate the hit model structure
-                pHitModel->m_pModel    = pSceneItem->m_pModel;
-                pHitModel->m_Type      = pSceneItem->m_Type;
-                pHitModel->m_Matrix    = ((CSR_Matrix4*)pSceneItem->m_pMatrixArray->m_pItem->m_pData)[i];
-                pHitModel->m_pAABBTree = &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex];
+        pTable->m_pKey  = (const void**)malloc(size * sizeof(void*));
+        pTable->m_pRank = (unsigned*)   malloc(size * sizeof(unsigned));
+        pTable->m_Size  = size;
 
-                // add the hit model structure in the array
-                csrArrayAdd(pHitModel, pCollisionOutput->m_pHitModel, 0);
-            }
-            else
-            {
-                // no found collision, release the hit model
-                csrHitModelRelease(pHitModel);
-            }
+        // succeeded?
+        if (!pTable->m_pKey || !pTable->m_pRank)
+        {
+            free((void*)pTable->m_pKey);
+            free(pTable->m_pRank);
+
+            pTable->m_pKey  = 0;
+            pTable->m_pRank = 0;
+            pTable->m_Size  = 0;
+            pTable->m_Count = 0;
+            return 0;
         }
     }
+
+    // empty the slots
+    memset(pTable->m_pRank, 0, pTable->m_Size * sizeof(unsigned));
+    pTable->m_Count = 0;
+
+    return 1;
 }
 //---------------------------------------------------------------------------
-// Scene functions
+void csrSceneRankTableRelease(CSR_SceneRankTable* pTable)
+{
+    free((void*)pTable->m_pKey);
+    free(pTable->m_pRank);
+
+    pTable->m_pKey  = 0;
+    pTable->m_pRank = 0;
+    pTable->m_Size  = 0;
+    pTable->m_Count = 0;
+}
 //---------------------------------------------------------------------------
-CSR_Scene* csrSceneCreate(void)
+unsigned csrSceneRankTableGet(CSR_SceneRankTable* pTable, const void* pKey, unsigned maxRank)
 {
-    // create a new scene
-    CSR_Scene* pScene = (CSR_Scene*)malloc(sizeof(CSR_Scene));
+    size_t index;
+    size_t hash;
+
+    // no table? (all the keys share the same rank in this case)
+    if (!pTable->m_Size)
+        return maxRank;
+
+    // mix the key bits, the lowest ones are always 0 because of the alignment
+    hash  = (size_t)pKey;
+    hash ^= hash >> 16;
+    hash *= 0x45D9F3B;
+    hash ^= hash >> 16;
+    index = hash & (pTable->m_Size - 1);
+
+    // search for an already ranked key
+    while (pTable->m_pRank[index])
+    {
+        if (pTable->m_pKey[index] == pKey)
+            return pTable->m_pRank[index] - 1;
 
-    // succeeded?
-    if (!pScene)
-        return 0;
+        index = (index + 1) & (pTable->m_Size - 1);
+    }
 
-    // initialize the scene content
-    csrSceneInit(pScene);
+    // the rank field is saturated, no need to remember more keys
+    if (pTable->m_Count > maxRank)
+        return maxRank;
 
-    return pScene;
+    // add the key to the table
+    pTable->m_pKey[index]  = pKey;
+    pTable->m_pRank[index] = (unsigned)pTable->m_Count + 1;
+
+    return (unsigned)pTable->m_Count++;
 }
 //---------------------------------------------------------------------------
-void csrSceneRelease(CSR_Scene* pScene, const CSR_fOnDeleteTexture fOnDeleteTexture)
+int csrSceneDrawListReserve(CSR_SceneDrawList* pList,
+                            size_t             commandCount,
+                            size_t             matrixCount,
+                            size_t             levelCount)
 {
-    size_t i;
+    size_t                size;
+    CSR_SceneDrawCommand* pCommand;
+    CSR_ArrayItem*        pMatrix;
+    unsigned char*        pLevel;
 
-    // no scene to release?
-    if (!pScene)
-        return;
+    // grow the commands, by doubling their size to allocate rarely
+    if (pList->m_Count + commandCount > pList->m_Size)
+    {
+        size = pList->m_Size ? pList->m_Size * 2 : 16;
 
-    // do free the skybox?
-    if (pScene->m_pSkybox)
-        csrMeshRelease(pScene->m_pSkybox, fOnDeleteTexture);
+        if (size < pList->m_Count + commandCount)
+            size = pList->m_Count + commandCount;
 
-    // do free the normal items content?
-    if (pScene->m_pItem)
+        pCommand = (CSR_SceneDrawCommand*)csrMemoryAlloc(pList->m_pCommand, sizeof(CSR_SceneDrawCommand), size);
+
+        // succeeded?
+        if (!pCommand)
+            return 0;
+
+        pList->m_pCommand = pCommand;
+        pList->m_Size     = size;
+    }
+
+    // grow the matrices. NOTE the commands linking them are linked again once the list is prepared
+    if (pList->m_MatrixCount + matrixCount > pList->m_MatrixSize)
     {
-        // iterate through each scene item to release, and release each of them
-        for (i = 0; i < pScene->m_ItemCount; ++i)
-            csrSceneItemContentRelease(&pScene->m_pItem[i], fOnDeleteTexture);
+        size = pList->m_MatrixSize ? pList->m_MatrixSize * 2 : 64;
 
-        // free the scene items
-        free(pScene->m_pItem);
+        if (size < pList->m_MatrixCount + matrixCount)
+            size = pList->m_MatrixCount + matrixCount;
+
+        pMatrix = (CSR_ArrayItem*)csrMemoryAlloc(pList->m_pMatrix, sizeof(CSR_ArrayItem), size);
+
+        // succeeded?
+        if (!pMatrix)
+            return 0;
+
+        pList->m_pMatrix    = pMatrix;
+        pList->m_MatrixSize = size;
     }
 
-    // do free the transparent items content?
-    if (pScene->m_pTransparentItem)
+    // grow the levels
+    if (levelCount > pList->m_LevelSize)
     {
-        // iterate through each scene transparent item to release, and release each of them
-        for (i = 0; i < pScene->m_TransparentItemCount; ++i)
-            csrSceneItemContentRelease(&pScene->m_pTransparentItem[i], fOnDeleteTexture);
+        pLevel = (unsigned char*)csrMemoryAlloc(pList->m_pLevel, sizeof(unsigned char), levelCount);
 
-        // free the scene transparent items
-        free(pScene->m_pTransparentItem);
+        // succeeded?
+        if (!pLevel)
+            return 0;
+
+        pList->m_pLevel    = pLevel;
+        pList->m_LevelSize = levelCount;
     }
 
-    // free the scene
-    free(pScene);
+    return 1;
 }
 //---------------------------------------------------------------------------
-void csrSceneInit(CSR_Scene* pScene)
+void csrSceneDrawListLink(CSR_SceneDrawList* pList)
 {
-    // no scene to initialize?
-    if (!pScene)
-        return;
+    size_t i;
 
-    // initialize the scene
-    pScene->m_Color.m_R            =  0.0f;
-    pScene->m_Color.m_G            =  0.0f;
-    pScene->m_Color.m_B            =  0.0f;
-    pScene->m_Color.m_A            =  1.0f;
-    pScene->m_GroundDir.m_X        =  0.0f;
-    pScene->m_GroundDir.m_Y        = -1.0f;
-    pScene->m_GroundDir.m_Z        =  0.0f;
-    pScene->m_pSkybox              =  0;
-    pScene->m_pItem                =  0;
-    pScene->m_ItemCount            =  0;
-    pScene->m_pTransparentItem     =  0;
-    pScene->m_TransparentItemCount =  0;
+    // link the culled commands to their visible instance matrices
+    for (i = 0; i < pList->m_Count; ++i)
+        if (pList->m_pCommand[i].m_Culled)
+            pList->m_pCommand[i].m_VisibleArray.m_pItem = &pList->m_pMatrix[pList->m_pCommand[i].m_VisibleIndex];
+}
+//---------------------------------------------------------------------------
+void csrSceneDrawListGetIndexes(const CSR_SceneContext* pContext, CSR_SceneDrawList* pList, size_t first)
+{
+    size_t i;
 
-    // set the default item matrix to identity
-    csrMat4Identity(&pScene->m_ViewMatrix);
+    // get the indexes of each item once, and share them with the commands drawing its levels of
+    // detail. NOTE the commands of an item are contiguous until the list is sorted
+    for (i = first; i < pList->m_Count; ++i)
+        if (i > first && pList->m_pCommand[i].m_pItem == pList->m_pCommand[i - 1].m_pItem)
+            pList->m_pCommand[i].m_Index = pList->m_pCommand[i - 1].m_Index;
+        else
+            csrSceneItemGetIndex(pContext, pList->m_pCommand[i].m_pItem, &pList->m_pCommand[i].m_Index);
 }
 //---------------------------------------------------------------------------
-CSR_SceneItem* csrSceneAddLine(CSR_Scene* pScene, CSR_Line* pLine, int transparent)
+int csrSceneDrawListAddItems(const CSR_Scene*         pScene,
+                             const CSR_SceneContext*  pContext,
+                             const CSR_SceneItem*     pItems,
+                                   size_t             count,
+                             const CSR_Frustum*       pFrustum,
+                                   CSR_SceneDrawList* pList)
 {
-    CSR_SceneItem* pItem;
-    int            index;
+    size_t      i;
+    size_t      commandCount;
+    size_t      matrixCount;
+    size_t      levelCount;
+    CSR_Vector3 viewPos;
 
     // validate the inputs
-    if (!pScene || !pLine)
+    if (!pScene || !pContext || !pList)
         return 0;
 
-    // search for a scene item which already contains the same line
-    pItem = csrSceneGetItem(pScene, pLine);
+    // nothing to add?
+    if (!pItems || !count)
+        return 1;
 
-    // found one?
-    if (pItem)
-        return pItem;
+    commandCount = 0;
+    matrixCount  = 0;
+    levelCount   = 0;
 
-    // do add a transparent line?
-    if (transparent)
+    // count the commands the items may require, and the instance matrices they may list. NOTE each
+    // instance is drawn at most once, thus it's listed at most once
+    for (i = 0; i < count; ++i)
     {
-        // add a new item to the transparent items
-        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pTransparentItem,
-                                               sizeof(CSR_SceneItem),
-                                               pScene->m_TransparentItemCount + 1);
+        commandCount += csrSceneItemGetMaxDrawCommands(&pItems[i]);
 
-        // succeeded?
-        if (!pItem)
-            return 0;
+        if (!pItems[i].m_pMatrixArray)
+            continue;
 
-        // get the item index to update
-        index = (int)pScene->m_TransparentItemCount;
+        matrixCount += pItems[i].m_pMatrixArray->m_Count;
+
+        if (pItems[i].m_pMatrixArray->m_Count > levelCount)
+            levelCount = pItems[i].m_pMatrixArray->m_Count;
     }
-    else
-    {
-        // add a new item to the scene items
-        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pItem,
-                                               sizeof(CSR_SceneItem),
-                                               pScene->m_ItemCount + 1);
 
-        // succeeded?
-        if (!pItem)
-            return 0;
+    // reserve enough memory for all the items, thus nothing is allocated while they are prepared
+    if (!csrSceneDrawListReserve(pList, commandCount, matrixCount, levelCount))
+        return 0;
 
-        // get the scene item index to update
-        index = (int)pScene->m_ItemCount;
-    }
+    // get the camera position, used to select the levels of detail
+    csrSceneGetViewPosition(pScene, &viewPos);
 
-    // initialize the newly created item with the default values
-    csrSceneItemInit(&pItem[index]);
+    // prepare the items, and keep those which are visible
+    for (i = 0; i < count; ++i)
+        pList->m_Count += csrSceneItemPrepareDraw(pScene, pContext, &pItems[i], pFrustum, &viewPos, pList);
 
-    // configure the item
-    pItem[index].m_pModel = pLine;
-    pItem[index].m_Type   = CSR_MT_Line;
+    // link the commands to their visible instances
+    csrSceneDrawListLink(pList);
 
-    // do add a transparent item?
-    if (transparent)
-    {
-        // add item to the transparent item list
-        pScene->m_pTransparentItem = pItem;
-        ++pScene->m_TransparentItemCount;
-    }
-    else
-    {
-        // add item to the normal item list
-        pScene->m_pItem = pItem;
-        ++pScene->m_ItemCount;
-    }
+    return 1;
+}
+unsigned csrSceneDepthToKey(float depth)
+{
+    unsigned key;
 
-    return &pItem[index];
+    // convert the float bits to an unsigned value keeping the same order, i.e. flip all the bits
+    // of the negative values, and only the sign bit of the positive ones
+    memcpy(&key, &depth, sizeof(unsigned));
+
+    if (key & 0x80000000)
+        return ~key;
+
+    return key | 0x80000000;
 }
 //---------------------------------------------------------------------------
-CSR_SceneItem* csrSceneAddMesh(CSR_Scene* pScene, CSR_Mesh* pMesh, int transparent, int aabb)
+float csrSceneInstanceGetDepth(const CSR_Matrix4* pViewMatrix, const CSR_SceneInstance* pInstance)
 {
-    CSR_SceneItem* pItem;
-    int            index;
+    CSR_Vector3 worldPos;
+    CSR_Vector3 viewPos;
 
-    // validate the inputs
-    if (!pScene || !pMesh)
-        return 0;
+    // get the instance position in the world coordinates system
+    csrSceneItemGetCenter(pInstance->m_pItem, (const CSR_Matrix4*)pInstance->m_Matrix.m_pData, &worldPos);
 
-    // search for a scene item which already contains the same mesh
-    pItem = csrSceneGetItem(pScene, pMesh);
+    // put the position in the view coordinates system
+    csrMat4ApplyToVector(pViewMatrix, &worldPos, &viewPos);
 
-    // found one?
-    if (pItem)
-        return pItem;
+    // the view looks toward the negative z axis, thus the farthest instances have the lowest depth
+    return viewPos.m_Z;
+}
+//---------------------------------------------------------------------------
+int csrSceneDepthListSort(CSR_SortItem* pOrder, size_t count)
+{
+    size_t       i;
+    size_t       j;
+    size_t       moves;
+    CSR_SortItem item;
 
-    // do add a transparent item?
-    if (transparent)
+    moves = 0;
+
+    // the order is generally almost the same as in the previous frame, in this case an insertion
+    // sort is the fastest way to restore it
+    for (i = 1; i < count; ++i)
     {
-        // add a new item to the transparent items
-        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pTransparentItem,
-                                               sizeof(CSR_SceneItem),
-                                               pScene->m_TransparentItemCount + 1);
+        // already in order?
+        if (pOrder[i - 1].m_Key <= pOrder[i].m_Key)
+            continue;
 
-        // succeeded?
-        if (!pItem)
-            return 0;
+        item = pOrder[i];
+        j    = i;
 
-        // get the item index to update
-        index = (int)pScene->m_TransparentItemCount;
-    }
-    else
-    {
-        // add a new item to the scene items
-        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pItem,
-                                               sizeof(CSR_SceneItem),
-                                               pScene->m_ItemCount + 1);
+        // move the item back to its location
+        do
+        {
+            pOrder[j] = pOrder[j - 1];
+            --j;
+            ++moves;
+        }
+        while (j && pOrder[j - 1].m_Key > item.m_Key && moves <= count);
 
-        // succeeded?
-        if (!pItem)
-            return 0;
+        pOrder[j] = item;
 
-        // get the scene item index to update
-        index = (int)pScene->m_ItemCount;
+        // too many items moved since the previous frame, a full sort will be faster
+        if (moves > count)
+            return csrRadixSort(pOrder, count);
     }
 
-    // initialize the newly created item with the default values
-    csrSceneItemInit(&pItem[index]);
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrSceneGetFrustum(const CSR_Scene* pScene, CSR_Frustum* pFrustum)
+{
+    CSR_Matrix4 viewProjMatrix;
 
-    // configure the item
-    pItem[index].m_pModel = pMesh;
-    pItem[index].m_Type   = CSR_MT_Mesh;
+    // the frustum planes are extracted from the view matrix combined with the projection matrix,
+    // thus they are expressed in the world coordinates system
+    csrMat4Multiply(&pScene->m_ViewMatrix, &pScene->m_ProjectionMatrix, &viewProjMatrix);
+    csrFrustumFromMatrix(&viewProjMatrix, pFrustum);
+}
+//---------------------------------------------------------------------------
+void csrSceneDrawJobExecute(void* pJob)
+{
+    CSR_SceneDrawJob* pDrawJob = (CSR_SceneDrawJob*)pJob;
 
-    // generate the aligned-axis bounding box tree for this mesh
-    if (aabb)
-    {
-        pItem[index].m_AABBTreeCount = 1;
-        pItem[index].m_pAABBTree     = csrAABBTreeFromMesh(pMesh);
+    // no job to execute?
+    if (!pDrawJob)
+        return;
 
-        // succeeded?
-        if (!pItem[index].m_pAABBTree)
-        {
-            // realloc to the previous size, thus the latest added item will be freed
-            if (transparent)
-                pScene->m_pTransparentItem =
-                        (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                       sizeof(CSR_SceneItem),
-                                                       pScene->m_TransparentItemCount);
-            else
-                pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                                 sizeof(CSR_SceneItem),
-                                                                 pScene->m_ItemCount);
+    // prepare the job items in its own list. NOTE each item belongs to only one job, thus the
+    // per-item states, e.g. the level of detail ones, are never shared between threads. The item
+    // indexes are get later, from the thread drawing the scene
+    pDrawJob->m_Success = csrSceneDrawListAddItems(pDrawJob->m_pScene,
+                                                   pDrawJob->m_pContext,
+                                                   pDrawJob->m_pItems,
+                                                   pDrawJob->m_Count,
+                                                   pDrawJob->m_pFrustum,
+                                                  &pDrawJob->m_List);
+}
+//---------------------------------------------------------------------------
+int csrSceneOcclusionProject(const CSR_Matrix4*     pMatrix,
+                             const CSR_Vector3*     pVertex,
+                             const CSR_DepthBuffer* pDB,
+                                   CSR_Vector3*     pR)
+{
+    float x;
+    float y;
+    float z;
+    float w;
+
+    // transform the vertex in the clip space
+    x = (pVertex->m_X * pMatrix->m_Table[0][0]) + (pVertex->m_Y * pMatrix->m_Table[1][0]) +
+        (pVertex->m_Z * pMatrix->m_Table[2][0]) +  pMatrix->m_Table[3][0];
+    y = (pVertex->m_X * pMatrix->m_Table[0][1]) + (pVertex->m_Y * pMatrix->m_Table[1][1]) +
+        (pVertex->m_Z * pMatrix->m_Table[2][1]) +  pMatrix->m_Table[3][1];
+    z = (pVertex->m_X * pMatrix->m_Table[0][2]) + (pVertex->m_Y * pMatrix->m_Table[1][2]) +
+        (pVertex->m_Z * pMatrix->m_Table[2][2]) +  pMatrix->m_Table[3][2];
+    w = (pVertex->m_X * pMatrix->m_Table[0][3]) + (pVertex->m_Y * pMatrix->m_Table[1][3]) +
+        (pVertex->m_Z * pMatrix->m_Table[2][3]) +  pMatrix->m_Table[3][3];
+
+    // the vertex is behind the near plane, thus its projection is meaningless
+    if (w < M_CSR_Epsilon || z < -w)
+        return 0;
 
+    // convert to raster space. NOTE in raster space y is down, so the direction is inverted
+    pR->m_X = ((x / w) + 1.0f) * 0.5f * (float)pDB->m_Width;
+    pR->m_Y = (1.0f - (y / w)) * 0.5f * (float)pDB->m_Height;
+    pR->m_Z =   z / w;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneOcclusionRasterizePolygon(const CSR_Polygon3*    pPolygon,
+                                      const CSR_Matrix4*     pMatrix,
+                                            CSR_DepthBuffer* pDB)
+{
+    size_t      i;
+    int         x;
+    int         y;
+    int         xMin;
+    int         yMin;
+    int         xMax;
+    int         yMax;
+    float       area;
+    float       sign;
+    float       dzdx;
+    float       dzdy;
+    float       zOffset;
+    float       zMax;
+    float       z;
+    float       bound[4];
+    float       edge[3][3];
+    CSR_Vector3 v[3];
+
+    // project the polygon. NOTE a polygon crossing the near plane is ignored, it hides nothing
+    for (i = 0; i < 3; ++i)
+        if (!csrSceneOcclusionProject(pMatrix, &pPolygon->m_Vertex[i], pDB, &v[i]))
             return 0;
-        }
-    }
 
-    // do add a transparent item?
-    if (transparent)
-    {
-        // add item to the transparent item list
-        pScene->m_pTransparentItem = pItem;
-        ++pScene->m_TransparentItemCount;
-    }
-    else
+    // calculate the polygon area, its sign depends on the vertex winding
+    area = ((v[1].m_X - v[0].m_X) * (v[2].m_Y - v[0].m_Y)) -
+           ((v[1].m_Y - v[0].m_Y) * (v[2].m_X - v[0].m_X));
+
+    // degenerated polygon?
+    if (fabs(area) < M_CSR_Epsilon)
+        return 0;
+
+    sign = (area > 0.0f) ? 1.0f : -1.0f;
+
+    // calculate the edge equations, in such a way the polygon inside is always positive
+    for (i = 0; i < 3; ++i)
     {
-        // add item to the normal item list
-        pScene->m_pItem = pItem;
-        ++pScene->m_ItemCount;
+        const CSR_Vector3* pA = &v[i];
+        const CSR_Vector3* pB = &v[(i + 1) % 3];
+
+        edge[i][0] = -(pB->m_Y - pA->m_Y) * sign;
+        edge[i][1] =  (pB->m_X - pA->m_X) * sign;
+        edge[i][2] = -(edge[i][0] * pA->m_X) - (edge[i][1] * pA->m_Y);
     }
 
-    return &pItem[index];
+    // calculate the depth gradients, and the farthest depth the polygon may reach in a texel
+    dzdx    = (((v[1].m_Z - v[0].m_Z) * (v[2].m_Y - v[0].m_Y)) -
+               ((v[2].m_Z - v[0].m_Z) * (v[1].m_Y - v[0].m_Y))) / area;
+    dzdy    = (((v[2].m_Z - v[0].m_Z) * (v[1].m_X - v[0].m_X)) -
+               ((v[1].m_Z - v[0].m_Z) * (v[2].m_X - v[0].m_X))) / area;
+    zOffset = (fabs(dzdx) + fabs(dzdy)) * 0.5f;
+    csrRasterFindMax(v[0].m_Z, v[1].m_Z, v[2].m_Z, &zMax);
+
+    // get the polygon bounding rect, clamped to the buffer
+    csrRasterFindMin(v[0].m_X, v[1].m_X, v[2].m_X, &bound[0]);
+    csrRasterFindMin(v[0].m_Y, v[1].m_Y, v[2].m_Y, &bound[1]);
+    csrRasterFindMax(v[0].m_X, v[1].m_X, v[2].m_X, &bound[2]);
+    csrRasterFindMax(v[0].m_Y, v[1].m_Y, v[2].m_Y, &bound[3]);
+
+    xMin = (int)floor(bound[0]);
+    yMin = (int)floor(bound[1]);
+    xMax = (int)floor(bound[2]);
+    yMax = (int)floor(bound[3]);
+
+    if (xMin < 0)
+        xMin = 0;
+
+    if (yMin < 0)
+        yMin = 0;
+
+    if (xMax > (int)pDB->m_Width - 1)
+        xMax = (int)pDB->m_Width - 1;
+
+    if (yMax > (int)pDB->m_Height - 1)
+        yMax = (int)pDB->m_Height - 1;
+
+    // write the texels whose center is covered by the polygon. NOTE the shared edges are written
+    // by both their polygons, thus a mesh leaves no crack between them
+    for (y = yMin; y <= yMax; ++y)
+        for (x = xMin; x <= xMax; ++x)
+        {
+            const float cx = (float)x + 0.5f;
+            const float cy = (float)y + 0.5f;
+
+            // is the texel center inside the polygon?
+            if ((edge[0][0] * cx) + (edge[0][1] * cy) + edge[0][2] < 0.0f ||
+                (edge[1][0] * cx) + (edge[1][1] * cy) + edge[1][2] < 0.0f ||
+                (edge[2][0] * cx) + (edge[2][1] * cy) + edge[2][2] < 0.0f)
+                continue;
+
+            // get the farthest depth inside the texel
+            z = v[0].m_Z + (dzdx * (cx - v[0].m_X)) + (dzdy * (cy - v[0].m_Y)) + zOffset;
+
+            if (z > zMax)
+                z = zMax;
+
+            // keep the nearest occluder
+            if (z < pDB->m_pData[(y * pDB->m_Width) + x])
+                pDB->m_pData[(y * pDB->m_Width) + x] = z;
+        }
+
+    return 1;
 }
 //---------------------------------------------------------------------------
-CSR_SceneItem* csrSceneAddModel(CSR_Scene* pScene, CSR_Model* pModel, int transparent, int aabb)
+CSR_Mesh* csrSceneItemGetStaticMesh(const CSR_SceneItem* pItem)
 {
-    CSR_SceneItem* pItem;
-    int            index;
-
-    // validate the inputs
-    if (!pScene || !pModel)
+    CSR_Model* pModel;
+
+    // the item should be static, and its instances fully described by their matrices and box
+    if (!pItem->m_Static                 ||
+        !pItem->m_pModel                 ||
+        !pItem->m_HasBox                 ||
+         pItem->m_pLOD                   ||
+         pItem->m_pBatch                 ||
+        !pItem->m_pMatrixArray           ||
+        !pItem->m_pMatrixArray->m_Count  ||
+        (pItem->m_CollisionType & CSR_CO_Custom))
         return 0;
 
-    // search for a scene item which already contains the same model
-    pItem = csrSceneGetItem(pScene, pModel);
+    switch (pItem->m_Type)
+    {
+        case CSR_MT_Mesh:
+            return (CSR_Mesh*)pItem->m_pModel;
 
-    // found one?
-    if (pItem)
-        return pItem;
+        case CSR_MT_Model:
+            pModel = (CSR_Model*)pItem->m_pModel;
 
-    // do add a transparent item?
-    if (transparent)
-    {
-        // add a new item to the transparent items
-        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pTransparentItem,
-                                               sizeof(CSR_SceneItem),
-                                               pScene->m_TransparentItemCount + 1);
+            // a model containing several meshes is animated, each mesh being a frame
+            if (pModel->m_MeshCount != 1)
+                return 0;
 
-        // succeeded?
-        if (!pItem)
-            return 0;
+            return pModel->m_pMesh;
 
-        // get the item index to update
-        index = (int)pScene->m_TransparentItemCount;
+        default:
+            return 0;
     }
-    else
-    {
-        // add a new item to the scene items
-        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pItem,
-                                               sizeof(CSR_SceneItem),
-                                               pScene->m_ItemCount + 1);
+}
+//---------------------------------------------------------------------------
+int csrSceneBatchSkinMatch(const CSR_SceneContext* pContext, const CSR_Mesh* pMesh1, const CSR_Mesh* pMesh2)
+{
+    // same mesh?
+    if (pMesh1 == pMesh2)
+        return 1;
 
-        // succeeded?
-        if (!pItem)
-            return 0;
+    // without identifiers, the textures of two meshes cannot be compared
+    if (!pContext->m_fOnGetID)
+        return 0;
 
-        // get the scene item index to update
-        index = (int)pScene->m_ItemCount;
+    return (pContext->m_fOnGetID(&pMesh1->m_Skin.m_Texture) == pContext->m_fOnGetID(&pMesh2->m_Skin.m_Texture) &&
+            pContext->m_fOnGetID(&pMesh1->m_Skin.m_BumpMap) == pContext->m_fOnGetID(&pMesh2->m_Skin.m_BumpMap) &&
+            pContext->m_fOnGetID(&pMesh1->m_Skin.m_CubeMap) == pContext->m_fOnGetID(&pMesh2->m_Skin.m_CubeMap));
+}
+//---------------------------------------------------------------------------
+void csrSceneBatchGetCell(const CSR_Box* pBox, float cellSize, long* pCell)
+{
+    // no grid, all the instances are located in the same cell
+    if (cellSize <= 0.0f)
+    {
+        pCell[0] = 0;
+        pCell[1] = 0;
+        pCell[2] = 0;
+        return;
     }
 
-    // initialize the newly created item with the default values
-    csrSceneItemInit(&pItem[index]);
+    // the instance belongs to the cell containing its center
+    pCell[0] = (long)floor(((pBox->m_Min.m_X + pBox->m_Max.m_X) * 0.5f) / cellSize);
+    pCell[1] = (long)floor(((pBox->m_Min.m_Y + pBox->m_Max.m_Y) * 0.5f) / cellSize);
+    pCell[2] = (long)floor(((pBox->m_Min.m_Z + pBox->m_Max.m_Z) * 0.5f) / cellSize);
+}
+//---------------------------------------------------------------------------
+size_t csrSceneBatchGetCapacity(size_t count)
+{
+    size_t capacity = 16;
 
-    // configure the item
-    pItem[index].m_pModel = pModel;
-    pItem[index].m_Type   = CSR_MT_Model;
+    // the batch arrays are grown to the next power of 2, thus merging many instances doesn't
+    // reallocate them each time. NOTE they are shrunk to their real size once the batches are built
+    while (capacity < count)
+        capacity <<= 1;
 
-    // generate the aligned-axis bounding box tree for this model
-    if (aabb)
+    return capacity;
+}
+//---------------------------------------------------------------------------
+int csrSceneBatchAddInstance(const CSR_Mesh*      pSource,
+                             const CSR_Matrix4*   pMatrix,
+                             const CSR_Box*       pBox,
+                                   CSR_SceneItem* pBatchItem)
+{
+    size_t                    i;
+    size_t                    j;
+    size_t                    k;
+    size_t                    index;
+    size_t                    vbIndex;
+    size_t                    polygonCount;
+    size_t                    offset;
+    size_t                    dataCount;
+    float                     determinant;
+    float*                    pData;
+    CSR_Matrix4               invMatrix;
+    CSR_Matrix4               normalMatrix;
+    CSR_Vector3               vertex;
+    CSR_Vector3               transformed;
+    CSR_VertexBuffer*         pVB;
+    CSR_SceneBatchRange*      pRange;
+    CSR_IndexedPolygonBuffer* pIPB;
+    CSR_Mesh*                 pMesh  = (CSR_Mesh*)pBatchItem->m_pModel;
+    CSR_SceneBatch*           pBatch = pBatchItem->m_pBatch;
+
+    // get the source polygons, whatever their vertex buffer type is
+    pIPB = csrIndexedPolygonBufferFromMesh(pSource);
+
+    // succeeded?
+    if (!pIPB)
+        return 0;
+
+    // the normals are transformed by the inverted transposed matrix, thus they remain perpendicular
+    // to their surface even if the instance is scaled non-uniformly
+    csrMat4Inverse(pMatrix, &invMatrix, &determinant);
+    csrMat4Transpose(&invMatrix, &normalMatrix);
+
+    // iterate through the source vertex buffers
+    for (i = 0; i < pSource->m_Count; ++i)
     {
-        size_t i;
+        const CSR_VertexBuffer* pSourceVB = &pSource->m_pVB[i];
+        const size_t            stride    =  pSourceVB->m_Format.m_Stride;
 
-        // reserve memory for all the AABB trees to create
-        pItem[index].m_AABBTreeCount = pModel->m_MeshCount;
-        pItem[index].m_pAABBTree     = (CSR_AABBNode*)csrMemoryAlloc(0,
-                                                                     sizeof(CSR_AABBNode),
-                                                                     pItem[index].m_AABBTreeCount);
+        polygonCount = 0;
 
-        // succeeded?
-        if (!pItem[index].m_pAABBTree)
-        {
-            // realloc to the previous size, thus the latest added item will be freed
-            if (transparent)
-                pScene->m_pTransparentItem =
-                        (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                       sizeof(CSR_SceneItem),
-                                                       pScene->m_TransparentItemCount);
-            else
-                pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                                 sizeof(CSR_SceneItem),
-                                                                 pScene->m_ItemCount);
+        // count the vertex buffer polygons
+        for (j = 0; j < pIPB->m_Count; ++j)
+            if (pIPB->m_pIndexedPolygon[j].m_pVB == pSourceVB)
+                ++polygonCount;
 
-            return 0;
+        // nothing to merge?
+        if (!polygonCount || !stride)
+            continue;
+
+        // search for a batch vertex buffer sharing the same format, culling and material
+        for (vbIndex = 0; vbIndex < pMesh->m_Count; ++vbIndex)
+        {
+            pVB = &pMesh->m_pVB[vbIndex];
+
+            if (pVB->m_Format.m_HasNormal         == pSourceVB->m_Format.m_HasNormal         &&
+                pVB->m_Format.m_HasTexCoords      == pSourceVB->m_Format.m_HasTexCoords      &&
+                pVB->m_Format.m_HasPerVertexColor == pSourceVB->m_Format.m_HasPerVertexColor &&
+                pVB->m_Format.m_Stride            == pSourceVB->m_Format.m_Stride            &&
+                pVB->m_Culling.m_Type             == pSourceVB->m_Culling.m_Type             &&
+                pVB->m_Culling.m_Face             == pSourceVB->m_Culling.m_Face             &&
+                pVB->m_Material.m_Color           == pSourceVB->m_Material.m_Color           &&
+                pVB->m_Material.m_Transparent     == pSourceVB->m_Material.m_Transparent     &&
+                pVB->m_Material.m_Wireframe       == pSourceVB->m_Material.m_Wireframe)
+                break;
         }
 
-        // iterate through the model meshes
-        for (i = 0; i < pModel->m_MeshCount; ++i)
+        // not found? Create a new one
+        if (vbIndex == pMesh->m_Count)
         {
-            // create a new tree for the mesh
-            CSR_AABBNode* pAABBTree = csrAABBTreeFromMesh(&pModel->m_pMesh[i]);
+            pVB = (CSR_VertexBuffer*)csrMemoryAlloc(pMesh->m_pVB, sizeof(CSR_VertexBuffer), pMesh->m_Count + 1);
 
             // succeeded?
-            if (!pAABBTree)
+            if (!pVB)
             {
-                // realloc to the previous size, thus the latest added item will be freed
-                if (transparent)
-                    pScene->m_pTransparentItem =
-                            (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                           sizeof(CSR_SceneItem),
-                                                           pScene->m_TransparentItemCount);
-                else
-                    pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                                     sizeof(CSR_SceneItem),
-                                                                     pScene->m_ItemCount);
-
+                csrIndexedPolygonBufferRelease(pIPB);
                 return 0;
             }
 
-            // copy the tree content
-            memcpy(&pItem[index].m_pAABBTree[i], pAABBTree, sizeof(CSR_AABBNode));
+            pMesh->m_pVB = pVB;
+
+            csrVertexBufferInit(&pMesh->m_pVB[vbIndex]);
+            pMesh->m_pVB[vbIndex].m_Format        = pSourceVB->m_Format;
+            pMesh->m_pVB[vbIndex].m_Format.m_Type = CSR_VT_Triangles;
+            pMesh->m_pVB[vbIndex].m_Culling       = pSourceVB->m_Culling;
+            pMesh->m_pVB[vbIndex].m_Material      = pSourceVB->m_Material;
+            ++pMesh->m_Count;
+        }
+
+        pVB       = &pMesh->m_pVB[vbIndex];
+        dataCount =  pVB->m_Count + (polygonCount * 3 * stride);
+
+        // add room for the new vertices, if required
+        if (!pVB->m_pData || dataCount > csrSceneBatchGetCapacity(pVB->m_Count))
+        {
+            pData = (float*)csrMemoryAlloc(pVB->m_pData, sizeof(float), csrSceneBatchGetCapacity(dataCount));
+
+            // succeeded?
+            if (!pData)
+            {
+                csrIndexedPolygonBufferRelease(pIPB);
+                return 0;
+            }
+
+            pVB->m_pData = pData;
+        }
+
+        // add room for their range, if required
+        if (!pBatch->m_pRange || pBatch->m_Count + 1 > csrSceneBatchGetCapacity(pBatch->m_Count))
+        {
+            pRange = (CSR_SceneBatchRange*)csrMemoryAlloc(pBatch->m_pRange,
+                                                          sizeof(CSR_SceneBatchRange),
+                                                          csrSceneBatchGetCapacity(pBatch->m_Count + 1));
+
+            // succeeded?
+            if (!pRange)
+            {
+                csrIndexedPolygonBufferRelease(pIPB);
+                return 0;
+            }
+
+            pBatch->m_pRange = pRange;
+        }
+
+        pData  = pVB->m_pData;
+        pRange = pBatch->m_pRange;
+
+        // keep the instance range
+        pRange[pBatch->m_Count].m_VBIndex = vbIndex;
+        pRange[pBatch->m_Count].m_Start   = pVB->m_Count;
+        pRange[pBatch->m_Count].m_Count   = polygonCount * 3 * stride;
+        pRange[pBatch->m_Count].m_Box     = *pBox;
+        ++pBatch->m_Count;
+
+        offset = pVB->m_Count;
+
+        // copy the polygons, in the world coordinates system
+        for (j = 0; j < pIPB->m_Count; ++j)
+        {
+            if (pIPB->m_pIndexedPolygon[j].m_pVB != pSourceVB)
+                continue;
+
+            for (k = 0; k < 3; ++k)
+            {
+                // a mirroring matrix reverses the polygon winding, thus the culling would be wrong
+                index = pIPB->m_pIndexedPolygon[j].m_pIndex[(determinant < 0.0f) ? 2 - k : k];
+
+                memcpy(&pData[offset], &pSourceVB->m_pData[index], stride * sizeof(float));
+
+                // transform the vertex position
+                vertex.m_X = pData[offset];
+                vertex.m_Y = pData[offset + 1];
+                vertex.m_Z = pData[offset + 2];
+
+                csrMat4ApplyToVector(pMatrix, &vertex, &transformed);
+
+                pData[offset]     = transformed.m_X;
+                pData[offset + 1] = transformed.m_Y;
+                pData[offset + 2] = transformed.m_Z;
+
+                // transform the vertex normal
+                if (pSourceVB->m_Format.m_HasNormal)
+                {
+                    vertex.m_X = pData[offset + 3];
+                    vertex.m_Y = pData[offset + 4];
+                    vertex.m_Z = pData[offset + 5];
+
+                    csrMat4ApplyToNormal(&normalMatrix, &vertex, &transformed);
+                    csrVec3Normalize(&transformed, &vertex);
+
+                    pData[offset + 3] = vertex.m_X;
+                    pData[offset + 4] = vertex.m_Y;
+                    pData[offset + 5] = vertex.m_Z;
+                }
+
+                offset += stride;
+            }
+        }
+
+        pVB->m_Count = offset;
+    }
+
+    csrIndexedPolygonBufferRelease(pIPB);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneBatchAddOccluder(const CSR_Polygon3Buffer* pOccluder,
+                             const CSR_Matrix4*        pMatrix,
+                                   CSR_Polygon3Buffer* pBatchOccluder)
+{
+    size_t        i;
+    size_t        j;
+    CSR_Polygon3* pPolygon;
+
+    // nothing to add?
+    if (!pOccluder->m_Count)
+        return 1;
+
+    // add room for the occluder polygons, if required
+    if (!pBatchOccluder->m_pPolygon ||
+         pBatchOccluder->m_Count + pOccluder->m_Count > csrSceneBatchGetCapacity(pBatchOccluder->m_Count))
+    {
+        pPolygon = (CSR_Polygon3*)csrMemoryAlloc(pBatchOccluder->m_pPolygon,
+                                                 sizeof(CSR_Polygon3),
+                                                 csrSceneBatchGetCapacity(pBatchOccluder->m_Count + pOccluder->m_Count));
+
+        // succeeded?
+        if (!pPolygon)
+            return 0;
+
+        pBatchOccluder->m_pPolygon = pPolygon;
+    }
+
+    pPolygon = pBatchOccluder->m_pPolygon;
+
+    // copy the polygons, in the world coordinates system
+    for (i = 0; i < pOccluder->m_Count; ++i)
+    {
+        for (j = 0; j < 3; ++j)
+            csrMat4ApplyToVector(pMatrix,
+                                 &pOccluder->m_pPolygon[i].m_Vertex[j],
+                                 &pPolygon[pBatchOccluder->m_Count].m_Vertex[j]);
+
+        ++pBatchOccluder->m_Count;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrSceneBatchShrink(CSR_SceneItem* pBatchItem)
+{
+    size_t               i;
+    float*               pData;
+    CSR_SceneBatchRange* pRange;
+    CSR_Polygon3*        pPolygon;
+    CSR_Mesh*            pMesh = (CSR_Mesh*)pBatchItem->m_pModel;
+
+    // shrink the batch arrays to their real size. NOTE if it fails, the previous arrays are still
+    // valid and can be kept
+    for (i = 0; i < pMesh->m_Count; ++i)
+        if (pMesh->m_pVB[i].m_Count)
+        {
+            pData = (float*)csrMemoryAlloc(pMesh->m_pVB[i].m_pData, sizeof(float), pMesh->m_pVB[i].m_Count);
+
+            if (pData)
+                pMesh->m_pVB[i].m_pData = pData;
+        }
+
+    if (pBatchItem->m_pBatch->m_Count)
+    {
+        pRange = (CSR_SceneBatchRange*)csrMemoryAlloc(pBatchItem->m_pBatch->m_pRange,
+                                                      sizeof(CSR_SceneBatchRange),
+                                                      pBatchItem->m_pBatch->m_Count);
+
+        if (pRange)
+            pBatchItem->m_pBatch->m_pRange = pRange;
+    }
+
+    if (pBatchItem->m_Occluder.m_Count)
+    {
+        pPolygon = (CSR_Polygon3*)csrMemoryAlloc(pBatchItem->m_Occluder.m_pPolygon,
+                                                 sizeof(CSR_Polygon3),
+                                                 pBatchItem->m_Occluder.m_Count);
+
+        if (pPolygon)
+            pBatchItem->m_Occluder.m_pPolygon = pPolygon;
+    }
+}
+//---------------------------------------------------------------------------
+int csrSceneFileCanRead(const CSR_Buffer* pBuffer, size_t offset, size_t length, size_t count)
+{
+    // check that the remaining data may contain the requested values, without overflowing
+    return (offset <= pBuffer->m_Length && count <= (pBuffer->m_Length - offset) / length);
+}
+//---------------------------------------------------------------------------
+int csrSceneFileRead(const CSR_Buffer* pBuffer,
+                           size_t*     pOffset,
+                           size_t      length,
+                           size_t      count,
+                           void*       pData)
+{
+    // nothing to read?
+    if (!count)
+        return 1;
+
+    // a truncated scene is an error (csrBufferRead() would read the remaining data only)
+    if (!csrSceneFileCanRead(pBuffer, *pOffset, length, count))
+        return 0;
+
+    return csrBufferRead(pBuffer, pOffset, length, count, pData);
+}
+//---------------------------------------------------------------------------
+int csrSceneFileWriteUnsigned(size_t value, CSR_Buffer* pBuffer)
+{
+    const unsigned data = (unsigned)value;
+
+    return csrBufferWrite(pBuffer, &data, sizeof(unsigned), 1);
+}
+//---------------------------------------------------------------------------
+int csrSceneFileReadUnsigned(const CSR_Buffer* pBuffer, size_t* pOffset, size_t* pValue)
+{
+    unsigned data;
+
+    if (!csrSceneFileRead(pBuffer, pOffset, sizeof(unsigned), 1, &data))
+        return 0;
+
+    *pValue = data;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneFileWriteBox(const CSR_Box* pBox, CSR_Buffer* pBuffer)
+{
+    float data[6];
+
+    data[0] = pBox->m_Min.m_X;
+    data[1] = pBox->m_Min.m_Y;
+    data[2] = pBox->m_Min.m_Z;
+    data[3] = pBox->m_Max.m_X;
+    data[4] = pBox->m_Max.m_Y;
+    data[5] = pBox->m_Max.m_Z;
+
+    return csrBufferWrite(pBuffer, data, sizeof(float), 6);
+}
+//---------------------------------------------------------------------------
+int csrSceneFileReadBox(const CSR_Buffer* pBuffer, size_t* pOffset, CSR_Box* pBox)
+{
+    float data[6];
+
+    if (!csrSceneFileRead(pBuffer, pOffset, sizeof(float), 6, data))
+        return 0;
+
+    pBox->m_Min.m_X = data[0];
+    pBox->m_Min.m_Y = data[1];
+    pBox->m_Min.m_Z = data[2];
+    pBox->m_Max.m_X = data[3];
+    pBox->m_Max.m_Y = data[4];
+    pBox->m_Max.m_Z = data[5];
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneFileWriteString(const char* pString, CSR_Buffer* pBuffer)
+{
+    const size_t length = pString ? strlen(pString) : 0;
+
+    // write the string length, followed by the string characters
+    return (csrSceneFileWriteUnsigned(length, pBuffer) &&
+            (!length || csrBufferWrite(pBuffer, pString, sizeof(char), length)));
+}
+//---------------------------------------------------------------------------
+int csrSceneFileReadString(const CSR_Buffer* pBuffer, size_t* pOffset, char** ppString)
+{
+    size_t length;
+
+    // read the string length
+    if (!csrSceneFileReadUnsigned(pBuffer, pOffset, &length))
+        return 0;
+
+    // empty string?
+    if (!length)
+        return 1;
+
+    // is the string complete?
+    if (!csrSceneFileCanRead(pBuffer, *pOffset, sizeof(char), length))
+        return 0;
+
+    *ppString = (char*)malloc(length + 1);
+
+    // succeeded?
+    if (!*ppString)
+        return 0;
+
+    // read the string characters. NOTE the string is released by its owner on failure
+    if (!csrSceneFileRead(pBuffer, pOffset, sizeof(char), length, *ppString))
+        return 0;
+
+    (*ppString)[length] = '\0';
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneFileWriteMesh(const CSR_Mesh* pMesh, CSR_Buffer* pBuffer)
+{
+    size_t i;
+
+    // write the skin texture file names
+    if (!csrSceneFileWriteString(pMesh->m_Skin.m_Texture.m_pFileName, pBuffer) ||
+        !csrSceneFileWriteString(pMesh->m_Skin.m_BumpMap.m_pFileName, pBuffer) ||
+        !csrSceneFileWriteString(pMesh->m_Skin.m_CubeMap.m_pFileName, pBuffer))
+        return 0;
+
+    // write the vertex buffer count
+    if (!csrSceneFileWriteUnsigned(pMesh->m_Count, pBuffer))
+        return 0;
+
+    // iterate through the vertex buffers to write
+    for (i = 0; i < pMesh->m_Count; ++i)
+    {
+        const CSR_VertexBuffer* pVB = &pMesh->m_pVB[i];
+              unsigned          header[12];
+
+        // write the vertex buffer header
+        header[0]  = (unsigned)pVB->m_Format.m_Type;
+        header[1]  = (unsigned)pVB->m_Format.m_HasNormal;
+        header[2]  = (unsigned)pVB->m_Format.m_HasTexCoords;
+        header[3]  = (unsigned)pVB->m_Format.m_HasPerVertexColor;
+        header[4]  =           pVB->m_Format.m_Stride;
+        header[5]  = (unsigned)pVB->m_Culling.m_Type;
+        header[6]  = (unsigned)pVB->m_Culling.m_Face;
+        header[7]  =           pVB->m_Material.m_Color;
+        header[8]  = (unsigned)pVB->m_Material.m_Transparent;
+        header[9]  = (unsigned)pVB->m_Material.m_Wireframe;
+        header[10] = (unsigned)pVB->m_Count;
+        header[11] = (pVB->m_pIndex && pVB->m_Count) ? (unsigned)pVB->m_IndexCount : 0;
+
+        if (!csrBufferWrite(pBuffer, header, sizeof(unsigned), 12))
+            return 0;
+
+        // write the vertex data
+        if (pVB->m_Count && !csrBufferWrite(pBuffer, pVB->m_pData, sizeof(float), pVB->m_Count))
+            return 0;
+
+        // write the vertex indices
+        if (header[11] && !csrBufferWrite(pBuffer, pVB->m_pIndex, sizeof(unsigned), header[11]))
+            return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneFileReadMesh(const CSR_Buffer* pBuffer, size_t* pOffset, CSR_Mesh* pMesh)
+{
+    size_t i;
+    size_t j;
+    size_t count;
+
+    // read the skin texture file names. NOTE the textures themselves should be loaded by the caller
+    if (!csrSceneFileReadString(pBuffer, pOffset, &pMesh->m_Skin.m_Texture.m_pFileName) ||
+        !csrSceneFileReadString(pBuffer, pOffset, &pMesh->m_Skin.m_BumpMap.m_pFileName) ||
+        !csrSceneFileReadString(pBuffer, pOffset, &pMesh->m_Skin.m_CubeMap.m_pFileName))
+        return 0;
+
+    // read the vertex buffer count
+    if (!csrSceneFileReadUnsigned(pBuffer, pOffset, &count))
+        return 0;
+
+    // no vertex buffer?
+    if (!count)
+        return 1;
+
+    // may the buffer contain all the vertex buffer headers?
+    if (!csrSceneFileCanRead(pBuffer, *pOffset, sizeof(unsigned) * 12, count))
+        return 0;
+
+    pMesh->m_pVB = (CSR_VertexBuffer*)csrMemoryAlloc(0, sizeof(CSR_VertexBuffer), count);
+
+    // succeeded?
+    if (!pMesh->m_pVB)
+        return 0;
+
+    // initialize the vertex buffers, thus the mesh may be released at any time
+    for (i = 0; i < count; ++i)
+        csrVertexBufferInit(&pMesh->m_pVB[i]);
+
+    pMesh->m_Count = count;
+
+    // iterate through the vertex buffers to read
+    for (i = 0; i < count; ++i)
+    {
+        CSR_VertexBuffer* pVB = &pMesh->m_pVB[i];
+        unsigned          header[12];
+
+        // read the vertex buffer header
+        if (!csrSceneFileRead(pBuffer, pOffset, sizeof(unsigned), 12, header))
+            return 0;
+
+        pVB->m_Format.m_Type              = (CSR_EVertexType)header[0];
+        pVB->m_Format.m_HasNormal         = (int)header[1];
+        pVB->m_Format.m_HasTexCoords      = (int)header[2];
+        pVB->m_Format.m_HasPerVertexColor = (int)header[3];
+        pVB->m_Format.m_Stride            =      header[4];
+        pVB->m_Culling.m_Type             = (CSR_ECullingType)header[5];
+        pVB->m_Culling.m_Face             = (CSR_ECullingFace)header[6];
+        pVB->m_Material.m_Color           =      header[7];
+        pVB->m_Material.m_Transparent     = (int)header[8];
+        pVB->m_Material.m_Wireframe       = (int)header[9];
+
+        // no vertex data?
+        if (!header[10])
+            continue;
+
+        // is the vertex data complete?
+        if (!csrSceneFileCanRead(pBuffer, *pOffset, sizeof(float), header[10]))
+            return 0;
+
+        pVB->m_pData = (float*)malloc(header[10] * sizeof(float));
+
+        // succeeded?
+        if (!pVB->m_pData)
+            return 0;
+
+        // read the vertex data
+        if (!csrSceneFileRead(pBuffer, pOffset, sizeof(float), header[10], pVB->m_pData))
+            return 0;
+
+        pVB->m_Count = header[10];
+
+        // no vertex indices?
+        if (!header[11])
+            continue;
+
+        // are the vertex indices complete?
+        if (!csrSceneFileCanRead(pBuffer, *pOffset, sizeof(unsigned), header[11]))
+            return 0;
+
+        pVB->m_pIndex = (unsigned*)malloc(header[11] * sizeof(unsigned));
+
+        // succeeded?
+        if (!pVB->m_pIndex)
+            return 0;
+
+        // read the vertex indices
+        if (!csrSceneFileRead(pBuffer, pOffset, sizeof(unsigned), header[11], pVB->m_pIndex))
+            return 0;
+
+        pVB->m_IndexCount = header[11];
+
+        // validate the indices, thus a corrupted file never reads outside the vertex data
+        for (j = 0; j < pVB->m_IndexCount; ++j)
+            if ((size_t)pVB->m_pIndex[j] * pVB->m_Format.m_Stride >= pVB->m_Count)
+                return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneFileWriteAABBNode(const CSR_AABBNode* pNode, const CSR_Mesh* pMesh, CSR_Buffer* pBuffer)
+{
+    size_t   i;
+    unsigned header[6];
+
+    // write the node header, i.e. which content follows
+    header[0] = pNode->m_pLeft          ? 1 : 0;
+    header[1] = pNode->m_pRight         ? 1 : 0;
+    header[2] = pNode->m_Pending        ? 1 : 0;
+    header[3] = pNode->m_pBox           ? 1 : 0;
+    header[4] = pNode->m_pPolygonBuffer ? 1 : 0;
+    header[5] = pNode->m_pTriangles     ? 1 : 0;
+
+    if (!csrBufferWrite(pBuffer, header, sizeof(unsigned), 6))
+        return 0;
+
+    // write the node box
+    if (pNode->m_pBox && !csrSceneFileWriteBox(pNode->m_pBox, pBuffer))
+        return 0;
+
+    // write the node polygons
+    if (pNode->m_pPolygonBuffer)
+    {
+        if (!csrSceneFileWriteUnsigned(pNode->m_pPolygonBuffer->m_Count, pBuffer))
+            return 0;
+
+        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+        {
+            const CSR_IndexedPolygon* pPolygon = &pNode->m_pPolygonBuffer->m_pIndexedPolygon[i];
+                  unsigned            polygon[4];
+
+            // the polygon should belong to the mesh for which the tree was built
+            if (pPolygon->m_pVB < pMesh->m_pVB || pPolygon->m_pVB >= pMesh->m_pVB + pMesh->m_Count)
+                return 0;
+
+            // write the polygon as a vertex buffer index, followed by its vertex offsets in the buffer
+            polygon[0] = (unsigned)(pPolygon->m_pVB - pMesh->m_pVB);
+            polygon[1] = (unsigned)pPolygon->m_pIndex[0];
+            polygon[2] = (unsigned)pPolygon->m_pIndex[1];
+            polygon[3] = (unsigned)pPolygon->m_pIndex[2];
+
+            if (!csrBufferWrite(pBuffer, polygon, sizeof(unsigned), 4))
+                return 0;
+        }
+    }
+
+    // write the node precomputed triangles
+    if (pNode->m_pTriangles)
+    {
+        if (!csrSceneFileWriteUnsigned(pNode->m_pTriangles->m_Count, pBuffer))
+            return 0;
+
+        if (pNode->m_pTriangles->m_Count && !csrBufferWrite(pBuffer,
+                                                            pNode->m_pTriangles->m_pData,
+                                                            sizeof(float),
+                                                            pNode->m_pTriangles->m_Count * CSR_TC_Count))
+            return 0;
+    }
+
+    // write the children, in depth-first order
+    if (pNode->m_pLeft && !csrSceneFileWriteAABBNode(pNode->m_pLeft, pMesh, pBuffer))
+        return 0;
+
+    if (pNode->m_pRight && !csrSceneFileWriteAABBNode(pNode->m_pRight, pMesh, pBuffer))
+        return 0;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+CSR_AABBNode* csrSceneFileCreateAABBNode(CSR_AABBNode* pParent)
+{
+    CSR_AABBNode* pNode = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+
+    // succeeded?
+    if (!pNode)
+        return 0;
+
+    pNode->m_pParent        = pParent;
+    pNode->m_pLeft          = 0;
+    pNode->m_pRight         = 0;
+    pNode->m_pBox           = 0;
+    pNode->m_pPolygonBuffer = 0;
+    pNode->m_pTriangles     = 0;
+    pNode->m_Pending        = 0;
+
+    return pNode;
+}
+//---------------------------------------------------------------------------
+int csrSceneFileReadAABBNode(const CSR_Buffer*   pBuffer,
+                                   size_t*       pOffset,
+                             const CSR_Mesh*     pMesh,
+                                   size_t        depth,
+                                   CSR_AABBNode* pNode)
+{
+    size_t   i;
+    size_t   count;
+    unsigned header[6];
+
+    // is the tree too deep? (the file is probably corrupted, and reading it would exhaust the stack)
+    if (depth >= M_CSR_Scene_Max_Depth)
+        return 0;
+
+    // read the node header
+    if (!csrSceneFileRead(pBuffer, pOffset, sizeof(unsigned), 6, header))
+        return 0;
+
+    pNode->m_Pending = header[2] ? 1 : 0;
+
+    // read the node box
+    if (header[3])
+    {
+        pNode->m_pBox = (CSR_Box*)malloc(sizeof(CSR_Box));
+
+        // succeeded?
+        if (!pNode->m_pBox)
+            return 0;
+
+        if (!csrSceneFileReadBox(pBuffer, pOffset, pNode->m_pBox))
+            return 0;
+    }
+
+    // read the node polygons
+    if (header[4])
+    {
+        if (!csrSceneFileReadUnsigned(pBuffer, pOffset, &count))
+            return 0;
+
+        // are the polygons complete?
+        if (!csrSceneFileCanRead(pBuffer, *pOffset, sizeof(unsigned) * 4, count))
+            return 0;
+
+        pNode->m_pPolygonBuffer = (CSR_IndexedPolygonBuffer*)malloc(sizeof(CSR_IndexedPolygonBuffer));
+
+        // succeeded?
+        if (!pNode->m_pPolygonBuffer)
+            return 0;
+
+        pNode->m_pPolygonBuffer->m_pIndexedPolygon = 0;
+        pNode->m_pPolygonBuffer->m_Count           = 0;
+
+        if (count)
+        {
+            pNode->m_pPolygonBuffer->m_pIndexedPolygon =
+                    (CSR_IndexedPolygon*)csrMemoryAlloc(0, sizeof(CSR_IndexedPolygon), count);
+
+            // succeeded?
+            if (!pNode->m_pPolygonBuffer->m_pIndexedPolygon)
+                return 0;
+        }
+
+        for (i = 0; i < count; ++i)
+        {
+            CSR_IndexedPolygon* pPolygon = &pNode->m_pPolygonBuffer->m_pIndexedPolygon[i];
+            unsigned            polygon[4];
+
+            if (!csrSceneFileRead(pBuffer, pOffset, sizeof(unsigned), 4, polygon))
+                return 0;
+
+            // is the vertex buffer valid?
+            if (polygon[0] >= pMesh->m_Count)
+                return 0;
+
+            // are the vertex positions contained in the vertex buffer?
+            if ((size_t)polygon[1] + 3 > pMesh->m_pVB[polygon[0]].m_Count ||
+                (size_t)polygon[2] + 3 > pMesh->m_pVB[polygon[0]].m_Count ||
+                (size_t)polygon[3] + 3 > pMesh->m_pVB[polygon[0]].m_Count)
+                return 0;
+
+            pPolygon->m_pVB       = &pMesh->m_pVB[polygon[0]];
+            pPolygon->m_pIndex[0] = polygon[1];
+            pPolygon->m_pIndex[1] = polygon[2];
+            pPolygon->m_pIndex[2] = polygon[3];
+
+            ++pNode->m_pPolygonBuffer->m_Count;
+        }
+    }
+
+    // read the node precomputed triangles
+    if (header[5])
+    {
+        if (!csrSceneFileReadUnsigned(pBuffer, pOffset, &count))
+            return 0;
+
+        // the triangles are read back from the node polygons, thus they should match
+        if (!pNode->m_pPolygonBuffer || count != pNode->m_pPolygonBuffer->m_Count)
+            return 0;
+
+        // are the triangles complete?
+        if (!csrSceneFileCanRead(pBuffer, *pOffset, sizeof(float) * CSR_TC_Count, count))
+            return 0;
+
+        pNode->m_pTriangles = (CSR_AABBTriangles*)malloc(sizeof(CSR_AABBTriangles));
+
+        // succeeded?
+        if (!pNode->m_pTriangles)
+            return 0;
+
+        pNode->m_pTriangles->m_pData = 0;
+        pNode->m_pTriangles->m_Count = 0;
+
+        if (count)
+        {
+            pNode->m_pTriangles->m_pData = (float*)malloc(count * CSR_TC_Count * sizeof(float));
+
+            // succeeded?
+            if (!pNode->m_pTriangles->m_pData)
+                return 0;
+
+            if (!csrSceneFileRead(pBuffer, pOffset, sizeof(float), count * CSR_TC_Count, pNode->m_pTriangles->m_pData))
+                return 0;
+
+            pNode->m_pTriangles->m_Count = count;
+        }
+    }
+
+    // read the left child. NOTE it's linked before being read, thus the tree may always be released
+    if (header[0])
+    {
+        pNode->m_pLeft = csrSceneFileCreateAABBNode(pNode);
+
+        // succeeded?
+        if (!pNode->m_pLeft)
+            return 0;
+
+        if (!csrSceneFileReadAABBNode(pBuffer, pOffset, pMesh, depth + 1, pNode->m_pLeft))
+            return 0;
+    }
+
+    // read the right child
+    if (header[1])
+    {
+        pNode->m_pRight = csrSceneFileCreateAABBNode(pNode);
+
+        // succeeded?
+        if (!pNode->m_pRight)
+            return 0;
+
+        if (!csrSceneFileReadAABBNode(pBuffer, pOffset, pMesh, depth + 1, pNode->m_pRight))
+            return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneFileCanWriteItem(const CSR_SceneItem* pItem)
+{
+    return (pItem->m_pModel && (pItem->m_Type == CSR_MT_Mesh || pItem->m_Type == CSR_MT_Model));
+}
+//---------------------------------------------------------------------------
+int csrSceneFileWriteItem(const CSR_SceneItem* pItem, CSR_Buffer* pBuffer)
+{
+    size_t          i;
+    size_t          j;
+    size_t          meshCount;
+    const CSR_Mesh* pMeshes;
+    unsigned        header[10];
+
+    // get the item meshes
+    if (pItem->m_Type == CSR_MT_Mesh)
+    {
+        pMeshes   = (const CSR_Mesh*)pItem->m_pModel;
+        meshCount = 1;
+    }
+    else
+    {
+        pMeshes   = ((const CSR_Model*)pItem->m_pModel)->m_pMesh;
+        meshCount = ((const CSR_Model*)pItem->m_pModel)->m_MeshCount;
+    }
+
+    // the item trees should match with the meshes for which they were built
+    if (pItem->m_AABBTreeCount && pItem->m_AABBTreeCount != meshCount)
+        return 0;
+
+    // write the item header
+    header[0] = (unsigned)pItem->m_Type;
+    header[1] = (unsigned)pItem->m_CollisionType;
+    header[2] = (unsigned)pItem->m_Static;
+    header[3] = (unsigned)pItem->m_HasBox;
+    header[4] = (unsigned)meshCount;
+    header[5] = (unsigned)(pItem->m_pMatrixArray ? pItem->m_pMatrixArray->m_Count : 0);
+    header[6] = (unsigned)(pItem->m_pAABBTree    ? pItem->m_AABBTreeCount         : 0);
+    header[7] = (unsigned)pItem->m_AABBTreeIndex;
+    header[8] = (unsigned)pItem->m_Occluder.m_Count;
+    header[9] = (unsigned)(pItem->m_pBatch       ? pItem->m_pBatch->m_Count       : 0);
+
+    if (!csrBufferWrite(pBuffer, header, sizeof(unsigned), 10))
+        return 0;
+
+    // write the item box
+    if (!csrSceneFileWriteBox(&pItem->m_Box, pBuffer))
+        return 0;
+
+    // write the instance matrices
+    for (i = 0; i < header[5]; ++i)
+        if (!csrBufferWrite(pBuffer,
+                            ((CSR_Matrix4*)pItem->m_pMatrixArray->m_pItem[i].m_pData)->m_Table,
+                            sizeof(float),
+                            16))
+            return 0;
+
+    // write the meshes
+    for (i = 0; i < meshCount; ++i)
+        if (!csrSceneFileWriteMesh(&pMeshes[i], pBuffer))
+            return 0;
+
+    // write the aligned-axis bounding box trees, each one belongs to the matching mesh
+    for (i = 0; i < header[6]; ++i)
+        if (!csrSceneFileWriteAABBNode(&pItem->m_pAABBTree[i], &pMeshes[i], pBuffer))
+            return 0;
+
+    // write the occluder
+    for (i = 0; i < pItem->m_Occluder.m_Count; ++i)
+    {
+        float polygon[9];
+
+        for (j = 0; j < 3; ++j)
+        {
+            polygon[j * 3]     = pItem->m_Occluder.m_pPolygon[i].m_Vertex[j].m_X;
+            polygon[j * 3 + 1] = pItem->m_Occluder.m_pPolygon[i].m_Vertex[j].m_Y;
+            polygon[j * 3 + 2] = pItem->m_Occluder.m_pPolygon[i].m_Vertex[j].m_Z;
+        }
+
+        if (!csrBufferWrite(pBuffer, polygon, sizeof(float), 9))
+            return 0;
+    }
+
+    // write the batch ranges
+    for (i = 0; i < header[9]; ++i)
+    {
+        const CSR_SceneBatchRange* pRange = &pItem->m_pBatch->m_pRange[i];
+
+        if (!csrSceneFileWriteUnsigned(pRange->m_VBIndex, pBuffer) ||
+            !csrSceneFileWriteUnsigned(pRange->m_Start,   pBuffer) ||
+            !csrSceneFileWriteUnsigned(pRange->m_Count,   pBuffer) ||
+            !csrSceneFileWriteBox(&pRange->m_Box, pBuffer))
+            return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneFileReadItem(      CSR_Scene*     pScene,
+                         const CSR_Buffer*    pBuffer,
+                               size_t         offset,
+                               size_t         index,
+                               int            transparent,
+                               CSR_SceneItem* pItem)
+{
+    size_t    i;
+    size_t    j;
+    size_t    meshCount;
+    CSR_Mesh* pMeshes;
+    unsigned  header[10];
+
+    // read the item header
+    if (!csrSceneFileRead(pBuffer, &offset, sizeof(unsigned), 10, header))
+        return 0;
+
+    // only the meshes and models are written in a scene file
+    if (header[0] != CSR_MT_Mesh && header[0] != CSR_MT_Model)
+        return 0;
+
+    meshCount = header[4];
+
+    // a mesh item contains one mesh, and each tree belongs to a mesh
+    if ((header[0] == CSR_MT_Mesh && meshCount != 1) || (header[6] && header[6] != meshCount))
+        return 0;
+
+    // may the buffer contain the matrices and the meshes?
+    if (!csrSceneFileCanRead(pBuffer, offset, sizeof(float) * 16, header[5]) ||
+        !csrSceneFileCanRead(pBuffer, offset, sizeof(unsigned) * 4, meshCount))
+        return 0;
+
+    pItem->m_Type          = (CSR_EModelType)header[0];
+    pItem->m_CollisionType = (CSR_ECollisionType)header[1];
+    pItem->m_Static        = (int)header[2];
+    pItem->m_HasBox        = (int)header[3];
+    pItem->m_AABBTreeIndex = header[7];
+
+    // link a handle to the item. NOTE the item remains usable without handle if it fails
+    pItem->m_Handle = csrHandleTableAdd(&pScene->m_ItemHandles, index, transparent ? 1 : 0);
+
+    // read the item box
+    if (!csrSceneFileReadBox(pBuffer, &offset, &pItem->m_Box))
+        return 0;
+
+    // read the instance matrices
+    if (header[5])
+    {
+        pItem->m_pMatrixArray = csrArrayCreate();
+
+        // succeeded?
+        if (!pItem->m_pMatrixArray)
+            return 0;
+
+        for (i = 0; i < header[5]; ++i)
+        {
+            CSR_Matrix4* pMatrix = (CSR_Matrix4*)malloc(sizeof(CSR_Matrix4));
+
+            // succeeded?
+            if (!pMatrix)
+                return 0;
+
+            if (!csrSceneFileRead(pBuffer, &offset, sizeof(float), 16, pMatrix->m_Table))
+            {
+                free(pMatrix);
+                return 0;
+            }
+
+            // add the matrix. NOTE the matrix is owned by the matrix array
+            csrArrayAdd(pMatrix, pItem->m_pMatrixArray, 1);
+
+            // succeeded?
+            if (pItem->m_pMatrixArray->m_Count != i + 1)
+            {
+                free(pMatrix);
+                return 0;
+            }
+        }
+
+        // add a handle for each instance
+        pItem->m_pInstanceHandle = (CSR_Handle*)csrMemoryAlloc(0, sizeof(CSR_Handle), header[5]);
+
+        // succeeded? (if not, the instances remain usable without handle)
+        if (pItem->m_pInstanceHandle)
+        {
+            for (i = 0; i < header[5]; ++i)
+                pItem->m_pInstanceHandle[i] = csrHandleTableAdd(&pScene->m_InstanceHandles,
+                                                                i,
+                                                                pItem->m_Handle);
+
+            pItem->m_InstanceHandleCount = header[5];
+        }
+    }
+
+    // create the item model
+    if (pItem->m_Type == CSR_MT_Mesh)
+    {
+        pMeshes = csrMeshCreate();
+
+        // succeeded?
+        if (!pMeshes)
+            return 0;
+
+        pItem->m_pModel = pMeshes;
+    }
+    else
+    {
+        CSR_Model* pModel = csrModelCreate();
+
+        // succeeded?
+        if (!pModel)
+            return 0;
+
+        pItem->m_pModel = pModel;
+
+        pModel->m_pMesh = (CSR_Mesh*)csrMemoryAlloc(0, sizeof(CSR_Mesh), meshCount);
+
+        // succeeded?
+        if (meshCount && !pModel->m_pMesh)
+            return 0;
+
+        // initialize the meshes, thus the model may be released at any time
+        for (i = 0; i < meshCount; ++i)
+            csrMeshInit(&pModel->m_pMesh[i]);
+
+        pModel->m_MeshCount = meshCount;
+
+        pMeshes = pModel->m_pMesh;
+    }
+
+    // read the meshes
+    for (i = 0; i < meshCount; ++i)
+        if (!csrSceneFileReadMesh(pBuffer, &offset, &pMeshes[i]))
+            return 0;
+
+    // read the aligned-axis bounding box trees
+    if (header[6])
+    {
+        pItem->m_pAABBTree = (CSR_AABBNode*)csrMemoryAlloc(0, sizeof(CSR_AABBNode), header[6]);
+
+        // succeeded?
+        if (!pItem->m_pAABBTree)
+            return 0;
+
+        // initialize the root nodes, thus the trees may be released at any time
+        for (i = 0; i < header[6]; ++i)
+        {
+            pItem->m_pAABBTree[i].m_pParent        = 0;
+            pItem->m_pAABBTree[i].m_pLeft          = 0;
+            pItem->m_pAABBTree[i].m_pRight         = 0;
+            pItem->m_pAABBTree[i].m_pBox           = 0;
+            pItem->m_pAABBTree[i].m_pPolygonBuffer = 0;
+            pItem->m_pAABBTree[i].m_pTriangles     = 0;
+            pItem->m_pAABBTree[i].m_Pending        = 0;
+        }
+
+        pItem->m_AABBTreeCount = header[6];
+
+        for (i = 0; i < header[6]; ++i)
+            if (!csrSceneFileReadAABBNode(pBuffer, &offset, &pMeshes[i], 0, &pItem->m_pAABBTree[i]))
+                return 0;
+    }
+
+    // read the occluder
+    if (header[8])
+    {
+        // is the occluder complete?
+        if (!csrSceneFileCanRead(pBuffer, offset, sizeof(float) * 9, header[8]))
+            return 0;
+
+        pItem->m_Occluder.m_pPolygon = (CSR_Polygon3*)csrMemoryAlloc(0, sizeof(CSR_Polygon3), header[8]);
+
+        // succeeded?
+        if (!pItem->m_Occluder.m_pPolygon)
+            return 0;
+
+        pItem->m_Occluder.m_Count = header[8];
+
+        for (i = 0; i < header[8]; ++i)
+        {
+            float polygon[9];
+
+            if (!csrSceneFileRead(pBuffer, &offset, sizeof(float), 9, polygon))
+                return 0;
+
+            for (j = 0; j < 3; ++j)
+            {
+                pItem->m_Occluder.m_pPolygon[i].m_Vertex[j].m_X = polygon[j * 3];
+                pItem->m_Occluder.m_pPolygon[i].m_Vertex[j].m_Y = polygon[j * 3 + 1];
+                pItem->m_Occluder.m_pPolygon[i].m_Vertex[j].m_Z = polygon[j * 3 + 2];
+            }
+        }
+    }
+
+    // read the batch ranges
+    if (header[9])
+    {
+        // are the batch ranges complete?
+        if (!csrSceneFileCanRead(pBuffer, offset, sizeof(unsigned) * 3 + sizeof(float) * 6, header[9]))
+            return 0;
+
+        pItem->m_pBatch = (CSR_SceneBatch*)malloc(sizeof(CSR_SceneBatch));
+
+        // succeeded?
+        if (!pItem->m_pBatch)
+            return 0;
+
+        pItem->m_pBatch->m_pRange = (CSR_SceneBatchRange*)csrMemoryAlloc(0, sizeof(CSR_SceneBatchRange), header[9]);
+        pItem->m_pBatch->m_Count  = 0;
+
+        // succeeded?
+        if (!pItem->m_pBatch->m_pRange)
+            return 0;
+
+        for (i = 0; i < header[9]; ++i)
+        {
+            CSR_SceneBatchRange* pRange = &pItem->m_pBatch->m_pRange[i];
+
+            if (!csrSceneFileReadUnsigned(pBuffer, &offset, &pRange->m_VBIndex) ||
+                !csrSceneFileReadUnsigned(pBuffer, &offset, &pRange->m_Start)   ||
+                !csrSceneFileReadUnsigned(pBuffer, &offset, &pRange->m_Count)   ||
+                !csrSceneFileReadBox(pBuffer, &offset, &pRange->m_Box))
+                return 0;
+
+            ++pItem->m_pBatch->m_Count;
+        }
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+size_t csrSceneStateLoadFront(const CSR_SceneState* pState)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+        // acquire the index, thus the snapshot published with it is complete when it's read
+        return __atomic_load_n(&pState->m_Front, __ATOMIC_ACQUIRE);
+    #else
+        // no atomic operation available, the swap should be synchronized by the caller
+        return pState->m_Front;
+    #endif
+}
+//---------------------------------------------------------------------------
+void csrSceneStateStoreFront(CSR_SceneState* pState, size_t front)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+        // release the index, thus the snapshot is complete before a reader sees it published
+        __atomic_store_n(&pState->m_Front, front, __ATOMIC_RELEASE);
+    #else
+        pState->m_Front = front;
+    #endif
+}
+//---------------------------------------------------------------------------
+void csrSceneSnapshotInit(CSR_SceneSnapshot* pSnapshot)
+{
+    csrSceneInit(&pSnapshot->m_Scene);
+
+    pSnapshot->m_pItem         = 0;
+    pSnapshot->m_pArray        = 0;
+    pSnapshot->m_pIndex        = 0;
+    pSnapshot->m_ItemCount     = 0;
+    pSnapshot->m_pArrayItem    = 0;
+    pSnapshot->m_pMatrix       = 0;
+    pSnapshot->m_MatrixCount   = 0;
+    pSnapshot->m_pLOD          = 0;
+    pSnapshot->m_LODCount      = 0;
+    pSnapshot->m_pLODState     = 0;
+    pSnapshot->m_LODStateCount = 0;
+}
+//---------------------------------------------------------------------------
+void csrSceneSnapshotContentRelease(CSR_SceneSnapshot* pSnapshot)
+{
+    // NOTE the scene content is shared with the source scene, only the copies are released
+    free(pSnapshot->m_pItem);
+    free(pSnapshot->m_pArray);
+    free(pSnapshot->m_pIndex);
+    free(pSnapshot->m_pArrayItem);
+    free(pSnapshot->m_pMatrix);
+    free(pSnapshot->m_pLOD);
+    free(pSnapshot->m_pLODState);
+
+    csrSceneSnapshotInit(pSnapshot);
+}
+//---------------------------------------------------------------------------
+int csrSceneSnapshotWrite(const CSR_Scene*         pScene,
+                          const CSR_SceneContext*  pContext,
+                                CSR_SceneSnapshot* pSnapshot)
+{
+    size_t               i;
+    size_t               j;
+    size_t               k;
+    size_t               count;
+    size_t               itemCount;
+    size_t               matrixCount;
+    size_t               lodCount;
+    size_t               stateCount;
+    size_t               itemIndex;
+    size_t               matrixIndex;
+    size_t               lodIndex;
+    size_t               stateIndex;
+    int                  grown;
+    int                  keepState;
+    const CSR_SceneItem* pItems;
+
+    itemCount   = pScene->m_ItemCount + pScene->m_TransparentItemCount;
+    matrixCount = 0;
+    lodCount    = 0;
+    stateCount  = 0;
+    grown       = 0;
+
+    // count the instance matrices and the level of detail states to copy
+    for (i = 0; i < itemCount; ++i)
+    {
+        if (i < pScene->m_ItemCount)
+            pItems = &pScene->m_pItem[i];
+        else
+            pItems = &pScene->m_pTransparentItem[i - pScene->m_ItemCount];
+
+        count = pItems->m_pMatrixArray ? pItems->m_pMatrixArray->m_Count : 0;
+
+        matrixCount += count;
+
+        if (pItems->m_pLOD)
+        {
+            ++lodCount;
+            stateCount += count;
+        }
+    }
+
+    // do add room for the items?
+    if (itemCount > pSnapshot->m_ItemCount)
+    {
+        CSR_SceneItem*      pItem;
+        CSR_Array*          pArray;
+        CSR_SceneItemIndex* pIndex;
+
+        // the previous item copies are lost, thus their level states can't be kept
+        grown = 1;
+
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pSnapshot->m_pItem, sizeof(CSR_SceneItem), itemCount);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        pSnapshot->m_pItem = pItem;
+
+        pArray = (CSR_Array*)csrMemoryAlloc(pSnapshot->m_pArray, sizeof(CSR_Array), itemCount);
+
+        // succeeded?
+        if (!pArray)
+            return 0;
+
+        pSnapshot->m_pArray = pArray;
+
+        pIndex = (CSR_SceneItemIndex*)csrMemoryAlloc(pSnapshot->m_pIndex, sizeof(CSR_SceneItemIndex), itemCount);
+
+        // succeeded?
+        if (!pIndex)
+            return 0;
+
+        pSnapshot->m_pIndex    = pIndex;
+        pSnapshot->m_ItemCount = itemCount;
+    }
+
+    // do add room for the matrices?
+    if (matrixCount > pSnapshot->m_MatrixCount)
+    {
+        CSR_ArrayItem* pArrayItem;
+        CSR_Matrix4*   pMatrix;
+
+        pArrayItem = (CSR_ArrayItem*)csrMemoryAlloc(pSnapshot->m_pArrayItem,
+                                                    sizeof(CSR_ArrayItem),
+                                                    matrixCount);
+
+        // succeeded?
+        if (!pArrayItem)
+            return 0;
+
+        pSnapshot->m_pArrayItem = pArrayItem;
+
+        pMatrix = (CSR_Matrix4*)csrMemoryAlloc(pSnapshot->m_pMatrix, sizeof(CSR_Matrix4), matrixCount);
+
+        // succeeded?
+        if (!pMatrix)
+            return 0;
+
+        pSnapshot->m_pMatrix     = pMatrix;
+        pSnapshot->m_MatrixCount = matrixCount;
+    }
+
+    // do add room for the level of detail groups?
+    if (lodCount > pSnapshot->m_LODCount)
+    {
+        CSR_SceneLODGroup* pLOD;
+
+        grown = 1;
+
+        pLOD = (CSR_SceneLODGroup*)csrMemoryAlloc(pSnapshot->m_pLOD, sizeof(CSR_SceneLODGroup), lodCount);
+
+        // succeeded?
+        if (!pLOD)
+            return 0;
+
+        pSnapshot->m_pLOD     = pLOD;
+        pSnapshot->m_LODCount = lodCount;
+    }
+
+    // do add room for the level states?
+    if (stateCount > pSnapshot->m_LODStateCount)
+    {
+        unsigned char* pLODState;
+
+        grown = 1;
+
+        pLODState = (unsigned char*)csrMemoryAlloc(pSnapshot->m_pLODState, sizeof(unsigned char), stateCount);
+
+        // succeeded?
+        if (!pLODState)
+            return 0;
+
+        pSnapshot->m_pLODState     = pLODState;
+        pSnapshot->m_LODStateCount = stateCount;
+    }
+
+    // copy the scene, the item lists and the handles are replaced below
+    memcpy(&pSnapshot->m_Scene, pScene, sizeof(CSR_Scene));
+
+    pSnapshot->m_Scene.m_pItem            = 0;
+    pSnapshot->m_Scene.m_pTransparentItem = 0;
+
+    if (pScene->m_ItemCount)
+        pSnapshot->m_Scene.m_pItem = pSnapshot->m_pItem;
+
+    if (pScene->m_TransparentItemCount)
+        pSnapshot->m_Scene.m_pTransparentItem = &pSnapshot->m_pItem[pScene->m_ItemCount];
+
+    // the handles and the transform hierarchy belong to the source scene
+    csrHandleTableInit(&pSnapshot->m_Scene.m_ItemHandles);
+    csrHandleTableInit(&pSnapshot->m_Scene.m_InstanceHandles);
+    csrTransformHierarchyInit(&pSnapshot->m_Scene.m_Transforms);
+
+    itemIndex   = 0;
+    matrixIndex = 0;
+    lodIndex    = 0;
+    stateIndex  = 0;
+
+    // copy the normal items, then the transparent ones
+    for (i = 0; i < 2; ++i)
+    {
+        if (!i)
+        {
+            pItems = pScene->m_pItem;
+            count  = pScene->m_ItemCount;
+        }
+        else
+        {
+            pItems = pScene->m_pTransparentItem;
+            count  = pScene->m_TransparentItemCount;
+        }
+
+        for (j = 0; j < count; ++j)
+        {
+            CSR_SceneItem*      pItem  = &pSnapshot->m_pItem[itemIndex];
+            CSR_Array*          pArray = &pSnapshot->m_pArray[itemIndex];
+            CSR_SceneItemIndex* pIndex = &pSnapshot->m_pIndex[itemIndex];
+
+            // get the level of detail group copy
+            if (pItems[j].m_pLOD)
+            {
+                CSR_SceneLODGroup* pLOD      = &pSnapshot->m_pLOD[lodIndex];
+                const size_t       instances = pItems[j].m_pMatrixArray ? pItems[j].m_pMatrixArray->m_Count : 0;
+
+                // may the level states written by the previous copy be kept? It's the case if the
+                // item copy linked the same states, for the same model and instance count
+                keepState = !grown                                                &&
+                             pItem->m_pLOD      == pLOD                               &&
+                             pItem->m_pModel    == pItems[j].m_pModel                 &&
+                             pLOD->m_pState     == &pSnapshot->m_pLODState[stateIndex] &&
+                             pLOD->m_StateCount == instances;
+
+                // copy the group, it shares its levels with the source group, but owns its states
+                memcpy(pLOD, pItems[j].m_pLOD, sizeof(CSR_SceneLODGroup));
+
+                pLOD->m_pState     = instances ? &pSnapshot->m_pLODState[stateIndex] : 0;
+                pLOD->m_StateCount = instances;
+
+                // the instance levels are unknown, they will be selected on the next draw
+                if (!keepState && instances)
+                    memset(pLOD->m_pState, 0xFF, instances);
+
+                ++lodIndex;
+                stateIndex += instances;
+            }
+
+            // copy the item, it shares its model and its trees with the source item
+            memcpy(pItem, &pItems[j], sizeof(CSR_SceneItem));
+
+            // link the level of detail group copy, thus drawing the snapshot never writes the
+            // source level states
+            if (pItems[j].m_pLOD)
+                pItem->m_pLOD = &pSnapshot->m_pLOD[lodIndex - 1];
+
+            // freeze the indexes selected by the caller for this frame
+            if (pContext)
+                csrSceneItemGetIndex(pContext, &pItems[j], pIndex);
+            else
+                memset(pIndex, 0, sizeof(CSR_SceneItemIndex));
+
+            pItem->m_pIndex = pIndex;
+
+            ++itemIndex;
+
+            // no instance to copy?
+            if (!pItems[j].m_pMatrixArray)
+                continue;
+
+            // link the item copy to its own matrix array
+            pArray->m_pItem       = 0;
+            pArray->m_Count       = pItems[j].m_pMatrixArray->m_Count;
+            pItem->m_pMatrixArray = pArray;
+
+            if (pArray->m_Count)
+                pArray->m_pItem = &pSnapshot->m_pArrayItem[matrixIndex];
+
+            // copy the instance matrices
+            for (k = 0; k < pArray->m_Count; ++k)
+            {
+                memcpy(&pSnapshot->m_pMatrix[matrixIndex],
+                       pItems[j].m_pMatrixArray->m_pItem[k].m_pData,
+                       sizeof(CSR_Matrix4));
+
+                pSnapshot->m_pArrayItem[matrixIndex].m_pData    = &pSnapshot->m_pMatrix[matrixIndex];
+                pSnapshot->m_pArrayItem[matrixIndex].m_AutoFree = 0;
+
+                ++matrixIndex;
+            }
+        }
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+// Scene item functions
+//---------------------------------------------------------------------------
+CSR_SceneItem* csrSceneItemCreate(void)
+{
+    // create a new scene item
+    CSR_SceneItem* pSceneItem = (CSR_SceneItem*)malloc(sizeof(CSR_SceneItem));
+
+    // succeeded?
+    if (!pSceneItem)
+        return 0;
+
+    // initialize the scene item content
+    csrSceneItemInit(pSceneItem);
+
+    return pSceneItem;
+}
+//---------------------------------------------------------------------------
+void csrSceneItemContentRelease(CSR_SceneItem*       pSceneItem,
+                          const CSR_fOnDeleteTexture fOnDeleteTexture)
+{
+    // no scene item to release?
+    if (!pSceneItem)
+        return;
+
+    // release the model
+    csrSceneModelRelease(pSceneItem->m_pModel, pSceneItem->m_Type, fOnDeleteTexture);
+
+    // release the levels of detail
+    if (pSceneItem->m_pLOD)
+    {
+        size_t i;
+
+        // release the level models
+        for (i = 0; i < pSceneItem->m_pLOD->m_Count; ++i)
+            csrSceneModelRelease(pSceneItem->m_pLOD->m_pLevel[i].m_pModel,
+                                 pSceneItem->m_Type,
+                                 fOnDeleteTexture);
+
+        free(pSceneItem->m_pLOD->m_pLevel);
+        free(pSceneItem->m_pLOD->m_pState);
+        free(pSceneItem->m_pLOD);
+    }
+
+    // release the aligned-axis bounding box tree
+    if (pSceneItem->m_pAABBTree)
+    {
+        size_t i;
+
+        // release all the tree content
+        for (i = 0; i < pSceneItem->m_AABBTreeCount; ++i)
+        {
+            // get the AABB tree root node
+            CSR_AABBNode* pNode = &pSceneItem->m_pAABBTree[i];
+
+            // release all children on left side
+            if (pNode->m_pLeft)
+                csrAABBTreeNodeRelease(pNode->m_pLeft);
+
+            // release all children on right side
+            if (pNode->m_pRight)
+                csrAABBTreeNodeRelease(pNode->m_pRight);
+
+            // delete node content
+            csrAABBTreeNodeContentRelease(pNode);
+        }
+
+        // free the tree container
+        free(pSceneItem->m_pAABBTree);
+    }
+
+    // release the matrix array
+    csrArrayRelease(pSceneItem->m_pMatrixArray);
+
+    // free the instance handles. NOTE the handles themselves are released by the scene
+    free(pSceneItem->m_pInstanceHandle);
+
+    // free the occluder
+    free(pSceneItem->m_Occluder.m_pPolygon);
+
+    // free the batch ranges
+    if (pSceneItem->m_pBatch)
+    {
+        free(pSceneItem->m_pBatch->m_pRange);
+        free(pSceneItem->m_pBatch);
+    }
+
+    // NOTE don't release the shader, as it's just linked with the item, not owned
+}
+//---------------------------------------------------------------------------
+void csrSceneItemInit(CSR_SceneItem* pSceneItem)
+{
+    // no scene item to initialize?
+    if (!pSceneItem)
+        return;
+
+    // initialize the scene item
+    pSceneItem->m_pModel              = 0;
+    pSceneItem->m_Type                = CSR_MT_Model;
+    pSceneItem->m_CollisionType       = CSR_CO_None;
+    pSceneItem->m_pMatrixArray        = 0;
+    pSceneItem->m_pAABBTree           = 0;
+    pSceneItem->m_AABBTreeCount       = 0;
+    pSceneItem->m_AABBTreeIndex       = 0;
+    pSceneItem->m_HasBox              = 0;
+    pSceneItem->m_Handle              = 0;
+    pSceneItem->m_pInstanceHandle     = 0;
+    pSceneItem->m_InstanceHandleCount = 0;
+    pSceneItem->m_pLOD                = 0;
+    pSceneItem->m_Occluder.m_pPolygon = 0;
+    pSceneItem->m_Occluder.m_Count    = 0;
+    pSceneItem->m_Static              = 0;
+    pSceneItem->m_pBatch              = 0;
+    pSceneItem->m_pIndex              = 0;
+    memset(&pSceneItem->m_Box, 0, sizeof(CSR_Box));
+}
+//---------------------------------------------------------------------------
+void csrSceneItemUpdateBox(CSR_SceneItem* pSceneItem)
+{
+    size_t i;
+    int    empty = 1;
+
+    // no scene item?
+    if (!pSceneItem)
+        return;
+
+    // extend the box to all the meshes the model may show
+    if (pSceneItem->m_pModel)
+        switch (pSceneItem->m_Type)
+        {
+            case CSR_MT_Mesh:
+                csrMeshExtendBox((const CSR_Mesh*)pSceneItem->m_pModel, &pSceneItem->m_Box, &empty);
+                break;
+
+            case CSR_MT_Model:
+            {
+                const CSR_Model* pModel = (const CSR_Model*)pSceneItem->m_pModel;
+
+                for (i = 0; i < pModel->m_MeshCount; ++i)
+                    csrMeshExtendBox(&pModel->m_pMesh[i], &pSceneItem->m_Box, &empty);
+
+                break;
+            }
+
+            case CSR_MT_MDL:
+            {
+                size_t j;
+
+                const CSR_MDL* pMDL = (const CSR_MDL*)pSceneItem->m_pModel;
+
+                // NOTE all the frames are considered, thus the box remains valid while animated
+                for (i = 0; i < pMDL->m_ModelCount; ++i)
+                    for (j = 0; j < pMDL->m_pModel[i].m_MeshCount; ++j)
+                        csrMeshExtendBox(&pMDL->m_pModel[i].m_pMesh[j], &pSceneItem->m_Box, &empty);
+
+                break;
+            }
+
+            default:
+                break;
+        }
+
+    pSceneItem->m_HasBox = !empty;
+}
+//---------------------------------------------------------------------------
+int csrSceneItemAddLOD(CSR_SceneItem* pSceneItem, void* pModel, float distance)
+{
+    size_t        i;
+    CSR_SceneLOD* pLevel;
+
+    // validate the inputs
+    if (!pSceneItem || distance < 0.0f)
+        return 0;
+
+    // do create the level of detail group?
+    if (!pSceneItem->m_pLOD)
+    {
+        pSceneItem->m_pLOD = (CSR_SceneLODGroup*)malloc(sizeof(CSR_SceneLODGroup));
+
+        // succeeded?
+        if (!pSceneItem->m_pLOD)
+            return 0;
+
+        pSceneItem->m_pLOD->m_pLevel     = 0;
+        pSceneItem->m_pLOD->m_Count      = 0;
+        pSceneItem->m_pLOD->m_Hysteresis = 0.1f;
+        pSceneItem->m_pLOD->m_pState     = 0;
+        pSceneItem->m_pLOD->m_StateCount = 0;
+    }
+
+    // the level index should fit in a level state
+    if (pSceneItem->m_pLOD->m_Count >= 0xFE)
+        return 0;
+
+    // add a new level
+    pLevel = (CSR_SceneLOD*)csrMemoryAlloc(pSceneItem->m_pLOD->m_pLevel,
+                                           sizeof(CSR_SceneLOD),
+                                           pSceneItem->m_pLOD->m_Count + 1);
+
+    // succeeded?
+    if (!pLevel)
+        return 0;
+
+    pSceneItem->m_pLOD->m_pLevel = pLevel;
+
+    // keep the levels sorted by ascending distance
+    for (i = pSceneItem->m_pLOD->m_Count; i > 0 && pLevel[i - 1].m_Distance > distance; --i)
+        pLevel[i] = pLevel[i - 1];
+
+    pLevel[i].m_pModel   = pModel;
+    pLevel[i].m_Distance = distance;
+    ++pSceneItem->m_pLOD->m_Count;
+
+    // the instance levels should be selected again
+    if (pSceneItem->m_pLOD->m_pState)
+        memset(pSceneItem->m_pLOD->m_pState, 0xFF, pSceneItem->m_pLOD->m_StateCount);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneItemSetOccluder(CSR_SceneItem* pSceneItem, const CSR_Mesh* pOccluder)
+{
+    size_t                    i;
+    CSR_IndexedPolygonBuffer* pIPB;
+
+    // no scene item?
+    if (!pSceneItem)
+        return 0;
+
+    // release the previous occluder
+    free(pSceneItem->m_Occluder.m_pPolygon);
+    pSceneItem->m_Occluder.m_pPolygon = 0;
+    pSceneItem->m_Occluder.m_Count    = 0;
+
+    // no longer any occluder?
+    if (!pOccluder)
+        return 1;
+
+    // get the occluder polygons
+    pIPB = csrIndexedPolygonBufferFromMesh(pOccluder);
+
+    // succeeded?
+    if (!pIPB)
+        return 0;
+
+    // empty occluder?
+    if (!pIPB->m_Count)
+    {
+        csrIndexedPolygonBufferRelease(pIPB);
+        return 1;
+    }
+
+    pSceneItem->m_Occluder.m_pPolygon = (CSR_Polygon3*)malloc(pIPB->m_Count * sizeof(CSR_Polygon3));
+
+    // succeeded?
+    if (!pSceneItem->m_Occluder.m_pPolygon)
+    {
+        csrIndexedPolygonBufferRelease(pIPB);
+        return 0;
+    }
+
+    // copy the polygons, thus the occluder no longer depends on the mesh
+    for (i = 0; i < pIPB->m_Count; ++i)
+        if (csrIndexedPolygonToPolygon(&pIPB->m_pIndexedPolygon[i],
+                                       &pSceneItem->m_Occluder.m_pPolygon[pSceneItem->m_Occluder.m_Count]))
+            ++pSceneItem->m_Occluder.m_Count;
+
+    csrIndexedPolygonBufferRelease(pIPB);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrSceneItemDraw(const CSR_Scene*        pScene,
+                      const CSR_SceneContext* pContext,
+                      const CSR_SceneItem*    pItem)
+{
+    CSR_Frustum       frustum;
+    CSR_SceneDrawList drawList;
+
+    // validate the inputs
+    if (!pScene || !pContext || !pItem)
+        return;
+
+    // get the scene view frustum
+    csrSceneGetFrustum(pScene, &frustum);
+
+    csrSceneDrawListInit(&drawList);
+
+    // prepare the item to draw, and draw it
+    if (csrSceneDrawListAdd(pScene, pContext, pItem, 1, &frustum, &drawList))
+        csrSceneDrawListSubmit(pScene, pContext, &drawList);
+
+    csrSceneDrawListContentRelease(&drawList);
+}
+//---------------------------------------------------------------------------
+void csrSceneItemDetectCollision(const CSR_Scene*                   pScene,
+                                 const CSR_SceneItem*               pSceneItem,
+                                 const CSR_CollisionInput*          pCollisionInput,
+                                       CSR_CollisionOutput*         pCollisionOutput,
+                                       CSR_fOnCustomDetectCollision fOnCustomDetectCollision)
+{
+    size_t      i;
+    CSR_Vector3 rayPos;
+    CSR_Vector3 rayDir;
+    CSR_Vector3 rayDirN;
+    CSR_Sphere  sphere;
+
+    // validate the inputs
+    if (!pScene || !pSceneItem || !pCollisionInput || !pCollisionOutput)
+        return;
+
+    // can detect collision on this model?
+    if (!(pSceneItem->m_CollisionType & CSR_CO_Custom) &&
+         (pSceneItem->m_CollisionType == CSR_CO_None   ||
+         !pSceneItem->m_pMatrixArray                   ||
+         !pSceneItem->m_pMatrixArray->m_Count          ||
+         !pSceneItem->m_AABBTreeCount                  ||
+          pSceneItem->m_AABBTreeIndex >= pSceneItem->m_AABBTreeCount))
+        return;
+
+    // copy the sphere radius
+    sphere.m_Radius = pCollisionInput->m_BoundingSphere.m_Radius;
+
+    // iterate through each model position
+    for (i = 0; i < pSceneItem->m_pMatrixArray->m_Count; ++i)
+    {
+        CSR_Matrix4 invertMatrix;
+        float       determinant;
+
+        // inverse the model matrix
+        csrMat4Inverse(&((CSR_Matrix4*)pSceneItem->m_pMatrixArray->m_pItem->m_pData)[i],
+                       &invertMatrix,
+                       &determinant);
+
+        // let the caller process custom collisions if required
+        if (fOnCustomDetectCollision && pSceneItem->m_CollisionType & CSR_CO_Custom)
+        {
+            if (fOnCustomDetectCollision(pScene,
+                                         pSceneItem,
+                                         i,
+                                        &invertMatrix,
+                                         pCollisionInput,
+                                         pCollisionOutput))
+                continue;
+
+            // because not checked above, to prevent that stupid things happen...
+            if (!pSceneItem->m_AABBTreeCount || pSceneItem->m_AABBTreeIndex >= pSceneItem->m_AABBTreeCount)
+                continue;
+        }
+
+        // put the bounding sphere into the model coordinate system (at the location where the
+        // collision should be checked)
+        csrMat4Transform(&invertMatrix, &pCollisionInput->m_CheckPos, &sphere.m_Center);
+
+        // do detect the ground collision on this model?
+        if (pSceneItem->m_CollisionType & CSR_CO_Ground)
+        {
+            CSR_Polygon3 groundPolygon;
+            float        posY;
+
+            // calculate the y position where to place the point of view
+            if (csrGroundPosY(&sphere,
+                              &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
+                              &pScene->m_GroundDir,
+                              &groundPolygon,
+                              &posY))
+            {
+                CSR_Plane   polygonPlane;
+                CSR_Matrix4 transposedMatrix;
+
+                // notify that a ground collision happened
+                pCollisionOutput->m_Collision |= CSR_CO_Ground;
+
+                // set the new ground position
+                pCollisionOutput->m_GroundPos = posY;
+
+                // calculate and set the new ground plane
+                csrPlaneFromPoints(&groundPolygon.m_Vertex[0],
+                                   &groundPolygon.m_Vertex[1],
+                                   &groundPolygon.m_Vertex[2],
+                                   &polygonPlane);
+                csrMat4Transpose(&invertMatrix, &transposedMatrix);
+                csrPlaneTransform(&polygonPlane, &transposedMatrix, &pCollisionOutput->m_GroundPlane);
+            }
+        }
+
+        // do detect the edge collision on this model?
+        if (pSceneItem->m_CollisionType & CSR_CO_Edge)
+        {
+            CSR_Vector3  motionDir;
+            CSR_Vector3  motionDirN;
+            CSR_Ray3     motionRay;
+            CSR_Polygon3 edgePolygon;
+            CSR_Plane    edgePlane;
+            CSR_Matrix4  transposedMatrix;
+
+            // calculate the motion ray and put it into the model coordinate system
+            csrVec3Sub(&pCollisionInput->m_CheckPos, &pCollisionInput->m_BoundingSphere.m_Center, &motionDir);
+            csrVec3Normalize(&motionDir, &motionDirN);
+            csrMat4ApplyToVector(&invertMatrix, &pCollisionInput->m_BoundingSphere.m_Center, &rayPos);
+            csrMat4ApplyToNormal(&invertMatrix, &motionDir, &rayDir);
+            csrVec3Normalize(&rayDir, &rayDirN);
+            csrRay3FromPointDir(&rayPos, &rayDirN, &motionRay);
+
+            // 1. detect if the motion ray intersects one of the polygon. If yes the detection is terminated
+            // 2. detect if the sphere intersects one of the polygon
+
+            // FIXME the motion ray isn't checked yet, thus a fast moving sphere may cross a polygon
+
+            // check if the sphere, at the location where the collision should be checked, hits one
+            // of the model polygons
+            if (csrAABBTreeSphereHit(&sphere,
+                                     &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
+                                     &edgePolygon,
+                                     &edgePlane))
+            {
+                // notify that an edge collision happened
+                pCollisionOutput->m_Collision |= CSR_CO_Edge;
+
+                // put the sliding plane back into the scene coordinate system
+                csrMat4Transpose(&invertMatrix, &transposedMatrix);
+                csrPlaneTransform(&edgePlane, &transposedMatrix, &pCollisionOutput->m_CollisionPlane);
+            }
+        }
+
+        // do detect the mouse collision on this model?
+        if (pSceneItem->m_CollisionType & CSR_CO_Mouse)
+        {
+            CSR_Ray3      mouseRay;
+            CSR_HitModel* pHitModel;
+
+            // put the mouse ray into the model coordinate system
+            csrMat4ApplyToVector(&invertMatrix, &pCollisionInput->m_MouseRay.m_Pos, &rayPos);
+            csrMat4ApplyToNormal(&invertMatrix, &pCollisionInput->m_MouseRay.m_Dir, &rayDir);
+            csrVec3Normalize(&rayDir, &rayDirN);
+            csrRay3FromPointDir(&rayPos, &rayDirN, &mouseRay);
+
+            // create a new hit model container, if required
+            if (!pCollisionOutput->m_pHitModel)
+                pCollisionOutput->m_pHitModel = csrArrayCreate();
+
+            // create a new hit model
+            pHitModel = csrHitModelCreate();
+
+            // succeeded?
+            if (!pHitModel)
+                continue;
+
+            // using the mouse ray, resolve aligned-axis bounding box tree
+            csrAABBTreeResolve(&mouseRay,
+                               &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
+                                0,
+                               &pHitModel->m_Polygons);
+
+            // found a collision with the mouse ray?
+            if (pHitModel->m_Polygons.m_Count)
+            {
+                // notify that a mouse collision happened
+                pCollisionOutput->m_Collision |= CSR_CO_Mouse;
+
+                // populate the hit model structure
+                pHitModel->m_pModel    = pSceneItem->m_pModel;
+                pHitModel->m_Type      = pSceneItem->m_Type;
+                pHitModel->m_Matrix    = ((CSR_Matrix4*)pSceneItem->m_pMatrixArray->m_pItem->m_pData)[i];
+                pHitModel->m_pAABBTree = &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex];
+
+                // add the hit model structure in the array
+                csrArrayAdd(pHitModel, pCollisionOutput->m_pHitModel, 0);
+            }
+            else
+            {
+                // no found collision, release the hit model
+                csrHitModelRelease(pHitModel);
+            }
+        }
+    }
+}
+//---------------------------------------------------------------------------
+// Scene draw list functions
+//---------------------------------------------------------------------------
+void csrSceneDrawListInit(CSR_SceneDrawList* pList)
+{
+    size_t i;
+
+    // no draw list to initialize?
+    if (!pList)
+        return;
+
+    pList->m_pCommand    = 0;
+    pList->m_Count       = 0;
+    pList->m_Size        = 0;
+    pList->m_pMatrix     = 0;
+    pList->m_MatrixCount = 0;
+    pList->m_MatrixSize  = 0;
+    pList->m_pLevel      = 0;
+    pList->m_LevelSize   = 0;
+    pList->m_pSortItem   = 0;
+    pList->m_SortSize    = 0;
+
+    for (i = 0; i < 3; ++i)
+    {
+        pList->m_Rank[i].m_pKey  = 0;
+        pList->m_Rank[i].m_pRank = 0;
+        pList->m_Rank[i].m_Size  = 0;
+        pList->m_Rank[i].m_Count = 0;
+    }
+}
+//---------------------------------------------------------------------------
+void csrSceneDrawListContentRelease(CSR_SceneDrawList* pList)
+{
+    size_t i;
+
+    // no draw list to release?
+    if (!pList)
+        return;
+
+    // free the commands and their visible instance lists. NOTE the matrices are only linked, thus
+    // they aren't freed
+    free(pList->m_pCommand);
+    free(pList->m_pMatrix);
+    free(pList->m_pLevel);
+    free(pList->m_pSortItem);
+
+    for (i = 0; i < 3; ++i)
+        csrSceneRankTableRelease(&pList->m_Rank[i]);
+
+    csrSceneDrawListInit(pList);
+}
+//---------------------------------------------------------------------------
+void csrSceneDrawListClear(CSR_SceneDrawList* pList)
+{
+    // no draw list to clear?
+    if (!pList)
+        return;
+
+    pList->m_Count       = 0;
+    pList->m_MatrixCount = 0;
+}
+//---------------------------------------------------------------------------
+int csrSceneDrawListAdd(const CSR_Scene*         pScene,
+                        const CSR_SceneContext*  pContext,
+                        const CSR_SceneItem*     pItems,
+                              size_t             count,
+                        const CSR_Frustum*       pFrustum,
+                              CSR_SceneDrawList* pList)
+{
+    size_t first;
+
+    // validate the inputs
+    if (!pList)
+        return 0;
+
+    first = pList->m_Count;
+
+    // prepare the items
+    if (!csrSceneDrawListAddItems(pScene, pContext, pItems, count, pFrustum, pList))
+        return 0;
+
+    // get the indexes to draw the added items with
+    csrSceneDrawListGetIndexes(pContext, pList, first);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneDrawListSort(const CSR_SceneContext* pContext, CSR_SceneDrawList* pList)
+{
+    size_t                i;
+    size_t                j;
+    size_t                k;
+    CSR_SortItem*         pSortItems;
+    CSR_SceneDrawCommand  command;
+
+    // validate the inputs
+    if (!pContext || !pList)
+        return 0;
+
+    // nothing to sort?
+    if (pList->m_Count < 2)
+        return 1;
+
+    // grow the sort keys if required
+    if (pList->m_Count > pList->m_SortSize)
+    {
+        pSortItems = (CSR_SortItem*)csrMemoryAlloc(pList->m_pSortItem, sizeof(CSR_SortItem), pList->m_Size);
+
+        // succeeded?
+        if (!pSortItems)
+            return 0;
+
+        pList->m_pSortItem = pSortItems;
+        pList->m_SortSize  = pList->m_Size;
+    }
+
+    pSortItems = pList->m_pSortItem;
+
+    // empty the rank tables. NOTE if a table cannot be allocated, all its keys share the same
+    // rank, thus the list is still sorted, only less finely
+    csrSceneRankTableReset(&pList->m_Rank[0], pList->m_Count < 0x100  ? pList->m_Count : 0x100);
+    csrSceneRankTableReset(&pList->m_Rank[1], pList->m_Count < 0x1000 ? pList->m_Count : 0x1000);
+    csrSceneRankTableReset(&pList->m_Rank[2], pList->m_Count < 0x100  ? pList->m_Count : 0x100);
+
+    // build the sort keys. The most expensive state changes are placed in the highest bits, i.e.
+    // the shader (31-24), then the texture (23-12), then the material states (11-8), and finally
+    // the model (7-0). The shaders, textures and models are ranked in the order they are first
+    // met, which is enough to group them
+    for (i = 0; i < pList->m_Count; ++i)
+    {
+        CSR_SceneDrawCommand* pCommand = &pList->m_pCommand[i];
+        const void*           pTexture = csrSceneDrawCommandGetTextureKey(pContext, pCommand);
+
+        pCommand->m_Key = (csrSceneRankTableGet(&pList->m_Rank[0], pCommand->m_pShader, 0xFF)  << 24) |
+                          (csrSceneRankTableGet(&pList->m_Rank[1], pTexture,            0xFFF) << 12) |
+                          (csrSceneDrawCommandGetStateKey(pCommand)                            <<  8) |
+                           csrSceneRankTableGet(&pList->m_Rank[2], pCommand->m_pModel,  0xFF);
+
+        pSortItems[i].m_Key   = pCommand->m_Key;
+        pSortItems[i].m_Index = i;
+    }
+
+    // sort the keys
+    if (!csrRadixSort(pSortItems, pList->m_Count))
+        return 0;
+
+    // reorder the commands in place, by following the permutation cycles. Each command reaching
+    // its location is marked by setting its sort index to this location
+    for (i = 0; i < pList->m_Count; ++i)
+    {
+        // already in place?
+        if (pSortItems[i].m_Index == i)
+            continue;
+
+        command = pList->m_pCommand[i];
+        j       = i;
+
+        for (;;)
+        {
+            k                     = pSortItems[j].m_Index;
+            pSortItems[j].m_Index = j;
+
+            // cycle closed?
+            if (k == i)
+                break;
+
+            pList->m_pCommand[j] = pList->m_pCommand[k];
+            j                    = k;
+        }
+
+        pList->m_pCommand[j] = command;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneDrawListPrepare(const CSR_Scene*         pScene,
+                            const CSR_SceneContext*  pContext,
+                            const CSR_SceneItem*     pItems,
+                                  size_t             count,
+                            const CSR_Frustum*       pFrustum,
+                                  CSR_SceneDrawList* pList)
+{
+    size_t            i;
+    size_t            jobCount;
+    size_t            jobIndex;
+    size_t            instanceCount;
+    size_t            total;
+    size_t            sum;
+    size_t            first;
+    int               success;
+    CSR_SceneDrawJob* pJobs;
+    void**            ppJobs;
+
+    // validate the inputs
+    if (!pScene || !pContext || !pList)
+        return 0;
+
+    jobCount = pContext->m_JobCount;
+
+    // no more jobs than items
+    if (jobCount > count)
+        jobCount = count;
+
+    // nothing to run in parallel?
+    if (!pContext->m_fOnRunJobs || jobCount < 2)
+        return csrSceneDrawListAdd(pScene, pContext, pItems, count, pFrustum, pList);
+
+    pJobs  = (CSR_SceneDrawJob*)malloc(jobCount * sizeof(CSR_SceneDrawJob));
+    ppJobs = (void**)           malloc(jobCount * sizeof(void*));
+
+    // succeeded?
+    if (!pJobs || !ppJobs)
+    {
+        free(pJobs);
+        free(ppJobs);
+
+        // prepare the items on the calling thread
+        return csrSceneDrawListAdd(pScene, pContext, pItems, count, pFrustum, pList);
+    }
+
+    total = 0;
+
+    // count the instances to prepare. NOTE an item without matrix is prepared once
+    for (i = 0; i < count; ++i)
+        if (pItems[i].m_pMatrixArray && pItems[i].m_pMatrixArray->m_Count)
+            total += pItems[i].m_pMatrixArray->m_Count;
+        else
+            ++total;
+
+    // initialize the jobs
+    for (i = 0; i < jobCount; ++i)
+    {
+        pJobs[i].m_pScene   = pScene;
+        pJobs[i].m_pContext = pContext;
+        pJobs[i].m_pItems   = 0;
+        pJobs[i].m_Count    = 0;
+        pJobs[i].m_pFrustum = pFrustum;
+        pJobs[i].m_Success  = 0;
+        csrSceneDrawListInit(&pJobs[i].m_List);
+
+        ppJobs[i] = &pJobs[i];
+    }
+
+    jobIndex = 0;
+    sum      = 0;
+
+    // split the items in contiguous ranges containing about the same instance count
+    for (i = 0; i < count; ++i)
+    {
+        if (pItems[i].m_pMatrixArray && pItems[i].m_pMatrixArray->m_Count)
+            instanceCount = pItems[i].m_pMatrixArray->m_Count;
+        else
+            instanceCount = 1;
+
+        // is the current job full?
+        if (jobIndex + 1 < jobCount && pJobs[jobIndex].m_Count &&
+            sum + instanceCount > ((jobIndex + 1) * total) / jobCount)
+            ++jobIndex;
+
+        if (!pJobs[jobIndex].m_Count)
+            pJobs[jobIndex].m_pItems = &pItems[i];
+
+        ++pJobs[jobIndex].m_Count;
+        sum += instanceCount;
+    }
+
+    // prepare the items
+    pContext->m_fOnRunJobs(pContext, csrSceneDrawJobExecute, ppJobs, jobIndex + 1);
+
+    success = 1;
+    first   = pList->m_Count;
+
+    // gather the prepared items, in the scene order
+    for (i = 0; i < jobCount; ++i)
+    {
+        if (i <= jobIndex && (!pJobs[i].m_Success || !csrSceneDrawListAppend(pList, &pJobs[i].m_List)))
+            success = 0;
+
+        csrSceneDrawListContentRelease(&pJobs[i].m_List);
+    }
+
+    // get the indexes to draw the added items with, from the calling thread
+    csrSceneDrawListGetIndexes(pContext, pList, first);
+
+    free(pJobs);
+    free(ppJobs);
+
+    return success;
+}
+//---------------------------------------------------------------------------
+int csrSceneDrawListAppend(CSR_SceneDrawList* pList, CSR_SceneDrawList* pOther)
+{
+    size_t i;
+
+    // validate the inputs
+    if (!pList || !pOther)
+        return 0;
+
+    // nothing to append?
+    if (!pOther->m_Count)
+        return 1;
+
+    // the other list may simply be moved, if the list owns no memory
+    if (!pList->m_Size && !pList->m_MatrixSize)
+    {
+        csrSceneDrawListContentRelease(pList);
+
+        *pList = *pOther;
+        csrSceneDrawListInit(pOther);
+
+        return 1;
+    }
+
+    // make room for the other list commands and matrices
+    if (!csrSceneDrawListReserve(pList, pOther->m_Count, pOther->m_MatrixCount, 0))
+        return 0;
+
+    // copy the commands, their visible instances are moved after the list ones
+    memcpy(&pList->m_pCommand[pList->m_Count],
+            pOther->m_pCommand,
+            pOther->m_Count * sizeof(CSR_SceneDrawCommand));
+
+    for (i = 0; i < pOther->m_Count; ++i)
+        pList->m_pCommand[pList->m_Count + i].m_VisibleIndex += pList->m_MatrixCount;
+
+    // copy the visible instances
+    if (pOther->m_MatrixCount)
+        memcpy(&pList->m_pMatrix[pList->m_MatrixCount],
+                pOther->m_pMatrix,
+                pOther->m_MatrixCount * sizeof(CSR_ArrayItem));
+
+    pList->m_Count       += pOther->m_Count;
+    pList->m_MatrixCount += pOther->m_MatrixCount;
+
+    // the other list is now empty, but keeps its memory
+    csrSceneDrawListClear(pOther);
+
+    // link the commands to their visible instances
+    csrSceneDrawListLink(pList);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrSceneDrawListSubmit(const CSR_Scene*         pScene,
+                            const CSR_SceneContext*  pContext,
+                            const CSR_SceneDrawList* pList)
+{
+    size_t i;
+    void*  pShader;
+
+    // validate the inputs
+    if (!pScene || !pContext || !pList || !pList->m_Count)
+        return;
+
+    pShader = 0;
+
+    // iterate through the commands to submit
+    for (i = 0; i < pList->m_Count; ++i)
+    {
+        // is the shader changing?
+        if (pList->m_pCommand[i].m_pShader != pShader)
+        {
+            pShader = pList->m_pCommand[i].m_pShader;
+
+            // enable the item shader
+            csrShaderEnable(pShader);
+
+            // connect the projection matrix to shader
+            csrShaderConnectProjectionMatrix(pShader, &pScene->m_ProjectionMatrix);
+
+            // connect the view matrix to shader
+            csrShaderConnectViewMatrix(pShader, &pScene->m_ViewMatrix);
+        }
+
+        // draw the item
+        csrSceneItemSubmitDraw(pScene, pContext, &pList->m_pCommand[i]);
+    }
+
+    // disable the last shader
+    csrShaderEnable(0);
+}
+//---------------------------------------------------------------------------
+// Scene depth list functions
+//---------------------------------------------------------------------------
+void csrSceneDepthListInit(CSR_SceneDepthList* pList)
+{
+    // no depth list to initialize?
+    if (!pList)
+        return;
+
+    pList->m_pInstance = 0;
+    pList->m_pOrder    = 0;
+    pList->m_Count     = 0;
+    pList->m_pVisible  = 0;
+    pList->m_pGroup    = 0;
+    pList->m_Size      = 0;
+}
+//---------------------------------------------------------------------------
+void csrSceneDepthListContentRelease(CSR_SceneDepthList* pList)
+{
+    // no depth list to release?
+    if (!pList)
+        return;
+
+    // free the instances, their order and the scratch arrays. NOTE the matrices are only linked,
+    // thus they aren't freed
+    free(pList->m_pInstance);
+    free(pList->m_pOrder);
+    free(pList->m_pVisible);
+    free(pList->m_pGroup);
+
+    csrSceneDepthListInit(pList);
+}
+//---------------------------------------------------------------------------
+int csrSceneDepthListBuild(const CSR_Scene*          pScene,
+                           const CSR_SceneContext*   pContext,
+                           const CSR_SceneItem*      pItems,
+                                 size_t              count,
+                           const CSR_Frustum*        pFrustum,
+                                 CSR_SceneDepthList* pList)
+{
+    size_t             i;
+    size_t             j;
+    size_t             index;
+    size_t             level;
+    size_t             instanceCount;
+    void*              pShader;
+    CSR_Box            box;
+    CSR_Vector3        viewPos;
+    CSR_Array          visibleArray;
+    CSR_SceneItemIndex itemIndex;
+    CSR_SceneInstance* pInstance;
+    CSR_ArrayItem*     pScratch;
+    const CSR_Array*   pMatrixArray;
+
+    // validate the inputs
+    if (!pScene || !pContext || !pList)
+        return 0;
+
+    instanceCount = 0;
+
+    // count the instances. NOTE an item without matrix is drawn once
+    for (i = 0; i < count; ++i)
+        if (pItems[i].m_pMatrixArray && pItems[i].m_pMatrixArray->m_Count)
+            instanceCount += pItems[i].m_pMatrixArray->m_Count;
+        else
+            ++instanceCount;
+
+    // did the instance count change since the previous frame?
+    if (instanceCount != pList->m_Count)
+    {
+        // the previous order is meaningless, forget it. NOTE the scratch arrays are kept
+        free(pList->m_pInstance);
+        free(pList->m_pOrder);
+
+        pList->m_pInstance = 0;
+        pList->m_pOrder    = 0;
+        pList->m_Count     = 0;
+
+        // nothing to draw?
+        if (!instanceCount)
+            return 1;
+
+        pList->m_pInstance = (CSR_SceneInstance*)malloc(instanceCount * sizeof(CSR_SceneInstance));
+        pList->m_pOrder    = (CSR_SortItem*)     malloc(instanceCount * sizeof(CSR_SortItem));
+
+        // succeeded?
+        if (!pList->m_pInstance || !pList->m_pOrder)
+        {
+            csrSceneDepthListContentRelease(pList);
+            return 0;
+        }
+
+        // start from the scene order
+        for (i = 0; i < instanceCount; ++i)
+            pList->m_pOrder[i].m_Index = i;
+
+        pList->m_Count = instanceCount;
+    }
+
+    // do grow the scratch arrays? NOTE they are never shrunk, thus a scene whose instance count
+    // varies doesn't reallocate them each frame
+    if (pList->m_Size < instanceCount)
+    {
+        pScratch = (CSR_ArrayItem*)csrMemoryAlloc(pList->m_pVisible, sizeof(CSR_ArrayItem), instanceCount);
+
+        // succeeded?
+        if (!pScratch)
+            return 0;
+
+        pList->m_pVisible = pScratch;
+
+        pScratch = (CSR_ArrayItem*)csrMemoryAlloc(pList->m_pGroup, sizeof(CSR_ArrayItem), instanceCount);
+
+        // succeeded?
+        if (!pScratch)
+            return 0;
+
+        pList->m_pGroup = pScratch;
+        pList->m_Size   = instanceCount;
+    }
+
+    csrArrayInit(&visibleArray);
+
+    // if the caller wants to know the visible instances, list them in the scratch array
+    if (pContext->m_fOnVisibleSet)
+        visibleArray.m_pItem = pList->m_pVisible;
+
+    // get the camera position, used to select the levels of detail
+    csrSceneGetViewPosition(pScene, &viewPos);
+
+    index = 0;
+
+    // build the instances
+    for (i = 0; i < count; ++i)
+    {
+        pShader = 0;
+
+        // get the shader to use with the model
+        if (pContext->m_fOnGetShader)
+            pShader = pContext->m_fOnGetShader(pItems[i].m_pModel, pItems[i].m_Type);
+
+        // get the indexes to draw the item with, shared by all its instances
+        csrSceneItemGetIndex(pContext, &pItems[i], &itemIndex);
+
+        pMatrixArray         = pItems[i].m_pMatrixArray;
+        visibleArray.m_Count = 0;
+
+        // keep one level state per instance, to apply the hysteresis
+        if (pItems[i].m_pLOD)
+            csrSceneItemUpdateLODState(&pItems[i]);
+
+        // item without matrix?
+        if (!pMatrixArray || !pMatrixArray->m_Count)
+        {
+            pInstance = &pList->m_pInstance[index];
+            ++index;
+
+            pInstance->m_pItem             = &pItems[i];
+            pInstance->m_pModel            =  pItems[i].m_pModel;
+            pInstance->m_pShader           =  pShader;
+            pInstance->m_Index             =  itemIndex;
+            pInstance->m_Matrix.m_pData    =  0;
+            pInstance->m_Matrix.m_AutoFree =  0;
+            pInstance->m_Visible           = (pShader != 0);
+
+            // notify the caller about the visible instances
+            if (pContext->m_fOnVisibleSet)
+                pContext->m_fOnVisibleSet(pScene, pContext, &pItems[i], pMatrixArray);
+
+            continue;
+        }
+
+        // iterate through the item instances
+        for (j = 0; j < pMatrixArray->m_Count; ++j)
+        {
+            pInstance = &pList->m_pInstance[index];
+            ++index;
+
+            pInstance->m_pItem             = &pItems[i];
+            pInstance->m_pModel            =  pItems[i].m_pModel;
+            pInstance->m_pShader           =  pShader;
+            pInstance->m_Index             =  itemIndex;
+            pInstance->m_Matrix.m_pData    =  pMatrixArray->m_pItem[j].m_pData;
+            pInstance->m_Matrix.m_AutoFree =  0;
+            pInstance->m_Visible           =  1;
+
+            // do cull the instance out of the view frustum?
+            if (pFrustum && pItems[i].m_HasBox)
+            {
+                // put the model box in the world coordinates system
+                csrBoxTransform(&pItems[i].m_Box, (const CSR_Matrix4*)pInstance->m_Matrix.m_pData, &box);
+
+                pInstance->m_Visible = csrFrustumIntersectBox(pFrustum, &box) &&
+                                       csrSceneOcclusionBufferIsVisible(pContext->m_pOcclusionBuffer, &box);
+            }
+
+            // select the instance level of detail. NOTE the instances using a level without model
+            // are no longer drawn
+            if (pInstance->m_Visible && pItems[i].m_pLOD)
+            {
+                level = csrSceneItemSelectLOD(&pItems[i],
+                                               j,
+                                              (const CSR_Matrix4*)pInstance->m_Matrix.m_pData,
+                                              &viewPos);
+
+                pInstance->m_pModel = csrSceneItemGetLODModel(&pItems[i], level);
+
+                if (!pInstance->m_pModel)
+                    pInstance->m_Visible = 0;
+            }
+
+            // list the visible instances for the caller, once their level of detail is known
+            if (pInstance->m_Visible && visibleArray.m_pItem)
+            {
+                visibleArray.m_pItem[visibleArray.m_Count] = pInstance->m_Matrix;
+                ++visibleArray.m_Count;
+            }
+
+            // an instance without shader cannot be drawn
+            if (!pShader)
+                pInstance->m_Visible = 0;
+        }
+
+        // notify the caller about the visible instances
+        if (pContext->m_fOnVisibleSet)
+            pContext->m_fOnVisibleSet(pScene,
+                                      pContext,
+                                     &pItems[i],
+                                      visibleArray.m_pItem ? &visibleArray : pMatrixArray);
+    }
+
+    // update the depth keys, the hidden instances are moved to the list end
+    for (i = 0; i < pList->m_Count; ++i)
+    {
+        pInstance = &pList->m_pInstance[pList->m_pOrder[i].m_Index];
+
+        if (pInstance->m_Visible)
+            pList->m_pOrder[i].m_Key = csrSceneDepthToKey(csrSceneInstanceGetDepth(&pScene->m_ViewMatrix,
+                                                                                  pInstance));
+        else
+            pList->m_pOrder[i].m_Key = 0xFFFFFFFF;
+    }
+
+    // sort the instances from the farthest to the nearest
+    return csrSceneDepthListSort(pList->m_pOrder, pList->m_Count);
+}
+//---------------------------------------------------------------------------
+void csrSceneDepthListSubmit(const CSR_Scene*          pScene,
+                             const CSR_SceneContext*   pContext,
+                             const CSR_SceneDepthList* pList)
+{
+    size_t                   i;
+    void*                    pShader;
+    CSR_ArrayItem*           pMatrices;
+    CSR_SceneDrawCommand     command;
+    const CSR_SceneInstance* pInstance;
+    const CSR_SceneInstance* pNext;
+
+    // validate the inputs
+    if (!pScene || !pContext || !pList || !pList->m_Count)
+        return;
+
+    // the instance matrices are grouped in the scratch array reserved while the list was built.
+    // Not reserved, or too small? The list wasn't successfully built
+    if (!pList->m_pGroup || pList->m_Size < pList->m_Count)
+        return;
+
+    pMatrices = pList->m_pGroup;
+
+    pShader = 0;
+    i       = 0;
+
+    // iterate through the instances to draw, from the farthest to the nearest
+    while (i < pList->m_Count)
+    {
+        pInstance = &pList->m_pInstance[pList->m_pOrder[i].m_Index];
+
+        // hidden instance?
+        if (!pInstance->m_Visible)
+        {
+            ++i;
+            continue;
+        }
+
+        // is the shader changing?
+        if (pInstance->m_pShader != pShader)
+        {
+            pShader = pInstance->m_pShader;
+
+            // enable the item shader
+            csrShaderEnable(pShader);
+
+            // connect the projection matrix to shader
+            csrShaderConnectProjectionMatrix(pShader, &pScene->m_ProjectionMatrix);
+
+            // connect the view matrix to shader
+            csrShaderConnectViewMatrix(pShader, &pScene->m_ViewMatrix);
+        }
+
+        command.m_pItem                = pInstance->m_pItem;
+        command.m_pModel               = pInstance->m_pModel;
+        command.m_pShader              = pShader;
+        command.m_Index                = pInstance->m_Index;
+        command.m_VisibleArray.m_pItem = pMatrices;
+        command.m_VisibleArray.m_Count = 0;
+        command.m_VisibleIndex         = 0;
+        command.m_Key                  = 0;
+
+        // item without matrix?
+        if (!pInstance->m_Matrix.m_pData)
+        {
+            command.m_Culled = 0;
+            ++i;
+        }
+        else
+        {
+            command.m_Culled = 1;
+
+            // group the following instances of the same item, they can be drawn together without
+            // breaking the drawing order
+            do
+            {
+                pMatrices[command.m_VisibleArray.m_Count] = pInstance->m_Matrix;
+                ++command.m_VisibleArray.m_Count;
+                ++i;
+
+                if (i >= pList->m_Count)
+                    break;
+
+                pNext = &pList->m_pInstance[pList->m_pOrder[i].m_Index];
+
+                if (!pNext->m_Visible || pNext->m_pItem != pInstance->m_pItem || pNext->m_pModel != pInstance->m_pModel)
+                    break;
+            }
+            while (1);
+        }
+
+        // draw the instances
+        csrSceneItemSubmitDraw(pScene, pContext, &command);
+    }
+
+    // disable the last shader
+    csrShaderEnable(0);
+}
+//---------------------------------------------------------------------------
+// Scene occlusion buffer functions
+//---------------------------------------------------------------------------
+int csrSceneOcclusionBufferInit(size_t width, size_t height, CSR_SceneOcclusionBuffer* pOB)
+{
+    // no occlusion buffer to initialize?
+    if (!pOB)
+        return 0;
+
+    csrMat4Identity(&pOB->m_ViewProjMatrix);
+    pOB->m_PolygonCount = 0;
+
+    // create the depth buffer
+    if (!csrDepthBufferInit(width, height, &pOB->m_DepthBuffer))
+    {
+        pOB->m_DepthBuffer.m_pData = 0;
+        return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrSceneOcclusionBufferContentRelease(CSR_SceneOcclusionBuffer* pOB)
+{
+    // no occlusion buffer to release?
+    if (!pOB)
+        return;
+
+    // free the depth data
+    free(pOB->m_DepthBuffer.m_pData);
+
+    pOB->m_DepthBuffer.m_pData  = 0;
+    pOB->m_DepthBuffer.m_Width  = 0;
+    pOB->m_DepthBuffer.m_Height = 0;
+    pOB->m_DepthBuffer.m_Size   = 0;
+    pOB->m_PolygonCount         = 0;
+}
+//---------------------------------------------------------------------------
+int csrSceneOcclusionBufferBuild(const CSR_Scene* pScene, CSR_SceneOcclusionBuffer* pOB)
+{
+    size_t               i;
+    size_t               j;
+    size_t               k;
+    CSR_Matrix4          matrix;
+    const CSR_Array*     pMatrixArray;
+    const CSR_SceneItem* pItem;
+
+    // validate the inputs
+    if (!pScene || !pOB || !pOB->m_DepthBuffer.m_pData)
+        return 0;
+
+    // the occluders are rasterized with the scene matrices
+    csrMat4Multiply(&pScene->m_ViewMatrix, &pScene->m_ProjectionMatrix, &pOB->m_ViewProjMatrix);
+
+    // clear the buffer to the far plane depth, in normalized device coordinates
+    csrDepthBufferClear(&pOB->m_DepthBuffer, 1.0f);
+    pOB->m_PolygonCount = 0;
+
+    // iterate through the opaque items. NOTE a transparent item hides nothing
+    for (i = 0; i < pScene->m_ItemCount; ++i)
+    {
+        pItem        = &pScene->m_pItem[i];
+        pMatrixArray =  pItem->m_pMatrixArray;
+
+        // no occluder, or no known location to draw it?
+        if (!pItem->m_Occluder.m_Count || !pMatrixArray)
+            continue;
+
+        // rasterize the occluder on each item instance
+        for (j = 0; j < pMatrixArray->m_Count; ++j)
+        {
+            csrMat4Multiply((const CSR_Matrix4*)pMatrixArray->m_pItem[j].m_pData,
+                            &pOB->m_ViewProjMatrix,
+                            &matrix);
+
+            for (k = 0; k < pItem->m_Occluder.m_Count; ++k)
+                if (csrSceneOcclusionRasterizePolygon(&pItem->m_Occluder.m_pPolygon[k],
+                                                      &matrix,
+                                                      &pOB->m_DepthBuffer))
+                    ++pOB->m_PolygonCount;
+        }
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneOcclusionBufferIsVisible(const CSR_SceneOcclusionBuffer* pOB, const CSR_Box* pBox)
+{
+    size_t      i;
+    int         x;
+    int         y;
+    int         xMin;
+    int         yMin;
+    int         xMax;
+    int         yMax;
+    float       zMin;
+    CSR_Rect    rect;
+    CSR_Vector3 corner;
+    CSR_Vector3 projected;
+
+    // nothing can hide the box?
+    if (!pOB || !pBox || !pOB->m_PolygonCount || !pOB->m_DepthBuffer.m_pData)
+        return 1;
+
+    // project the box corners, and keep their bounding rect and nearest depth
+    for (i = 0; i < 8; ++i)
+    {
+        corner.m_X = (i & 1) ? pBox->m_Max.m_X : pBox->m_Min.m_X;
+        corner.m_Y = (i & 2) ? pBox->m_Max.m_Y : pBox->m_Min.m_Y;
+        corner.m_Z = (i & 4) ? pBox->m_Max.m_Z : pBox->m_Min.m_Z;
+
+        // a box crossing the near plane may be visible from anywhere on the screen
+        if (!csrSceneOcclusionProject(&pOB->m_ViewProjMatrix, &corner, &pOB->m_DepthBuffer, &projected))
+            return 1;
+
+        if (!i)
+        {
+            rect.m_Min.m_X = projected.m_X;
+            rect.m_Min.m_Y = projected.m_Y;
+            rect.m_Max.m_X = projected.m_X;
+            rect.m_Max.m_Y = projected.m_Y;
+            zMin           = projected.m_Z;
+            continue;
+        }
+
+        csrMathMin(rect.m_Min.m_X, projected.m_X, &rect.m_Min.m_X);
+        csrMathMin(rect.m_Min.m_Y, projected.m_Y, &rect.m_Min.m_Y);
+        csrMathMax(rect.m_Max.m_X, projected.m_X, &rect.m_Max.m_X);
+        csrMathMax(rect.m_Max.m_Y, projected.m_Y, &rect.m_Max.m_Y);
+        csrMathMin(zMin,           projected.m_Z, &zMin);
+    }
+
+    // get the texels the box may cover, extended by one texel, because an occluder may only
+    // partially cover the texels located on its edges
+    xMin = (int)floor(rect.m_Min.m_X) - 1;
+    yMin = (int)floor(rect.m_Min.m_Y) - 1;
+    xMax = (int)floor(rect.m_Max.m_X) + 1;
+    yMax = (int)floor(rect.m_Max.m_Y) + 1;
+
+    // the box is out of the screen, the frustum culling should decide
+    if (xMax < 0 || yMax < 0 ||
+        xMin >= (int)pOB->m_DepthBuffer.m_Width || yMin >= (int)pOB->m_DepthBuffer.m_Height)
+        return 1;
+
+    if (xMin < 0)
+        xMin = 0;
+
+    if (yMin < 0)
+        yMin = 0;
+
+    if (xMax > (int)pOB->m_DepthBuffer.m_Width - 1)
+        xMax = (int)pOB->m_DepthBuffer.m_Width - 1;
+
+    if (yMax > (int)pOB->m_DepthBuffer.m_Height - 1)
+        yMax = (int)pOB->m_DepthBuffer.m_Height - 1;
+
+    // the box is hidden only if an occluder is nearer on all its texels
+    for (y = yMin; y <= yMax; ++y)
+        for (x = xMin; x <= xMax; ++x)
+            if (zMin <= pOB->m_DepthBuffer.m_pData[(y * pOB->m_DepthBuffer.m_Width) + x])
+                return 1;
+
+    return 0;
+}
+//---------------------------------------------------------------------------
+// Transform hierarchy functions
+//---------------------------------------------------------------------------
+void csrTransformHierarchyInit(CSR_TransformHierarchy* pHierarchy)
+{
+    // no hierarchy to initialize?
+    if (!pHierarchy)
+        return;
+
+    pHierarchy->m_pNode        = 0;
+    pHierarchy->m_Count        = 0;
+    pHierarchy->m_FirstDirty   = 0;
+    pHierarchy->m_FirstChanged = 0;
+}
+//---------------------------------------------------------------------------
+void csrTransformHierarchyContentRelease(CSR_TransformHierarchy* pHierarchy)
+{
+    // no hierarchy to release?
+    if (!pHierarchy)
+        return;
+
+    // free the nodes. NOTE the target matrices are only linked, thus they aren't freed
+    free(pHierarchy->m_pNode);
+
+    csrTransformHierarchyInit(pHierarchy);
+}
+//---------------------------------------------------------------------------
+size_t csrTransformHierarchyAdd(      CSR_TransformHierarchy* pHierarchy,
+                                      size_t                  parent,
+                                const CSR_Vector3*            pPosition,
+                                const CSR_Quaternion*         pRotation,
+                                const CSR_Vector3*            pScaling,
+                                      CSR_Matrix4*            pTarget)
+{
+    size_t             index;
+    CSR_TransformNode* pNode;
+
+    // validate the inputs
+    if (!pHierarchy)
+        return (size_t)M_CSR_Unknown_Index;
+
+    // the parent should already exist. This keeps the parents before their children in the list
+    if (parent != (size_t)M_CSR_Unknown_Index && parent >= pHierarchy->m_Count)
+        return (size_t)M_CSR_Unknown_Index;
+
+    // add a new node
+    pNode = (CSR_TransformNode*)csrMemoryAlloc(pHierarchy->m_pNode,
+                                               sizeof(CSR_TransformNode),
+                                               pHierarchy->m_Count + 1);
+
+    // succeeded?
+    if (!pNode)
+        return (size_t)M_CSR_Unknown_Index;
+
+    index               = pHierarchy->m_Count;
+    pHierarchy->m_pNode = pNode;
+    ++pHierarchy->m_Count;
+
+    // configure the node
+    pNode                 = &pHierarchy->m_pNode[index];
+    pNode->m_pTarget      = pTarget;
+    pNode->m_Parent       = parent;
+    pNode->m_Dirty        = 1;
+    pNode->m_WorldChanged = 0;
+
+    if (pPosition)
+        pNode->m_Position = *pPosition;
+    else
+    {
+        pNode->m_Position.m_X = 0.0f;
+        pNode->m_Position.m_Y = 0.0f;
+        pNode->m_Position.m_Z = 0.0f;
+    }
+
+    if (pRotation)
+        pNode->m_Rotation = *pRotation;
+    else
+        csrQuatIdentity(&pNode->m_Rotation);
+
+    if (pScaling)
+        pNode->m_Scaling = *pScaling;
+    else
+    {
+        pNode->m_Scaling.m_X = 1.0f;
+        pNode->m_Scaling.m_Y = 1.0f;
+        pNode->m_Scaling.m_Z = 1.0f;
+    }
+
+    csrMat4Identity(&pNode->m_World);
+
+    // the new node needs to be updated
+    if (index < pHierarchy->m_FirstDirty)
+        pHierarchy->m_FirstDirty = index;
+
+    return index;
+}
+//---------------------------------------------------------------------------
+void csrTransformHierarchySetLocal(      CSR_TransformHierarchy* pHierarchy,
+                                         size_t                  index,
+                                   const CSR_Vector3*            pPosition,
+                                   const CSR_Quaternion*         pRotation,
+                                   const CSR_Vector3*            pScaling)
+{
+    CSR_TransformNode* pNode;
+
+    // validate the inputs
+    if (!pHierarchy || index >= pHierarchy->m_Count)
+        return;
+
+    pNode = &pHierarchy->m_pNode[index];
+
+    // update the local transformation
+    if (pPosition)
+        pNode->m_Position = *pPosition;
+
+    if (pRotation)
+        pNode->m_Rotation = *pRotation;
+
+    if (pScaling)
+        pNode->m_Scaling = *pScaling;
+
+    // mark the node as dirty. NOTE its children will be updated with it
+    pNode->m_Dirty = 1;
+
+    if (index < pHierarchy->m_FirstDirty)
+        pHierarchy->m_FirstDirty = index;
+}
+//---------------------------------------------------------------------------
+void csrTransformHierarchyUpdate(CSR_TransformHierarchy* pHierarchy)
+{
+    size_t             i;
+    size_t             start;
+    size_t             firstChanged;
+    CSR_Matrix4        scaleMatrix;
+    CSR_Matrix4        rotateMatrix;
+    CSR_Matrix4        localMatrix;
+    CSR_TransformNode* pNode;
+
+    // validate the inputs
+    if (!pHierarchy)
+        return;
+
+    // start from the first dirty node, or from the first node changed by the previous update if
+    // it's before, in order to clear its world changed flag
+    if (pHierarchy->m_FirstChanged < pHierarchy->m_FirstDirty)
+        start = pHierarchy->m_FirstChanged;
+    else
+        start = pHierarchy->m_FirstDirty;
+
+    firstChanged = pHierarchy->m_Count;
+
+    // iterate through the nodes. As the parents are always located before their children, a
+    // single pass is enough to propagate the changes
+    for (i = start; i < pHierarchy->m_Count; ++i)
+    {
+        pNode = &pHierarchy->m_pNode[i];
+
+        // neither the node nor its parent changed?
+        if (!pNode->m_Dirty &&
+            (pNode->m_Parent == (size_t)M_CSR_Unknown_Index ||
+             !pHierarchy->m_pNode[pNode->m_Parent].m_WorldChanged))
+        {
+            pNode->m_WorldChanged = 0;
+            continue;
+        }
+
+        // build the local matrix (scaling, then rotation, then translation)
+        csrMat4Scale(&pNode->m_Scaling, &scaleMatrix);
+        csrQuatToMatrix(&pNode->m_Rotation, &rotateMatrix);
+        csrMat4Multiply(&scaleMatrix, &rotateMatrix, &localMatrix);
+        localMatrix.m_Table[3][0] = pNode->m_Position.m_X;
+        localMatrix.m_Table[3][1] = pNode->m_Position.m_Y;
+        localMatrix.m_Table[3][2] = pNode->m_Position.m_Z;
+
+        // combine it with the parent world matrix
+        if (pNode->m_Parent == (size_t)M_CSR_Unknown_Index)
+            pNode->m_World = localMatrix;
+        else
+            csrMat4Multiply(&localMatrix, &pHierarchy->m_pNode[pNode->m_Parent].m_World, &pNode->m_World);
+
+        // update the target matrix
+        if (pNode->m_pTarget)
+            *pNode->m_pTarget = pNode->m_World;
+
+        pNode->m_Dirty        = 0;
+        pNode->m_WorldChanged = 1;
+
+        if (i < firstChanged)
+            firstChanged = i;
+    }
+
+    // everything is up to date
+    pHierarchy->m_FirstDirty   = pHierarchy->m_Count;
+    pHierarchy->m_FirstChanged = firstChanged;
+}
+//---------------------------------------------------------------------------
+void csrTransformHierarchyDeleteFrom(CSR_TransformHierarchy* pHierarchy, size_t index)
+{
+    size_t  i;
+    size_t  count;
+    size_t* pNewIndex;
+
+    // validate the inputs
+    if (!pHierarchy || index >= pHierarchy->m_Count)
+        return;
+
+    pNewIndex = (size_t*)malloc(pHierarchy->m_Count * sizeof(size_t));
+
+    // succeeded?
+    if (!pNewIndex)
+        return;
+
+    count = index;
+
+    // the nodes before the deleted one are unchanged
+    for (i = 0; i < index; ++i)
+        pNewIndex[i] = i;
+
+    pNewIndex[index] = (size_t)M_CSR_Unknown_Index;
+
+    // compact the remaining nodes. As the parents are always located before their children, the
+    // whole descendance is found in a single pass
+    for (i = index + 1; i < pHierarchy->m_Count; ++i)
+    {
+        const size_t parent = pHierarchy->m_pNode[i].m_Parent;
+
+        // is a descendant of a deleted node?
+        if (parent != (size_t)M_CSR_Unknown_Index && pNewIndex[parent] == (size_t)M_CSR_Unknown_Index)
+        {
+            pNewIndex[i] = (size_t)M_CSR_Unknown_Index;
+            continue;
+        }
+
+        pNewIndex[i]               = count;
+        pHierarchy->m_pNode[count] = pHierarchy->m_pNode[i];
+
+        if (parent != (size_t)M_CSR_Unknown_Index)
+            pHierarchy->m_pNode[count].m_Parent = pNewIndex[parent];
+
+        ++count;
+    }
+
+    free(pNewIndex);
+
+    pHierarchy->m_Count = count;
+
+    // the nodes after the deleted one may have moved, keep their dirty and world changed flags in
+    // the range visited by the next update
+    if (pHierarchy->m_FirstDirty > index)
+        pHierarchy->m_FirstDirty = index;
+
+    if (pHierarchy->m_FirstChanged > index)
+        pHierarchy->m_FirstChanged = index;
+
+    // was the last node?
+    if (!count)
+    {
+        free(pHierarchy->m_pNode);
+        pHierarchy->m_pNode = 0;
+    }
+}
+//---------------------------------------------------------------------------
+// Scene state functions
+//---------------------------------------------------------------------------
+void csrSceneStateInit(CSR_SceneState* pState)
+{
+    // no scene state to initialize?
+    if (!pState)
+        return;
+
+    csrSceneSnapshotInit(&pState->m_Snapshot[0]);
+    csrSceneSnapshotInit(&pState->m_Snapshot[1]);
+
+    csrSceneStateStoreFront(pState, 0);
+}
+//---------------------------------------------------------------------------
+void csrSceneStateContentRelease(CSR_SceneState* pState)
+{
+    // no scene state to release?
+    if (!pState)
+        return;
+
+    csrSceneSnapshotContentRelease(&pState->m_Snapshot[0]);
+    csrSceneSnapshotContentRelease(&pState->m_Snapshot[1]);
+}
+//---------------------------------------------------------------------------
+int csrSceneStateUpdate(const CSR_Scene*        pScene,
+                        const CSR_SceneContext* pContext,
+                              CSR_SceneState*   pState)
+{
+    // validate the inputs
+    if (!pScene || !pState)
+        return 0;
+
+    // write the back snapshot, the front one may be drawn meanwhile
+    return csrSceneSnapshotWrite(pScene,
+                                 pContext,
+                                &pState->m_Snapshot[1 - csrSceneStateLoadFront(pState)]);
+}
+//---------------------------------------------------------------------------
+void csrSceneStateSwap(CSR_SceneState* pState)
+{
+    // no scene state to swap?
+    if (!pState)
+        return;
+
+    // publish the back snapshot, which was completely written before
+    csrSceneStateStoreFront(pState, 1 - csrSceneStateLoadFront(pState));
+}
+//---------------------------------------------------------------------------
+const CSR_Scene* csrSceneStateGetFront(const CSR_SceneState* pState)
+{
+    // no scene state?
+    if (!pState)
+        return 0;
+
+    return &pState->m_Snapshot[csrSceneStateLoadFront(pState)].m_Scene;
+}
+//---------------------------------------------------------------------------
+// Scene functions
+//---------------------------------------------------------------------------
+CSR_Scene* csrSceneCreate(void)
+{
+    // create a new scene
+    CSR_Scene* pScene = (CSR_Scene*)malloc(sizeof(CSR_Scene));
+
+    // succeeded?
+    if (!pScene)
+        return 0;
+
+    // initialize the scene content
+    csrSceneInit(pScene);
+
+    return pScene;
+}
+//---------------------------------------------------------------------------
+void csrSceneRelease(CSR_Scene* pScene, const CSR_fOnDeleteTexture fOnDeleteTexture)
+{
+    size_t i;
+
+    // no scene to release?
+    if (!pScene)
+        return;
+
+    // do free the skybox?
+    if (pScene->m_pSkybox)
+        csrMeshRelease(pScene->m_pSkybox, fOnDeleteTexture);
+
+    // do free the normal items content?
+    if (pScene->m_pItem)
+    {
+        // iterate through each scene item to release, and release each of them
+        for (i = 0; i < pScene->m_ItemCount; ++i)
+            csrSceneItemContentRelease(&pScene->m_pItem[i], fOnDeleteTexture);
+
+        // free the scene items
+        free(pScene->m_pItem);
+    }
+
+    // do free the transparent items content?
+    if (pScene->m_pTransparentItem)
+    {
+        // iterate through each scene transparent item to release, and release each of them
+        for (i = 0; i < pScene->m_TransparentItemCount; ++i)
+            csrSceneItemContentRelease(&pScene->m_pTransparentItem[i], fOnDeleteTexture);
+
+        // free the scene transparent items
+        free(pScene->m_pTransparentItem);
+    }
+
+    // free the handle tables
+    csrHandleTableContentRelease(&pScene->m_ItemHandles);
+    csrHandleTableContentRelease(&pScene->m_InstanceHandles);
+
+    // free the transform hierarchy
+    csrTransformHierarchyContentRelease(&pScene->m_Transforms);
+
+    // free the scene
+    free(pScene);
+}
+//---------------------------------------------------------------------------
+void csrSceneInit(CSR_Scene* pScene)
+{
+    // no scene to initialize?
+    if (!pScene)
+        return;
+
+    // initialize the scene
+    pScene->m_Color.m_R            =  0.0f;
+    pScene->m_Color.m_G            =  0.0f;
+    pScene->m_Color.m_B            =  0.0f;
+    pScene->m_Color.m_A            =  1.0f;
+    pScene->m_GroundDir.m_X        =  0.0f;
+    pScene->m_GroundDir.m_Y        = -1.0f;
+    pScene->m_GroundDir.m_Z        =  0.0f;
+    pScene->m_pSkybox              =  0;
+    pScene->m_pItem                =  0;
+    pScene->m_ItemCount            =  0;
+    pScene->m_pTransparentItem     =  0;
+    pScene->m_TransparentItemCount =  0;
+
+    // initialize the handle tables
+    csrHandleTableInit(&pScene->m_ItemHandles);
+    csrHandleTableInit(&pScene->m_InstanceHandles);
+
+    // initialize the transform hierarchy
+    csrTransformHierarchyInit(&pScene->m_Transforms);
+
+    // set the default item matrix to identity
+    csrMat4Identity(&pScene->m_ViewMatrix);
+}
+//---------------------------------------------------------------------------
+CSR_SceneItem* csrSceneAddLine(CSR_Scene* pScene, CSR_Line* pLine, int transparent)
+{
+    CSR_SceneItem* pItem;
+    int            index;
+
+    // validate the inputs
+    if (!pScene || !pLine)
+        return 0;
+
+    // search for a scene item which already contains the same line
+    pItem = csrSceneGetItem(pScene, pLine);
+
+    // found one?
+    if (pItem)
+        return pItem;
+
+    // do add a transparent line?
+    if (transparent)
+    {
+        // add a new item to the transparent items
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pTransparentItem,
+                                               sizeof(CSR_SceneItem),
+                                               pScene->m_TransparentItemCount + 1);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        // get the item index to update
+        index = (int)pScene->m_TransparentItemCount;
+    }
+    else
+    {
+        // add a new item to the scene items
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pItem,
+                                               sizeof(CSR_SceneItem),
+                                               pScene->m_ItemCount + 1);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        // get the scene item index to update
+        index = (int)pScene->m_ItemCount;
+    }
+
+    // initialize the newly created item with the default values
+    csrSceneItemInit(&pItem[index]);
+
+    // configure the item
+    pItem[index].m_pModel = pLine;
+    pItem[index].m_Type   = CSR_MT_Line;
+
+    // do add a transparent item?
+    if (transparent)
+    {
+        // add item to the transparent item list
+        pScene->m_pTransparentItem = pItem;
+        ++pScene->m_TransparentItemCount;
+    }
+    else
+    {
+        // add item to the normal item list
+        pScene->m_pItem = pItem;
+        ++pScene->m_ItemCount;
+    }
+
+    // link a handle to the item. NOTE the item remains usable without handle if it fails
+    pItem[index].m_Handle = csrHandleTableAdd(&pScene->m_ItemHandles, index, transparent ? 1 : 0);
+
+    return &pItem[index];
+}
+//---------------------------------------------------------------------------
+CSR_SceneItem* csrSceneAddMesh(CSR_Scene* pScene, CSR_Mesh* pMesh, int transparent, int aabb)
+{
+    CSR_SceneItem* pItem;
+    int            index;
+
+    // validate the inputs
+    if (!pScene || !pMesh)
+        return 0;
+
+    // search for a scene item which already contains the same mesh
+    pItem = csrSceneGetItem(pScene, pMesh);
+
+    // found one?
+    if (pItem)
+        return pItem;
+
+    // do add a transparent item?
+    if (transparent)
+    {
+        // add a new item to the transparent items
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pTransparentItem,
+                                               sizeof(CSR_SceneItem),
+                                               pScene->m_TransparentItemCount + 1);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        // get the item index to update
+        index = (int)pScene->m_TransparentItemCount;
+    }
+    else
+    {
+        // add a new item to the scene items
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pItem,
+                                               sizeof(CSR_SceneItem),
+                                               pScene->m_ItemCount + 1);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        // get the scene item index to update
+        index = (int)pScene->m_ItemCount;
+    }
+
+    // initialize the newly created item with the default values
+    csrSceneItemInit(&pItem[index]);
+
+    // configure the item
+    pItem[index].m_pModel = pMesh;
+    pItem[index].m_Type   = CSR_MT_Mesh;
+
+    // calculate the model bounding box, used to cull the instances out of the view
+    csrSceneItemUpdateBox(&pItem[index]);
+
+    // generate the aligned-axis bounding box tree for this mesh
+    if (aabb)
+    {
+        pItem[index].m_AABBTreeCount = 1;
+        pItem[index].m_pAABBTree     = csrAABBTreeFromMeshMode(pMesh, (CSR_EAABBTreeMode)aabb);
+
+        // succeeded?
+        if (!pItem[index].m_pAABBTree)
+        {
+            // realloc to the previous size, thus the latest added item will be freed
+            if (transparent)
+                pScene->m_pTransparentItem =
+                        (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                       sizeof(CSR_SceneItem),
+                                                       pScene->m_TransparentItemCount);
+            else
+                pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                 sizeof(CSR_SceneItem),
+                                                                 pScene->m_ItemCount);
+
+            return 0;
+        }
+    }
+
+    // do add a transparent item?
+    if (transparent)
+    {
+        // add item to the transparent item list
+        pScene->m_pTransparentItem = pItem;
+        ++pScene->m_TransparentItemCount;
+    }
+    else
+    {
+        // add item to the normal item list
+        pScene->m_pItem = pItem;
+        ++pScene->m_ItemCount;
+    }
+
+    // link a handle to the item. NOTE the item remains usable without handle if it fails
+    pItem[index].m_Handle = csrHandleTableAdd(&pScene->m_ItemHandles, index, transparent ? 1 : 0);
+
+    return &pItem[index];
+}
+//---------------------------------------------------------------------------
+CSR_SceneItem* csrSceneAddModel(CSR_Scene* pScene, CSR_Model* pModel, int transparent, int aabb)
+{
+    CSR_SceneItem* pItem;
+    int            index;
+
+    // validate the inputs
+    if (!pScene || !pModel)
+        return 0;
+
+    // search for a scene item which already contains the same model
+    pItem = csrSceneGetItem(pScene, pModel);
+
+    // found one?
+    if (pItem)
+        return pItem;
+
+    // do add a transparent item?
+    if (transparent)
+    {
+        // add a new item to the transparent items
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pTransparentItem,
+                                               sizeof(CSR_SceneItem),
+                                               pScene->m_TransparentItemCount + 1);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        // get the item index to update
+        index = (int)pScene->m_TransparentItemCount;
+    }
+    else
+    {
+        // add a new item to the scene items
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pItem,
+                                               sizeof(CSR_SceneItem),
+                                               pScene->m_ItemCount + 1);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        // get the scene item index to update
+        index = (int)pScene->m_ItemCount;
+    }
+
+    // initialize the newly created item with the default values
+    csrSceneItemInit(&pItem[index]);
+
+    // configure the item
+    pItem[index].m_pModel = pModel;
+    pItem[index].m_Type   = CSR_MT_Model;
+
+    // calculate the model bounding box, used to cull the instances out of the view
+    csrSceneItemUpdateBox(&pItem[index]);
+
+    // generate the aligned-axis bounding box tree for this model
+    if (aabb)
+    {
+        size_t i;
+
+        // reserve memory for all the AABB trees to create
+        pItem[index].m_AABBTreeCount = pModel->m_MeshCount;
+        pItem[index].m_pAABBTree     = (CSR_AABBNode*)csrMemoryAlloc(0,
+                                                                     sizeof(CSR_AABBNode),
+                                                                     pItem[index].m_AABBTreeCount);
+
+        // succeeded?
+        if (!pItem[index].m_pAABBTree)
+        {
+            // realloc to the previous size, thus the latest added item will be freed
+            if (transparent)
+                pScene->m_pTransparentItem =
+                        (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                       sizeof(CSR_SceneItem),
+                                                       pScene->m_TransparentItemCount);
+            else
+                pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                 sizeof(CSR_SceneItem),
+                                                                 pScene->m_ItemCount);
+
+            return 0;
+        }
+
+        // iterate through the model meshes
+        for (i = 0; i < pModel->m_MeshCount; ++i)
+        {
+            // create a new tree for the mesh
+            CSR_AABBNode* pAABBTree = csrAABBTreeFromMeshMode(&pModel->m_pMesh[i], (CSR_EAABBTreeMode)aabb);
+
+            // succeeded?
+            if (!pAABBTree)
+            {
+                // realloc to the previous size, thus the latest added item will be freed
+                if (transparent)
+                    pScene->m_pTransparentItem =
+                            (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                           sizeof(CSR_SceneItem),
+                                                           pScene->m_TransparentItemCount);
+                else
+                    pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                     sizeof(CSR_SceneItem),
+                                                                     pScene->m_ItemCount);
+
+                return 0;
+            }
+
+            // copy the tree content
+            memcpy(&pItem[index].m_pAABBTree[i], pAABBTree, sizeof(CSR_AABBNode));
+
+            // release the source tree (NOTE reset his value before, otherwise the copied tree
+            // content will also be released, which will corrupt the tree)
+            pAABBTree->m_pParent        = 0;
+            pAABBTree->m_pLeft          = 0;
+            pAABBTree->m_pRight         = 0;
+            pAABBTree->m_pBox           = 0;
+            pAABBTree->m_pPolygonBuffer = 0;
+            pAABBTree->m_pTriangles     = 0;
+            csrAABBTreeNodeRelease(pAABBTree);
+        }
+    }
+
+    // do add a transparent item?
+    if (transparent)
+    {
+        // add item to the transparent item list
+        pScene->m_pTransparentItem = pItem;
+        ++pScene->m_TransparentItemCount;
+    }
+    else
+    {
+        // add item to the normal item list
+        pScene->m_pItem = pItem;
+        ++pScene->m_ItemCount;
+    }
+
+    // link a handle to the item. NOTE the item remains usable without handle if it fails
+    pItem[index].m_Handle = csrHandleTableAdd(&pScene->m_ItemHandles, index, transparent ? 1 : 0);
+
+    return &pItem[index];
+}
+//---------------------------------------------------------------------------
+CSR_SceneItem* csrSceneAddMDL(CSR_Scene* pScene, CSR_MDL* pMDL, int transparent, int aabb)
+{
+    CSR_SceneItem* pItem;
+    int            index;
+
+    // validate the inputs
+    if (!pScene || !pMDL)
+        return 0;
+
+    // search for a scene item which already contains the same model
+    pItem = csrSceneGetItem(pScene, pMDL);
+
+    // found one?
+    if (pItem)
+        return pItem;
+
+    // do add a transparent item?
+    if (transparent)
+    {
+        // add a new item to the transparent items
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pTransparentItem,
+                                               sizeof(CSR_SceneItem),
+                                               pScene->m_TransparentItemCount + 1);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        // get the item index to update
+        index = (int)pScene->m_TransparentItemCount;
+    }
+    else
+    {
+        // add a new item to the scene items
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pItem,
+                                               sizeof(CSR_SceneItem),
+                                               pScene->m_ItemCount + 1);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        // get the scene item index to update
+        index = (int)pScene->m_ItemCount;
+    }
+
+    // initialize the newly created item with the default values
+    csrSceneItemInit(&pItem[index]);
+
+    // configure the item
+    pItem[index].m_pModel = pMDL;
+    pItem[index].m_Type   = CSR_MT_MDL;
+
+    // calculate the model bounding box, used to cull the instances out of the view
+    csrSceneItemUpdateBox(&pItem[index]);
+
+    // generate the aligned-axis bounding box tree for this model
+    if (aabb)
+    {
+        size_t i;
+        size_t j;
+
+        // reserve memory for all the AABB trees to create
+        pItem[index].m_AABBTreeCount = pMDL->m_ModelCount * pMDL->m_pModel->m_MeshCount;
+        pItem[index].m_pAABBTree     = (CSR_AABBNode*)csrMemoryAlloc(0,
+                                                                     sizeof(CSR_AABBNode),
+                                                                     pItem[index].m_AABBTreeCount);
+
+        // succeeded?
+        if (!pItem[index].m_pAABBTree)
+        {
+            // realloc to the previous size, thus the latest added item will be freed
+            if (transparent)
+                pScene->m_pTransparentItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                            sizeof(CSR_SceneItem),
+                                                                            pScene->m_TransparentItemCount);
+            else
+                pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                 sizeof(CSR_SceneItem),
+                                                                 pScene->m_ItemCount);
+
+            return 0;
+        }
+
+        // iterate through the model meshes
+        for (i = 0; i < pMDL->m_ModelCount; ++i)
+            for (j = 0; j < pMDL->m_pModel->m_MeshCount; ++j)
+            {
+                // create a new tree for the mesh
+                CSR_AABBNode* pAABBTree = csrAABBTreeFromMeshMode(&pMDL->m_pModel[i].m_pMesh[j], (CSR_EAABBTreeMode)aabb);
+
+                // succeeded?
+                if (!pAABBTree)
+                {
+                    // realloc to the previous size, thus the latest added item will be freed
+                    if (transparent)
+                        pScene->m_pTransparentItem =
+                                (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                               sizeof(CSR_SceneItem),
+                                                               pScene->m_TransparentItemCount);
+                    else
+                        pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                         sizeof(CSR_SceneItem),
+                                                                         pScene->m_ItemCount);
+
+                    return 0;
+                }
+
+                // copy the tree content
+                memcpy(&pItem[index].m_pAABBTree[i], pAABBTree, sizeof(CSR_AABBNode));
+
+                // release the source tree (NOTE reset his value before, otherwise the copied tree
+                // content will also be released, which will corrupt the tree)
+                pAABBTree->m_pParent        = 0;
+                pAABBTree->m_pLeft          = 0;
+                pAABBTree->m_pRight         = 0;
+                pAABBTree->m_pBox           = 0;
+                pAABBTree->m_pPolygonBuffer = 0;
+                pAABBTree->m_pTriangles     = 0;
+                csrAABBTreeNodeRelease(pAABBTree);
+            }
+    }
+
+    // do add a transparent item?
+    if (transparent)
+    {
+        // add item to the transparent item list
+        pScene->m_pTransparentItem = pItem;
+        ++pScene->m_TransparentItemCount;
+    }
+    else
+    {
+        // add item to the normal item list
+        pScene->m_pItem = pItem;
+        ++pScene->m_ItemCount;
+    }
+
+    // link a handle to the item. NOTE the item remains usable without handle if it fails
+    pItem[index].m_Handle = csrHandleTableAdd(&pScene->m_ItemHandles, index, transparent ? 1 : 0);
+
+    return &pItem[index];
+}
+//---------------------------------------------------------------------------
+CSR_SceneItem* csrSceneAddX(CSR_Scene* pScene, CSR_X* pX, int transparent, int aabb)
+{
+    CSR_SceneItem* pItem;
+    int            index;
+
+    // validate the inputs
+    if (!pScene || !pX)
+        return 0;
+
+    // search for a scene item which already contains the same model
+    pItem = csrSceneGetItem(pScene, pX);
+
+    // found one?
+    if (pItem)
+        return pItem;
+
+    // do add a transparent item?
+    if (transparent)
+    {
+        // add a new item to the transparent items
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pTransparentItem,
+                                               sizeof(CSR_SceneItem),
+                                               pScene->m_TransparentItemCount + 1);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        // get the item index to update
+        index = (int)pScene->m_TransparentItemCount;
+    }
+    else
+    {
+        // add a new item to the scene items
+        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pItem,
+                                               sizeof(CSR_SceneItem),
+                                               pScene->m_ItemCount + 1);
+
+        // succeeded?
+        if (!pItem)
+            return 0;
+
+        // get the scene item index to update
+        index = (int)pScene->m_ItemCount;
+    }
+
+    // initialize the newly created item with the default values
+    csrSceneItemInit(&pItem[index]);
+
+    // configure the item
+    pItem[index].m_pModel = pX;
+    pItem[index].m_Type   = CSR_MT_X;
+
+    // generate the aligned-axis bounding box tree for this model
+    if (aabb)
+    {
+        size_t i;
+
+        // reserve memory for all the AABB trees to create
+        pItem[index].m_AABBTreeCount = pX->m_MeshCount;
+        pItem[index].m_pAABBTree     = (CSR_AABBNode*)csrMemoryAlloc(0,
+                                                                     sizeof(CSR_AABBNode),
+                                                                     pItem[index].m_AABBTreeCount);
+
+        // succeeded?
+        if (!pItem[index].m_pAABBTree)
+        {
+            // realloc to the previous size, thus the latest added item will be freed
+            if (transparent)
+                pScene->m_pTransparentItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                            sizeof(CSR_SceneItem),
+                                                                            pScene->m_TransparentItemCount);
+            else
+                pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                 sizeof(CSR_SceneItem),
+                                                                 pScene->m_ItemCount);
+
+            return 0;
+        }
+
+        // iterate through the meshes
+        for (i = 0; i < pX->m_MeshCount; ++i)
+        {
+            // create a new tree for the mesh
+            CSR_AABBNode* pAABBTree = csrAABBTreeFromMeshMode(&pX->m_pMesh[i], (CSR_EAABBTreeMode)aabb);
+
+            // succeeded?
+            if (!pAABBTree)
+            {
+                // realloc to the previous size, thus the latest added item will be freed
+                if (transparent)
+                    pScene->m_pTransparentItem =
+                            (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                           sizeof(CSR_SceneItem),
+                                                           pScene->m_TransparentItemCount);
+                else
+                    pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                     sizeof(CSR_SceneItem),
+                                                                     pScene->m_ItemCount);
+
+                return 0;
+            }
+
+            // copy the tree content
+            memcpy(&pItem[index].m_pAABBTree[i], pAABBTree, sizeof(CSR_AABBNode));
 
             // release the source tree (NOTE reset his value before, otherwise the copied tree
             // content will also be released, which will corrupt the tree)
@@ -984,451 +5235,824 @@ CSR_SceneItem* csrSceneAddModel(CSR_Scene* pScene, CSR_Model* pModel, int transp
             pAABBTree->m_pRight         = 0;
             pAABBTree->m_pBox           = 0;
             pAABBTree->m_pPolygonBuffer = 0;
+            pAABBTree->m_pTriangles     = 0;
             csrAABBTreeNodeRelease(pAABBTree);
         }
     }
 
-    // do add a transparent item?
-    if (transparent)
+    // do add a transparent item?
+    if (transparent)
+    {
+        // add item to the transparent item list
+        pScene->m_pTransparentItem = pItem;
+        ++pScene->m_TransparentItemCount;
+    }
+    else
+    {
+        // add item to the normal item list
+        pScene->m_pItem = pItem;
+        ++pScene->m_ItemCount;
+    }
+
+    // link a handle to the item. NOTE the item remains usable without handle if it fails
+    pItem[index].m_Handle = csrHandleTableAdd(&pScene->m_ItemHandles, index, transparent ? 1 : 0);
+
+    return &pItem[index];
+}
+//---------------------------------------------------------------------------
+CSR_SceneItem* csrSceneAddModelMatrix(CSR_Scene* pScene, const void* pModel, CSR_Matrix4* pMatrix)
+{
+    size_t         count;
+    CSR_Handle*    pHandles;
+    CSR_SceneItem* pSceneItem;
+
+    // validate inputs
+    if (!pScene || !pModel || !pMatrix)
+        return 0;
+
+    // get the scene item matching with the model for which the matrix should be added
+    pSceneItem = csrSceneGetItem(pScene, pModel);
+
+    // found it?
+    if (!pSceneItem)
+        return 0;
+
+    // do create a matrix array for the item?
+    if (!pSceneItem->m_pMatrixArray)
+    {
+        // create a new matrix array
+        pSceneItem->m_pMatrixArray = (CSR_Array*)csrMemoryAlloc(0, sizeof(CSR_Array), 1);
+
+        // succeeded?
+        if (!pSceneItem->m_pMatrixArray)
+            return 0;
+
+        // initialize the array content
+        csrArrayInit(pSceneItem->m_pMatrixArray);
+    }
+
+    count = pSceneItem->m_pMatrixArray->m_Count;
+
+    // add the matrix to the array
+    csrArrayAddUnique(pMatrix, pSceneItem->m_pMatrixArray, 0);
+
+    // was the matrix added, and the previous instances all have a handle?
+    if (pSceneItem->m_pMatrixArray->m_Count == count + 1 && pSceneItem->m_InstanceHandleCount == count)
+    {
+        // add a handle for the new instance
+        pHandles = (CSR_Handle*)csrMemoryAlloc(pSceneItem->m_pInstanceHandle, sizeof(CSR_Handle), count + 1);
+
+        // succeeded? (if not, the instance remains usable without handle)
+        if (pHandles)
+        {
+            pHandles[count] = csrHandleTableAdd(&pScene->m_InstanceHandles, count, pSceneItem->m_Handle);
+
+            pSceneItem->m_pInstanceHandle = pHandles;
+            ++pSceneItem->m_InstanceHandleCount;
+        }
+    }
+
+    return pSceneItem;
+}
+//---------------------------------------------------------------------------
+CSR_Handle csrSceneAddInstance(CSR_Scene* pScene, const void* pModel, CSR_Matrix4* pMatrix)
+{
+    size_t         i;
+    CSR_SceneItem* pSceneItem;
+
+    // add the matrix to the scene
+    pSceneItem = csrSceneAddModelMatrix(pScene, pModel, pMatrix);
+
+    // succeeded?
+    if (!pSceneItem)
+        return 0;
+
+    // search for the instance handle. NOTE the newly added matrix is always the last one, unless
+    // it was already added before
+    for (i = pSceneItem->m_InstanceHandleCount; i > 0; --i)
+        if (pSceneItem->m_pMatrixArray->m_pItem[i - 1].m_pData == pMatrix)
+            return pSceneItem->m_pInstanceHandle[i - 1];
+
+    return 0;
+}
+//---------------------------------------------------------------------------
+CSR_SceneItem* csrSceneGetItem(const CSR_Scene* pScene, const void* pKey)
+{
+    size_t i;
+    size_t j;
+
+    // validate inputs
+    if (!pScene || !pKey)
+        return 0;
+
+    // first search in the standard models
+    for (i = 0; i < pScene->m_ItemCount; ++i)
+    {
+        // found a matching model?
+        if (pScene->m_pItem[i].m_pModel == pKey)
+            return &pScene->m_pItem[i];
+
+        // check also if the key is a known matrix
+        if (pScene->m_pItem[i].m_pMatrixArray)
+            for (j = 0; j < pScene->m_pItem[i].m_pMatrixArray->m_Count; ++j)
+                if (&pScene->m_pItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
+                    return &pScene->m_pItem[i];
+    }
+
+    // then search in the transparent models
+    for (i = 0; i < pScene->m_TransparentItemCount; ++i)
+    {
+        // found a matching model?
+        if (pScene->m_pTransparentItem[i].m_pModel == pKey)
+            return &pScene->m_pTransparentItem[i];
+
+        // check also if the key is a known matrix
+        if (pScene->m_pTransparentItem[i].m_pMatrixArray)
+            for (j = 0; j < pScene->m_pTransparentItem[i].m_pMatrixArray->m_Count; ++j)
+                if (&pScene->m_pTransparentItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
+                    return &pScene->m_pTransparentItem[i];
+    }
+
+    // not found
+    return 0;
+}
+//---------------------------------------------------------------------------
+CSR_SceneItem* csrSceneGetItemFromHandle(const CSR_Scene* pScene, CSR_Handle handle)
+{
+    CSR_HandleSlot* pSlot;
+
+    // validate inputs
+    if (!pScene)
+        return 0;
+
+    // get the item location
+    pSlot = csrHandleTableGet(&pScene->m_ItemHandles, handle);
+
+    // not found?
+    if (!pSlot)
+        return 0;
+
+    // get the item from its list. NOTE the tag indicates if the item is transparent
+    if (pSlot->m_Tag)
+        return &pScene->m_pTransparentItem[pSlot->m_Index];
+
+    return &pScene->m_pItem[pSlot->m_Index];
+}
+//---------------------------------------------------------------------------
+CSR_Matrix4* csrSceneGetInstanceFromHandle(const CSR_Scene*      pScene,
+                                                 CSR_Handle      handle,
+                                                 CSR_SceneItem** ppItem)
+{
+    CSR_SceneItem*  pItem;
+    CSR_HandleSlot* pSlot;
+
+    // validate inputs
+    if (!pScene)
+        return 0;
+
+    // get the instance location
+    pSlot = csrHandleTableGet(&pScene->m_InstanceHandles, handle);
+
+    // not found?
+    if (!pSlot)
+        return 0;
+
+    // get the item owning the instance. NOTE the tag contains the owner item handle
+    pItem = csrSceneGetItemFromHandle(pScene, (CSR_Handle)pSlot->m_Tag);
+
+    // found it?
+    if (!pItem)
+        return 0;
+
+    if (ppItem)
+        *ppItem = pItem;
+
+    return (CSR_Matrix4*)pItem->m_pMatrixArray->m_pItem[pSlot->m_Index].m_pData;
+}
+//---------------------------------------------------------------------------
+void csrSceneDeleteFrom(      CSR_Scene*           pScene,
+                        const void*                pKey,
+                        const CSR_fOnDeleteTexture fOnDeleteTexture)
+{
+    size_t i;
+    size_t j;
+
+    // validate inputs
+    if (!pScene || !pKey)
+        return;
+
+    // first search in the standard models
+    for (i = 0; i < pScene->m_ItemCount; ++i)
     {
-        // add item to the transparent item list
-        pScene->m_pTransparentItem = pItem;
-        ++pScene->m_TransparentItemCount;
+        // found a matching model?
+        if (pScene->m_pItem[i].m_pModel == pKey)
+        {
+            // delete the item from the list
+            csrSceneDeleteItemAt(pScene, 0, i, fOnDeleteTexture);
+            return;
+        }
+
+        // check also if the key is a known matrix
+        if (pScene->m_pItem[i].m_pMatrixArray)
+            for (j = 0; j < pScene->m_pItem[i].m_pMatrixArray->m_Count; ++j)
+                if (pScene->m_pItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
+                {
+                    // delete the matrix
+                    csrSceneDeleteInstanceAt(pScene, &pScene->m_pItem[i], j);
+                    return;
+                }
     }
-    else
+
+    // then search in the transparent models
+    for (i = 0; i < pScene->m_TransparentItemCount; ++i)
     {
-        // add item to the normal item list
-        pScene->m_pItem = pItem;
-        ++pScene->m_ItemCount;
-    }
+        // found a matching model?
+        if (pScene->m_pTransparentItem[i].m_pModel == pKey)
+        {
+            // delete the item from the list
+            csrSceneDeleteItemAt(pScene, 1, i, fOnDeleteTexture);
+            return;
+        }
 
-    return &pItem[index];
+        // check also if the key is a known matrix
+        if (pScene->m_pTransparentItem[i].m_pMatrixArray)
+            for (j = 0; j < pScene->m_pTransparentItem[i].m_pMatrixArray->m_Count; ++j)
+                if (pScene->m_pTransparentItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
+                {
+                    // delete the matrix
+                    csrSceneDeleteInstanceAt(pScene, &pScene->m_pTransparentItem[i], j);
+                    return;
+                }
+    }
 }
 //---------------------------------------------------------------------------
-CSR_SceneItem* csrSceneAddMDL(CSR_Scene* pScene, CSR_MDL* pMDL, int transparent, int aabb)
+void csrSceneDeleteItemFromHandle(      CSR_Scene*           pScene,
+                                        CSR_Handle           handle,
+                                  const CSR_fOnDeleteTexture fOnDeleteTexture)
 {
-    CSR_SceneItem* pItem;
-    int            index;
+    CSR_HandleSlot* pSlot;
 
-    // validate the inputs
-    if (!pScene || !pMDL)
-        return 0;
+    // validate inputs
+    if (!pScene)
+        return;
 
-    // search for a scene item which already contains the same model
-    pItem = csrSceneGetItem(pScene, pMDL);
+    // get the item location
+    pSlot = csrHandleTableGet(&pScene->m_ItemHandles, handle);
 
-    // found one?
-    if (pItem)
-        return pItem;
+    // not found?
+    if (!pSlot)
+        return;
 
-    // do add a transparent item?
-    if (transparent)
-    {
-        // add a new item to the transparent items
-        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pTransparentItem,
-                                               sizeof(CSR_SceneItem),
-                                               pScene->m_TransparentItemCount + 1);
+    // delete the item from its list. NOTE the tag indicates if the item is transparent
+    csrSceneDeleteItemAt(pScene, (int)pSlot->m_Tag, pSlot->m_Index, fOnDeleteTexture);
+}
+//---------------------------------------------------------------------------
+void csrSceneDeleteInstanceFromHandle(CSR_Scene* pScene, CSR_Handle handle)
+{
+    CSR_SceneItem*  pItem;
+    CSR_HandleSlot* pSlot;
 
-        // succeeded?
-        if (!pItem)
-            return 0;
+    // validate inputs
+    if (!pScene)
+        return;
 
-        // get the item index to update
-        index = (int)pScene->m_TransparentItemCount;
-    }
-    else
-    {
-        // add a new item to the scene items
-        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pItem,
-                                               sizeof(CSR_SceneItem),
-                                               pScene->m_ItemCount + 1);
+    // get the instance location
+    pSlot = csrHandleTableGet(&pScene->m_InstanceHandles, handle);
 
-        // succeeded?
-        if (!pItem)
-            return 0;
+    // not found?
+    if (!pSlot)
+        return;
 
-        // get the scene item index to update
-        index = (int)pScene->m_ItemCount;
-    }
+    // get the item owning the instance. NOTE the tag contains the owner item handle
+    pItem = csrSceneGetItemFromHandle(pScene, (CSR_Handle)pSlot->m_Tag);
 
-    // initialize the newly created item with the default values
-    csrSceneItemInit(&pItem[index]);
+    // found it?
+    if (!pItem)
+        return;
 
-    // configure the item
-    pItem[index].m_pModel = pMDL;
-    pItem[index].m_Type   = CSR_MT_MDL;
+    // delete the instance
+    csrSceneDeleteInstanceAt(pScene, pItem, pSlot->m_Index);
+}
+//---------------------------------------------------------------------------
+int csrSceneBatchStaticItems(      CSR_Scene*        pScene,
+                             const CSR_SceneContext* pContext,
+                                   float             cellSize,
+                             const CSR_fOnBatchSkin  fOnBatchSkin)
+{
+    size_t             i;
+    size_t             j;
+    size_t             k;
+    size_t             batchCount;
+    long               cell[3];
+    long               batchCell[3];
+    int                success;
+    CSR_Box            box;
+    CSR_Mesh*          pMesh;
+    CSR_Mesh*          pBatchMesh;
+    CSR_Mesh**         ppSkinMesh;
+    CSR_Mesh**         ppNewSkinMesh;
+    CSR_Matrix4*       pIdentity;
+    CSR_SceneItem*     pItem;
+    CSR_SceneItem*     pBatches;
+    CSR_SceneItem*     pNewBatches;
+    const CSR_Matrix4* pMatrix;
 
-    // generate the aligned-axis bounding box tree for this model
-    if (aabb)
+    // validate the inputs
+    if (!pScene || !pContext)
+        return 0;
+
+    pBatches   = 0;
+    ppSkinMesh = 0;
+    batchCount = 0;
+    success    = 1;
+
+    // merge the static instances. NOTE a transparent item cannot be batched, as its instances
+    // should be drawn in depth order
+    for (i = 0; i < pScene->m_ItemCount && success; ++i)
     {
-        size_t i;
-        size_t j;
+        pItem = &pScene->m_pItem[i];
+        pMesh = csrSceneItemGetStaticMesh(pItem);
 
-        // reserve memory for all the AABB trees to create
-        pItem[index].m_AABBTreeCount = pMDL->m_ModelCount * pMDL->m_pModel->m_MeshCount;
-        pItem[index].m_pAABBTree     = (CSR_AABBNode*)csrMemoryAlloc(0,
-                                                                     sizeof(CSR_AABBNode),
-                                                                     pItem[index].m_AABBTreeCount);
+        // not a static item?
+        if (!pMesh)
+            continue;
 
-        // succeeded?
-        if (!pItem[index].m_pAABBTree)
+        for (j = 0; j < pItem->m_pMatrixArray->m_Count; ++j)
         {
-            // realloc to the previous size, thus the latest added item will be freed
-            if (transparent)
-                pScene->m_pTransparentItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                                            sizeof(CSR_SceneItem),
-                                                                            pScene->m_TransparentItemCount);
-            else
-                pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                                 sizeof(CSR_SceneItem),
-                                                                 pScene->m_ItemCount);
+            pMatrix = (const CSR_Matrix4*)pItem->m_pMatrixArray->m_pItem[j].m_pData;
 
-            return 0;
-        }
+            // get the cell in which the instance is located
+            csrBoxTransform(&pItem->m_Box, pMatrix, &box);
+            csrSceneBatchGetCell(&box, cellSize, cell);
 
-        // iterate through the model meshes
-        for (i = 0; i < pMDL->m_ModelCount; ++i)
-            for (j = 0; j < pMDL->m_pModel->m_MeshCount; ++j)
+            // search for a batch located in the same cell, sharing the same skin and collision type
+            for (k = 0; k < batchCount; ++k)
             {
-                // create a new tree for the mesh
-                CSR_AABBNode* pAABBTree = csrAABBTreeFromMesh(&pMDL->m_pModel[i].m_pMesh[j]);
+                if (pBatches[k].m_CollisionType != pItem->m_CollisionType || !pBatches[k].m_pBatch->m_Count)
+                    continue;
 
-                // succeeded?
-                if (!pAABBTree)
-                {
-                    // realloc to the previous size, thus the latest added item will be freed
-                    if (transparent)
-                        pScene->m_pTransparentItem =
-                                (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                               sizeof(CSR_SceneItem),
-                                                               pScene->m_TransparentItemCount);
-                    else
-                        pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                                         sizeof(CSR_SceneItem),
-                                                                         pScene->m_ItemCount);
+                csrSceneBatchGetCell(&pBatches[k].m_pBatch->m_pRange[0].m_Box, cellSize, batchCell);
 
-                    return 0;
+                if (cell[0] == batchCell[0] &&
+                    cell[1] == batchCell[1] &&
+                    cell[2] == batchCell[2] &&
+                    csrSceneBatchSkinMatch(pContext, ppSkinMesh[k], pMesh))
+                    break;
+            }
+
+            // not found? Create a new batch
+            if (k == batchCount)
+            {
+                // add room for the new batch, if required
+                if (!pBatches || batchCount + 1 > csrSceneBatchGetCapacity(batchCount))
+                {
+                    pNewBatches   = (CSR_SceneItem*)csrMemoryAlloc(pBatches,
+                                                                   sizeof(CSR_SceneItem),
+                                                                   csrSceneBatchGetCapacity(batchCount + 1));
+                    ppNewSkinMesh = (CSR_Mesh**)    csrMemoryAlloc(ppSkinMesh,
+                                                                   sizeof(CSR_Mesh*),
+                                                                   csrSceneBatchGetCapacity(batchCount + 1));
+
+                    // succeeded?
+                    if (pNewBatches)
+                        pBatches = pNewBatches;
+
+                    if (ppNewSkinMesh)
+                        ppSkinMesh = ppNewSkinMesh;
+
+                    if (!pNewBatches || !ppNewSkinMesh)
+                    {
+                        success = 0;
+                        break;
+                    }
                 }
 
-                // copy the tree content
-                memcpy(&pItem[index].m_pAABBTree[i], pAABBTree, sizeof(CSR_AABBNode));
+                csrSceneItemInit(&pBatches[k]);
+                pBatches[k].m_pModel        = csrMeshCreate();
+                pBatches[k].m_Type          = CSR_MT_Mesh;
+                pBatches[k].m_CollisionType = pItem->m_CollisionType;
+                pBatches[k].m_Static        = 1;
+                pBatches[k].m_pBatch        = (CSR_SceneBatch*)calloc(1, sizeof(CSR_SceneBatch));
+                ppSkinMesh[k]               = pMesh;
+                ++batchCount;
 
-                // release the source tree (NOTE reset his value before, otherwise the copied tree
-                // content will also be released, which will corrupt the tree)
-                pAABBTree->m_pParent        = 0;
-                pAABBTree->m_pLeft          = 0;
-                pAABBTree->m_pRight         = 0;
-                pAABBTree->m_pBox           = 0;
-                pAABBTree->m_pPolygonBuffer = 0;
-                csrAABBTreeNodeRelease(pAABBTree);
+                // succeeded?
+                if (!pBatches[k].m_pModel || !pBatches[k].m_pBatch)
+                {
+                    success = 0;
+                    break;
+                }
             }
-    }
 
-    // do add a transparent item?
-    if (transparent)
-    {
-        // add item to the transparent item list
-        pScene->m_pTransparentItem = pItem;
-        ++pScene->m_TransparentItemCount;
+            // merge the instance in the batch
+            if (!csrSceneBatchAddInstance(pMesh, pMatrix, &box, &pBatches[k]) ||
+                !csrSceneBatchAddOccluder(&pItem->m_Occluder, pMatrix, &pBatches[k].m_Occluder))
+            {
+                success = 0;
+                break;
+            }
+        }
     }
-    else
+
+    // failed? Release the batches, the scene remains unchanged
+    if (!success)
     {
-        // add item to the normal item list
-        pScene->m_pItem = pItem;
-        ++pScene->m_ItemCount;
-    }
+        for (k = 0; k < batchCount; ++k)
+            csrSceneItemContentRelease(&pBatches[k], 0);
 
-    return &pItem[index];
-}
-//---------------------------------------------------------------------------
-CSR_SceneItem* csrSceneAddX(CSR_Scene* pScene, CSR_X* pX, int transparent, int aabb)
-{
-    CSR_SceneItem* pItem;
-    int            index;
+        free(pBatches);
+        free(ppSkinMesh);
 
-    // validate the inputs
-    if (!pScene || !pX)
         return 0;
+    }
 
-    // search for a scene item which already contains the same model
-    pItem = csrSceneGetItem(pScene, pX);
-
-    // found one?
-    if (pItem)
-        return pItem;
-
-    // do add a transparent item?
-    if (transparent)
+    // give the source skins to the batches. NOTE several batches may use the same source skin, in
+    // this case the first one owns the textures, and the others only share them
+    for (k = 0; k < batchCount; ++k)
     {
-        // add a new item to the transparent items
-        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pTransparentItem,
-                                               sizeof(CSR_SceneItem),
-                                               pScene->m_TransparentItemCount + 1);
+        pBatchMesh         = (CSR_Mesh*)pBatches[k].m_pModel;
+        pBatchMesh->m_Skin = ppSkinMesh[k]->m_Skin;
 
-        // succeeded?
-        if (!pItem)
-            return 0;
+        for (i = 0; i < k; ++i)
+            if (ppSkinMesh[i] == ppSkinMesh[k])
+            {
+                pBatchMesh->m_Skin.m_Texture.m_pBuffer   = 0;
+                pBatchMesh->m_Skin.m_Texture.m_pFileName = 0;
+                pBatchMesh->m_Skin.m_BumpMap.m_pBuffer   = 0;
+                pBatchMesh->m_Skin.m_BumpMap.m_pFileName = 0;
+                pBatchMesh->m_Skin.m_CubeMap.m_pBuffer   = 0;
+                pBatchMesh->m_Skin.m_CubeMap.m_pFileName = 0;
+                break;
+            }
 
-        // get the item index to update
-        index = (int)pScene->m_TransparentItemCount;
+        // notify the caller, thus the texture resources may be linked to the batch skin
+        if (fOnBatchSkin)
+            fOnBatchSkin(&ppSkinMesh[k]->m_Skin, &pBatchMesh->m_Skin);
     }
-    else
-    {
-        // add a new item to the scene items
-        pItem = (CSR_SceneItem*)csrMemoryAlloc(pScene->m_pItem,
-                                               sizeof(CSR_SceneItem),
-                                               pScene->m_ItemCount + 1);
 
-        // succeeded?
-        if (!pItem)
-            return 0;
+    // the other merged meshes share their textures with a batch, as their identifiers match. Notify
+    // the caller about them too
+    if (fOnBatchSkin)
+        for (i = 0; i < pScene->m_ItemCount; ++i)
+        {
+            pMesh = csrSceneItemGetStaticMesh(&pScene->m_pItem[i]);
 
-        // get the scene item index to update
-        index = (int)pScene->m_ItemCount;
-    }
+            // not a merged item?
+            if (!pMesh)
+                continue;
 
-    // initialize the newly created item with the default values
-    csrSceneItemInit(&pItem[index]);
+            for (k = 0; k < batchCount; ++k)
+                if (ppSkinMesh[k] != pMesh && csrSceneBatchSkinMatch(pContext, ppSkinMesh[k], pMesh))
+                    fOnBatchSkin(&pMesh->m_Skin, &((CSR_Mesh*)pBatches[k].m_pModel)->m_Skin);
+        }
 
-    // configure the item
-    pItem[index].m_pModel = pX;
-    pItem[index].m_Type   = CSR_MT_X;
+    // the source meshes no longer own the textures they gave
+    for (k = 0; k < batchCount; ++k)
+        csrSkinInit(&ppSkinMesh[k]->m_Skin);
 
-    // generate the aligned-axis bounding box tree for this model
-    if (aabb)
+    free(ppSkinMesh);
+
+    // delete the merged items. NOTE their textures are used by the batches, thus they should not
+    // be deleted. NOTE also the last item is moved on the deleted one, thus the items are deleted
+    // from the last to the first
+    for (i = pScene->m_ItemCount; i > 0; --i)
+        if (csrSceneItemGetStaticMesh(&pScene->m_pItem[i - 1]))
+            csrSceneDeleteItemAt(pScene, 0, i - 1, 0);
+
+    // add the batches to the scene
+    for (k = 0; k < batchCount; ++k)
     {
-        size_t i;
+        pBatchMesh = (CSR_Mesh*)pBatches[k].m_pModel;
 
-        // reserve memory for all the AABB trees to create
-        pItem[index].m_AABBTreeCount = pX->m_MeshCount;
-        pItem[index].m_pAABBTree     = (CSR_AABBNode*)csrMemoryAlloc(0,
-                                                                     sizeof(CSR_AABBNode),
-                                                                     pItem[index].m_AABBTreeCount);
+        // empty batch?
+        if (!pBatches[k].m_pBatch->m_Count)
+        {
+            csrSceneItemContentRelease(&pBatches[k], pContext->m_fOnDeleteTexture);
+            continue;
+        }
+
+        // release the memory the batch no longer needs
+        csrSceneBatchShrink(&pBatches[k]);
+
+        // add the batch mesh to the scene
+        pItem = csrSceneAddMesh(pScene, pBatchMesh, 0, pBatches[k].m_CollisionType != CSR_CO_None);
 
         // succeeded?
-        if (!pItem[index].m_pAABBTree)
+        if (!pItem)
         {
-            // realloc to the previous size, thus the latest added item will be freed
-            if (transparent)
-                pScene->m_pTransparentItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                                            sizeof(CSR_SceneItem),
-                                                                            pScene->m_TransparentItemCount);
-            else
-                pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                                 sizeof(CSR_SceneItem),
-                                                                 pScene->m_ItemCount);
-
-            return 0;
+            csrSceneItemContentRelease(&pBatches[k], pContext->m_fOnDeleteTexture);
+            success = 0;
+            continue;
         }
 
-        // iterate through the meshes
-        for (i = 0; i < pX->m_MeshCount; ++i)
-        {
-            // create a new tree for the mesh
-            CSR_AABBNode* pAABBTree = csrAABBTreeFromMesh(&pX->m_pMesh[i]);
+        // the batch item takes over the batch content
+        pItem->m_CollisionType = pBatches[k].m_CollisionType;
+        pItem->m_Static        = 1;
+        pItem->m_pBatch        = pBatches[k].m_pBatch;
+        pItem->m_Occluder      = pBatches[k].m_Occluder;
 
-            // succeeded?
-            if (!pAABBTree)
-            {
-                // realloc to the previous size, thus the latest added item will be freed
-                if (transparent)
-                    pScene->m_pTransparentItem =
-                            (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                           sizeof(CSR_SceneItem),
-                                                           pScene->m_TransparentItemCount);
-                else
-                    pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
-                                                                     sizeof(CSR_SceneItem),
-                                                                     pScene->m_ItemCount);
+        // the batch vertices are already in the world coordinates system
+        pIdentity = (CSR_Matrix4*)malloc(sizeof(CSR_Matrix4));
 
-                return 0;
-            }
+        // succeeded?
+        if (!pIdentity)
+        {
+            success = 0;
+            continue;
+        }
 
-            // copy the tree content
-            memcpy(&pItem[index].m_pAABBTree[i], pAABBTree, sizeof(CSR_AABBNode));
+        csrMat4Identity(pIdentity);
 
-            // release the source tree (NOTE reset his value before, otherwise the copied tree
-            // content will also be released, which will corrupt the tree)
-            pAABBTree->m_pParent        = 0;
-            pAABBTree->m_pLeft          = 0;
-            pAABBTree->m_pRight         = 0;
-            pAABBTree->m_pBox           = 0;
-            pAABBTree->m_pPolygonBuffer = 0;
-            csrAABBTreeNodeRelease(pAABBTree);
+        // add the batch instance. NOTE the matrix is owned by the matrix array
+        if (csrSceneAddModelMatrix(pScene, pBatchMesh, pIdentity))
+            pItem->m_pMatrixArray->m_pItem[pItem->m_pMatrixArray->m_Count - 1].m_AutoFree = 1;
+        else
+        {
+            free(pIdentity);
+            success = 0;
         }
     }
 
-    // do add a transparent item?
-    if (transparent)
-    {
-        // add item to the transparent item list
-        pScene->m_pTransparentItem = pItem;
-        ++pScene->m_TransparentItemCount;
-    }
-    else
-    {
-        // add item to the normal item list
-        pScene->m_pItem = pItem;
-        ++pScene->m_ItemCount;
-    }
+    free(pBatches);
 
-    return &pItem[index];
+    return success;
 }
 //---------------------------------------------------------------------------
-CSR_SceneItem* csrSceneAddModelMatrix(CSR_Scene* pScene, const void* pModel, CSR_Matrix4* pMatrix)
+int csrSceneWrite(const CSR_Scene* pScene, CSR_Buffer* pBuffer)
 {
-    CSR_SceneItem* pSceneItem;
+    size_t               i;
+    size_t               j;
+    size_t               start;
+    size_t               tableOffset;
+    size_t               index;
+    size_t               count;
+    const CSR_SceneItem* pItems;
+    unsigned             header[5];
+    float                data[39];
 
-    // validate inputs
-    if (!pScene || !pModel || !pMatrix)
+    // validate the inputs
+    if (!pScene || !pBuffer)
         return 0;
 
-    // get the scene item matching with the model for which the matrix should be added
-    pSceneItem = csrSceneGetItem(pScene, pModel);
+    // the item offsets are relative to the scene start
+    start = pBuffer->m_Length;
 
-    // found it?
-    if (!pSceneItem)
+    // write the scene header, containing the item counts
+    header[0] = M_CSR_Scene_File_ID;
+    header[1] = M_CSR_Scene_File_Version;
+    header[2] = 0;
+    header[3] = 0;
+    header[4] = pScene->m_pSkybox ? 1 : 0;
+
+    for (i = 0; i < pScene->m_ItemCount; ++i)
+        if (csrSceneFileCanWriteItem(&pScene->m_pItem[i]))
+            ++header[2];
+
+    for (i = 0; i < pScene->m_TransparentItemCount; ++i)
+        if (csrSceneFileCanWriteItem(&pScene->m_pTransparentItem[i]))
+            ++header[3];
+
+    if (!csrBufferWrite(pBuffer, header, sizeof(unsigned), 5))
         return 0;
 
-    // do create a matrix array for the item?
-    if (!pSceneItem->m_pMatrixArray)
-    {
-        // create a new matrix array
-        pSceneItem->m_pMatrixArray = (CSR_Array*)csrMemoryAlloc(0, sizeof(CSR_Array), 1);
+    // write the scene color, ground direction, projection and view matrices
+    data[0] = pScene->m_Color.m_R;
+    data[1] = pScene->m_Color.m_G;
+    data[2] = pScene->m_Color.m_B;
+    data[3] = pScene->m_Color.m_A;
+    data[4] = pScene->m_GroundDir.m_X;
+    data[5] = pScene->m_GroundDir.m_Y;
+    data[6] = pScene->m_GroundDir.m_Z;
+    memcpy(&data[7],  pScene->m_ProjectionMatrix.m_Table, sizeof(float) * 16);
+    memcpy(&data[23], pScene->m_ViewMatrix.m_Table,       sizeof(float) * 16);
+
+    if (!csrBufferWrite(pBuffer, data, sizeof(float), 39))
+        return 0;
 
-        // succeeded?
-        if (!pSceneItem->m_pMatrixArray)
+    // write the skybox
+    if (pScene->m_pSkybox && !csrSceneFileWriteMesh(pScene->m_pSkybox, pBuffer))
+        return 0;
+
+    // reserve the item offset table, it will be filled while the items are written
+    tableOffset = pBuffer->m_Length;
+
+    for (i = 0; i < (size_t)header[2] + header[3]; ++i)
+        if (!csrSceneFileWriteUnsigned(0, pBuffer))
             return 0;
 
-        // initialize the array content
-        csrArrayInit(pSceneItem->m_pMatrixArray);
-    }
+    index = 0;
 
-    // add the matrix to the array
-    csrArrayAddUnique(pMatrix, pSceneItem->m_pMatrixArray, 0);
+    // write the normal items, then the transparent ones
+    for (i = 0; i < 2; ++i)
+    {
+        if (!i)
+        {
+            pItems = pScene->m_pItem;
+            count  = pScene->m_ItemCount;
+        }
+        else
+        {
+            pItems = pScene->m_pTransparentItem;
+            count  = pScene->m_TransparentItemCount;
+        }
 
-    return pSceneItem;
+        for (j = 0; j < count; ++j)
+        {
+            unsigned itemOffset;
+
+            // skip the items which cannot be written
+            if (!csrSceneFileCanWriteItem(&pItems[j]))
+                continue;
+
+            // set the item offset in the table
+            itemOffset = (unsigned)(pBuffer->m_Length - start);
+            memcpy((unsigned char*)pBuffer->m_pData + tableOffset + index * sizeof(unsigned),
+                   &itemOffset,
+                   sizeof(unsigned));
+
+            // write the item
+            if (!csrSceneFileWriteItem(&pItems[j], pBuffer))
+                return 0;
+
+            ++index;
+        }
+    }
+
+    return 1;
 }
 //---------------------------------------------------------------------------
-CSR_SceneItem* csrSceneGetItem(const CSR_Scene* pScene, const void* pKey)
+int csrSceneSave(const CSR_Scene* pScene, const char* pFileName)
 {
-    size_t i;
-    size_t j;
+    int         success;
+    CSR_Buffer* pBuffer;
 
-    // validate inputs
-    if (!pScene || !pKey)
+    // validate the inputs
+    if (!pScene || !pFileName)
         return 0;
 
-    // first search in the standard models
-    for (i = 0; i < pScene->m_ItemCount; ++i)
-    {
-        // found a matching model?
-        if (pScene->m_pItem[i].m_pModel == pKey)
-            return &pScene->m_pItem[i];
+    // create a buffer to write the scene in
+    pBuffer = csrBufferCreate();
 
-        // check also if the key is a known matrix
-        if (pScene->m_pItem[i].m_pMatrixArray)
-            for (j = 0; j < pScene->m_pItem[i].m_pMatrixArray->m_Count; ++j)
-                if (&pScene->m_pItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
-                    return &pScene->m_pItem[i];
-    }
+    // succeeded?
+    if (!pBuffer)
+        return 0;
 
-    // then search in the transparent models
-    for (i = 0; i < pScene->m_TransparentItemCount; ++i)
-    {
-        // found a matching model?
-        if (pScene->m_pTransparentItem[i].m_pModel == pKey)
-            return &pScene->m_pTransparentItem[i];
+    // write the scene, and save it
+    success = csrSceneWrite(pScene, pBuffer) && csrFileSave(pFileName, pBuffer);
 
-        // check also if the key is a known matrix
-        if (pScene->m_pTransparentItem[i].m_pMatrixArray)
-            for (j = 0; j < pScene->m_pTransparentItem[i].m_pMatrixArray->m_Count; ++j)
-                if (&pScene->m_pTransparentItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
-                    return &pScene->m_pTransparentItem[i];
-    }
+    csrBufferRelease(pBuffer);
 
-    // not found
-    return 0;
+    return success;
 }
 //---------------------------------------------------------------------------
-void csrSceneDeleteFrom(      CSR_Scene*           pScene,
-                        const void*                pKey,
-                        const CSR_fOnDeleteTexture fOnDeleteTexture)
+CSR_Scene* csrSceneRead(const CSR_Buffer* pBuffer, size_t offset)
 {
-    size_t         i;
-    size_t         j;
-    CSR_SceneItem* pSceneItem;
+    size_t     i;
+    size_t     start;
+    size_t     itemCount;
+    size_t     transparentItemCount;
+    CSR_Scene* pScene;
+    unsigned   header[5];
+    float      data[39];
+
+    // no buffer to read from?
+    if (!pBuffer)
+        return 0;
 
-    // validate inputs
-    if (!pScene || !pKey)
-        return;
+    // the item offsets are relative to the scene start
+    start = offset;
 
-    // first search in the standard models
-    for (i = 0; i < pScene->m_ItemCount; ++i)
+    // read the scene header
+    if (!csrSceneFileRead(pBuffer, &offset, sizeof(unsigned), 5, header))
+        return 0;
+
+    // is a scene file with a known version?
+    if (header[0] != M_CSR_Scene_File_ID || header[1] != M_CSR_Scene_File_Version)
+        return 0;
+
+    itemCount            = header[2];
+    transparentItemCount = header[3];
+
+    // read the scene color, ground direction, projection and view matrices
+    if (!csrSceneFileRead(pBuffer, &offset, sizeof(float), 39, data))
+        return 0;
+
+    // create the scene
+    pScene = csrSceneCreate();
+
+    // succeeded?
+    if (!pScene)
+        return 0;
+
+    pScene->m_Color.m_R     = data[0];
+    pScene->m_Color.m_G     = data[1];
+    pScene->m_Color.m_B     = data[2];
+    pScene->m_Color.m_A     = data[3];
+    pScene->m_GroundDir.m_X = data[4];
+    pScene->m_GroundDir.m_Y = data[5];
+    pScene->m_GroundDir.m_Z = data[6];
+    memcpy(pScene->m_ProjectionMatrix.m_Table, &data[7],  sizeof(float) * 16);
+    memcpy(pScene->m_ViewMatrix.m_Table,       &data[23], sizeof(float) * 16);
+
+    // read the skybox
+    if (header[4])
     {
-        // found a matching model?
-        if (pScene->m_pItem[i].m_pModel == pKey)
+        pScene->m_pSkybox = csrMeshCreate();
+
+        // succeeded?
+        if (!pScene->m_pSkybox || !csrSceneFileReadMesh(pBuffer, &offset, pScene->m_pSkybox))
         {
-            // delete the item from the list
-            pSceneItem = csrSceneItemDeleteModelFrom(pScene->m_pItem,
-                                                     i,
-                                                     pScene->m_ItemCount,
-                                                     fOnDeleteTexture);
+            csrSceneRelease(pScene, 0);
+            return 0;
+        }
+    }
 
-            // update the scene content
-            free(pScene->m_pItem);
-            pScene->m_pItem = pSceneItem;
-            --pScene->m_ItemCount;
+    // is the item offset table complete?
+    if (!csrSceneFileCanRead(pBuffer, offset, sizeof(unsigned), itemCount + transparentItemCount))
+    {
+        csrSceneRelease(pScene, 0);
+        return 0;
+    }
 
-            return;
-        }
+    // reserve the memory for all the items
+    if (itemCount)
+        pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(0, sizeof(CSR_SceneItem), itemCount);
 
-        // check also if the key is a known matrix
-        if (pScene->m_pItem[i].m_pMatrixArray)
-            for (j = 0; j < pScene->m_pItem[i].m_pMatrixArray->m_Count; ++j)
-                if (pScene->m_pItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
-                {
-                    // delete the matrix
-                    csrArrayDeleteAt(j, pScene->m_pItem[i].m_pMatrixArray);
-                    return;
-                }
+    if (transparentItemCount)
+        pScene->m_pTransparentItem = (CSR_SceneItem*)csrMemoryAlloc(0,
+                                                                    sizeof(CSR_SceneItem),
+                                                                    transparentItemCount);
+
+    // succeeded?
+    if ((itemCount && !pScene->m_pItem) || (transparentItemCount && !pScene->m_pTransparentItem))
+    {
+        csrSceneRelease(pScene, 0);
+        return 0;
     }
 
-    // then search in the transparent models
-    for (i = 0; i < pScene->m_TransparentItemCount; ++i)
+    // read the items, the normal ones first
+    for (i = 0; i < itemCount + transparentItemCount; ++i)
     {
-        // found a matching model?
-        if (pScene->m_pTransparentItem[i].m_pModel == pKey)
+        const int            transparent = (i >= itemCount);
+        const size_t         index       = transparent ? i - itemCount : i;
+              CSR_SceneItem* pItem       = transparent ? &pScene->m_pTransparentItem[index] :
+                                                         &pScene->m_pItem[index];
+              size_t         itemOffset;
+
+        // get the item offset from the table
+        if (!csrSceneFileReadUnsigned(pBuffer, &offset, &itemOffset))
         {
-            // delete the item from the list
-            pSceneItem = csrSceneItemDeleteModelFrom(pScene->m_pTransparentItem,
-                                                     i,
-                                                     pScene->m_TransparentItemCount,
-                                                     fOnDeleteTexture);
+            csrSceneRelease(pScene, 0);
+            return 0;
+        }
 
-            // update the scene content
-            free(pScene->m_pTransparentItem);
-            pScene->m_pTransparentItem = pSceneItem;
-            --pScene->m_TransparentItemCount;
+        csrSceneItemInit(pItem);
 
-            return;
+        // read the item
+        if (!csrSceneFileReadItem(pScene, pBuffer, start + itemOffset, index, transparent, pItem))
+        {
+            csrSceneItemContentRelease(pItem, 0);
+            csrSceneRelease(pScene, 0);
+            return 0;
         }
 
-        // check also if the key is a known matrix
-        if (pScene->m_pTransparentItem[i].m_pMatrixArray)
-            for (j = 0; j < pScene->m_pTransparentItem[i].m_pMatrixArray->m_Count; ++j)
-                if (pScene->m_pTransparentItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
-                {
-                    // delete the matrix
-                    csrArrayDeleteAt(j, pScene->m_pItem[i].m_pMatrixArray);
-                    return;
-                }
+        // add the item to the scene
+        if (transparent)
+            ++pScene->m_TransparentItemCount;
+        else
+            ++pScene->m_ItemCount;
     }
+
+    return pScene;
+}
+//---------------------------------------------------------------------------
+CSR_Scene* csrSceneOpen(const char* pFileName)
+{
+    CSR_Buffer* pBuffer;
+    CSR_Scene*  pScene;
+
+    // open the scene file
+    pBuffer = csrFileOpen(pFileName);
+
+    // succeeded?
+    if (!pBuffer)
+        return 0;
+
+    // read the scene
+    pScene = csrSceneRead(pBuffer, 0);
+
+    csrBufferRelease(pBuffer);
+
+    return pScene;
 }
 //---------------------------------------------------------------------------
 void csrSceneDraw(const CSR_Scene* pScene, const CSR_SceneContext* pContext)
 {
-    size_t i;
+    CSR_Frustum         frustum;
+    CSR_SceneDrawList   drawList;
+    CSR_SceneDrawList*  pDrawList;
+    CSR_SceneDepthList  depthList;
+    CSR_SceneDepthList* pDepthList;
 
     // no scene to draw?
     if (!pScene)
@@ -1438,6 +6062,8 @@ void csrSceneDraw(const CSR_Scene* pScene, const CSR_SceneContext* pContext)
     if (!pContext)
         return;
 
+    csrProfilerBegin("Scene draw");
+
     // begin the scene drawing
     if (pContext->m_fOnSceneBegin)
         pContext->m_fOnSceneBegin(pScene, pContext);
@@ -1449,6 +6075,8 @@ void csrSceneDraw(const CSR_Scene* pScene, const CSR_SceneContext* pContext)
     {
         void* pShader = 0;
 
+        csrProfilerBegin("Skybox");
+
         // get the shader to use with the skybox
         if (pContext->m_fOnGetShader)
             pShader = pContext->m_fOnGetShader(pScene->m_pSkybox, CSR_MT_Mesh);
@@ -1487,33 +6115,81 @@ void csrSceneDraw(const CSR_Scene* pScene, const CSR_SceneContext* pContext)
             // enable the depth buffer writing again
             csrStateEnableDepthMask(1);
         }
+
+        csrProfilerEnd();
     }
 
+    csrProfilerBegin("Opaque");
+
+    // get the scene view frustum, used to cull the items out of the view
+    csrSceneGetFrustum(pScene, &frustum);
+
+    // rasterize the occluders, the instances they hide will be culled
+    if (pContext->m_pOcclusionBuffer)
+        csrSceneOcclusionBufferBuild(pScene, pContext->m_pOcclusionBuffer);
+
     // prepare the scene to draw common models
     if (pContext->m_fOnPrepareDraw)
         pContext->m_fOnPrepareDraw(pScene, pContext);
 
-    // first draw the standard models
-    for (i = 0; i < pScene->m_ItemCount; ++i)
-        csrSceneItemDraw(pScene,
-                         pContext,
-                        &pScene->m_pItem[i]);
+    // the draw list memory is kept between frames if the context provides a draw list
+    if (pContext->m_pDrawList)
+    {
+        pDrawList = pContext->m_pDrawList;
+        csrSceneDrawListClear(pDrawList);
+    }
+    else
+    {
+        csrSceneDrawListInit(&drawList);
+        pDrawList = &drawList;
+    }
+
+    // first draw the standard models, sorted by render states to minimize the state changes
+    csrSceneDrawListPrepare(pScene, pContext, pScene->m_pItem, pScene->m_ItemCount, &frustum, pDrawList);
+    csrSceneDrawListSort(pContext, pDrawList);
+    csrSceneDrawListSubmit(pScene, pContext, pDrawList);
+
+    if (!pContext->m_pDrawList)
+        csrSceneDrawListContentRelease(&drawList);
+
+    csrProfilerEnd();
+
+    csrProfilerBegin("Transparent");
 
     // prepare the scene to draw transparent models
     if (pContext->m_fOnPrepareTransparentDraw)
         pContext->m_fOnPrepareTransparentDraw(pScene, pContext);
 
-    // then draw the transparent models
-    for (i = 0; i < pScene->m_TransparentItemCount; ++i)
-        csrSceneItemDraw(pScene,
-                         pContext,
-                        &pScene->m_pTransparentItem[i]);
+    // then draw the transparent models, from the farthest to the nearest instance. NOTE the order
+    // is kept between frames if the context provides a depth list
+    if (pContext->m_pTransparentList)
+        pDepthList = pContext->m_pTransparentList;
+    else
+    {
+        csrSceneDepthListInit(&depthList);
+        pDepthList = &depthList;
+    }
+
+    csrSceneDepthListBuild(pScene,
+                           pContext,
+                           pScene->m_pTransparentItem,
+                           pScene->m_TransparentItemCount,
+                          &frustum,
+                           pDepthList);
+    csrSceneDepthListSubmit(pScene, pContext, pDepthList);
+
+    if (!pContext->m_pTransparentList)
+        csrSceneDepthListContentRelease(&depthList);
+
+    csrProfilerEnd();
 
     // end the scene drawing
     if (pContext->m_fOnSceneEnd)
         pContext->m_fOnSceneEnd(pScene, pContext);
     else
         csrDrawEnd();
+
+    csrProfilerEnd();
 }
 //---------------------------------------------------------------------------
 void csrSceneArcBallToMatrix(const CSR_ArcBall* pArcball, CSR_Matrix4* pR)
@@ -1665,6 +6341,8 @@ void csrSceneDetectCollision(const CSR_Scene*                   pScene,
     if (!pScene || !pCollisionInput || !pCollisionOutput)
         return;
 
+    csrProfilerBegin("Scene collision");
+
     // initialize the collision output
     csrCollisionOutputInit(pCollisionOutput);
 
@@ -1683,6 +6361,8 @@ void csrSceneDetectCollision(const CSR_Scene*                   pScene,
                                     pCollisionInput,
                                     pCollisionOutput,
                                     fOnCustomDetectCollision);
+
+    csrProfilerEnd();
 }
 //---------------------------------------------------------------------------
 void csrSceneTouchPosToViewportPos(const CSR_Vector2* pTouchPos,
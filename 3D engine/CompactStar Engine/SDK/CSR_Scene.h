@@ -22,12 +22,17 @@
 #include "CSR_Collision.h"
 #include "CSR_Model.h"
 #include "CSR_Renderer.h"
+#include "CSR_SoftwareRaster.h"
+#include "CSR_Profiler.h"
 
 //---------------------------------------------------------------------------
 // Global defines
 //---------------------------------------------------------------------------
 
-#define M_CSR_NoGround 1.0f / 0.0f // i.e. infinite, this is the only case where a division by 0 is allowed
+#define M_CSR_NoGround           1.0f / 0.0f // i.e. infinite, this is the only case where a division by 0 is allowed
+#define M_CSR_Scene_File_ID      (('N' << 24) + ('C' << 16) + ('S' << 8) + 'C')
+#define M_CSR_Scene_File_Version 3
+#define M_CSR_Scene_Max_Depth    1024        // deepest aligned-axis bounding box tree a scene file may contain
 
 //---------------------------------------------------------------------------
 // Enumerators
@@ -81,36 +86,266 @@ typedef struct CSR_SceneContext CSR_SceneContext;
 // Structures
 //---------------------------------------------------------------------------
 
+/**
+* Scene item level of detail
+*/
+typedef struct
+{
+    void* m_pModel;   // model to draw from this level, of the same type as the item model. 0 to hide the instances
+    float m_Distance; // distance from the camera from which this level is used
+} CSR_SceneLOD;
+
+/**
+* Scene item level of detail group
+*/
+typedef struct
+{
+    CSR_SceneLOD*  m_pLevel;     // lower detail levels, sorted by ascending distance. The item model is the level 0
+    size_t         m_Count;      // level count
+    float          m_Hysteresis; // relative distance to exceed around a threshold before the level changes, e.g. 0.1 for 10%
+    unsigned char* m_pState;     // current level of each item instance
+    size_t         m_StateCount; // level state count
+} CSR_SceneLODGroup;
+
+/**
+* Scene batch range, i.e. the vertices a static instance brought in a batch
+*/
+typedef struct
+{
+    size_t  m_VBIndex; // vertex buffer containing the vertices, in the batch mesh
+    size_t  m_Start;   // first vertex value in the vertex buffer data
+    size_t  m_Count;   // vertex value count
+    CSR_Box m_Box;     // instance bounding box, in the world coordinates system. The batch is culled if all its boxes are
+} CSR_SceneBatchRange;
+
+/**
+* Scene batch, i.e. the static instances merged in a single mesh
+*/
+typedef struct
+{
+    CSR_SceneBatchRange* m_pRange;
+    size_t               m_Count;
+} CSR_SceneBatch;
+
+/**
+* Scene item indexes, i.e. the model, skin, mesh or animation indexes the caller selected to draw an item
+*/
+typedef struct
+{
+    size_t m_ModelIndex;   // model index, for a model or a MDL model
+    size_t m_SkinIndex;    // skin index, for a MDL model
+    size_t m_MeshIndex;    // mesh index, for a MDL model
+    size_t m_AnimSetIndex; // animation set index, for a X model
+    size_t m_FrameIndex;   // frame index, for a X model
+} CSR_SceneItemIndex;
+
 /**
 * Scene item
 */
 typedef struct
 {
-    void*              m_pModel;        // the model to draw
-    CSR_EModelType     m_Type;          // model type (a simple mesh, a model or a complex MDL model)
-    CSR_ECollisionType m_CollisionType; // collision type to apply to model
-    CSR_Array*         m_pMatrixArray;  // matrices sharing the same model, e.g. all the walls of a room
-    CSR_AABBNode*      m_pAABBTree;     // aligned-axis bounding box trees owned by the model
-    size_t             m_AABBTreeCount; // aligned-axis bounding box tree count
-    size_t             m_AABBTreeIndex; // aligned-axis bounding box tree index to use for the collision detection
+    void*               m_pModel;              // the model to draw
+    CSR_EModelType      m_Type;                // model type (a simple mesh, a model or a complex MDL model)
+    CSR_ECollisionType  m_CollisionType;       // collision type to apply to model
+    CSR_Array*          m_pMatrixArray;        // matrices sharing the same model, e.g. all the walls of a room
+    CSR_AABBNode*       m_pAABBTree;           // aligned-axis bounding box trees owned by the model
+    size_t              m_AABBTreeCount;       // aligned-axis bounding box tree count
+    size_t              m_AABBTreeIndex;       // aligned-axis bounding box tree index to use for the collision detection
+    CSR_Box             m_Box;                 // model bounding box, in the model coordinates system
+    int                 m_HasBox;              // if 1, the box is valid and the instances out of the view are culled
+    CSR_Handle          m_Handle;              // item handle, 0 if the item has no handle
+    CSR_Handle*         m_pInstanceHandle;     // instance handles, in the same order as the matrices
+    size_t              m_InstanceHandleCount; // instance handle count
+    CSR_SceneLODGroup*  m_pLOD;                // levels of detail, 0 if the item model is always drawn
+    CSR_Polygon3Buffer  m_Occluder;            // low-poly occluder hiding what is behind the instances, in model coordinates
+    int                 m_Static;              // if 1, the instances never move, thus they may be batched
+    CSR_SceneBatch*     m_pBatch;              // merged instance ranges if the item is a batch, otherwise 0
+    CSR_SceneItemIndex* m_pIndex;              // indexes frozen by a scene snapshot, if 0 they are asked to the context
 } CSR_SceneItem;
 
+/**
+* Transform node, i.e. a local transformation relative to a parent node
+*/
+typedef struct
+{
+    CSR_Vector3    m_Position;     // local position, relative to the parent
+    CSR_Quaternion m_Rotation;     // local rotation, relative to the parent
+    CSR_Vector3    m_Scaling;      // local scaling, relative to the parent
+    CSR_Matrix4    m_World;        // cached world matrix
+    CSR_Matrix4*   m_pTarget;      // matrix receiving the world matrix, e.g. a scene item instance, may be 0
+    size_t         m_Parent;       // parent node index, M_CSR_Unknown_Index if the node is a root
+    int            m_Dirty;        // if 1, the local transformation changed since the last update
+    int            m_WorldChanged; // if 1, the world matrix changed during the last update
+} CSR_TransformNode;
+
+/**
+* Transform hierarchy
+*@note The nodes are always sorted in such a way that a parent precedes its children
+*/
+typedef struct
+{
+    CSR_TransformNode* m_pNode;
+    size_t             m_Count;
+    size_t             m_FirstDirty;   // first node to update, m_Count if the hierarchy is up to date
+    size_t             m_FirstChanged; // first node whose world matrix changed during the last update
+} CSR_TransformHierarchy;
+
 /**
 * Scene
 */
 typedef struct
 {
-    CSR_Color        m_Color;                // the scene background color
-    CSR_Matrix4      m_ProjectionMatrix;     // the scene projection matrix
-    CSR_Matrix4      m_ViewMatrix;           // the scene view matrix
-    CSR_Vector3      m_GroundDir;            // the ground direction in the whole scene
-    CSR_Mesh*        m_pSkybox;              // skybox geometry (because there is only one skybox per scene)
-    CSR_SceneItem*   m_pItem;                // the items in this list will be drawn in the scene
-    size_t           m_ItemCount;            // number of items
-    CSR_SceneItem*   m_pTransparentItem;     // the items in this list will be drawn on the scene end, allowing transparency
-    size_t           m_TransparentItemCount; // number of transparent items
+    CSR_Color              m_Color;                // the scene background color
+    CSR_Matrix4            m_ProjectionMatrix;     // the scene projection matrix
+    CSR_Matrix4            m_ViewMatrix;           // the scene view matrix
+    CSR_Vector3            m_GroundDir;            // the ground direction in the whole scene
+    CSR_Mesh*              m_pSkybox;              // skybox geometry (because there is only one skybox per scene)
+    CSR_SceneItem*         m_pItem;                // the items in this list will be drawn in the scene
+    size_t                 m_ItemCount;            // number of items
+    CSR_SceneItem*         m_pTransparentItem;     // the items in this list will be drawn on the scene end, allowing transparency
+    size_t                 m_TransparentItemCount; // number of transparent items
+    CSR_HandleTable        m_ItemHandles;          // handles linked to the items
+    CSR_HandleTable        m_InstanceHandles;      // handles linked to the item instances (i.e. their matrices)
+    CSR_TransformHierarchy m_Transforms;           // transform hierarchy, may drive the item instance matrices
 } CSR_Scene;
 
+/**
+* Scene snapshot, i.e. a copy of the scene dynamic state which may be drawn while the scene changes
+*@note The snapshot scene shares its models, trees, level of detail models and skybox with the source
+*      scene, but owns its items, instance matrices, level of detail states and item indexes, thus
+*      drawing it never writes the source scene memory. It should never be released with
+*      csrSceneRelease()
+*/
+typedef struct
+{
+    CSR_Scene           m_Scene;         // scene copy to draw
+    CSR_SceneItem*      m_pItem;         // item copies, the normal items followed by the transparent ones
+    CSR_Array*          m_pArray;        // matrix arrays linked by the item copies
+    CSR_SceneItemIndex* m_pIndex;        // item indexes, in the same order as the item copies
+    size_t              m_ItemCount;     // item copy count
+    CSR_ArrayItem*      m_pArrayItem;    // matrix array content, shared by all the arrays
+    CSR_Matrix4*        m_pMatrix;       // instance matrix copies
+    size_t              m_MatrixCount;   // instance matrix copy count
+    CSR_SceneLODGroup*  m_pLOD;          // level of detail group copies, linked by the item copies
+    size_t              m_LODCount;      // level of detail group copy count
+    unsigned char*      m_pLODState;     // instance level states, shared by all the group copies
+    size_t              m_LODStateCount; // instance level state count
+} CSR_SceneSnapshot;
+
+/**
+* Scene state, i.e. the scene dynamic state, double-buffered between the update and the rendering
+*@note The update side writes the back snapshot while the render side draws the front one. The
+*      update side then swaps them, the front index being published with a release store and read
+*      with an acquire load, thus no lock is required (on the compilers supporting it, i.e. gcc and
+*      clang, otherwise the swap should be synchronized by the caller)
+*/
+typedef struct
+{
+    CSR_SceneSnapshot m_Snapshot[2];
+    size_t            m_Front;       // index of the snapshot to draw, only accessed atomically
+} CSR_SceneState;
+
+/**
+* Scene draw command, i.e. a scene item ready to be submitted to the renderer
+*/
+typedef struct
+{
+    const CSR_SceneItem*     m_pItem;        // scene item to draw
+          void*              m_pModel;       // model to draw, i.e. the item model or one of its levels of detail
+          void*              m_pShader;      // shader to use to draw the item
+          CSR_SceneItemIndex m_Index;        // indexes to draw the model with, shared by all the item levels of detail
+          CSR_Array          m_VisibleArray; // visible instance matrices, linked from the draw list matrices
+          size_t             m_VisibleIndex; // index of the first visible instance matrix in the draw list matrices
+          int                m_Culled;       // if 1, only the instances contained in m_VisibleArray are drawn
+          unsigned           m_Key;          // sort key, built from the render states the item requires
+} CSR_SceneDrawCommand;
+
+/**
+* Scene draw list rank table, i.e. a hash table giving the rank of each key, the keys being ranked
+* in the order they are first met
+*/
+typedef struct
+{
+    const void** m_pKey;  // ranked keys
+    unsigned*    m_pRank; // key ranks, plus one. 0 if the slot is empty
+    size_t       m_Size;  // slot count, always a power of 2
+    size_t       m_Count; // ranked key count
+} CSR_SceneRankTable;
+
+/**
+* Scene draw list
+*@note The list memory is only grown, and kept when the list is cleared, thus a list reused between
+*      frames allocates nothing as long as the scene doesn't grow, see the context m_pDrawList
+*/
+typedef struct
+{
+    CSR_SceneDrawCommand* m_pCommand;
+    size_t                m_Count;
+    size_t                m_Size;        // command count the command array may contain
+    CSR_ArrayItem*        m_pMatrix;     // visible instance matrices of all the commands, only linked
+    size_t                m_MatrixCount; // visible instance matrix count
+    size_t                m_MatrixSize;  // matrix count the matrix array may contain
+    unsigned char*        m_pLevel;      // instance levels of detail, used while an item is prepared
+    size_t                m_LevelSize;   // level count the level array may contain
+    CSR_SortItem*         m_pSortItem;   // command sort keys, used while the list is sorted
+    size_t                m_SortSize;    // sort key count the sort key array may contain
+    CSR_SceneRankTable    m_Rank[3];     // shader, texture and model ranks, used while the list is sorted
+} CSR_SceneDrawList;
+
+/**
+* Scene draw job, i.e. a range of scene items to prepare for drawing, possibly on another thread
+*/
+typedef struct
+{
+    const CSR_Scene*        m_pScene;   // scene owning the items
+    const CSR_SceneContext* m_pContext; // scene context
+    const CSR_SceneItem*    m_pItems;   // first scene item to prepare
+          size_t            m_Count;    // scene item count
+    const CSR_Frustum*      m_pFrustum; // view frustum against which the item instances are culled, may be 0
+          CSR_SceneDrawList m_List;     // draw list receiving the prepared items
+          int               m_Success;  // 1 if the job succeeded, otherwise 0
+} CSR_SceneDrawJob;
+
+/**
+* Scene instance, i.e. a single instance of a scene item, ready to be drawn
+*/
+typedef struct
+{
+    const CSR_SceneItem*     m_pItem;   // scene item owning the instance
+          void*              m_pModel;  // model to draw, i.e. the item model or one of its levels of detail
+          void*              m_pShader; // shader to use to draw the instance
+          CSR_SceneItemIndex m_Index;   // indexes to draw the model with, shared by all the item instances
+          CSR_ArrayItem      m_Matrix;  // instance matrix, linked from the item matrix array. 0 if the item has no matrix
+          int                m_Visible; // if 0, the instance is out of the view frustum
+} CSR_SceneInstance;
+
+/**
+* Scene depth list, contains the scene instances sorted from the farthest to the nearest
+*@note The drawing order is kept between frames, so re-sorting a scene in which the instances
+*      moved only a little is almost free
+*/
+typedef struct
+{
+    CSR_SceneInstance* m_pInstance; // instances, in the scene order
+    CSR_SortItem*      m_pOrder;    // instance drawing order, from the farthest to the nearest
+    size_t             m_Count;     // instance count
+    CSR_ArrayItem*     m_pVisible;  // scratch array listing the visible item instances, for the visible set callback
+    CSR_ArrayItem*     m_pGroup;    // scratch array grouping the instance matrices drawn together
+    size_t             m_Size;      // scratch array size, only grows, thus they aren't reallocated each frame
+} CSR_SceneDepthList;
+
+/**
+* Scene occlusion buffer, i.e. a small depth buffer in which the scene occluders are rasterized
+*@note The occluders are written with the farthest depth they reach inside each texel, and the tested
+*      boxes are extended by one texel, thus an instance is only culled if it's certainly hidden
+*/
+typedef struct
+{
+    CSR_DepthBuffer m_DepthBuffer;    // occluder depths, in normalized device coordinates
+    CSR_Matrix4     m_ViewProjMatrix; // view projection matrix used to rasterize the occluders
+    size_t          m_PolygonCount;   // occluder polygons rasterized during the last build, nothing is culled if 0
+} CSR_SceneOcclusionBuffer;
+
 /**
 * Camera
 */
@@ -209,13 +444,83 @@ typedef void (*CSR_fOnPrepareTransparentDraw)(const CSR_Scene* pScene, const CSR
 *@param type - model type
 *@return shader to use to draw the model, 0 if no shader
 *@note The model will not be drawn if no shader is returned
+*@note This callback may be called from several threads at once, see CSR_fOnRunJobs
+*@note The scene items are all prepared before the first of them is drawn, thus this callback
+*      should only look up the shader, without changing any render state or shader uniform. The
+*      uniforms specific to an item should be set in CSR_fOnDrawItem instead
 */
 typedef void* (*CSR_fOnGetShader)(const void* pModel, CSR_EModelType type);
 
+/**
+* Called when a scene item is about to be drawn
+*@param pScene - scene containing the item
+*@param pContext - scene context
+*@param pItem - scene item about to be drawn
+*@param pShader - shader used to draw the item, already enabled and connected to the scene matrices
+*@note This is the place where the shader uniforms specific to the item should be set. It's called
+*      once per draw, from the thread drawing the scene
+*@note While a render command buffer is recording, this callback is called at record time, thus
+*      the uniforms it sets directly in the graphics library aren't recorded
+*/
+typedef void (*CSR_fOnDrawItem)(const CSR_Scene*        pScene,
+                                const CSR_SceneContext* pContext,
+                                const CSR_SceneItem*    pItem,
+                                      void*             pShader);
+
+/**
+* Called when the visible instances of a scene item were found
+*@param pScene - scene containing the item
+*@param pContext - scene context
+*@param pItem - scene item about to be drawn
+*@param pVisibleMatrixArray - matrices of the visible item instances, may be empty if all the
+*                             instances are out of the view. May be 0 if the item has no matrix
+*@note The array content is only valid while the callback is executed
+*@note This callback may be called from several threads at once, see CSR_fOnRunJobs. However a
+*      given item is always notified by one thread only
+*/
+typedef void (*CSR_fOnVisibleSet)(const CSR_Scene*        pScene,
+                                  const CSR_SceneContext* pContext,
+                                  const CSR_SceneItem*    pItem,
+                                  const CSR_Array*        pVisibleMatrixArray);
+
+/**
+* Called when a batch mesh takes over the textures of a source mesh skin
+*@param pSourceSkin - source mesh skin, released once the batches are built
+*@param pBatchSkin - batch mesh skin, using the same textures
+*@note The resources linked to the source textures, e.g. the identifiers CSR_fOnGetID returns,
+*      should also be linked to the batch textures. Several batches may share the same source skin
+*/
+typedef void (*CSR_fOnBatchSkin)(const CSR_Skin* pSourceSkin, const CSR_Skin* pBatchSkin);
+
+/**
+* Called when a job should be executed
+*@param pJob - job to execute
+*/
+typedef void (*CSR_fOnExecuteJob)(void* pJob);
+
+/**
+* Called when several independent jobs may be executed in parallel, e.g. on a thread pool
+*@param pContext - scene context
+*@param fOnExecuteJob - function to call for each job
+*@param ppJobs - jobs to execute
+*@param count - job count
+*@note All the jobs must be completed before this callback returns. Executing them one after
+*      the other on the calling thread is also valid
+*@note While the jobs are executed, the CSR_fOnGetShader and CSR_fOnVisibleSet callbacks may be
+*      called from several threads at once, and should thus be thread safe. The other callbacks
+*      are always called from the thread drawing the scene
+*/
+typedef void (*CSR_fOnRunJobs)(const CSR_SceneContext* pContext,
+                               const CSR_fOnExecuteJob fOnExecuteJob,
+                                     void**            ppJobs,
+                                     size_t            count);
+
 /**
 * Called when a model index should be get
 *@param pModel - model for which the index should be get
 *@param[in, out] pIndex - model index
+*@note Called once per item and per frame, with the item model. The index is used to draw all the
+*      item levels of detail
 */
 typedef void (*CSR_fOnGetModelIndex)(const CSR_Model* pModel, size_t* pIndex);
 
@@ -225,6 +530,8 @@ typedef void (*CSR_fOnGetModelIndex)(const CSR_Model* pModel, size_t* pIndex);
 *@param[in, out] pSkinIndex - skin index
 *@param[in, out] pModelIndex - model index
 *@param[in, out] pMeshIndex - mesh index
+*@note Called once per item and per frame, with the item model. The indexes are used to draw all
+*      the item levels of detail
 */
 typedef void (*CSR_fOnGetMDLIndex)(const CSR_MDL* pMDL,
                                          size_t*  pSkinIndex,
@@ -236,6 +543,8 @@ typedef void (*CSR_fOnGetMDLIndex)(const CSR_MDL* pMDL,
 *@param pX - X model for which the indexes should be get
 *@param[in, out] pAnimSetIndex - animation set index
 *@param[in, out] pFrameIndex - frame index
+*@note Called once per item and per frame, with the item model. The indexes are used to draw all
+*      the item levels of detail
 */
 typedef void (*CSR_fOnGetXIndex)(const CSR_X* pX, size_t* pAnimSetIndex, size_t* pFrameIndex);
 
@@ -275,8 +584,15 @@ struct CSR_SceneContext
     CSR_fOnGetMDLIndex            m_fOnGetMDLIndex;
     CSR_fOnGetXIndex              m_fOnGetXIndex;
     CSR_fOnGetShader              m_fOnGetShader;
+    CSR_fOnDrawItem               m_fOnDrawItem;
+    CSR_fOnVisibleSet             m_fOnVisibleSet;
     CSR_fOnGetID                  m_fOnGetID;
     CSR_fOnDeleteTexture          m_fOnDeleteTexture;
+    CSR_SceneDrawList*            m_pDrawList;        // if set, keeps the draw list memory between frames
+    CSR_SceneDepthList*           m_pTransparentList; // if set, keeps the transparent drawing order between frames
+    CSR_SceneOcclusionBuffer*     m_pOcclusionBuffer; // if set, the instances hidden behind the occluders are culled
+    CSR_fOnRunJobs                m_fOnRunJobs;       // if set, the scene items are prepared in parallel
+    size_t                        m_JobCount;         // number of jobs the scene items are split into, e.g. the core count
 };
 
 #ifdef __cplusplus
@@ -388,11 +704,46 @@ struct CSR_SceneContext
         */
         void csrSceneItemInit(CSR_SceneItem* pSI);
 
+        /**
+        * Calculates and caches the scene item bounding box, from his model
+        *@param[in, out] pSI - scene item for which the box should be calculated
+        *@note This function is called when the item is added to the scene. It should be called
+        *      again if the model geometry changes
+        *@note No box is calculated for lines and X models (their skinned vertices may move
+        *      anywhere), thus they are never culled
+        */
+        void csrSceneItemUpdateBox(CSR_SceneItem* pSI);
+
+        /**
+        * Adds a level of detail to a scene item
+        *@param[in, out] pSceneItem - scene item to add to
+        *@param pModel - lower detail model, of the same type as the item model. If 0, the instances
+        *                located beyond the distance are no longer drawn
+        *@param distance - distance from the camera from which the level is used
+        *@return 1 on success, otherwise 0
+        *@note The level is selected for each instance while the scene is drawn. The item model
+        *      remains the level 0, and is the only one used for the collisions
+        *@note The model is owned by the item, and is released with it
+        */
+        int csrSceneItemAddLOD(CSR_SceneItem* pSceneItem, void* pModel, float distance);
+
+        /**
+        * Sets the occluder of a scene item
+        *@param[in, out] pSceneItem - scene item to set to
+        *@param pOccluder - low-poly mesh, fully contained in the item model, hiding what is located
+        *                   behind the item instances. If 0, the item no longer hides anything
+        *@return 1 on success, otherwise 0
+        *@note The occluder polygons are copied, thus the mesh may be released after the call
+        *@note Only the opaque items with at least one matrix may hide the other instances
+        */
+        int csrSceneItemSetOccluder(CSR_SceneItem* pSceneItem, const CSR_Mesh* pOccluder);
+
         /**
         * Draws a scene item
         *@param pScene - scene at which the item belongs
         *@param pContext - scene context
         *@param pItem - scene item to draw
+        *@note The item instances out of the view frustum are not drawn
         */
         void csrSceneItemDraw(const CSR_Scene*        pScene,
                               const CSR_SceneContext* pContext,
@@ -412,6 +763,316 @@ struct CSR_SceneContext
                                                CSR_CollisionOutput*         pCollisionOutput,
                                                CSR_fOnCustomDetectCollision fOnCustomDetectCollision);
 
+        //-------------------------------------------------------------------
+        // Scene draw list functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Initializes a scene draw list
+        *@param[in, out] pList - draw list to initialize
+        */
+        void csrSceneDrawListInit(CSR_SceneDrawList* pList);
+
+        /**
+        * Releases the draw list content
+        *@param[in, out] pList - draw list for which the content should be released
+        *@note Only the content is released, the draw list itself is not released
+        */
+        void csrSceneDrawListContentRelease(CSR_SceneDrawList* pList);
+
+        /**
+        * Clears a draw list, i.e. removes its commands but keeps its memory
+        *@param[in, out] pList - draw list to clear
+        */
+        void csrSceneDrawListClear(CSR_SceneDrawList* pList);
+
+        /**
+        * Adds the visible scene items to a draw list
+        *@param pScene - scene owning the items
+        *@param pContext - scene context
+        *@param pItems - scene items to add
+        *@param count - scene item count
+        *@param pFrustum - view frustum against which the item instances are culled, ignored if 0
+        *@param[in, out] pList - draw list to add to
+        *@return 1 on success, otherwise 0
+        *@note The items for which no shader is available, or for which no instance is visible, are
+        *      not added to the list
+        *@note The visible instance matrices are only linked, thus the list should be submitted
+        *      before the item matrix arrays change
+        */
+        int csrSceneDrawListAdd(const CSR_Scene*         pScene,
+                                const CSR_SceneContext*  pContext,
+                                const CSR_SceneItem*     pItems,
+                                      size_t             count,
+                                const CSR_Frustum*       pFrustum,
+                                      CSR_SceneDrawList* pList);
+
+        /**
+        * Sorts a draw list by render states, in order to group the items sharing the same shader,
+        * texture and material states
+        *@param pContext - scene context
+        *@param[in, out] pList - draw list to sort
+        *@return 1 on success, otherwise 0
+        *@note The sort is stable, so the items sharing the same states keep their order
+        */
+        int csrSceneDrawListSort(const CSR_SceneContext* pContext, CSR_SceneDrawList* pList);
+
+        /**
+        * Adds the visible scene items to a draw list, preparing them in parallel if the context allows it
+        *@param pScene - scene owning the items
+        *@param pContext - scene context
+        *@param pItems - scene items to add
+        *@param count - scene item count
+        *@param pFrustum - view frustum against which the item instances are culled, ignored if 0
+        *@param[in, out] pList - draw list to add to
+        *@return 1 on success, otherwise 0
+        *@note The items are split in m_JobCount ranges of similar instance counts, each of them
+        *      prepared in its own draw list by a job run through the context m_fOnRunJobs callback.
+        *      The lists are then appended in the scene order. Without callback, this function
+        *      behaves like csrSceneDrawListAdd()
+        */
+        int csrSceneDrawListPrepare(const CSR_Scene*         pScene,
+                                    const CSR_SceneContext*  pContext,
+                                    const CSR_SceneItem*     pItems,
+                                          size_t             count,
+                                    const CSR_Frustum*       pFrustum,
+                                          CSR_SceneDrawList* pList);
+
+        /**
+        * Moves the commands of a draw list to the end of another
+        *@param[in, out] pList - draw list to append to
+        *@param[in, out] pOther - draw list to append, empty after the call
+        *@return 1 on success, otherwise 0
+        */
+        int csrSceneDrawListAppend(CSR_SceneDrawList* pList, CSR_SceneDrawList* pOther);
+
+        /**
+        * Submits a draw list to the renderer
+        *@param pScene - scene owning the items
+        *@param pContext - scene context
+        *@param pList - draw list to submit
+        *@note The shader is enabled and connected to the scene matrices only when it differs from
+        *      the previous command one
+        */
+        void csrSceneDrawListSubmit(const CSR_Scene*         pScene,
+                                    const CSR_SceneContext*  pContext,
+                                    const CSR_SceneDrawList* pList);
+
+        //-------------------------------------------------------------------
+        // Scene depth list functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Initializes a scene depth list
+        *@param[in, out] pList - depth list to initialize
+        */
+        void csrSceneDepthListInit(CSR_SceneDepthList* pList);
+
+        /**
+        * Releases the depth list content
+        *@param[in, out] pList - depth list for which the content should be released
+        *@note Only the content is released, the depth list itself is not released
+        */
+        void csrSceneDepthListContentRelease(CSR_SceneDepthList* pList);
+
+        /**
+        * Builds the scene item instances and sorts them from the farthest to the nearest
+        *@param pScene - scene owning the items
+        *@param pContext - scene context
+        *@param pItems - scene items to add
+        *@param count - scene item count
+        *@param pFrustum - view frustum against which the instances are culled, ignored if 0
+        *@param[in, out] pList - depth list to build
+        *@return 1 on success, otherwise 0
+        *@note If the instance count didn't change since the previous call, the previous order is
+        *      reused as a starting point, and only refined. Otherwise the instances are fully sorted
+        *@note The scratch arrays used to report the visible instances and to submit the list are
+        *      reserved here, and only grow
+        */
+        int csrSceneDepthListBuild(const CSR_Scene*          pScene,
+                                   const CSR_SceneContext*   pContext,
+                                   const CSR_SceneItem*      pItems,
+                                         size_t              count,
+                                   const CSR_Frustum*        pFrustum,
+                                         CSR_SceneDepthList* pList);
+
+        /**
+        * Submits a depth list to the renderer
+        *@param pScene - scene owning the items
+        *@param pContext - scene context
+        *@param pList - depth list to submit
+        *@note The consecutive instances belonging to the same item are drawn together
+        *@note Nothing is drawn if the list wasn't successfully built, see csrSceneDepthListBuild()
+        */
+        void csrSceneDepthListSubmit(const CSR_Scene*          pScene,
+                                     const CSR_SceneContext*   pContext,
+                                     const CSR_SceneDepthList* pList);
+
+        //-------------------------------------------------------------------
+        // Scene occlusion buffer functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Initializes a scene occlusion buffer
+        *@param width - buffer width, in texels
+        *@param height - buffer height, in texels
+        *@param[in, out] pOB - occlusion buffer to initialize
+        *@return 1 on success, otherwise 0
+        *@note A small buffer, e.g. 256x128, is generally enough, as only large occluders matter
+        */
+        int csrSceneOcclusionBufferInit(size_t width, size_t height, CSR_SceneOcclusionBuffer* pOB);
+
+        /**
+        * Releases the occlusion buffer content
+        *@param[in, out] pOB - occlusion buffer for which the content should be released
+        *@note Only the content is released, the occlusion buffer itself is not released
+        */
+        void csrSceneOcclusionBufferContentRelease(CSR_SceneOcclusionBuffer* pOB);
+
+        /**
+        * Rasterizes the scene occluders in an occlusion buffer
+        *@param pScene - scene containing the occluders
+        *@param[in, out] pOB - occlusion buffer to build
+        *@return 1 on success, otherwise 0
+        *@note This function is called by csrSceneDraw() if the scene context links an occlusion
+        *      buffer, thus the buffer reflects the last drawn frame
+        */
+        int csrSceneOcclusionBufferBuild(const CSR_Scene* pScene, CSR_SceneOcclusionBuffer* pOB);
+
+        /**
+        * Checks if a box may be visible, i.e. isn't fully hidden behind the occluders
+        *@param pOB - occlusion buffer to test against
+        *@param pBox - box to test, in the world coordinates system
+        *@return 1 if the box may be visible, 0 if it's certainly hidden
+        *@note A box crossing the camera near plane is always considered as visible
+        */
+        int csrSceneOcclusionBufferIsVisible(const CSR_SceneOcclusionBuffer* pOB, const CSR_Box* pBox);
+
+        //-------------------------------------------------------------------
+        // Scene state functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Initializes a scene state
+        *@param[in, out] pState - scene state to initialize
+        *@note The front snapshot contains an empty scene until the first swap
+        */
+        void csrSceneStateInit(CSR_SceneState* pState);
+
+        /**
+        * Releases the scene state content
+        *@param[in, out] pState - scene state for which the content should be released
+        *@note Only the content is released, the scene state itself is not released
+        */
+        void csrSceneStateContentRelease(CSR_SceneState* pState);
+
+        /**
+        * Copies the scene dynamic state, i.e. the scene matrices, the item instance matrices, their
+        * level of detail states and the item indexes, in the back snapshot
+        *@param pScene - scene from which the state should be copied
+        *@param pContext - scene context whose callbacks select the item indexes, may be 0
+        *@param[in, out] pState - scene state to update
+        *@return 1 on success, otherwise 0
+        *@note This function should be called by the update side, once the frame is simulated. The
+        *      memory is kept between frames, thus nothing is allocated unless the scene grows
+        *@note The context m_fOnGetModelIndex, m_fOnGetMDLIndex and m_fOnGetXIndex callbacks are
+        *      called here, on the update side, and no longer while the front scene is drawn
+        *@note Each snapshot selects its instance levels of detail by itself. Their states are kept
+        *      as long as the item instances don't change, thus the hysteresis is preserved
+        */
+        int csrSceneStateUpdate(const CSR_Scene*        pScene,
+                                const CSR_SceneContext* pContext,
+                                      CSR_SceneState*   pState);
+
+        /**
+        * Swaps the scene state snapshots, thus the last updated one becomes the one to draw
+        *@param[in, out] pState - scene state to swap
+        *@note This function should be called by the update side, once csrSceneStateUpdate()
+        *      returned. The back snapshot is published with a release store, thus it's complete
+        *      when the render side gets it, and no lock is required
+        *@note The update side shouldn't write the next state before the render side got the new
+        *      front scene, otherwise it would write the snapshot still drawn. It's the case if both
+        *      sides run once per frame, and the render side gets the front scene on the frame start
+        */
+        void csrSceneStateSwap(CSR_SceneState* pState);
+
+        /**
+        * Gets the scene to draw from a scene state
+        *@param pState - scene state
+        *@return scene to draw, or to test the collisions against, in the front snapshot
+        *@note The returned scene remains valid until the next swap. Drawing it never writes the
+        *      source scene, thus the items and instances may be added or deleted meanwhile. However
+        *      the models, their trees and their levels of detail are shared, and should only be
+        *      released while the front scene isn't used
+        */
+        const CSR_Scene* csrSceneStateGetFront(const CSR_SceneState* pState);
+
+        //-------------------------------------------------------------------
+        // Transform hierarchy functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Initializes a transform hierarchy
+        *@param[in, out] pHierarchy - hierarchy to initialize
+        */
+        void csrTransformHierarchyInit(CSR_TransformHierarchy* pHierarchy);
+
+        /**
+        * Releases the transform hierarchy content
+        *@param[in, out] pHierarchy - hierarchy for which the content should be released
+        *@note Only the content is released, the hierarchy itself is not released
+        */
+        void csrTransformHierarchyContentRelease(CSR_TransformHierarchy* pHierarchy);
+
+        /**
+        * Adds a node to a transform hierarchy
+        *@param[in, out] pHierarchy - hierarchy to add to
+        *@param parent - parent node index, M_CSR_Unknown_Index to add a root node
+        *@param pPosition - local position, origin if 0
+        *@param pRotation - local rotation, identity if 0
+        *@param pScaling - local scaling, no scaling if 0
+        *@param pTarget - matrix to update with the node world matrix, ignored if 0
+        *@return the newly added node index, M_CSR_Unknown_Index on error
+        *@note The target matrix is not owned by the hierarchy, it's typically a matrix added to a
+        *      scene item with csrSceneAddModelMatrix() or csrSceneAddInstance()
+        */
+        size_t csrTransformHierarchyAdd(      CSR_TransformHierarchy* pHierarchy,
+                                              size_t                  parent,
+                                        const CSR_Vector3*            pPosition,
+                                        const CSR_Quaternion*         pRotation,
+                                        const CSR_Vector3*            pScaling,
+                                              CSR_Matrix4*            pTarget);
+
+        /**
+        * Sets the local transformation of a node
+        *@param[in, out] pHierarchy - hierarchy containing the node
+        *@param index - node index
+        *@param pPosition - new local position, unchanged if 0
+        *@param pRotation - new local rotation, unchanged if 0
+        *@param pScaling - new local scaling, unchanged if 0
+        *@note The world matrices are only calculated on the next csrTransformHierarchyUpdate() call
+        */
+        void csrTransformHierarchySetLocal(      CSR_TransformHierarchy* pHierarchy,
+                                                 size_t                  index,
+                                           const CSR_Vector3*            pPosition,
+                                           const CSR_Quaternion*         pRotation,
+                                           const CSR_Vector3*            pScaling);
+
+        /**
+        * Updates the world matrices of the changed nodes and of their descendants
+        *@param[in, out] pHierarchy - hierarchy to update
+        *@note Nothing is calculated if no node changed since the previous update
+        */
+        void csrTransformHierarchyUpdate(CSR_TransformHierarchy* pHierarchy);
+
+        /**
+        * Deletes a node and all its descendants from a transform hierarchy
+        *@param[in, out] pHierarchy - hierarchy to delete from
+        *@param index - node index to delete
+        *@note The indexes of the nodes located after the deleted one may change
+        */
+        void csrTransformHierarchyDeleteFrom(CSR_TransformHierarchy* pHierarchy, size_t index);
+
         //-------------------------------------------------------------------
         // Scene functions
         //-------------------------------------------------------------------
@@ -452,7 +1113,7 @@ struct CSR_SceneContext
         *@param pScene - scene in which the mesh will be added
         *@param pMesh - mesh to add
         *@param transparent - if 1, the mesh is transparent, if 0 the mesh is opaque
-        *@param aabb - if 1, the AABB tree will be generated for the mesh
+        *@param aabb - AABB tree build mode to use for the mesh, see CSR_EAABBTreeMode. If 0, no tree is generated
         *@return the scene item containing the mesh on success, otherwise 0
         *@note Once successfully added, the mesh will be owned by the scene and should no longer be
         *      released from outside
@@ -464,7 +1125,7 @@ struct CSR_SceneContext
         *@param pScene - scene in which the model will be added
         *@param pModel - model to add
         *@param transparent - if 1, the model is transparent, if 0 the model is opaque
-        *@param aabb - if 1, the AABB tree will be generated for the mesh
+        *@param aabb - AABB tree build mode to use for the mesh, see CSR_EAABBTreeMode. If 0, no tree is generated
         *@return the scene item containing the model on success, otherwise 0
         *@note Once successfully added, the model will be owned by the scene and should no longer be
         *      released from outside
@@ -476,7 +1137,7 @@ struct CSR_SceneContext
         *@param pScene - scene in which the model will be added
         *@param pMDL - model to add
         *@param transparent - if 1, the model is transparent, if 0 the model is opaque
-        *@param aabb - if 1, the AABB tree will be generated for the mesh
+        *@param aabb - AABB tree build mode to use for the mesh, see CSR_EAABBTreeMode. If 0, no tree is generated
         *@return the scene item containing the model on success, otherwise 0
         *@note Once successfully added, the MDL model will be owned by the scene and should no
         *      longer be released from outside
@@ -488,7 +1149,7 @@ struct CSR_SceneContext
         *@param pScene - scene in which the model will be added
         *@param pX - model to add
         *@param transparent - if 1, the model is transparent, if 0 the model is opaque
-        *@param aabb - if 1, the AABB tree will be generated for the mesh
+        *@param aabb - AABB tree build mode to use for the mesh, see CSR_EAABBTreeMode. If 0, no tree is generated
         *@return the scene item containing the model on success, otherwise 0
         *@note Once successfully added, the X model will be owned by the scene and should no longer
         *      be released from outside
@@ -507,6 +1168,17 @@ struct CSR_SceneContext
         */
         CSR_SceneItem* csrSceneAddModelMatrix(CSR_Scene* pScene, const void* pModel, CSR_Matrix4* pMatrix);
 
+        /**
+        * Adds a model instance to a scene, and gets its handle
+        *@param pScene - scene in which the model will be added
+        *@param pModel - model for which the instance should be added
+        *@param pMatrix - instance matrix
+        *@return the instance handle on success, otherwise 0
+        *@note Same as csrSceneAddModelMatrix(), but the returned handle remains valid until the
+        *      instance is deleted, whatever the other changes in the scene
+        */
+        CSR_Handle csrSceneAddInstance(CSR_Scene* pScene, const void* pModel, CSR_Matrix4* pMatrix);
+
         /**
         * Gets a scene item matching with a model or a matrix
         *@param pScene - scene from which the item should be get
@@ -515,6 +1187,27 @@ struct CSR_SceneContext
         */
         CSR_SceneItem* csrSceneGetItem(const CSR_Scene* pScene, const void* pKey);
 
+        /**
+        * Gets a scene item from its handle
+        *@param pScene - scene from which the item should be get
+        *@param handle - item handle, see the item m_Handle member
+        *@return scene item, 0 if not found or on error
+        *@note The returned pointer is only valid until the next item is added to or deleted from
+        *      the scene, unlike the handle itself
+        */
+        CSR_SceneItem* csrSceneGetItemFromHandle(const CSR_Scene* pScene, CSR_Handle handle);
+
+        /**
+        * Gets an instance matrix from its handle
+        *@param pScene - scene from which the instance should be get
+        *@param handle - instance handle, see csrSceneAddInstance()
+        *@param[out] ppItem - scene item owning the instance, ignored if 0
+        *@return instance matrix, 0 if not found or on error
+        */
+        CSR_Matrix4* csrSceneGetInstanceFromHandle(const CSR_Scene*      pScene,
+                                                         CSR_Handle      handle,
+                                                         CSR_SceneItem** ppItem);
+
         /**
         * Deletes a model or a matrix from the scene
         *@param pScene - scene from which the item should be deleted
@@ -528,6 +1221,96 @@ struct CSR_SceneContext
                                 const void*                pKey,
                                 const CSR_fOnDeleteTexture fOnDeleteTexture);
 
+        /**
+        * Deletes an item from the scene, using its handle
+        *@param pScene - scene from which the item should be deleted
+        *@param handle - item handle
+        *@param fOnDeleteTexture - callback function to notify the GPU that a texture should be deleted
+        *@note The item and all his associated resources will be freed internally, and all its
+        *      instance handles become invalid
+        */
+        void csrSceneDeleteItemFromHandle(      CSR_Scene*           pScene,
+                                                CSR_Handle           handle,
+                                          const CSR_fOnDeleteTexture fOnDeleteTexture);
+
+        /**
+        * Deletes an instance from the scene, using its handle
+        *@param pScene - scene from which the instance should be deleted
+        *@param handle - instance handle
+        *@note The item owning the instance is kept, even if no instance remains
+        */
+        void csrSceneDeleteInstanceFromHandle(CSR_Scene* pScene, CSR_Handle handle);
+
+        /**
+        * Merges the static scene items sharing the same skin in batches, pre-transformed by their matrices
+        *@param pScene - scene containing the items to batch
+        *@param pContext - scene context, used to compare the skins and to release the merged items
+        *@param cellSize - size of the grid cells between which the batches are split, thus they can
+        *                  still be culled. If 0, all the instances sharing a skin are merged together
+        *@param fOnBatchSkin - callback notifying that a batch uses the textures of a source skin, may be 0
+        *@return 1 on success, otherwise 0
+        *@note Only the opaque items marked as static, drawing a mesh or a single frame model, and
+        *      using neither levels of detail nor custom collisions, are merged. Their vertex buffers
+        *      sharing the same format, culling and material are concatenated as triangles
+        *@note Two meshes share the same skin if they are the same mesh, or if the context m_fOnGetID
+        *      callback returns the same identifiers for their textures
+        *@note The merged items are deleted from the scene, and each batch is added as a new mesh item
+        *      drawn with an identity matrix. Its m_pBatch member keeps the vertices of each merged instance,
+        *      and the batch is culled if none of their boxes is visible
+        *@note The textures of a merged mesh whose skin matches a batch skin by identifier aren't deleted
+        *      through the context m_fOnDeleteTexture callback, as the batch still uses them. The
+        *      fOnBatchSkin callback is notified instead
+        */
+        int csrSceneBatchStaticItems(      CSR_Scene*        pScene,
+                                     const CSR_SceneContext* pContext,
+                                           float             cellSize,
+                                     const CSR_fOnBatchSkin  fOnBatchSkin);
+
+        /**
+        * Writes a scene in a buffer, using the binary scene format
+        *@param pScene - scene to write
+        *@param[in, out] pBuffer - buffer in which the scene will be appended
+        *@return 1 on success, otherwise 0
+        *@note The scene starts at the buffer length before the call, this offset should be given
+        *      to csrSceneRead() to read it back
+        *@note The item models, instance matrices, collision types, aligned-axis bounding box trees,
+        *      occluders and batch ranges are written, thus nothing should be rebuilt while reading
+        *@note Only the mesh and model items are written. The lines, the MDL and X models, which
+        *      are animated from their source files, and the levels of detail should be added again
+        *      once the scene is read
+        *@note The skins are written with their texture file names only
+        */
+        int csrSceneWrite(const CSR_Scene* pScene, CSR_Buffer* pBuffer);
+
+        /**
+        * Saves a scene in a file, using the binary scene format
+        *@param pScene - scene to save
+        *@param pFileName - scene file name
+        *@return 1 on success, otherwise 0
+        *@note See csrSceneWrite() for the saved content
+        */
+        int csrSceneSave(const CSR_Scene* pScene, const char* pFileName);
+
+        /**
+        * Reads a scene from a buffer containing the binary scene format
+        *@param pBuffer - buffer containing the scene to read
+        *@param offset - offset of the scene start in the buffer
+        *@return newly created scene, 0 on error
+        *@note The scene must be released when no longer used, see csrSceneRelease()
+        *@note The item blocks are located from an offset table relative to the scene start, thus each
+        *      block may be read without parsing the previous ones
+        *@note The skin textures aren't loaded, the caller should load them from their file names
+        */
+        CSR_Scene* csrSceneRead(const CSR_Buffer* pBuffer, size_t offset);
+
+        /**
+        * Opens a scene from a file containing the binary scene format
+        *@param pFileName - scene file name
+        *@return newly created scene, 0 on error
+        *@note The scene must be released when no longer used, see csrSceneRelease()
+        */
+        CSR_Scene* csrSceneOpen(const char* pFileName);
+
         /**
         * Draws a scene
         *@param pScene - scene to draw
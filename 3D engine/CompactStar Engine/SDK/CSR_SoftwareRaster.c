@@ -759,6 +759,54 @@ int csrRasterDraw(const CSR_Matrix4*               pMatrix,
                                   zNear,
                                  &screenRect);
 
+    // indexed vertex buffer? Draw its polygons in the index order
+    if (pVB->m_pIndex)
+    {
+        CSR_Mesh                  mesh;
+        CSR_IndexedPolygonBuffer* pIPB;
+        int                       success = 1;
+
+        // get the polygons from a mesh containing only the vertex buffer
+        csrMeshInit(&mesh);
+        mesh.m_pVB   = (CSR_VertexBuffer*)pVB;
+        mesh.m_Count = 1;
+
+        pIPB = csrIndexedPolygonBufferFromMesh(&mesh);
+
+        // succeeded?
+        if (!pIPB)
+            return 0;
+
+        // iterate through the polygons to draw
+        for (i = 0; i < pIPB->m_Count && success; ++i)
+            success = csrRasterGetPolygon(pMatrix,
+                                          pIPB->m_pIndexedPolygon[i].m_pIndex[0],
+                                          pIPB->m_pIndexedPolygon[i].m_pIndex[1],
+                                          pIPB->m_pIndexedPolygon[i].m_pIndex[2],
+                                          pVB,
+                                         &polygon,
+                                          normal,
+                                          st,
+                                          color,
+                                          fOnApplyVertexShader) &&
+                      csrRasterDrawPolygon(&polygon,
+                                            normal,
+                                            st,
+                                            color,
+                                            pMatrix,
+                                            zNear,
+                                            pVB->m_Culling.m_Type,
+                                            pVB->m_Culling.m_Face,
+                                           &screenRect,
+                                            pFB,
+                                            pDB,
+                                            fOnApplyFragmentShader);
+
+        csrIndexedPolygonBufferRelease(pIPB);
+
+        return success;
+    }
+
     // search for vertex type
     switch (pVB->m_Format.m_Type)
     {
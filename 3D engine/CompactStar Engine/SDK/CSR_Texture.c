@@ -17,6 +17,7 @@
 
 // std
 #include <stdlib.h>
+#include <string.h>
 
 //---------------------------------------------------------------------------
 // Pixel buffer functions
@@ -438,3 +439,451 @@ void csrSkinInit(CSR_Skin* pSkin)
     pSkin->m_Time = 0.0;
 }
 //---------------------------------------------------------------------------
+// Texture atlas private functions
+//---------------------------------------------------------------------------
+unsigned csrTextureAtlasGetStride(const CSR_PixelBuffer* pPB)
+{
+    // the stride may be missing in the raw pixel buffers, in this case the rows aren't aligned
+    if (!pPB->m_Stride)
+        return pPB->m_Width * pPB->m_BytePerPixel;
+
+    return pPB->m_Stride;
+}
+//---------------------------------------------------------------------------
+int csrTextureAtlasCanPack(const CSR_TextureAtlas* pAtlas, const CSR_PixelBuffer* pPB)
+{
+    // no pixels to pack?
+    if (!pPB || !pPB->m_pData || !pPB->m_Width || !pPB->m_Height)
+        return 0;
+
+    // only the 24 and 32 bit pixels are supported, and the bitmaps are limited to 24 bit, as when
+    // they are converted to textures
+    if (pPB->m_BytePerPixel != 3 && pPB->m_BytePerPixel != 4)
+        return 0;
+
+    if (pPB->m_ImageType == CSR_IT_Bitmap && pPB->m_BytePerPixel != 3)
+        return 0;
+
+    // all the pages share the same pixel size
+    if (pAtlas->m_BytePerPixel && pPB->m_BytePerPixel != pAtlas->m_BytePerPixel)
+        return 0;
+
+    // is the texture, surrounded by its padding, larger than a page?
+    if (pPB->m_Width  + 2 * pAtlas->m_Padding > pAtlas->m_PageWidth ||
+        pPB->m_Height + 2 * pAtlas->m_Padding > pAtlas->m_PageHeight)
+        return 0;
+
+    // the pixel data should contain all the rows (e.g. the default MDL skins don't)
+    return (pPB->m_DataLength >= (size_t)csrTextureAtlasGetStride(pPB) * (pPB->m_Height - 1) +
+                                 pPB->m_Width * pPB->m_BytePerPixel);
+}
+//---------------------------------------------------------------------------
+int csrTextureAtlasShelfFit(const CSR_TextureAtlas* pAtlas,
+                                  unsigned          width,
+                                  unsigned          height,
+                                  unsigned*         pShelfX,
+                                  unsigned*         pShelfY,
+                                  unsigned*         pShelfHeight,
+                                  unsigned*         pX,
+                                  unsigned*         pY)
+{
+    // not enough room on the current shelf? Open a new one below it
+    if (*pShelfX + width > pAtlas->m_PageWidth)
+    {
+        *pShelfY     += *pShelfHeight;
+        *pShelfX      = 0;
+        *pShelfHeight = 0;
+    }
+
+    // no more room on the page?
+    if (*pShelfX + width > pAtlas->m_PageWidth || *pShelfY + height > pAtlas->m_PageHeight)
+        return 0;
+
+    *pX = *pShelfX;
+    *pY = *pShelfY;
+
+    // reserve the room on the shelf
+    *pShelfX += width;
+
+    if (height > *pShelfHeight)
+        *pShelfHeight = height;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrTextureAtlasAddPage(CSR_TextureAtlas* pAtlas,
+                           unsigned          shelfX,
+                           unsigned          shelfY,
+                           unsigned          shelfHeight)
+{
+    CSR_PixelBuffer*      pPB;
+    CSR_TextureAtlasPage* pPage;
+
+    // create the page pixel buffer
+    pPB = csrPixelBufferCreate();
+
+    // succeeded?
+    if (!pPB)
+        return 0;
+
+    // the page pixels are raw and already ordered, thus they may be used as is by the GPU
+    pPB->m_ImageType    = CSR_IT_Raw;
+    pPB->m_PixelType    = (pAtlas->m_BytePerPixel == 4) ? CSR_PT_RGBA : CSR_PT_RGB;
+    pPB->m_Width        = pAtlas->m_PageWidth;
+    pPB->m_Height       = pAtlas->m_PageHeight;
+    pPB->m_BytePerPixel = pAtlas->m_BytePerPixel;
+    pPB->m_Stride       = pPB->m_Width * pPB->m_BytePerPixel;
+    pPB->m_DataLength   = (size_t)pPB->m_Stride * pPB->m_Height;
+    pPB->m_pData        = calloc(pPB->m_DataLength, sizeof(unsigned char));
+
+    // succeeded?
+    if (!pPB->m_pData)
+    {
+        csrPixelBufferRelease(pPB);
+        return 0;
+    }
+
+    // add a new page
+    pPage = (CSR_TextureAtlasPage*)csrMemoryAlloc(pAtlas->m_pPage,
+                                                  sizeof(CSR_TextureAtlasPage),
+                                                  pAtlas->m_PageCount + 1);
+
+    // succeeded?
+    if (!pPage)
+    {
+        csrPixelBufferRelease(pPB);
+        return 0;
+    }
+
+    pAtlas->m_pPage = pPage;
+
+    // initialize the page
+    pPage = &pAtlas->m_pPage[pAtlas->m_PageCount];
+    csrTextureInit(&pPage->m_Texture);
+    pPage->m_Texture.m_pBuffer = pPB;
+    pPage->m_ShelfX            = shelfX;
+    pPage->m_ShelfY            = shelfY;
+    pPage->m_ShelfHeight       = shelfHeight;
+
+    ++pAtlas->m_PageCount;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrTextureAtlasCopyPixel(const CSR_PixelBuffer* pPB,
+                                    unsigned         x,
+                                    unsigned         y,
+                                    unsigned char*   pTarget)
+{
+    unsigned             c;
+    const unsigned char* pData = (const unsigned char*)pPB->m_pData;
+
+    // the bitmaps are mirrored and stored in BGR order, reorder them as when they are converted to
+    // textures
+    if (pPB->m_ImageType == CSR_IT_Bitmap)
+    {
+        for (c = 0; c < 3; ++c)
+            pTarget[c] = pData[pPB->m_Stride * y + 3 * (pPB->m_Width - x - 1) + (2 - c)];
+
+        return;
+    }
+
+    memcpy(pTarget,
+           pData + (size_t)csrTextureAtlasGetStride(pPB) * y + pPB->m_BytePerPixel * x,
+           pPB->m_BytePerPixel);
+}
+//---------------------------------------------------------------------------
+void csrTextureAtlasCopyItem(const CSR_TextureAtlas* pAtlas, const CSR_TextureAtlasItem* pItem)
+{
+    unsigned               x;
+    unsigned               y;
+    unsigned               sourceX;
+    unsigned               sourceY;
+    const unsigned         padding = pAtlas->m_Padding;
+    const CSR_PixelBuffer* pSource = pItem->m_pTexture->m_pBuffer;
+    const CSR_PixelBuffer* pPage   = pAtlas->m_pPage[pItem->m_Layer].m_Texture.m_pBuffer;
+
+    // copy the item pixels, and repeat its edges in the padding surrounding it
+    for (y = 0; y < pItem->m_Height + 2 * padding; ++y)
+    {
+        sourceY = (y < padding) ? 0 : y - padding;
+
+        if (sourceY >= pItem->m_Height)
+            sourceY = pItem->m_Height - 1;
+
+        for (x = 0; x < pItem->m_Width + 2 * padding; ++x)
+        {
+            sourceX = (x < padding) ? 0 : x - padding;
+
+            if (sourceX >= pItem->m_Width)
+                sourceX = pItem->m_Width - 1;
+
+            csrTextureAtlasCopyPixel(pSource,
+                                     sourceX,
+                                     sourceY,
+                                     (unsigned char*)pPage->m_pData                   +
+                                             (size_t)pPage->m_Stride * (pItem->m_Y - padding + y) +
+                                             pPage->m_BytePerPixel   * (pItem->m_X - padding + x));
+        }
+    }
+}
+//---------------------------------------------------------------------------
+// Texture atlas functions
+//---------------------------------------------------------------------------
+CSR_TextureAtlas* csrTextureAtlasCreate(unsigned pageWidth, unsigned pageHeight, unsigned padding)
+{
+    // create a new texture atlas
+    CSR_TextureAtlas* pAtlas = (CSR_TextureAtlas*)malloc(sizeof(CSR_TextureAtlas));
+
+    // succeeded?
+    if (!pAtlas)
+        return 0;
+
+    // initialize the texture atlas content
+    csrTextureAtlasInit(pageWidth, pageHeight, padding, pAtlas);
+
+    return pAtlas;
+}
+//---------------------------------------------------------------------------
+void csrTextureAtlasRelease(CSR_TextureAtlas* pAtlas, const CSR_fOnDeleteTexture fOnDeleteTexture)
+{
+    // no texture atlas to release?
+    if (!pAtlas)
+        return;
+
+    // release the texture atlas content
+    csrTextureAtlasContentRelease(pAtlas, fOnDeleteTexture);
+
+    // free the texture atlas
+    free(pAtlas);
+}
+//---------------------------------------------------------------------------
+void csrTextureAtlasInit(unsigned          pageWidth,
+                         unsigned          pageHeight,
+                         unsigned          padding,
+                         CSR_TextureAtlas* pAtlas)
+{
+    // no texture atlas to initialize?
+    if (!pAtlas)
+        return;
+
+    // initialize the texture atlas content
+    pAtlas->m_pPage        = 0;
+    pAtlas->m_PageCount    = 0;
+    pAtlas->m_pItem        = 0;
+    pAtlas->m_ItemCount    = 0;
+    pAtlas->m_PageWidth    = pageWidth;
+    pAtlas->m_PageHeight   = pageHeight;
+    pAtlas->m_Padding      = padding;
+    pAtlas->m_BytePerPixel = 0;
+}
+//---------------------------------------------------------------------------
+void csrTextureAtlasContentRelease(CSR_TextureAtlas*          pAtlas,
+                                   const CSR_fOnDeleteTexture fOnDeleteTexture)
+{
+    size_t i;
+
+    // no texture atlas to release?
+    if (!pAtlas)
+        return;
+
+    // do free the pages?
+    if (pAtlas->m_pPage)
+    {
+        // iterate through the pages and release their texture
+        for (i = 0; i < pAtlas->m_PageCount; ++i)
+        {
+            // notify the GPU side about the texture deletion
+            if (fOnDeleteTexture)
+                fOnDeleteTexture(&pAtlas->m_pPage[i].m_Texture);
+
+            csrTextureContentRelease(&pAtlas->m_pPage[i].m_Texture);
+        }
+
+        // free the pages
+        free(pAtlas->m_pPage);
+    }
+
+    // free the items
+    if (pAtlas->m_pItem)
+        free(pAtlas->m_pItem);
+
+    pAtlas->m_pPage        = 0;
+    pAtlas->m_PageCount    = 0;
+    pAtlas->m_pItem        = 0;
+    pAtlas->m_ItemCount    = 0;
+    pAtlas->m_BytePerPixel = 0;
+}
+//---------------------------------------------------------------------------
+size_t csrTextureAtlasAdd(CSR_TextureAtlas* pAtlas, const CSR_Texture* pTexture)
+{
+    size_t i;
+
+    // validate the inputs
+    if (!pAtlas || !pTexture)
+        return M_CSR_Unknown_Index;
+
+    // was the texture already added?
+    for (i = 0; i < pAtlas->m_ItemCount; ++i)
+        if (pAtlas->m_pItem[i].m_pTexture == pTexture)
+            return i;
+
+    return csrTextureAtlasAddLayered(pAtlas, &pTexture, 1);
+}
+//---------------------------------------------------------------------------
+size_t csrTextureAtlasAddLayered(      CSR_TextureAtlas* pAtlas,
+                                 const CSR_Texture**     ppTexture,
+                                       size_t            count)
+{
+    size_t                 i;
+    size_t                 page;
+    size_t                 first;
+    unsigned               width;
+    unsigned               height;
+    unsigned               x;
+    unsigned               y;
+    unsigned               shelfX;
+    unsigned               shelfY;
+    unsigned               shelfHeight;
+    CSR_TextureAtlasItem*  pItem;
+    const CSR_PixelBuffer* pPB;
+
+    // validate the inputs
+    if (!pAtlas || !ppTexture || !count || !ppTexture[0])
+        return M_CSR_Unknown_Index;
+
+    pPB = ppTexture[0]->m_pBuffer;
+
+    // all the textures should be packable, and should have the same size and pixel size
+    for (i = 0; i < count; ++i)
+        if (!ppTexture[i]                                                  ||
+            !csrTextureAtlasCanPack(pAtlas, ppTexture[i]->m_pBuffer)       ||
+             ppTexture[i]->m_pBuffer->m_Width        != pPB->m_Width       ||
+             ppTexture[i]->m_pBuffer->m_Height       != pPB->m_Height      ||
+             ppTexture[i]->m_pBuffer->m_BytePerPixel != pPB->m_BytePerPixel)
+            return M_CSR_Unknown_Index;
+
+    // reserve the room for the padding
+    width  = pPB->m_Width  + 2 * pAtlas->m_Padding;
+    height = pPB->m_Height + 2 * pAtlas->m_Padding;
+
+    // search for the first page on which the textures fit. NOTE the next pages, if any, should
+    // have the same shelves, otherwise the textures wouldn't share the same position
+    for (page = 0; page < pAtlas->m_PageCount; ++page)
+    {
+        shelfX      = pAtlas->m_pPage[page].m_ShelfX;
+        shelfY      = pAtlas->m_pPage[page].m_ShelfY;
+        shelfHeight = pAtlas->m_pPage[page].m_ShelfHeight;
+
+        if (!csrTextureAtlasShelfFit(pAtlas, width, height, &shelfX, &shelfY, &shelfHeight, &x, &y))
+            continue;
+
+        for (i = 1; i < count && page + i < pAtlas->m_PageCount; ++i)
+            if (pAtlas->m_pPage[page + i].m_ShelfX      != pAtlas->m_pPage[page].m_ShelfX ||
+                pAtlas->m_pPage[page + i].m_ShelfY      != pAtlas->m_pPage[page].m_ShelfY ||
+                pAtlas->m_pPage[page + i].m_ShelfHeight != pAtlas->m_pPage[page].m_ShelfHeight)
+                break;
+
+        if (i == count || page + i == pAtlas->m_PageCount)
+            break;
+    }
+
+    // no page found? Start on new pages
+    if (page == pAtlas->m_PageCount)
+    {
+        shelfX      = 0;
+        shelfY      = 0;
+        shelfHeight = 0;
+
+        if (!csrTextureAtlasShelfFit(pAtlas, width, height, &shelfX, &shelfY, &shelfHeight, &x, &y))
+            return M_CSR_Unknown_Index;
+    }
+
+    // the first added texture defines the pixel size of all the pages
+    if (!pAtlas->m_BytePerPixel)
+        pAtlas->m_BytePerPixel = pPB->m_BytePerPixel;
+
+    // add the missing pages. NOTE they start with the same shelves as the first page, thus the
+    // room above the textures remains unused
+    while (pAtlas->m_PageCount < page + count)
+        if (page < pAtlas->m_PageCount)
+        {
+            if (!csrTextureAtlasAddPage(pAtlas,
+                                        pAtlas->m_pPage[page].m_ShelfX,
+                                        pAtlas->m_pPage[page].m_ShelfY,
+                                        pAtlas->m_pPage[page].m_ShelfHeight))
+                return M_CSR_Unknown_Index;
+        }
+        else
+        if (!csrTextureAtlasAddPage(pAtlas, 0, 0, 0))
+            return M_CSR_Unknown_Index;
+
+    // add the new items
+    pItem = (CSR_TextureAtlasItem*)csrMemoryAlloc(pAtlas->m_pItem,
+                                                  sizeof(CSR_TextureAtlasItem),
+                                                  pAtlas->m_ItemCount + count);
+
+    // succeeded?
+    if (!pItem)
+        return M_CSR_Unknown_Index;
+
+    pAtlas->m_pItem = pItem;
+    first           = pAtlas->m_ItemCount;
+
+    // copy the textures in their page
+    for (i = 0; i < count; ++i)
+    {
+        pAtlas->m_pPage[page + i].m_ShelfX      = shelfX;
+        pAtlas->m_pPage[page + i].m_ShelfY      = shelfY;
+        pAtlas->m_pPage[page + i].m_ShelfHeight = shelfHeight;
+
+        pItem                = &pAtlas->m_pItem[first + i];
+        pItem->m_pTexture    = ppTexture[i];
+        pItem->m_Layer       = page + i;
+        pItem->m_X           = x + pAtlas->m_Padding;
+        pItem->m_Y           = y + pAtlas->m_Padding;
+        pItem->m_Width       = pPB->m_Width;
+        pItem->m_Height      = pPB->m_Height;
+        pItem->m_UVOffset[0] = (float)pItem->m_X      / (float)pAtlas->m_PageWidth;
+        pItem->m_UVOffset[1] = (float)pItem->m_Y      / (float)pAtlas->m_PageHeight;
+        pItem->m_UVScale[0]  = (float)pItem->m_Width  / (float)pAtlas->m_PageWidth;
+        pItem->m_UVScale[1]  = (float)pItem->m_Height / (float)pAtlas->m_PageHeight;
+
+        csrTextureAtlasCopyItem(pAtlas, pItem);
+    }
+
+    pAtlas->m_ItemCount += count;
+
+    return first;
+}
+//---------------------------------------------------------------------------
+const CSR_TextureAtlasItem* csrTextureAtlasFind(const CSR_TextureAtlas* pAtlas,
+                                                const CSR_Texture*      pTexture)
+{
+    size_t i;
+
+    // validate the inputs
+    if (!pAtlas || !pTexture)
+        return 0;
+
+    // search for the item containing the texture
+    for (i = 0; i < pAtlas->m_ItemCount; ++i)
+        if (pAtlas->m_pItem[i].m_pTexture == pTexture)
+            return &pAtlas->m_pItem[i];
+
+    return 0;
+}
+//---------------------------------------------------------------------------
+const CSR_Texture* csrTextureAtlasGetPageTexture(const CSR_TextureAtlas* pAtlas,
+                                                 const CSR_Texture*      pTexture)
+{
+    // search for the item containing the texture
+    const CSR_TextureAtlasItem* pItem = csrTextureAtlasFind(pAtlas, pTexture);
+
+    // is the texture packed?
+    if (!pItem)
+        return 0;
+
+    return &pAtlas->m_pPage[pItem->m_Layer].m_Texture;
+}
+//---------------------------------------------------------------------------
@@ -93,6 +93,49 @@ typedef struct
     double      m_Time;
 } CSR_Skin;
 
+/**
+* Texture atlas item, i.e. a texture copied in an atlas page
+*/
+typedef struct
+{
+    const CSR_Texture* m_pTexture;    // source texture, identifies the item
+    size_t             m_Layer;       // page containing the item, which is also its texture array layer
+    unsigned           m_X;           // item left position in the page, in pixels
+    unsigned           m_Y;           // item top position in the page, in pixels
+    unsigned           m_Width;       // item width, in pixels
+    unsigned           m_Height;      // item height, in pixels
+    float              m_UVOffset[2]; // offset to add to the scaled item texture coordinates
+    float              m_UVScale[2];  // scale to apply to the item texture coordinates
+} CSR_TextureAtlasItem;
+
+/**
+* Texture atlas page, its items are packed on shelves, i.e. rows filled from left to right
+*/
+typedef struct
+{
+    CSR_Texture m_Texture;     // page texture, its pixel buffer contains the packed items
+    unsigned    m_ShelfX;      // next free position on the current shelf
+    unsigned    m_ShelfY;      // current shelf top position
+    unsigned    m_ShelfHeight; // current shelf height
+} CSR_TextureAtlasPage;
+
+/**
+* Texture atlas, packs several small textures in a few pages, thus they may be bound once
+*@note All the pages have the same size and pixel format, thus they may also be used as the layers
+*      of a texture array
+*/
+typedef struct
+{
+    CSR_TextureAtlasPage* m_pPage;
+    size_t                m_PageCount;
+    CSR_TextureAtlasItem* m_pItem;
+    size_t                m_ItemCount;
+    unsigned              m_PageWidth;
+    unsigned              m_PageHeight;
+    unsigned              m_Padding;      // pixels repeating the item edges around each item
+    unsigned              m_BytePerPixel; // page pixel size, defined by the first added texture
+} CSR_TextureAtlas;
+
 //---------------------------------------------------------------------------
 // Callbacks
 //---------------------------------------------------------------------------
@@ -235,6 +278,96 @@ typedef void (*CSR_fOnDeleteTexture)(const CSR_Texture* pTexture);
         */
         void csrSkinInit(CSR_Skin* pSkin);
 
+        //-------------------------------------------------------------------
+        // Texture atlas functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a texture atlas
+        *@param pageWidth - page width, in pixels
+        *@param pageHeight - page height, in pixels
+        *@param padding - pixels repeating the item edges around each item, to avoid that the
+        *                 linear filtering bleeds the neighbor items
+        *@return newly created texture atlas, 0 on error
+        *@note The texture atlas must be released when no longer used, see csrTextureAtlasRelease()
+        */
+        CSR_TextureAtlas* csrTextureAtlasCreate(unsigned pageWidth, unsigned pageHeight, unsigned padding);
+
+        /**
+        * Releases a texture atlas
+        *@param[in, out] pAtlas - texture atlas to release
+        *@param fOnDeleteTexture - callback function to notify the GPU that a page texture should be deleted
+        */
+        void csrTextureAtlasRelease(CSR_TextureAtlas* pAtlas, const CSR_fOnDeleteTexture fOnDeleteTexture);
+
+        /**
+        * Initializes a texture atlas structure
+        *@param pageWidth - page width, in pixels
+        *@param pageHeight - page height, in pixels
+        *@param padding - pixels repeating the item edges around each item
+        *@param[in, out] pAtlas - texture atlas to initialize
+        */
+        void csrTextureAtlasInit(unsigned          pageWidth,
+                                 unsigned          pageHeight,
+                                 unsigned          padding,
+                                 CSR_TextureAtlas* pAtlas);
+
+        /**
+        * Releases a texture atlas content
+        *@param[in, out] pAtlas - texture atlas for which the content should be released
+        *@param fOnDeleteTexture - callback function to notify the GPU that a page texture should be deleted
+        *@note Only the content is released, the texture atlas itself is not released
+        */
+        void csrTextureAtlasContentRelease(CSR_TextureAtlas*          pAtlas,
+                                           const CSR_fOnDeleteTexture fOnDeleteTexture);
+
+        /**
+        * Adds a texture to a texture atlas
+        *@param[in, out] pAtlas - texture atlas to add to
+        *@param pTexture - texture to add, its pixel buffer is copied in the atlas
+        *@return added item index, M_CSR_Unknown_Index if the texture can't be packed
+        *@note The texture can't be packed if it has no pixels, if its pixel size differs from the
+        *      atlas one, or if it's larger than a page. In this case it should remain separated
+        *@note If the texture was already added, the existing item index is returned
+        */
+        size_t csrTextureAtlasAdd(CSR_TextureAtlas* pAtlas, const CSR_Texture* pTexture);
+
+        /**
+        * Adds several textures to a texture atlas, at the same position in consecutive layers
+        *@param[in, out] pAtlas - texture atlas to add to
+        *@param ppTexture - textures to add, all of the same size
+        *@param count - texture count
+        *@return first added item index, the others follow it, M_CSR_Unknown_Index if the textures
+        *        can't be packed
+        *@note This is useful for textures sharing the same texture coordinates, e.g. the
+        *      alternative skins of a model, which may be switched by changing only the layer
+        */
+        size_t csrTextureAtlasAddLayered(      CSR_TextureAtlas* pAtlas,
+                                         const CSR_Texture**     ppTexture,
+                                               size_t            count);
+
+        /**
+        * Finds the item containing a texture in a texture atlas
+        *@param pAtlas - texture atlas to search in
+        *@param pTexture - texture to find
+        *@return item, 0 if not found or on error
+        *@note The returned item is no longer valid after a texture is added to the atlas
+        */
+        const CSR_TextureAtlasItem* csrTextureAtlasFind(const CSR_TextureAtlas* pAtlas,
+                                                        const CSR_Texture*      pTexture);
+
+        /**
+        * Gets the page texture containing a packed texture
+        *@param pAtlas - texture atlas to search in
+        *@param pTexture - packed texture
+        *@return page texture, 0 if the texture isn't packed or on error
+        *@note The page texture should be bound instead of the packed texture, e.g. in fOnGetID, thus
+        *      all the models packed on the same page share the same texture
+        *@note The returned page texture is no longer valid after a texture is added to the atlas
+        */
+        const CSR_Texture* csrTextureAtlasGetPageTexture(const CSR_TextureAtlas* pAtlas,
+                                                         const CSR_Texture*      pTexture);
+
 #ifdef __cplusplus
     }
 #endif
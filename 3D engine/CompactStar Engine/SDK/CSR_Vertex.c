@@ -17,7 +17,17 @@
 
 // std
 #include <stdlib.h>
+#include <string.h>
 
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+//---------------------------------------------------------------------------
+// Global values
+//---------------------------------------------------------------------------
+size_t                    g_VertexBufferGeneration = 0;
+CSR_fOnDeleteVertexBuffer g_fOnDeleteVertexBuffer  = 0;
 //---------------------------------------------------------------------------
 // Line functions
 //---------------------------------------------------------------------------
@@ -108,6 +118,50 @@ void csrVertexCullingInit(CSR_VertexCulling* pVertexCulling)
     pVertexCulling->m_Face = CSR_CF_CCW;
 }
 //---------------------------------------------------------------------------
+// Vertex buffer private functions
+//---------------------------------------------------------------------------
+unsigned csrVertexBufferHashVertex(const float* pVertex, size_t stride)
+{
+    size_t               i;
+    unsigned             hash  = 2166136261u;
+    const unsigned char* pByte = (const unsigned char*)pVertex;
+
+    // hash the vertex values, using the FNV-1a algorithm
+    for (i = 0; i < stride * sizeof(float); ++i)
+    {
+        hash ^= pByte[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+//---------------------------------------------------------------------------
+size_t csrVertexBufferGetTexCoordsOffset(const CSR_VertexBuffer* pVB)
+{
+    // the texture coordinates follow the position and the normal, if any
+    #ifdef CSR_USE_METAL
+        return pVB->m_Format.m_HasNormal ? 8 : 4;
+    #else
+        return pVB->m_Format.m_HasNormal ? 6 : 3;
+    #endif
+}
+//---------------------------------------------------------------------------
+size_t csrVertexBufferNextGeneration(void)
+{
+    // increment the generation atomically, thus the buffers created by several threads at once
+    // (e.g. several loaders) never get the same one
+    #if defined(__GNUC__) || defined(__clang__)
+        return __atomic_add_fetch(&g_VertexBufferGeneration, 1, __ATOMIC_RELAXED);
+    #elif defined(_MSC_VER) && defined(_WIN64)
+        return (size_t)_InterlockedIncrement64((__int64 volatile*)&g_VertexBufferGeneration);
+    #elif defined(_MSC_VER)
+        return (size_t)_InterlockedIncrement((long volatile*)&g_VertexBufferGeneration);
+    #else
+        // no atomic operation available, the vertex buffers should be modified by one thread
+        return ++g_VertexBufferGeneration;
+    #endif
+}
+//---------------------------------------------------------------------------
 // Vertex buffer functions
 //---------------------------------------------------------------------------
 CSR_VertexBuffer* csrVertexBufferCreate(void)
@@ -132,13 +186,40 @@ void csrVertexBufferRelease(CSR_VertexBuffer* pVB)
         return;
 
     // free the vertex buffer content
-    if (pVB->m_pData)
-        free(pVB->m_pData);
+    csrVertexBufferContentRelease(pVB);
 
     // free the vertex buffer
     free(pVB);
 }
 //---------------------------------------------------------------------------
+void csrVertexBufferContentRelease(CSR_VertexBuffer* pVB)
+{
+    // no vertex buffer to release?
+    if (!pVB)
+        return;
+
+    // notify that the vertex buffer content will be deleted
+    if (g_fOnDeleteVertexBuffer)
+        g_fOnDeleteVertexBuffer(pVB);
+
+    // free the vertex buffer content
+    if (pVB->m_pData)
+    {
+        free(pVB->m_pData);
+        pVB->m_pData = 0;
+    }
+
+    // free the vertex indices
+    if (pVB->m_pIndex)
+    {
+        free(pVB->m_pIndex);
+        pVB->m_pIndex = 0;
+    }
+
+    pVB->m_Count      = 0;
+    pVB->m_IndexCount = 0;
+}
+//---------------------------------------------------------------------------
 void csrVertexBufferInit(CSR_VertexBuffer* pVB)
 {
     // no vertex buffer to initialize?
@@ -155,9 +236,38 @@ void csrVertexBufferInit(CSR_VertexBuffer* pVB)
     csrMaterialInit(&pVB->m_Material);
 
     // initialize the vertex buffer content
-    pVB->m_pData = 0;
-    pVB->m_Count = 0;
-    pVB->m_Time  = 0.0;
+    pVB->m_pData      = 0;
+    pVB->m_Count      = 0;
+    pVB->m_pIndex     = 0;
+    pVB->m_IndexCount = 0;
+    pVB->m_Time       = 0.0;
+
+    // get a new data generation, thus a buffer reusing the memory of a released one is never
+    // confused with it
+    csrVertexBufferUpdateGeneration(pVB);
+}
+//---------------------------------------------------------------------------
+void csrVertexBufferUpdateGeneration(CSR_VertexBuffer* pVB)
+{
+    size_t generation;
+
+    // no vertex buffer to update?
+    if (!pVB)
+        return;
+
+    // get the next generation, unique among all the vertex buffers. NOTE 0 is never used, thus
+    // it may identify a buffer which was never initialized
+    generation = csrVertexBufferNextGeneration();
+
+    if (!generation)
+        generation = csrVertexBufferNextGeneration();
+
+    pVB->m_Generation = generation;
+}
+//---------------------------------------------------------------------------
+void csrVertexBufferSetOnDelete(const CSR_fOnDeleteVertexBuffer fOnDeleteVertexBuffer)
+{
+    g_fOnDeleteVertexBuffer = fOnDeleteVertexBuffer;
 }
 //---------------------------------------------------------------------------
 int csrVertexBufferAdd(const CSR_Vector3*          pVertex,
@@ -286,9 +396,226 @@ int csrVertexBufferAdd(const CSR_Vector3*          pVertex,
         pVB->m_pData[offset + 3] = (float) (color        & 0xFF) / 255.0f;
     }
 
+    // is the vertex buffer indexed?
+    if (pVB->m_pIndex)
+    {
+        unsigned* pIndex = (unsigned*)csrMemoryAlloc(pVB->m_pIndex,
+                                                     sizeof(unsigned),
+                                                     pVB->m_IndexCount + 1);
+
+        // succeeded?
+        if (!pIndex)
+            return 0;
+
+        // draw the new vertex after the existing ones
+        pIndex[pVB->m_IndexCount] = (unsigned)(pVB->m_Count / pVB->m_Format.m_Stride);
+        pVB->m_pIndex             = pIndex;
+        ++pVB->m_IndexCount;
+    }
+
     // update vertex count
     pVB->m_Count += pVB->m_Format.m_Stride;
 
+    // notify that the vertex data changed
+    csrVertexBufferUpdateGeneration(pVB);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrVertexBufferIndex(CSR_VertexBuffer* pVB, const size_t* pGroup, size_t* pVertexMap)
+{
+    size_t         i;
+    size_t         stride;
+    size_t         vertexCount;
+    size_t         uniqueCount;
+    size_t*        pUniqueGroup;
+    size_t         bucketCount;
+    unsigned       unique;
+    unsigned*      pBucket;
+    unsigned*      pNext;
+    unsigned*      pIndex;
+    float*         pData;
+    const unsigned empty = ~0u;
+
+    // no vertex buffer to index?
+    if (!pVB)
+        return 0;
+
+    stride      = pVB->m_Format.m_Stride;
+    vertexCount = stride ? pVB->m_Count / stride : 0;
+
+    // already indexed or empty vertex buffer? (NOTE the vertices are kept in place in this case)
+    if (pVB->m_pIndex || !vertexCount)
+    {
+        if (pVertexMap)
+            for (i = 0; i < vertexCount; ++i)
+                pVertexMap[i] = i;
+
+        return 1;
+    }
+
+    // get a bucket count at least twice the vertex count, to keep the collision chains short
+    for (bucketCount = 1; bucketCount < vertexCount * 2; bucketCount <<= 1);
+
+    pBucket = (unsigned*)malloc(bucketCount * sizeof(unsigned));
+    pNext   = (unsigned*)malloc(vertexCount * sizeof(unsigned));
+    pIndex  = (unsigned*)malloc(vertexCount * sizeof(unsigned));
+
+    // keep the group of each unique vertex, if groups are used
+    if (pGroup)
+        pUniqueGroup = (size_t*)malloc(vertexCount * sizeof(size_t));
+    else
+        pUniqueGroup = 0;
+
+    // succeeded?
+    if (!pBucket || !pNext || !pIndex || (pGroup && !pUniqueGroup))
+    {
+        free(pBucket);
+        free(pNext);
+        free(pIndex);
+        free(pUniqueGroup);
+        return 0;
+    }
+
+    memset(pBucket, 0xFF, bucketCount * sizeof(unsigned));
+
+    uniqueCount = 0;
+
+    // iterate through the vertices
+    for (i = 0; i < vertexCount; ++i)
+    {
+        const float*   pVertex = &pVB->m_pData[i * stride];
+        const size_t   group   = pGroup ? pGroup[i] : 0;
+        const unsigned hash    = csrVertexBufferHashVertex(pVertex, stride) ^ (unsigned)(group * 2654435761u);
+        const unsigned slot    = hash & (unsigned)(bucketCount - 1);
+
+        // search for an identical vertex already kept, in the same group
+        for (unique = pBucket[slot]; unique != empty; unique = pNext[unique])
+            if ((!pGroup || pUniqueGroup[unique] == group) &&
+                !memcmp(&pVB->m_pData[unique * stride], pVertex, stride * sizeof(float)))
+                break;
+
+        // not found? Keep the vertex after the previous unique ones. NOTE the kept vertices are
+        // moved backward only, thus the vertices still to read are never overwritten
+        if (unique == empty)
+        {
+            unique = (unsigned)uniqueCount;
+
+            if (unique != i)
+                memcpy(&pVB->m_pData[unique * stride], pVertex, stride * sizeof(float));
+
+            if (pGroup)
+                pUniqueGroup[unique] = group;
+
+            pNext[unique] = pBucket[slot];
+            pBucket[slot] = unique;
+            ++uniqueCount;
+        }
+
+        pIndex[i] = unique;
+
+        if (pVertexMap)
+            pVertexMap[i] = unique;
+    }
+
+    free(pBucket);
+    free(pNext);
+    free(pUniqueGroup);
+
+    // all the vertices are unique? (NOTE they weren't moved in this case)
+    if (uniqueCount == vertexCount)
+    {
+        free(pIndex);
+        return 1;
+    }
+
+    // shrink the vertex data to the unique vertices (NOTE the data remains valid on failure)
+    pData = (float*)realloc(pVB->m_pData, uniqueCount * stride * sizeof(float));
+
+    if (pData)
+        pVB->m_pData = pData;
+
+    pVB->m_Count      = uniqueCount * stride;
+    pVB->m_pIndex     = pIndex;
+    pVB->m_IndexCount = vertexCount;
+
+    // notify that the vertex data changed
+    csrVertexBufferUpdateGeneration(pVB);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+size_t csrVertexBufferGetElementCount(const CSR_VertexBuffer* pVB)
+{
+    // validate the input
+    if (!pVB || !pVB->m_Format.m_Stride)
+        return 0;
+
+    // indexed vertex buffer?
+    if (pVB->m_pIndex)
+        return pVB->m_IndexCount;
+
+    return pVB->m_Count / pVB->m_Format.m_Stride;
+}
+//---------------------------------------------------------------------------
+size_t csrVertexBufferGetElementOffset(const CSR_VertexBuffer* pVB, size_t element)
+{
+    // indexed vertex buffer?
+    if (pVB->m_pIndex)
+        return (size_t)pVB->m_pIndex[element] * pVB->m_Format.m_Stride;
+
+    return element * pVB->m_Format.m_Stride;
+}
+//---------------------------------------------------------------------------
+int csrVertexBufferCanUseAtlas(const CSR_VertexBuffer* pVB)
+{
+    size_t i;
+    size_t offset;
+
+    // validate the input
+    if (!pVB || !pVB->m_Format.m_Stride)
+        return 0;
+
+    // nothing to remap?
+    if (!pVB->m_Format.m_HasTexCoords)
+        return 1;
+
+    offset = csrVertexBufferGetTexCoordsOffset(pVB);
+
+    // the texture coordinates should not repeat the texture, as the neighbor items would be read
+    for (i = offset; i + 1 < pVB->m_Count; i += pVB->m_Format.m_Stride)
+        if (pVB->m_pData[i]     < -M_CSR_Epsilon || pVB->m_pData[i]     > 1.0f + M_CSR_Epsilon ||
+            pVB->m_pData[i + 1] < -M_CSR_Epsilon || pVB->m_pData[i + 1] > 1.0f + M_CSR_Epsilon)
+            return 0;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrVertexBufferRemapToAtlas(CSR_VertexBuffer* pVB, const CSR_TextureAtlasItem* pItem)
+{
+    size_t i;
+    size_t offset;
+
+    // validate the inputs
+    if (!pItem || !csrVertexBufferCanUseAtlas(pVB))
+        return 0;
+
+    // nothing to remap?
+    if (!pVB->m_Format.m_HasTexCoords)
+        return 1;
+
+    offset = csrVertexBufferGetTexCoordsOffset(pVB);
+
+    // move the texture coordinates in the item area
+    for (i = offset; i + 1 < pVB->m_Count; i += pVB->m_Format.m_Stride)
+    {
+        pVB->m_pData[i]     = pItem->m_UVOffset[0] + pVB->m_pData[i]     * pItem->m_UVScale[0];
+        pVB->m_pData[i + 1] = pItem->m_UVOffset[1] + pVB->m_pData[i + 1] * pItem->m_UVScale[1];
+    }
+
+    // notify that the vertex data changed
+    csrVertexBufferUpdateGeneration(pVB);
+
     return 1;
 }
 //---------------------------------------------------------------------------
@@ -325,8 +652,7 @@ void csrMeshRelease(CSR_Mesh* pMesh, const CSR_fOnDeleteTexture fOnDeleteTexture
     {
         // free the static mesh vertex buffer content
         for (i = 0; i < pMesh->m_Count; ++i)
-            if (pMesh->m_pVB[i].m_pData)
-                free(pMesh->m_pVB[i].m_pData);
+            csrVertexBufferContentRelease(&pMesh->m_pVB[i]);
 
         // free the static mesh vertex buffer
         free(pMesh->m_pVB);
@@ -351,6 +677,85 @@ void csrMeshInit(CSR_Mesh* pMesh)
     pMesh->m_Time  = 0.0;
 }
 //---------------------------------------------------------------------------
+int csrMeshIndex(CSR_Mesh* pMesh)
+{
+    size_t i;
+    int    success = 1;
+
+    // no mesh to index?
+    if (!pMesh)
+        return 0;
+
+    // index each vertex buffer, even if a previous one failed
+    for (i = 0; i < pMesh->m_Count; ++i)
+        if (!csrVertexBufferIndex(&pMesh->m_pVB[i], 0, 0))
+            success = 0;
+
+    return success;
+}
+//---------------------------------------------------------------------------
+void csrMeshExtendBox(const CSR_Mesh* pMesh, CSR_Box* pBox, int* pEmpty)
+{
+    size_t      i;
+    size_t      j;
+    CSR_Vector3 vertex;
+
+    // validate the inputs
+    if (!pMesh || !pBox || !pEmpty)
+        return;
+
+    // iterate through the mesh vertex buffers
+    for (i = 0; i < pMesh->m_Count; ++i)
+    {
+        const CSR_VertexBuffer* pVB = &pMesh->m_pVB[i];
+
+        // invalid stride?
+        if (!pVB->m_Format.m_Stride)
+            continue;
+
+        // iterate through the vertices, the position is always the first vertex value
+        for (j = 0; j + 2 < pVB->m_Count; j += pVB->m_Format.m_Stride)
+        {
+            vertex.m_X = pVB->m_pData[j];
+            vertex.m_Y = pVB->m_pData[j + 1];
+            vertex.m_Z = pVB->m_pData[j + 2];
+
+            csrBoxExtendToPoint(&vertex, pBox, pEmpty);
+        }
+    }
+}
+//---------------------------------------------------------------------------
+int csrMeshCanUseAtlas(const CSR_Mesh* pMesh)
+{
+    size_t i;
+
+    // validate the input
+    if (!pMesh)
+        return 0;
+
+    // all the vertex buffers should be remappable
+    for (i = 0; i < pMesh->m_Count; ++i)
+        if (!csrVertexBufferCanUseAtlas(&pMesh->m_pVB[i]))
+            return 0;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrMeshRemapToAtlas(CSR_Mesh* pMesh, const CSR_TextureAtlasItem* pItem)
+{
+    size_t i;
+
+    // validate the inputs. NOTE the mesh is checked first, thus it's never partially remapped
+    if (!pItem || !csrMeshCanUseAtlas(pMesh))
+        return 0;
+
+    // remap each vertex buffer
+    for (i = 0; i < pMesh->m_Count; ++i)
+        csrVertexBufferRemapToAtlas(&pMesh->m_pVB[i], pItem);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
 // Indexed polygon functions
 //---------------------------------------------------------------------------
 void csrIndexedPolygonInit(CSR_IndexedPolygon* pIndexedPolygon)
@@ -499,7 +904,7 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
 {
     size_t                    i;
     size_t                    j;
-    size_t                    index;
+    size_t                    count;
     CSR_IndexedPolygon        indexedPolygon;
     CSR_IndexedPolygonBuffer* pIPB;
 
@@ -517,136 +922,83 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
     // iterate through meshes
     for (i = 0; i < pMesh->m_Count; ++i)
     {
+        const CSR_VertexBuffer* pVB = &pMesh->m_pVB[i];
+
+        // get the vertex count to read, through the indices if the vertex buffer is indexed
+        count = csrVertexBufferGetElementCount(pVB);
+
         // is mesh empty?
-        if (!pMesh->m_pVB[i].m_Count)
+        if (!pVB->m_Count || !count)
             continue;
 
         // assign the reference to the source vertex buffer
-        indexedPolygon.m_pVB = &pMesh->m_pVB[i];
+        indexedPolygon.m_pVB = pVB;
 
         // search for vertex type
-        switch (pMesh->m_pVB[i].m_Format.m_Type)
+        switch (pVB->m_Format.m_Type)
         {
             case CSR_VT_Triangles:
-            {
-                // calculate iteration step
-                const unsigned step = (pMesh->m_pVB[i].m_Format.m_Stride * 3);
-
                 // iterate through source vertices
-                for (j = 0; j < pMesh->m_pVB[i].m_Count; j += step)
+                for (j = 0; j + 2 < count; j += 3)
                 {
                     // extract polygon from source vertex buffer and add it to polygon buffer
-                    indexedPolygon.m_pIndex[0] = j;
-                    indexedPolygon.m_pIndex[1] = j +  pMesh->m_pVB[i].m_Format.m_Stride;
-                    indexedPolygon.m_pIndex[2] = j + (pMesh->m_pVB[i].m_Format.m_Stride * 2);
+                    indexedPolygon.m_pIndex[0] = csrVertexBufferGetElementOffset(pVB, j);
+                    indexedPolygon.m_pIndex[1] = csrVertexBufferGetElementOffset(pVB, j + 1);
+                    indexedPolygon.m_pIndex[2] = csrVertexBufferGetElementOffset(pVB, j + 2);
                     csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
                 }
 
                 continue;
-            }
 
             case CSR_VT_TriangleStrip:
-            {
-                // calculate length to read in triangle strip buffer
-                const unsigned stripLength =
-                        (unsigned)(pMesh->m_pVB[i].m_Count -
-                                (pMesh->m_pVB[i].m_Format.m_Stride * 2));
-
-                index = 0;
-
                 // iterate through source vertices
-                for (j = 0; j < stripLength; j += pMesh->m_pVB[i].m_Format.m_Stride)
+                for (j = 0; j + 2 < count; ++j)
                 {
                     // extract polygon from source buffer, revert odd polygons
-                    if (!index || !(index % 2))
+                    if (!(j % 2))
                     {
-                        indexedPolygon.m_pIndex[0] = j;
-                        indexedPolygon.m_pIndex[1] = j +  pMesh->m_pVB[i].m_Format.m_Stride;
-                        indexedPolygon.m_pIndex[2] = j + (pMesh->m_pVB[i].m_Format.m_Stride * 2);
+                        indexedPolygon.m_pIndex[0] = csrVertexBufferGetElementOffset(pVB, j);
+                        indexedPolygon.m_pIndex[1] = csrVertexBufferGetElementOffset(pVB, j + 1);
                     }
                     else
                     {
-                        indexedPolygon.m_pIndex[0] = j +  pMesh->m_pVB[i].m_Format.m_Stride;
-                        indexedPolygon.m_pIndex[1] = j;
-                        indexedPolygon.m_pIndex[2] = j + (pMesh->m_pVB[i].m_Format.m_Stride * 2);
+                        indexedPolygon.m_pIndex[0] = csrVertexBufferGetElementOffset(pVB, j + 1);
+                        indexedPolygon.m_pIndex[1] = csrVertexBufferGetElementOffset(pVB, j);
                     }
 
+                    indexedPolygon.m_pIndex[2] = csrVertexBufferGetElementOffset(pVB, j + 2);
                     csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
-                    ++index;
                 }
 
                 continue;
-            }
 
             case CSR_VT_TriangleFan:
-            {
-                // calculate length to read in triangle fan buffer
-                const unsigned fanLength =
-                        (unsigned)(pMesh->m_pVB[i].m_Count - pMesh->m_pVB[i].m_Format.m_Stride);
-
                 // iterate through source vertices
-                for (j  = pMesh->m_pVB[i].m_Format.m_Stride;
-                     j  < fanLength;
-                     j += pMesh->m_pVB[i].m_Format.m_Stride)
+                for (j = 1; j + 1 < count; ++j)
                 {
                     // extract polygon from source buffer
-                    indexedPolygon.m_pIndex[0] = 0;
-                    indexedPolygon.m_pIndex[1] = j;
-                    indexedPolygon.m_pIndex[2] = j + pMesh->m_pVB[i].m_Format.m_Stride;
+                    indexedPolygon.m_pIndex[0] = csrVertexBufferGetElementOffset(pVB, 0);
+                    indexedPolygon.m_pIndex[1] = csrVertexBufferGetElementOffset(pVB, j);
+                    indexedPolygon.m_pIndex[2] = csrVertexBufferGetElementOffset(pVB, j + 1);
                     csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
                 }
 
                 continue;
-            }
 
             case CSR_VT_Quads:
-            {
-                // calculate iteration step
-                const unsigned step = (pMesh->m_pVB[i].m_Format.m_Stride * 4);
-
-                // iterate through source vertices
-                for (j = 0; j < pMesh->m_pVB[i].m_Count; j += step)
-                {
-                    // calculate vertices position
-                    const unsigned v1 = (unsigned) j;
-                    const unsigned v2 = (unsigned)(j +  pMesh->m_pVB[i].m_Format.m_Stride);
-                    const unsigned v3 = (unsigned)(j + (pMesh->m_pVB[i].m_Format.m_Stride * 2));
-                    const unsigned v4 = (unsigned)(j + (pMesh->m_pVB[i].m_Format.m_Stride * 3));
-
-                    // extract first polygon from source buffer
-                    indexedPolygon.m_pIndex[0] = v1;
-                    indexedPolygon.m_pIndex[1] = v2;
-                    indexedPolygon.m_pIndex[2] = v3;
-                    csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
-
-                    // extract second polygon from source buffer
-                    indexedPolygon.m_pIndex[0] = v3;
-                    indexedPolygon.m_pIndex[1] = v2;
-                    indexedPolygon.m_pIndex[2] = v4;
-                    csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
-                }
-
-                continue;
-            }
-
             case CSR_VT_QuadStrip:
             {
-                // calculate iteration step
-                const unsigned step = (pMesh->m_pVB[i].m_Format.m_Stride * 2);
-
-                // calculate length to read in triangle strip buffer
-                const unsigned stripLength =
-                        (unsigned)(pMesh->m_pVB[i].m_Count -
-                                (pMesh->m_pVB[i].m_Format.m_Stride * 2));
+                // quads are made of 4 separate vertices, quad strips share 2 vertices between quads
+                const size_t step = (pVB->m_Format.m_Type == CSR_VT_Quads) ? 4 : 2;
 
                 // iterate through source vertices
-                for (j = 0; j < stripLength; j += step)
+                for (j = 0; j + 3 < count; j += step)
                 {
                     // calculate vertices position
-                    const unsigned v1 = (unsigned) j;
-                    const unsigned v2 = (unsigned)(j +  pMesh->m_pVB[i].m_Format.m_Stride);
-                    const unsigned v3 = (unsigned)(j + (pMesh->m_pVB[i].m_Format.m_Stride * 2));
-                    const unsigned v4 = (unsigned)(j + (pMesh->m_pVB[i].m_Format.m_Stride * 3));
+                    const size_t v1 = csrVertexBufferGetElementOffset(pVB, j);
+                    const size_t v2 = csrVertexBufferGetElementOffset(pVB, j + 1);
+                    const size_t v3 = csrVertexBufferGetElementOffset(pVB, j + 2);
+                    const size_t v4 = csrVertexBufferGetElementOffset(pVB, j + 3);
 
                     // extract first polygon from source buffer
                     indexedPolygon.m_pIndex[0] = v1;
@@ -106,6 +106,9 @@ typedef struct
     CSR_Material      m_Material;
     float*            m_pData;
     size_t            m_Count;
+    unsigned*         m_pIndex;     // vertex indices, read in the m_Format.m_Type order, 0 if not indexed
+    size_t            m_IndexCount;
+    size_t            m_Generation; // data generation, changes each time the vertex data is modified
     double            m_Time;
 } CSR_VertexBuffer;
 
@@ -155,6 +158,13 @@ typedef unsigned (*CSR_fOnGetVertexColor)(const CSR_VertexBuffer* pVB,
                                           const CSR_Vector3*      pNormal,
                                                 size_t            groupIndex);
 
+/**
+* Called when a vertex buffer content is about to be deleted
+*@param pVB - vertex buffer which content will be deleted
+*@note This callback allows a renderer to delete the copy it may keep on the GPU side
+*/
+typedef void (*CSR_fOnDeleteVertexBuffer)(const CSR_VertexBuffer* pVB);
+
 #ifdef __cplusplus
     extern "C"
     {
@@ -212,12 +222,41 @@ typedef unsigned (*CSR_fOnGetVertexColor)(const CSR_VertexBuffer* pVB,
         */
         void csrVertexBufferRelease(CSR_VertexBuffer* pVB);
 
+        /**
+        * Releases a vertex buffer content, without releasing the vertex buffer itself
+        *@param[in, out] pVB - vertex buffer which content should be released
+        *@note The delete callback, if any, is notified before the content is freed
+        */
+        void csrVertexBufferContentRelease(CSR_VertexBuffer* pVB);
+
         /**
         * Initializes a vertex buffer structure
         *@param[in, out] pVB - vertex buffer to initialize
         */
         void csrVertexBufferInit(CSR_VertexBuffer* pVB);
 
+        /**
+        * Notifies that the vertex buffer data was modified
+        *@param[in, out] pVB - vertex buffer which data was modified
+        *@note The renderers may keep a copy of the vertex data on the GPU side, which is updated
+        *      only when the buffer generation changes. This function should be called each time
+        *      the data of an already drawn vertex buffer is modified
+        *@note The generations are incremented atomically (with gcc, clang and Visual C++), thus the
+        *      vertex buffers may be created or modified by several threads at once, e.g. loaders
+        */
+        void csrVertexBufferUpdateGeneration(CSR_VertexBuffer* pVB);
+
+        /**
+        * Sets the callback to notify when a vertex buffer content is deleted
+        *@param fOnDeleteVertexBuffer - callback function, 0 to remove it
+        *@note The OpenGL renderer sets this callback as soon as it keeps a vertex buffer copy on
+        *      the GPU side, thus the copy is deleted along with the vertex buffer
+        *@note The callback is called by the thread which releases the vertex buffer. When the
+        *      OpenGL renderer is used, the drawn vertex buffers should be released by the thread
+        *      which owns the OpenGL context
+        */
+        void csrVertexBufferSetOnDelete(const CSR_fOnDeleteVertexBuffer fOnDeleteVertexBuffer);
+
         /**
         * Adds a vertex to a vertex buffer
         *@param pVertex - vertex
@@ -227,6 +266,7 @@ typedef unsigned (*CSR_fOnGetVertexColor)(const CSR_VertexBuffer* pVB,
         *@param fOnGetVertexColor - get vertex color callback function to use, 0 if not used
         *@param[in, out] pVB - vertex buffer to add to
         *@return 1 on success, otherwise 0
+        *@note If the vertex buffer is indexed, the new vertex index is added after the existing ones
         */
         int csrVertexBufferAdd(const CSR_Vector3*          pVertex,
                                const CSR_Vector3*          pNormal,
@@ -235,6 +275,58 @@ typedef unsigned (*CSR_fOnGetVertexColor)(const CSR_VertexBuffer* pVB,
                                const CSR_fOnGetVertexColor fOnGetVertexColor,
                                      CSR_VertexBuffer*     pVB);
 
+        /**
+        * Indexes a vertex buffer, i.e. merges its identical vertices and draws them by index
+        *@param[in, out] pVB - vertex buffer to index
+        *@param pGroup - for each source vertex, a group identifier, may be 0 if not used,
+        *               otherwise must contain m_Count / m_Format.m_Stride items
+        *@param[out] pVertexMap - for each source vertex, the index of the vertex replacing it, may
+        *                         be 0 if not used, otherwise must contain m_Count / m_Format.m_Stride
+        *                         items
+        *@return 1 on success, otherwise 0
+        *@note The vertex buffer is kept unchanged if already indexed, or if all its vertices are
+        *      unique, as the index would be useless in this case. The map is filled in both cases
+        *@note Only the exactly identical vertices are merged, thus two vertices with the same
+        *      position but another normal, texture coordinate or color remain separated. If
+        *      groups are used, only the vertices belonging to the same group are merged, e.g. to
+        *      keep separated the vertices influenced by different bones
+        */
+        int csrVertexBufferIndex(CSR_VertexBuffer* pVB, const size_t* pGroup, size_t* pVertexMap);
+
+        /**
+        * Gets the vertex count to read in a vertex buffer, i.e. its index count if indexed
+        *@param pVB - vertex buffer
+        *@return vertex count to read
+        */
+        size_t csrVertexBufferGetElementCount(const CSR_VertexBuffer* pVB);
+
+        /**
+        * Gets the offset of a vertex to read in a vertex buffer
+        *@param pVB - vertex buffer
+        *@param element - element to read, between 0 and csrVertexBufferGetElementCount() - 1
+        *@return vertex offset in the vertex buffer data
+        */
+        size_t csrVertexBufferGetElementOffset(const CSR_VertexBuffer* pVB, size_t element);
+
+        /**
+        * Checks if the texture coordinates of a vertex buffer may be remapped in a texture atlas
+        *@param pVB - vertex buffer to check
+        *@return 1 if the vertex buffer may be remapped, otherwise 0
+        *@note A vertex buffer can't be remapped if its texture coordinates repeat the texture, i.e.
+        *      are outside the [0, 1] range, as the atlas can't repeat its items
+        */
+        int csrVertexBufferCanUseAtlas(const CSR_VertexBuffer* pVB);
+
+        /**
+        * Remaps the texture coordinates of a vertex buffer in a texture atlas item
+        *@param[in, out] pVB - vertex buffer to remap
+        *@param pItem - texture atlas item containing the vertex buffer texture
+        *@return 1 on success, otherwise 0
+        *@note The vertex buffer is kept unchanged if it can't be remapped, see
+        *      csrVertexBufferCanUseAtlas()
+        */
+        int csrVertexBufferRemapToAtlas(CSR_VertexBuffer* pVB, const CSR_TextureAtlasItem* pItem);
+
         //-------------------------------------------------------------------
         // Mesh functions
         //-------------------------------------------------------------------
@@ -259,6 +351,41 @@ typedef unsigned (*CSR_fOnGetVertexColor)(const CSR_VertexBuffer* pVB,
         */
         void csrMeshInit(CSR_Mesh* pMesh);
 
+        /**
+        * Indexes all the vertex buffers of a mesh
+        *@param[in, out] pMesh - mesh to index
+        *@return 1 on success, otherwise 0
+        *@note On failure the mesh remains valid, although some of its vertex buffers may be still
+        *      not indexed
+        *@note See csrVertexBufferIndex() for further details
+        */
+        int csrMeshIndex(CSR_Mesh* pMesh);
+
+        /**
+        * Extends a box to encompass all the vertices of a mesh
+        *@param pMesh - mesh to encompass in the box
+        *@param[in, out] pBox - bounding box that will encompass the mesh
+        *@param[in, out] pEmpty - if 1, box is empty and still not contains any vertex
+        */
+        void csrMeshExtendBox(const CSR_Mesh* pMesh, CSR_Box* pBox, int* pEmpty);
+
+        /**
+        * Checks if the texture coordinates of all the mesh vertex buffers may be remapped in a
+        * texture atlas
+        *@param pMesh - mesh to check
+        *@return 1 if the mesh may be remapped, otherwise 0
+        */
+        int csrMeshCanUseAtlas(const CSR_Mesh* pMesh);
+
+        /**
+        * Remaps the texture coordinates of all the mesh vertex buffers in a texture atlas item
+        *@param[in, out] pMesh - mesh to remap
+        *@param pItem - texture atlas item containing the mesh texture
+        *@return 1 on success, otherwise 0
+        *@note The mesh is kept unchanged if one of its vertex buffers can't be remapped
+        */
+        int csrMeshRemapToAtlas(CSR_Mesh* pMesh, const CSR_TextureAtlasItem* pItem);
+
         //-------------------------------------------------------------------
         // Indexed polygon functions
         //-------------------------------------------------------------------
@@ -847,6 +847,8 @@ void InitScene(int w, int h)
     g_AlphaSlot             = glGetUniformLocation(g_ShaderProgram, "mini_uAlpha");
     g_FadeFactorSlot        = glGetUniformLocation(g_ShaderProgram, "mini_uFadeFactor");
     g_RedFilterSlot         = glGetUniformLocation(g_ShaderProgram, "mini_uRedFilter");
+    g_ViewUniform           = glGetUniformLocation(g_ShaderProgram, "mini_uView");
+    g_ModelviewUniform      = glGetUniformLocation(g_ShaderProgram, "mini_uModelview");
 
     // create the viewport
     CreateViewport(w, h);
@@ -1299,7 +1301,6 @@ void DrawScene()
     MINI_Matrix        modelViewMatrix;
     MINI_LevelDrawInfo drawInfo;
     float              angle;
-    GLint              modelviewUniform;
 
     miniBeginScene(0.0f, 0.0f, 0.0f, 1.0f);
 
@@ -1323,6 +1324,8 @@ void DrawScene()
     drawInfo.m_pVertexFormat      = &g_VertexFormat;
     drawInfo.m_pShader            = &g_Shader;
     drawInfo.m_ShaderProgram      =  g_ShaderProgram;
+    drawInfo.m_ViewSlot           =  g_ViewUniform;
+    drawInfo.m_ModelviewSlot      =  g_ModelviewUniform;
     drawInfo.m_SoilTextureIndex   =  g_SoilTextureIndex;
     drawInfo.m_WallTextureIndex   =  g_WallTextureIndex;
     drawInfo.m_CeilTextureIndex   =  g_CeilTextureIndex;
@@ -1378,8 +1381,7 @@ void DrawScene()
     miniMatrixMultiply(&combinedMatrixLevel2, &translateMatrix, &modelViewMatrix);
 
     // connect model view matrix to shader
-    modelviewUniform = glGetUniformLocation(g_ShaderProgram, "mini_uModelview");
-    glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+    glUniformMatrix4fv(g_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
     // bind the model texture
     glBindTexture(GL_TEXTURE_2D, g_ModelTextureIndex);
@@ -1413,7 +1415,7 @@ void DrawScene()
         miniGetTranslateMatrix(&t, &modelViewMatrix);
 
         // connect model view matrix to shader
-        glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+        glUniformMatrix4fv(g_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
         // bind the model texture
         glBindTexture(GL_TEXTURE_2D, g_BulletTextureIndex);
@@ -1444,7 +1446,7 @@ void DrawScene()
         miniGetTranslateMatrix(&t, &modelViewMatrix);
 
         // connect model view matrix to shader
-        glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+        glUniformMatrix4fv(g_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
         // bind the model texture
         glBindTexture(GL_TEXTURE_2D, g_BulletTextureIndex);
@@ -246,6 +246,8 @@ void InitScene(int w, int h)
     g_Shader.m_ColorSlot    = glGetAttribLocation(g_ShaderProgram, "mini_vColor");
     g_Shader.m_TexCoordSlot = glGetAttribLocation(g_ShaderProgram, "mini_vTexCoord");
     g_TexSamplerSlot        = glGetAttribLocation(g_ShaderProgram, "mini_sColorMap");
+    g_ViewUniform           = glGetUniformLocation(g_ShaderProgram, "mini_uView");
+    g_ModelviewUniform      = glGetUniformLocation(g_ShaderProgram, "mini_uModelview");
 
     // create the viewport
     CreateViewport(w, h);
@@ -425,6 +427,8 @@ void DrawScene()
     drawInfo.m_pVertexFormat      = &g_VertexFormat;
     drawInfo.m_pShader            = &g_Shader;
     drawInfo.m_ShaderProgram      =  g_ShaderProgram;
+    drawInfo.m_ViewSlot           =  g_ViewUniform;
+    drawInfo.m_ModelviewSlot      =  g_ModelviewUniform;
     drawInfo.m_SoilTextureIndex   =  g_SoilTextureIndex;
     drawInfo.m_WallTextureIndex   =  g_WallTextureIndex;
     drawInfo.m_CeilTextureIndex   =  g_CeilTextureIndex;
@@ -345,6 +345,8 @@ void TMainForm::InitScene(int w, int h)
     m_AlphaSlot             = glGetUniformLocation(m_ShaderProgram, "mini_uAlpha");
     m_FadeFactorSlot        = glGetUniformLocation(m_ShaderProgram, "mini_uFadeFactor");
     m_RedFilterSlot         = glGetUniformLocation(m_ShaderProgram, "mini_uRedFilter");
+    m_ViewUniform           = glGetUniformLocation(m_ShaderProgram, "mini_uView");
+    m_ModelviewUniform      = glGetUniformLocation(m_ShaderProgram, "mini_uModelview");
 
     // configure OpenGL depth testing
     glEnable(GL_DEPTH_TEST);
@@ -794,7 +796,6 @@ void TMainForm::DrawScene()
     MINI_Matrix        modelViewMatrix;
     MINI_LevelDrawInfo drawInfo;
     float              angle;
-    GLint              modelviewUniform;
 
     miniBeginScene(0.0f, 0.0f, 0.0f, 1.0f);
 
@@ -818,6 +819,8 @@ void TMainForm::DrawScene()
     drawInfo.m_pVertexFormat      = &m_VertexFormat;
     drawInfo.m_pShader            = &m_Shader;
     drawInfo.m_ShaderProgram      =  m_ShaderProgram;
+    drawInfo.m_ViewSlot           =  m_ViewUniform;
+    drawInfo.m_ModelviewSlot      =  m_ModelviewUniform;
     drawInfo.m_SoilTextureIndex   =  m_SoilTextureIndex;
     drawInfo.m_WallTextureIndex   =  m_WallTextureIndex;
     drawInfo.m_CeilTextureIndex   =  m_CeilTextureIndex;
@@ -873,8 +876,7 @@ void TMainForm::DrawScene()
     miniMatrixMultiply(&combinedMatrixLevel2, &translateMatrix, &modelViewMatrix);
 
     // connect model view matrix to shader
-    modelviewUniform = glGetUniformLocation(m_ShaderProgram, "mini_uModelview");
-    glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+    glUniformMatrix4fv(m_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
     // bind the model texture
     glBindTexture(GL_TEXTURE_2D, m_ModelTextureIndex);
@@ -908,7 +910,7 @@ void TMainForm::DrawScene()
         miniGetTranslateMatrix(&t, &modelViewMatrix);
 
         // connect model view matrix to shader
-        glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+        glUniformMatrix4fv(m_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
         // bind the model texture
         glBindTexture(GL_TEXTURE_2D, m_BulletTextureIndex);
@@ -939,7 +941,7 @@ void TMainForm::DrawScene()
         miniGetTranslateMatrix(&t, &modelViewMatrix);
 
         // connect model view matrix to shader
-        glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+        glUniformMatrix4fv(m_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
         // bind the model texture
         glBindTexture(GL_TEXTURE_2D, m_BulletTextureIndex);
@@ -239,6 +239,8 @@ void TMainForm::InitScene(int w, int h)
     m_Shader.m_ColorSlot    = glGetAttribLocation(m_ShaderProgram, "mini_vColor");
     m_Shader.m_TexCoordSlot = glGetAttribLocation(m_ShaderProgram, "mini_vTexCoord");
     m_TexSamplerSlot        = glGetAttribLocation(m_ShaderProgram, "mini_sColorMap");
+    m_ViewUniform           = glGetUniformLocation(m_ShaderProgram, "mini_uView");
+    m_ModelviewUniform      = glGetUniformLocation(m_ShaderProgram, "mini_uModelview");
 
     // configure OpenGL depth testing
     glEnable(GL_DEPTH_TEST);
@@ -414,6 +416,8 @@ void TMainForm::DrawScene()
     drawInfo.m_pVertexFormat      = &m_VertexFormat;
     drawInfo.m_pShader            = &m_Shader;
     drawInfo.m_ShaderProgram      =  m_ShaderProgram;
+    drawInfo.m_ViewSlot           =  m_ViewUniform;
+    drawInfo.m_ModelviewSlot      =  m_ModelviewUniform;
     drawInfo.m_SoilTextureIndex   =  m_SoilTextureIndex;
     drawInfo.m_WallTextureIndex   =  m_WallTextureIndex;
     drawInfo.m_CeilTextureIndex   =  m_CeilTextureIndex;
@@ -1043,6 +1043,8 @@ void MINI_CallbackManager::ExecuteTasks(float elapsedTime, MINI_BotItem* pItems)
     m_AlphaSlot             = glGetUniformLocation(m_ShaderProgram, "mini_uAlpha");
     m_FadeFactorSlot        = glGetUniformLocation(m_ShaderProgram, "mini_uFadeFactor");
     m_RedFilterSlot         = glGetUniformLocation(m_ShaderProgram, "mini_uRedFilter");
+    m_ViewUniform           = glGetUniformLocation(m_ShaderProgram, "mini_uView");
+    m_ModelviewUniform      = glGetUniformLocation(m_ShaderProgram, "mini_uModelview");
     
     // configure OpenGL depth testing
     glEnable(GL_DEPTH_TEST);
@@ -1558,7 +1560,6 @@ void MINI_CallbackManager::ExecuteTasks(float elapsedTime, MINI_BotItem* pItems)
     MINI_Matrix        modelViewMatrix;
     MINI_LevelDrawInfo drawInfo;
     float              angle;
-    GLint              modelviewUniform;
     
     miniBeginScene(0.0f, 0.0f, 0.0f, 1.0f);
     
@@ -1582,6 +1583,8 @@ void MINI_CallbackManager::ExecuteTasks(float elapsedTime, MINI_BotItem* pItems)
     drawInfo.m_pVertexFormat      = &m_VertexFormat;
     drawInfo.m_pShader            = &m_Shader;
     drawInfo.m_ShaderProgram      =  m_ShaderProgram;
+    drawInfo.m_ViewSlot           =  m_ViewUniform;
+    drawInfo.m_ModelviewSlot      =  m_ModelviewUniform;
     drawInfo.m_SoilTextureIndex   =  m_SoilTextureIndex;
     drawInfo.m_WallTextureIndex   =  m_WallTextureIndex;
     drawInfo.m_CeilTextureIndex   =  m_CeilTextureIndex;
@@ -1637,8 +1640,7 @@ void MINI_CallbackManager::ExecuteTasks(float elapsedTime, MINI_BotItem* pItems)
     miniMatrixMultiply(&combinedMatrixLevel2, &translateMatrix, &modelViewMatrix);
     
     // connect model view matrix to shader
-    modelviewUniform = glGetUniformLocation(m_ShaderProgram, "mini_uModelview");
-    glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+    glUniformMatrix4fv(m_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
     
     // bind the model texture
     glBindTexture(GL_TEXTURE_2D, m_ModelTextureIndex);
@@ -1672,7 +1674,7 @@ void MINI_CallbackManager::ExecuteTasks(float elapsedTime, MINI_BotItem* pItems)
         miniGetTranslateMatrix(&t, &modelViewMatrix);
         
         // connect model view matrix to shader
-        glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+        glUniformMatrix4fv(m_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
         
         // bind the model texture
         glBindTexture(GL_TEXTURE_2D, m_BulletTextureIndex);
@@ -1703,7 +1705,7 @@ void MINI_CallbackManager::ExecuteTasks(float elapsedTime, MINI_BotItem* pItems)
         miniGetTranslateMatrix(&t, &modelViewMatrix);
         
         // connect model view matrix to shader
-        glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+        glUniformMatrix4fv(m_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
         
         // bind the model texture
         glBindTexture(GL_TEXTURE_2D, m_BulletTextureIndex);
@@ -771,6 +771,8 @@ void on_GLES2_Init(int view_w, int view_h)
     g_AlphaSlot             = glGetUniformLocation(g_ShaderProgram, "mini_uAlpha");
     g_FadeFactorSlot        = glGetUniformLocation(g_ShaderProgram, "mini_uFadeFactor");
     g_RedFilterSlot         = glGetUniformLocation(g_ShaderProgram, "mini_uRedFilter");
+    g_ViewUniform           = glGetUniformLocation(g_ShaderProgram, "mini_uView");
+    g_ModelviewUniform      = glGetUniformLocation(g_ShaderProgram, "mini_uModelview");
 
     // configure OpenGL depth testing
     glEnable(GL_DEPTH_TEST);
@@ -1250,7 +1252,6 @@ void on_GLES2_Render()
     MINI_Matrix        modelViewMatrix;
     MINI_LevelDrawInfo drawInfo;
     float              angle;
-    GLint              modelviewUniform;
 
     miniBeginScene(0.0f, 0.0f, 0.0f, 1.0f);
 
@@ -1274,6 +1275,8 @@ void on_GLES2_Render()
     drawInfo.m_pVertexFormat      = &g_VertexFormat;
     drawInfo.m_pShader            = &g_Shader;
     drawInfo.m_ShaderProgram      =  g_ShaderProgram;
+    drawInfo.m_ViewSlot           =  g_ViewUniform;
+    drawInfo.m_ModelviewSlot      =  g_ModelviewUniform;
     drawInfo.m_SoilTextureIndex   =  g_SoilTextureIndex;
     drawInfo.m_WallTextureIndex   =  g_WallTextureIndex;
     drawInfo.m_CeilTextureIndex   =  g_CeilTextureIndex;
@@ -1329,8 +1332,7 @@ void on_GLES2_Render()
     miniMatrixMultiply(&combinedMatrixLevel2, &translateMatrix, &modelViewMatrix);
 
     // connect model view matrix to shader
-    modelviewUniform = glGetUniformLocation(g_ShaderProgram, "mini_uModelview");
-    glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+    glUniformMatrix4fv(g_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
     // bind the model texture
     glBindTexture(GL_TEXTURE_2D, g_ModelTextureIndex);
@@ -1364,7 +1366,7 @@ void on_GLES2_Render()
         miniGetTranslateMatrix(&t, &modelViewMatrix);
 
         // connect model view matrix to shader
-        glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+        glUniformMatrix4fv(g_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
         // bind the model texture
         glBindTexture(GL_TEXTURE_2D, g_BulletTextureIndex);
@@ -1395,7 +1397,7 @@ void on_GLES2_Render()
         miniGetTranslateMatrix(&t, &modelViewMatrix);
 
         // connect model view matrix to shader
-        glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+        glUniformMatrix4fv(g_ModelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
         // bind the model texture
         glBindTexture(GL_TEXTURE_2D, g_BulletTextureIndex);
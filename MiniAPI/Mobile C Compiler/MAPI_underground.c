@@ -183,6 +183,8 @@ void on_GLES2_Init(int view_w, int view_h)
     g_Shader.m_ColorSlot    = glGetAttribLocation(g_ShaderProgram, "mini_vColor");
     g_Shader.m_TexCoordSlot = glGetAttribLocation(g_ShaderProgram, "mini_vTexCoord");
     g_TexSamplerSlot        = glGetAttribLocation(g_ShaderProgram, "mini_sColorMap");
+    g_ViewUniform           = glGetUniformLocation(g_ShaderProgram, "mini_uView");
+    g_ModelviewUniform      = glGetUniformLocation(g_ShaderProgram, "mini_uModelview");
 
     // configure OpenGL depth testing
     glEnable(GL_DEPTH_TEST);
@@ -390,6 +392,8 @@ void on_GLES2_Render()
     drawInfo.m_pVertexFormat      = &g_VertexFormat;
     drawInfo.m_pShader            = &g_Shader;
     drawInfo.m_ShaderProgram      =  g_ShaderProgram;
+    drawInfo.m_ViewSlot           =  g_ViewUniform;
+    drawInfo.m_ModelviewSlot      =  g_ModelviewUniform;
     drawInfo.m_SoilTextureIndex   =  g_SoilTextureIndex;
     drawInfo.m_WallTextureIndex   =  g_WallTextureIndex;
     drawInfo.m_CeilTextureIndex   =  g_CeilTextureIndex;
@@ -342,7 +342,6 @@ void miniDrawLevelItem(const MINI_Vector3*       pTranslate,
     MINI_Matrix translateMatrix;
     MINI_Matrix rotateMatrix;
     MINI_Matrix modelViewMatrix;
-    GLint       modelviewUniform;
 
     // build the model matrix
     miniGetTranslateMatrix(pTranslate, &translateMatrix);
@@ -350,8 +349,7 @@ void miniDrawLevelItem(const MINI_Vector3*       pTranslate,
     miniMatrixMultiply(&rotateMatrix, &translateMatrix, &modelViewMatrix);
 
     // connect model view matrix to shader
-    modelviewUniform = glGetUniformLocation(pDrawInfo->m_ShaderProgram, "mini_uModelview");
-    glUniformMatrix4fv(modelviewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+    glUniformMatrix4fv(pDrawInfo->m_ModelviewSlot, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
     // draw the item
     miniDrawSurface(pDrawInfo->m_pSurfaceVB,
@@ -375,8 +373,6 @@ void miniDrawLevel(const MINI_LevelItem*     pLevel,
     MINI_Vector3 r;
     MINI_Matrix  viewMatrix;
     MINI_Matrix  modelViewMatrix;
-    GLint        viewUniform;
-    GLint        modelViewUniform;
 
     // is map mode enabled? (it's a spacial mode for debugging purposes)
     if (pDrawInfo->m_MapMode)
@@ -399,8 +395,7 @@ void miniDrawLevel(const MINI_LevelItem*     pLevel,
     }
 
     // connect model view matrix to shader
-    viewUniform = glGetUniformLocation(pDrawInfo->m_ShaderProgram, "mini_uView");
-    glUniformMatrix4fv(viewUniform, 1, 0, &viewMatrix.m_Table[0][0]);
+    glUniformMatrix4fv(pDrawInfo->m_ViewSlot, 1, 0, &viewMatrix.m_Table[0][0]);
 
     // iterate through the level items to draw
     for (i = 0; i < levelItemCount; ++i)
@@ -559,8 +554,7 @@ void miniDrawLevel(const MINI_LevelItem*     pLevel,
         miniGetTranslateMatrix(&t, &modelViewMatrix);
 
         // connect model view matrix to shader
-        modelViewUniform = glGetUniformLocation(pDrawInfo->m_ShaderProgram, "mini_uModelview");
-        glUniformMatrix4fv(modelViewUniform, 1, 0, &modelViewMatrix.m_Table[0][0]);
+        glUniformMatrix4fv(pDrawInfo->m_ModelviewSlot, 1, 0, &modelViewMatrix.m_Table[0][0]);
 
         // bind soil texture
         glBindTexture(GL_TEXTURE_2D, pDrawInfo->m_SphereTextureIndex);
@@ -72,6 +72,8 @@ typedef struct
     MINI_Shader*       m_pShader;
     MINI_Shader*       m_pSphereShader;
     GLuint             m_ShaderProgram;
+    GLint              m_ViewSlot;
+    GLint              m_ModelviewSlot;
     GLuint             m_SoilTextureIndex;
     GLuint             m_WallTextureIndex;
     GLuint             m_CeilTextureIndex;